@@ -11,9 +11,9 @@ cd ..
 
 rm libscclust/Makefile
 cat <<EOF > libscclust/Makefile
-# Use 64-bit arc ref: -DSCC_ARC64
 # Use stable NNG: -DSCC_STABLE_NNG
 # Use stable findseed: -DSCC_STABLE_FINDSEED
+# Never spill digraphs to temporary files: -DSCC_NO_DISK_SPILL
 XTRA_FLAGS =
 
 LIBOBJS = \\
@@ -27,9 +27,12 @@ LIBOBJS = \\
 	src/nng_clustering.o \\
 	src/nng_core.o \\
 	src/nng_findseeds.o \\
+	src/point_order.o \\
+	src/resources.o \\
 	src/scclust_spi.o \\
 	src/scclust.o \\
-	src/utilities.o
+	src/utilities.o \\
+	src/workspace.o
 
 libscclust.a: \$(LIBOBJS)
 	\$(R_AR) -rcs libscclust.a \$^
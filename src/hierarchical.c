@@ -37,7 +37,9 @@
 SEXP Rscc_hierarchical_clustering(const SEXP R_distances,
                                   const SEXP R_size_constraint,
                                   const SEXP R_batch_assign,
-                                  const SEXP R_existing_clustering)
+                                  const SEXP R_existing_clustering,
+                                  const SEXP R_center_probes,
+                                  const SEXP R_max_center_iterations)
 {
 	Rscc_set_dist_functions();
 
@@ -53,10 +55,22 @@ SEXP Rscc_hierarchical_clustering(const SEXP R_distances,
 	if (!isNull(R_existing_clustering) && !isInteger(R_existing_clustering)) {
 		iRscc_error("`R_existing_clustering` is not a valid clustering object.");
 	}
+	if (!isInteger(R_center_probes)) {
+		iRscc_error("`R_center_probes` must be integer.");
+	}
+	if (!isNull(R_max_center_iterations) && !isInteger(R_max_center_iterations)) {
+		iRscc_error("`R_max_center_iterations` must be NULL or integer.");
+	}
 
 	const uint64_t num_data_points = (uint64_t) idist_num_data_points(R_distances);
-	const uint32_t size_constraint = (uint32_t) asInteger(R_size_constraint);
-	const bool batch_assign = (bool) asLogical(R_batch_assign);
+
+	scc_HierarchicalOptions options = scc_get_default_hierarchical_options();
+	options.size_constraint = (uint32_t) asInteger(R_size_constraint);
+	options.batch_assign = (bool) asLogical(R_batch_assign);
+	options.num_center_probes = (uint32_t) asInteger(R_center_probes);
+	if (isInteger(R_max_center_iterations)) {
+		options.max_center_iterations = (uint32_t) asInteger(R_max_center_iterations);
+	}
 
 	scc_ErrorCode ec;
 	SEXP R_cluster_labels;
@@ -95,8 +109,7 @@ SEXP Rscc_hierarchical_clustering(const SEXP R_distances,
 	}
 
 	if ((ec = scc_hierarchical_clustering(Rscc_get_distances_pointer(R_distances),
-	                                      size_constraint,
-	                                      batch_assign,
+	                                      &options,
 	                                      clustering)) != SCC_ER_OK) {
 		scc_free_clustering(&clustering);
 		iRscc_scc_error();
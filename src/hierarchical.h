@@ -28,7 +28,9 @@
 SEXP Rscc_hierarchical_clustering(SEXP R_distances,
                                   SEXP R_size_constraint,
                                   SEXP R_batch_assign,
-                                  SEXP R_existing_clustering);
+                                  SEXP R_existing_clustering,
+                                  SEXP R_center_probes,
+                                  SEXP R_max_center_iterations);
 
 
 #endif // ifndef RSCC_HIERARCHICAL_HG
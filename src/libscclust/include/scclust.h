@@ -253,6 +253,97 @@ scc_ErrorCode scc_get_cluster_labels(const scc_Clustering* clustering,
                                      scc_Clabel out_label_buffer[]);
 
 
+// =============================================================================
+// Workspace
+// =============================================================================
+
+/** Type used for workspaces.
+ *
+ *  A workspace keeps memory freed by the library for reuse, so that repeated calls
+ *  (e.g., clustering many small strata) do not go to the system allocator each time.
+ *  Blocks up to 4 MiB are rounded up to powers of two, so they may use up to twice
+ *  the memory of the plain allocator. Larger blocks are taken from the system
+ *  directly; they are neither cached nor counted in #scc_WorkspaceStats.
+ */
+typedef struct scc_Workspace scc_Workspace;
+
+
+/// Struct to report memory use of a workspace
+typedef struct scc_WorkspaceStats {
+	/// Bytes currently handed out from the workspace.
+	uint64_t used_bytes;
+	/// Largest value of #used_bytes since the workspace was created or last reset.
+	uint64_t high_water_bytes;
+	/// Bytes held by the workspace for reuse.
+	uint64_t cached_bytes;
+	/// Allocations made from the workspace since it was created or last reset.
+	uint64_t num_allocations;
+	/// Allocations among #num_allocations that reused cached memory.
+	uint64_t num_reused;
+} scc_WorkspaceStats;
+
+
+/** Construct new workspace.
+ *
+ *  \param[out] out_workspace double pointer to where to write the workspace reference.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ */
+scc_ErrorCode scc_init_workspace(scc_Workspace** out_workspace);
+
+
+/** Free workspace.
+ *
+ *  Frees a #scc_Workspace and all memory it holds for reuse. If the workspace is in
+ *  use by the calling thread, the thread goes back to the plain allocator.
+ *
+ *  \note Only the calling thread's workspace is cleared. Other threads that use the
+ *        workspace must call #scc_set_workspace with another workspace (or `NULL`)
+ *        before it is freed.
+ *
+ *  \param[in,out] workspace double pointer to the #scc_Workspace to free.
+ */
+void scc_free_workspace(scc_Workspace** workspace);
+
+
+/** Use workspace for all subsequent allocations in the library made by the calling thread.
+ *
+ *  Memory allocated from a workspace goes back to it when freed, also after the
+ *  workspace is replaced, as long as the workspace exists. Memory freed after the
+ *  workspace is freed is given back to the system. Clusterings can therefore
+ *  outlive the workspace.
+ *
+ *  \param[in] workspace the #scc_Workspace to use, or `NULL` for the plain allocator.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ *
+ *  \note The workspace is set per thread. Threads started by the library itself (with
+ *        OpenMP) use the plain allocator. A workspace may be used by several threads;
+ *        access is synchronized when the library is built with OpenMP.
+ */
+scc_ErrorCode scc_set_workspace(scc_Workspace* workspace);
+
+
+/** Reset workspace.
+ *
+ *  Gives back memory held for reuse in block sizes that were not allocated since the
+ *  workspace was created or last reset, so a workspace that is reset between calls
+ *  holds memory only for the latest call. Sets the high-water mark to the current
+ *  use and clears the allocation counts.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ */
+scc_ErrorCode scc_reset_workspace(scc_Workspace* workspace);
+
+
+/** Report memory use of workspace.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ */
+scc_ErrorCode scc_get_workspace_stats(const scc_Workspace* workspace,
+                                      scc_WorkspaceStats* out_stats);
+
+
 // =============================================================================
 // Clustering functions
 // =============================================================================
@@ -331,11 +422,28 @@ typedef enum scc_RadiusMethod {
 } scc_RadiusMethod;
 
 
+/// Struct to report the batches used by #SCC_SM_BATCHES
+typedef struct scc_BatchStats {
+	/// Number of batches searched.
+	uint64_t num_batches;
+	/// Number of queries searched.
+	uint64_t num_queries;
+	/// Queries among #num_queries that were assigned before their turn, i.e., searches that were not needed.
+	uint64_t wasted_queries;
+	/// Smallest batch size used.
+	uint32_t min_batch_size;
+	/// Largest batch size used.
+	uint32_t max_batch_size;
+	/// Batch size when the clustering finished.
+	uint32_t final_batch_size;
+} scc_BatchStats;
+
+
 typedef struct scc_ClusterOptions {
 	/** scc_ClusterOptions struct version
 	 *
 	 *  \note
-	 *  This must be set to "722678001".
+	 *  This must be set to "722678005".
 	 */
 	int32_t options_version;
 	uint32_t size_constraint;
@@ -355,6 +463,44 @@ typedef struct scc_ClusterOptions {
 	scc_RadiusMethod secondary_radius;
 	double secondary_supplied_radius;
 	uint32_t batch_size;
+	/** Sort data points along a Morton (Z-order) curve before clustering.
+	 *
+	 *  Points close in space get close IDs, which improves memory locality in all phases.
+	 *  The output is mapped back to the original IDs. Results may differ from the
+	 *  unsorted run since ties are broken by ID. Requires the built-in data set.
+	 */
+	bool reorder_data_points;
+	/** Seed methods to run concurrently on the same NNG, as a bitmask with bit `1 << method` for each method.
+	 *
+	 *  When non-zero, #seed_method is ignored (but may not be #SCC_SM_BATCHES) and the method finding the most
+	 *  seeds is used. Ties go to the method listed first in #scc_SeedMethod. #SCC_SM_BATCHES cannot be included.
+	 *  Each method needs its own working memory, so peak memory grows with the number of methods.
+	 */
+	uint32_t seed_portfolio;
+	/** Break all ties by data point ID.
+	 *
+	 *  Arcs in the NNG are sorted by ID, and the updating seed methods pick the vertex with the lowest
+	 *  ID among those with the same count. The clustering then does not depend on the order in which
+	 *  the NN search reports neighbors. This is the same as compiling with `SCC_STABLE_NNG` and
+	 *  `SCC_STABLE_FINDSEED`, but can be set at run time.
+	 */
+	bool stable_clustering;
+	/** Let #SCC_SM_BATCHES adapt the batch size while clustering.
+	 *
+	 *  #batch_size is used as the initial size (100 if zero). The size is doubled while few queries
+	 *  in a batch turn out to be assigned before their turn, and halved when many do. The clustering
+	 *  does not depend on the batch sizes. Can only be set with #SCC_SM_BATCHES.
+	 */
+	bool adaptive_batch_size;
+	/** Largest memory in bytes of the batch buffers when #adaptive_batch_size is set. Zero means no limit.
+	 *
+	 *  Each query in a batch needs `(size_constraint + 1) * sizeof(scc_PointIndex)` bytes, twice if the
+	 *  search is pipelined with the checking. Must be zero when #adaptive_batch_size is not set, and
+	 *  otherwise zero or large enough for one query.
+	 */
+	size_t max_batch_bytes;
+	/// If not `NULL`, #SCC_SM_BATCHES reports the batches it used here. Must be `NULL` with other seed methods.
+	scc_BatchStats* batch_stats;
 } scc_ClusterOptions;
 
 
@@ -366,9 +512,87 @@ scc_ErrorCode scc_sc_clustering(void* data_set,
                                 scc_Clustering* out_clustering);
 
 
+/// Enum to specify how #scc_hierarchical_clustering breaks clusters
+typedef enum scc_SplitMethod {
+	/** Break clusters around centers that are far apart.
+	 *
+	 *  The centers are found by repeated farthest-point searches and the points are assigned to the centers
+	 *  by their distances to them.
+	 */
+	SCC_SP_DISTANCES,
+
+	/** Break clusters along the widest coordinate.
+	 *
+	 *  The points are sorted along the dimension with the largest range in the cluster and split into
+	 *  `num_splits` parts of about equal size. The parts are multiples of `size_constraint`, except the
+	 *  last one, so the final clustering has as many clusters as possible. This takes time linear in the
+	 *  cluster size and avoids all distance calculations, but the clusters are only rough approximations
+	 *  of the ones produced by #SCC_SP_DISTANCES. The option `batch_assign` has no effect. This method
+	 *  can only be used with the built-in Euclidean distance functions.
+	 */
+	SCC_SP_COORDINATES
+} scc_SplitMethod;
+
+
+/// Options struct for #scc_hierarchical_clustering
+typedef struct scc_HierarchicalOptions {
+	/** scc_HierarchicalOptions struct version
+	 *
+	 *  \note
+	 *  This must be set to "722519001".
+	 */
+	int32_t options_version;
+	uint32_t size_constraint;
+	/// Assign the points remaining after the centers have picked their nearest points in batches of `size_constraint`.
+	bool batch_assign;
+	/** Number of clusters each cluster is broken into.
+	 *
+	 *  Two (the default) bisects clusters. With more, `num_splits` centers are picked by farthest-first
+	 *  traversal, and the points are assigned greedily to the centers so that all new clusters satisfy
+	 *  the size constraint. Clusters with fewer than `num_splits * size_constraint` points are broken into
+	 *  as many clusters as possible. This shortens the hierarchy when there are many more points than
+	 *  `size_constraint`. Values above the size of the largest cluster divided by `size_constraint` have
+	 *  the same effect as that number.
+	 *
+	 *  \note
+	 *  Breaking a cluster needs a list for each new cluster, with a distance and two indices for every
+	 *  point in the cluster, and two more rows of distances. The memory is therefore proportional to
+	 *  `num_splits` times the size of the largest cluster, about 16 bytes per point for each split. When
+	 *  clusters are broken in parallel, each thread holds its own lists, so the memory is also multiplied
+	 *  by the number of threads.
+	 */
+	uint32_t num_splits;
+	/// Method used to break clusters.
+	scc_SplitMethod split_method;
+	/** Number of data points to start from when searching for centers.
+	 *
+	 *  The search for two points far apart starts from this many points spread over the cluster. Each
+	 *  iteration finds the farthest point from each point still being checked, so the cost of an iteration
+	 *  grows with the number of probes. Defaults to 100.
+	 */
+	uint32_t num_center_probes;
+	/** Maximum number of iterations when searching for centers.
+	 *
+	 *  Zero (the default) continues until no new farthest points are found. One probe and two iterations
+	 *  give a double sweep, which is linear in the cluster size.
+	 */
+	uint32_t max_center_iterations;
+	/** Find centers as extreme points along random projections.
+	 *
+	 *  The centers are the extreme points along one of a few random directions, picking the direction
+	 *  where the extremes are farthest apart. This is linear in the cluster size and ignores
+	 *  `num_center_probes` and `max_center_iterations`. It can only be used with the built-in Euclidean
+	 *  distance functions.
+	 */
+	bool approximate_centers;
+} scc_HierarchicalOptions;
+
+
+scc_HierarchicalOptions scc_get_default_hierarchical_options(void);
+
+
 scc_ErrorCode scc_hierarchical_clustering(void* data_set,
-                                          uint32_t size_constraint,
-                                          bool batch_assign,
+                                          const scc_HierarchicalOptions* options,
                                           scc_Clustering* out_clustering);
 
 
@@ -413,6 +637,58 @@ scc_ErrorCode scc_get_clustering_stats(void* data_set,
                                        scc_ClusteringStats* out_stats);
 
 
+/** Struct to report estimated resource use of #scc_sc_clustering
+ *
+ *  Byte counts are the peak memory allocated by the library during each phase,
+ *  including data from earlier phases that is still alive. With a workspace (see
+ *  #scc_set_workspace), blocks up to 4 MiB are rounded up to powers of two and may
+ *  take up to twice the counted bytes. Distance evaluation
+ *  counts assume exhaustive nearest neighbor searches (as done by the built-in
+ *  data set) and are upper bounds when the search is approximate or uses a tree.
+ */
+typedef struct scc_ResourceEstimate {
+	/// Number of data points in the sample used to estimate degrees and seeds.
+	uint64_t sample_size;
+	/// Estimated number of seeds (i.e., clusters).
+	uint64_t num_seeds;
+	/// Number of arcs in the NNG.
+	uint64_t nng_arcs;
+	/// Estimated number of arcs in the exclusion graph (zero if not used). The graph is traversed implicitly and never stored.
+	uint64_t exclusion_graph_arcs;
+	/// Peak bytes when constructing the NNG.
+	uint64_t nng_bytes;
+	/// Peak bytes when deriving degrees in the exclusion graph (zero if not used).
+	uint64_t exclusion_graph_bytes;
+	/// Peak bytes when sorting vertices and finding seeds.
+	uint64_t sort_bytes;
+	/// Peak bytes when assigning vertices to clusters.
+	uint64_t assignment_bytes;
+	/// Peak bytes over all phases.
+	uint64_t peak_bytes;
+	/// Distance evaluations when constructing the NNG.
+	uint64_t nng_dist_evals;
+	/// Distance evaluations when estimating radii and assigning unassigned vertices.
+	uint64_t assignment_dist_evals;
+	/// Distance evaluations over all phases.
+	uint64_t total_dist_evals;
+} scc_ResourceEstimate;
+
+
+/** Estimate resource use of #scc_sc_clustering
+ *
+ *  Predicts the peak memory and the number of distance evaluations of each phase
+ *  of #scc_sc_clustering with the supplied options. Degrees in the NNG and the
+ *  exclusion graph, and the number of seeds, are estimated by running the seed
+ *  finding on the NNG of a deterministic sample of at most 1000 data points.
+ *  The estimate is rough; radius constraints are ignored when sampling.
+ *
+ *  \return #scc_ErrorCode describing eventual error.
+ */
+scc_ErrorCode scc_estimate_resources(void* data_set,
+                                     const scc_ClusterOptions* options,
+                                     scc_ResourceEstimate* out_estimate);
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -29,6 +29,7 @@
 #include "error.h"
 #include "data_set_struct.h"
 #include "scclust_types.h"
+#include "workspace.h"
 
 
 // =============================================================================
@@ -70,7 +71,7 @@ scc_ErrorCode scc_init_data_set(const uint64_t num_data_points,
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid data matrix.");
 	}
 
-	scc_DataSet* tmp_dso = malloc(sizeof(scc_DataSet));
+	scc_DataSet* tmp_dso = iscc_malloc(sizeof(scc_DataSet));
 	if (tmp_dso == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 
 	*tmp_dso = (scc_DataSet) {
@@ -89,7 +90,7 @@ scc_ErrorCode scc_init_data_set(const uint64_t num_data_points,
 void scc_free_data_set(scc_DataSet** const data_set)
 {
 	if ((data_set != NULL) && (*data_set != NULL)) {
-		free(*data_set);
+		iscc_free(*data_set);
 		*data_set = NULL;
 	}
 }
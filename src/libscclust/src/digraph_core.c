@@ -24,10 +24,26 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include "../include/scclust.h"
 #include "error.h"
 #include "scclust_types.h"
+#include "workspace.h"
+
+
+// =============================================================================
+// Static function prototypes
+// =============================================================================
+
+static scc_ErrorCode iscc_alloc_digraph(size_t vertices,
+                                        uintmax_t max_arcs,
+                                        bool zero_tail_ptr,
+                                        iscc_Digraph* out_dg);
+
+
+static scc_ErrorCode iscc_change_tail_ptr_width(iscc_Digraph* dg,
+                                                bool arc64);
 
 
 // =============================================================================
@@ -37,8 +53,9 @@
 void iscc_free_digraph(iscc_Digraph* const dg)
 {
 	if (dg != NULL) {
-		free(dg->head);
-		free(dg->tail_ptr);
+		iscc_free(dg->head);
+		iscc_free(dg->tail_ptr32);
+		iscc_free(dg->tail_ptr64);
 		*dg = ISCC_NULL_DIGRAPH;
 	}
 }
@@ -46,7 +63,9 @@ void iscc_free_digraph(iscc_Digraph* const dg)
 
 bool iscc_digraph_is_initialized(const iscc_Digraph* const dg)
 {
-	if ((dg == NULL) || (dg->tail_ptr == NULL)) return false;
+	if (dg == NULL) return false;
+	if ((dg->tail_ptr32 == NULL) == (dg->tail_ptr64 == NULL)) return false;
+	if ((dg->tail_ptr32 != NULL) && (dg->max_arcs > ISCC_ARCINDEX32_MAX)) return false;
 	if ((dg->vertices > ISCC_POINTINDEX_MAX) || (dg->max_arcs > ISCC_ARCINDEX_MAX)) return false;
 	if ((dg->max_arcs == 0) && (dg->head != NULL)) return false;
 	if ((dg->max_arcs > 0) && (dg->head == NULL)) return false;
@@ -57,19 +76,27 @@ bool iscc_digraph_is_initialized(const iscc_Digraph* const dg)
 bool iscc_digraph_is_valid(const iscc_Digraph* const dg)
 {
 	if (!iscc_digraph_is_initialized(dg)) return false;
-	if (dg->tail_ptr[0] != 0) return false;
-	if (dg->tail_ptr[dg->vertices] > dg->max_arcs) return false;
+	if (iscc_get_tail_ptr(dg, 0) != 0) return false;
+	if (iscc_digraph_arcs(dg) > dg->max_arcs) return false;
 	for (size_t i = 0; i < dg->vertices; ++i) {
-		if (dg->tail_ptr[i] > dg->tail_ptr[i + 1]) return false;
+		if (iscc_get_tail_ptr(dg, (scc_PointIndex) i) > iscc_get_tail_ptr(dg, (scc_PointIndex) (i + 1))) return false;
 	}
-	if (dg->tail_ptr[dg->vertices] > 0) {
+	if (iscc_digraph_arcs(dg) > 0) {
 		assert(dg->vertices <= ISCC_POINTINDEX_MAX);
 		scc_PointIndex vertices = (scc_PointIndex) dg->vertices; // If `scc_PointIndex` is signed.
-		const scc_PointIndex* const arc_stop = dg->head + dg->tail_ptr[dg->vertices];
+		const scc_PointIndex* const arc_stop = dg->head + iscc_digraph_arcs(dg);
 		for (const scc_PointIndex* arc = dg->head; arc != arc_stop; ++arc) {
 			if (*arc >= vertices) return false;
 		}
 	}
+	if (dg->sorted_rows) {
+		for (size_t i = 0; i < dg->vertices; ++i) {
+			const scc_PointIndex* const arc_stop = iscc_arc_stop(dg, (scc_PointIndex) i);
+			for (const scc_PointIndex* arc = iscc_arc_start(dg, (scc_PointIndex) i) + 1; arc < arc_stop; ++arc) {
+				if (*(arc - 1) >= *arc) return false;
+			}
+		}
+	}
 	return true;
 }
 
@@ -77,7 +104,7 @@ bool iscc_digraph_is_valid(const iscc_Digraph* const dg)
 bool iscc_digraph_is_empty(const iscc_Digraph* const dg)
 {
 	assert(iscc_digraph_is_initialized(dg));
-	return (dg->tail_ptr[dg->vertices] == 0);
+	return (iscc_digraph_arcs(dg) == 0);
 }
 
 
@@ -85,89 +112,270 @@ scc_ErrorCode iscc_init_digraph(const size_t vertices,
                                 const uintmax_t max_arcs,
                                 iscc_Digraph* const out_dg)
 {
-	assert(vertices > 0);
-	assert(vertices <= ISCC_POINTINDEX_MAX);
-	assert(vertices < SIZE_MAX);
-	assert(out_dg != NULL);
-	if ((max_arcs > ISCC_ARCINDEX_MAX) || (max_arcs > SIZE_MAX)) {
-		return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many arcs in graph (adjust the `iscc_ArcIndex` type).");
+	scc_ErrorCode ec;
+	if ((ec = iscc_alloc_digraph(vertices, max_arcs, false, out_dg)) != SCC_ER_OK) return ec;
+
+	assert(iscc_digraph_is_initialized(out_dg));
+
+	return iscc_no_error();
+}
+
+
+scc_ErrorCode iscc_empty_digraph(const size_t vertices,
+                                 const uintmax_t max_arcs,
+                                 iscc_Digraph* const out_dg)
+{
+	scc_ErrorCode ec;
+	if ((ec = iscc_alloc_digraph(vertices, max_arcs, true, out_dg)) != SCC_ER_OK) return ec;
+
+	assert(iscc_digraph_is_valid(out_dg));
+
+	return iscc_no_error();
+}
+
+
+scc_ErrorCode iscc_change_arc_storage(iscc_Digraph* const dg,
+                                      const uintmax_t new_max_arcs)
+{
+	assert(iscc_digraph_is_initialized(dg));
+	assert(iscc_digraph_arcs(dg) <= new_max_arcs);
+	if ((new_max_arcs > ISCC_ARCINDEX_MAX) || (new_max_arcs > SIZE_MAX)) {
+		return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many arcs in graph.");
 	}
+	if (dg->max_arcs == new_max_arcs) return iscc_no_error();
 
-	*out_dg = (iscc_Digraph) {
-		.vertices = vertices,
-		.max_arcs = (size_t) max_arcs,
-		.head = NULL,
-		.tail_ptr = malloc(sizeof(iscc_ArcIndex[vertices + 1])),
-	};
-	if (out_dg->tail_ptr == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+	scc_ErrorCode ec;
+	const bool arc64 = (new_max_arcs > ISCC_ARCINDEX32_MAX);
+	if (arc64 && (dg->tail_ptr64 == NULL)) {
+		// Must widen before the arc storage grows
+		if ((ec = iscc_change_tail_ptr_width(dg, true)) != SCC_ER_OK) return ec;
+	}
 
-	if (max_arcs > 0) {
-		out_dg->head = malloc(sizeof(scc_PointIndex[max_arcs]));
-		if (out_dg->head == NULL) {
+	if (new_max_arcs == 0) {
+		iscc_free(dg->head);
+		dg->head = NULL;
+		dg->max_arcs = 0;
+	} else {
+		scc_PointIndex* const tmp_ptr = iscc_realloc(dg->head, sizeof(scc_PointIndex[new_max_arcs]));
+		if (tmp_ptr == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+		dg->head = tmp_ptr;
+		dg->max_arcs = (size_t) new_max_arcs;
+	}
+
+	if (!arc64 && (dg->tail_ptr64 != NULL)) {
+		// Narrowing only saves memory, the digraph is valid with either width
+		if (iscc_change_tail_ptr_width(dg, false) != SCC_ER_OK) iscc_reset_error();
+	}
+
+	return iscc_no_error();
+}
+
+
+scc_ErrorCode iscc_spill_digraph(iscc_Digraph* const dg,
+                                 iscc_SpilledDigraph* const out_spilled)
+{
+	assert(iscc_digraph_is_valid(dg));
+	assert(out_spilled != NULL);
+
+	#ifdef SCC_NO_DISK_SPILL
+		(void) dg;
+		(void) out_spilled;
+		return iscc_make_error_msg(SCC_ER_NO_MEMORY, "Cannot allocate memory (disk spill is disabled).");
+	#else
+		FILE* const file = tmpfile();
+		if (file == NULL) {
+			return iscc_make_error_msg(SCC_ER_NO_MEMORY, "Cannot allocate memory or temporary file.");
+		}
+
+		bool write_ok = true;
+		size_t max_row_arcs = 0;
+		for (size_t v = 0; write_ok && (v < dg->vertices); ++v) {
+			const size_t row_arcs = iscc_get_tail_ptr(dg, (scc_PointIndex) (v + 1)) - iscc_get_tail_ptr(dg, (scc_PointIndex) v);
+			const uint64_t row_arcs64 = (uint64_t) row_arcs;
+			if (max_row_arcs < row_arcs) max_row_arcs = row_arcs;
+			write_ok = (fwrite(&row_arcs64, sizeof(uint64_t), 1, file) == 1);
+			if (write_ok && (row_arcs > 0)) {
+				write_ok = (fwrite(iscc_arc_start(dg, (scc_PointIndex) v), sizeof(scc_PointIndex), row_arcs, file) == row_arcs);
+			}
+		}
+		if (!write_ok || (fflush(file) != 0) || (fseek(file, 0, SEEK_SET) != 0)) {
+			fclose(file);
+			return iscc_make_error_msg(SCC_ER_NO_MEMORY, "Cannot allocate memory or write temporary file.");
+		}
+
+		*out_spilled = (iscc_SpilledDigraph) {
+			.vertices = dg->vertices,
+			.arcs = iscc_digraph_arcs(dg),
+			.max_row_arcs = max_row_arcs,
+			.sorted_rows = dg->sorted_rows,
+			.file = file,
+		};
+
+		iscc_free_digraph(dg);
+
+		return iscc_no_error();
+	#endif // ifdef SCC_NO_DISK_SPILL
+}
+
+
+scc_ErrorCode iscc_read_spilled_row(iscc_SpilledDigraph* const spilled,
+                                    scc_PointIndex out_row[const],
+                                    size_t* const out_row_arcs)
+{
+	assert(spilled != NULL);
+	assert(spilled->file != NULL);
+	assert(out_row_arcs != NULL);
+
+	uint64_t row_arcs64;
+	if (fread(&row_arcs64, sizeof(uint64_t), 1, spilled->file) != 1) {
+		return iscc_make_error_msg(SCC_ER_UNKNOWN_ERROR, "Cannot read temporary file.");
+	}
+	assert(row_arcs64 <= spilled->max_row_arcs);
+	const size_t row_arcs = (size_t) row_arcs64;
+	if ((row_arcs > 0) && (fread(out_row, sizeof(scc_PointIndex), row_arcs, spilled->file) != row_arcs)) {
+		return iscc_make_error_msg(SCC_ER_UNKNOWN_ERROR, "Cannot read temporary file.");
+	}
+
+	*out_row_arcs = row_arcs;
+
+	return iscc_no_error();
+}
+
+
+scc_ErrorCode iscc_load_spilled_digraph(iscc_SpilledDigraph* const spilled,
+                                        iscc_Digraph* const out_dg)
+{
+	assert(spilled != NULL);
+	assert(spilled->file != NULL);
+	assert(out_dg != NULL);
+
+	scc_ErrorCode ec;
+	if ((ec = iscc_init_digraph(spilled->vertices, spilled->arcs, out_dg)) != SCC_ER_OK) return ec;
+
+	size_t arcs_read = 0;
+	iscc_set_tail_ptr(out_dg, 0, 0);
+	for (size_t v = 0; v < spilled->vertices; ++v) {
+		size_t row_arcs;
+		if ((ec = iscc_read_spilled_row(spilled, out_dg->head + arcs_read, &row_arcs)) != SCC_ER_OK) {
 			iscc_free_digraph(out_dg);
-			return iscc_make_error(SCC_ER_NO_MEMORY);
+			return ec;
 		}
+		arcs_read += row_arcs;
+		iscc_set_tail_ptr(out_dg, (scc_PointIndex) (v + 1), arcs_read);
 	}
+	assert(arcs_read == spilled->arcs);
+	out_dg->sorted_rows = spilled->sorted_rows;
 
-	assert(iscc_digraph_is_initialized(out_dg));
+	iscc_free_spilled_digraph(spilled);
+
+	assert(iscc_digraph_is_valid(out_dg));
 
 	return iscc_no_error();
 }
 
 
-scc_ErrorCode iscc_empty_digraph(const size_t vertices,
-                                 const uintmax_t max_arcs,
-                                 iscc_Digraph* const out_dg)
+scc_ErrorCode iscc_rewind_spilled_digraph(iscc_SpilledDigraph* const spilled)
+{
+	assert(spilled != NULL);
+	assert(spilled->file != NULL);
+
+	if (fseek(spilled->file, 0, SEEK_SET) != 0) {
+		return iscc_make_error_msg(SCC_ER_UNKNOWN_ERROR, "Cannot read temporary file.");
+	}
+
+	return iscc_no_error();
+}
+
+
+void iscc_free_spilled_digraph(iscc_SpilledDigraph* const spilled)
+{
+	if (spilled != NULL) {
+		if (spilled->file != NULL) fclose(spilled->file);
+		*spilled = ISCC_NULL_SPILLED_DIGRAPH;
+	}
+}
+
+
+// =============================================================================
+// Static function implementations
+// =============================================================================
+
+static scc_ErrorCode iscc_alloc_digraph(const size_t vertices,
+                                        const uintmax_t max_arcs,
+                                        const bool zero_tail_ptr,
+                                        iscc_Digraph* const out_dg)
 {
 	assert(vertices > 0);
 	assert(vertices <= ISCC_POINTINDEX_MAX);
 	assert(vertices < SIZE_MAX);
 	assert(out_dg != NULL);
 	if ((max_arcs > ISCC_ARCINDEX_MAX) || (max_arcs > SIZE_MAX)) {
-		return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many arcs in graph (adjust the `iscc_ArcIndex` type).");
+		return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many arcs in graph.");
 	}
 
 	*out_dg = (iscc_Digraph) {
 		.vertices = vertices,
 		.max_arcs = (size_t) max_arcs,
 		.head = NULL,
-		.tail_ptr = calloc(vertices + 1, sizeof(iscc_ArcIndex)),
+		.tail_ptr32 = NULL,
+		.tail_ptr64 = NULL,
+		.sorted_rows = false,
 	};
-	if (out_dg->tail_ptr == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+
+	if (max_arcs > ISCC_ARCINDEX32_MAX) {
+		if (zero_tail_ptr) {
+			out_dg->tail_ptr64 = iscc_calloc(vertices + 1, sizeof(iscc_ArcIndex64));
+		} else {
+			out_dg->tail_ptr64 = iscc_malloc(sizeof(iscc_ArcIndex64[vertices + 1]));
+		}
+		if (out_dg->tail_ptr64 == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+	} else {
+		if (zero_tail_ptr) {
+			out_dg->tail_ptr32 = iscc_calloc(vertices + 1, sizeof(iscc_ArcIndex32));
+		} else {
+			out_dg->tail_ptr32 = iscc_malloc(sizeof(iscc_ArcIndex32[vertices + 1]));
+		}
+		if (out_dg->tail_ptr32 == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
 
 	if (max_arcs > 0) {
-		out_dg->head = malloc(sizeof(scc_PointIndex[max_arcs]));
+		out_dg->head = iscc_malloc(sizeof(scc_PointIndex[max_arcs]));
 		if (out_dg->head == NULL) {
 			iscc_free_digraph(out_dg);
 			return iscc_make_error(SCC_ER_NO_MEMORY);
 		}
 	}
 
-	assert(iscc_digraph_is_valid(out_dg));
-
 	return iscc_no_error();
 }
 
 
-scc_ErrorCode iscc_change_arc_storage(iscc_Digraph* const dg,
-                                      const uintmax_t new_max_arcs)
+static scc_ErrorCode iscc_change_tail_ptr_width(iscc_Digraph* const dg,
+                                                const bool arc64)
 {
 	assert(iscc_digraph_is_initialized(dg));
-	assert(dg->tail_ptr[dg->vertices] <= new_max_arcs);
-	if ((new_max_arcs > ISCC_ARCINDEX_MAX) || (new_max_arcs > SIZE_MAX)) {
-		return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many arcs in graph (adjust the `iscc_ArcIndex` type).");
-	}
-	if (dg->max_arcs == new_max_arcs) return iscc_no_error();
+	assert(arc64 == (dg->tail_ptr64 == NULL));
 
-	if (new_max_arcs == 0) {
-		free(dg->head);
-		dg->head = NULL;
-		dg->max_arcs = 0;
+	const size_t len_tail_ptr = dg->vertices + 1;
+	if (arc64) {
+		iscc_ArcIndex64* const tmp_ptr = iscc_malloc(sizeof(iscc_ArcIndex64[len_tail_ptr]));
+		if (tmp_ptr == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+		for (size_t v = 0; v < len_tail_ptr; ++v) {
+			tmp_ptr[v] = dg->tail_ptr32[v];
+		}
+		iscc_free(dg->tail_ptr32);
+		dg->tail_ptr32 = NULL;
+		dg->tail_ptr64 = tmp_ptr;
 	} else {
-		scc_PointIndex* const tmp_ptr = realloc(dg->head, sizeof(scc_PointIndex[new_max_arcs]));
+		assert(dg->tail_ptr64[dg->vertices] <= ISCC_ARCINDEX32_MAX);
+		iscc_ArcIndex32* const tmp_ptr = iscc_malloc(sizeof(iscc_ArcIndex32[len_tail_ptr]));
 		if (tmp_ptr == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
-		dg->head = tmp_ptr;
-		dg->max_arcs = (size_t) new_max_arcs;
+		for (size_t v = 0; v < len_tail_ptr; ++v) {
+			tmp_ptr[v] = (iscc_ArcIndex32) dg->tail_ptr64[v];
+		}
+		iscc_free(dg->tail_ptr64);
+		dg->tail_ptr64 = NULL;
+		dg->tail_ptr32 = tmp_ptr;
 	}
 
 	return iscc_no_error();
@@ -32,6 +32,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 #include "../include/scclust.h"
 #include "scclust_types.h"
 
@@ -43,12 +44,12 @@
 /** Main digraph struct stored as sparse matrix.
  *
  *  Stores the digraph in Yale sparse matrix format. For any vertex `i` in the digraph,
- *  `#tail_ptr[i]` indicates the arc index in #head of the first arc for which `i` is the tail, and `#tail_ptr[i+1]-1`
- *  indicates the last arc. If `#tail_ptr[i] == #tail_ptr[i+1]`, there exists no arc for which `i` is the tail.
- *  Thus if `i` is a tail for at least one arc, `#head[#tail_ptr[i]]` is the head of the first arc for which
- *  `i` is the tail, and `#head[#tail_ptr[i+1]-1]` is the last.
+ *  `tail_ptr[i]` indicates the arc index in #head of the first arc for which `i` is the tail, and `tail_ptr[i+1]-1`
+ *  indicates the last arc. If `tail_ptr[i] == tail_ptr[i+1]`, there exists no arc for which `i` is the tail.
+ *  Thus if `i` is a tail for at least one arc, `#head[tail_ptr[i]]` is the head of the first arc for which
+ *  `i` is the tail, and `#head[tail_ptr[i+1]-1]` is the last.
  *
- *  In other words, if there is an arc `i` -> `j`, there exists some `k` such that `#tail_ptr[i] <= k < #tail_ptr[i+1]` and `#head[k]==j`.
+ *  In other words, if there is an arc `i` -> `j`, there exists some `k` such that `tail_ptr[i] <= k < tail_ptr[i+1]` and `#head[k]==j`.
  */
 typedef struct iscc_Digraph {
 	/** Number of vertices in the digraph. May not be greater than `ISCC_POINTINDEX_MAX`.
@@ -71,12 +72,28 @@ typedef struct iscc_Digraph {
 
 	/** Array of arc indices indicating arcs for which a vertex is the tail.
 	 *
-	 *  #tail_ptr may never be `NULL` and must point a memory area of length `#vertices + 1`.
+	 *  The tail pointers are stored either in #tail_ptr32 or in #tail_ptr64. The width
+	 *  is chosen when the digraph is allocated: if #max_arcs fits in #iscc_ArcIndex32,
+	 *  #tail_ptr32 is used and #tail_ptr64 is `NULL`, otherwise the reverse. Use
+	 *  #iscc_get_tail_ptr and #iscc_set_tail_ptr to access the array.
 	 *
-	 *  The first element of #tail_ptr must be zero (`#tail_ptr[0] == 0`). For all `i < #vertices`,
-	 *  we must have `#tail_ptr[i] <= #tail_ptr[i+1] <= #max_arcs`.
+	 *  The used array may never be `NULL` and must point a memory area of length `#vertices + 1`.
+	 *
+	 *  The first element of the array must be zero (`tail_ptr[0] == 0`). For all `i < #vertices`,
+	 *  we must have `tail_ptr[i] <= tail_ptr[i+1] <= #max_arcs`.
+	 */
+	iscc_ArcIndex32* tail_ptr32;
+
+	/// 64-bit tail pointers, used when #max_arcs does not fit in #iscc_ArcIndex32.
+	iscc_ArcIndex64* tail_ptr64;
+
+	/** Indicates that the heads of each vertex's arcs are stored in increasing order.
+	 *
+	 *  The flag is a promise, not a requirement: digraphs are valid with unsorted rows, and
+	 *  functions that cannot guarantee the order leave the flag unset. Set-like operations
+	 *  use it to merge rows sequentially instead of marking heads in a vertex-sized array.
 	 */
-	iscc_ArcIndex* tail_ptr;
+	bool sorted_rows;
 } iscc_Digraph;
 
 
@@ -84,7 +101,95 @@ typedef struct iscc_Digraph {
  *
  *  The null digraph is an easily detectable invalid digraph.
  */
-static const iscc_Digraph ISCC_NULL_DIGRAPH = { 0, 0, NULL, NULL };
+static const iscc_Digraph ISCC_NULL_DIGRAPH = { 0, 0, NULL, NULL, NULL, false };
+
+
+/** Digraph stored in a temporary file.
+ *
+ *  Digraphs are spilled to disk when memory runs out while other digraphs are derived.
+ *  The file holds the rows in vertex order, each row as its number of arcs (as `uint64_t`)
+ *  followed by its heads, so the rows can be read back sequentially one at a time.
+ */
+typedef struct iscc_SpilledDigraph {
+	/// Number of vertices in the digraph.
+	size_t vertices;
+
+	/// Number of arcs in the digraph.
+	size_t arcs;
+
+	/// Largest number of arcs in any row.
+	size_t max_row_arcs;
+
+	/// The spilled digraph's scc_Digraph::sorted_rows.
+	bool sorted_rows;
+
+	/// Temporary file holding the rows. `NULL` if nothing is spilled.
+	FILE* file;
+} iscc_SpilledDigraph;
+
+
+/// The null spilled digraph.
+static const iscc_SpilledDigraph ISCC_NULL_SPILLED_DIGRAPH = { 0, 0, 0, false, NULL };
+
+
+// =============================================================================
+// Inline functions
+// =============================================================================
+
+/** Get tail pointer.
+ *
+ *  \param[in] dg digraph to read from.
+ *  \param     v vertex, may be `dg->vertices`.
+ *
+ *  \return index in scc_Digraph::head of the first arc for which \p v is the tail.
+ */
+static inline size_t iscc_get_tail_ptr(const iscc_Digraph* const dg,
+                                       const scc_PointIndex v)
+{
+	if (dg->tail_ptr32 != NULL) return (size_t) dg->tail_ptr32[v];
+	return (size_t) dg->tail_ptr64[v];
+}
+
+
+/** Set tail pointer.
+ *
+ *  \param[in,out] dg digraph to write to.
+ *  \param         v vertex, may be `dg->vertices`.
+ *  \param         arc_index new tail pointer of \p v. Must be less or equal to scc_Digraph::max_arcs.
+ */
+static inline void iscc_set_tail_ptr(iscc_Digraph* const dg,
+                                     const scc_PointIndex v,
+                                     const size_t arc_index)
+{
+	if (dg->tail_ptr32 != NULL) {
+		dg->tail_ptr32[v] = (iscc_ArcIndex32) arc_index;
+	} else {
+		dg->tail_ptr64[v] = (iscc_ArcIndex64) arc_index;
+	}
+}
+
+
+/// First arc for which \p v is the tail.
+static inline scc_PointIndex* iscc_arc_start(const iscc_Digraph* const dg,
+                                             const scc_PointIndex v)
+{
+	return dg->head + iscc_get_tail_ptr(dg, v);
+}
+
+
+/// One past the last arc for which \p v is the tail.
+static inline scc_PointIndex* iscc_arc_stop(const iscc_Digraph* const dg,
+                                            const scc_PointIndex v)
+{
+	return dg->head + iscc_get_tail_ptr(dg, v + 1);
+}
+
+
+/// Number of arcs in \p dg.
+static inline size_t iscc_digraph_arcs(const iscc_Digraph* const dg)
+{
+	return iscc_get_tail_ptr(dg, (scc_PointIndex) dg->vertices);
+}
 
 
 // =============================================================================
@@ -102,8 +207,8 @@ void iscc_free_digraph(iscc_Digraph* dg);
 
 /** Checks whether provided digraph is initialized.
  *
- *  This function returns \c true if \p dg is initialized. That is, scc_Digraph::tail_ptr
- *  and scc_Digraph::head are allocated. If scc_Digraph::max_arcs is zero, it checks so
+ *  This function returns \c true if \p dg is initialized. That is, exactly one of
+ *  scc_Digraph::tail_ptr32 and scc_Digraph::tail_ptr64 is allocated and scc_Digraph::head is allocated. If scc_Digraph::max_arcs is zero, it checks so
  *  scc_Digraph::head is \c NULL.
  *
  *  \param[in] dg digraph to check.
@@ -145,8 +250,9 @@ bool iscc_digraph_is_empty(const iscc_Digraph* dg);
 /** Generic constructor for digraphs.
  *
  *  Initializes and allocates memory for specified digraph. The memory spaces
- *  (i.e., scc_Digraph::head and scc_Digraph::tail_ptr) are uninitialized, thus
- *  the produced digraph is in general invalid.
+ *  (i.e., scc_Digraph::head and the tail pointers) are uninitialized, thus
+ *  the produced digraph is in general invalid. The width of the tail pointers
+ *  is chosen from \p max_arcs.
  *
  *  \param vertices number of vertices that can be represented in the digraph.å
  *  \param max_arcs memory space to be allocated for arcs.
@@ -159,7 +265,7 @@ scc_ErrorCode iscc_init_digraph(size_t vertices,
 
 /** Construct an empty digraph.
  *
- *  This function returns a digraph where all elements of scc_Digraph::tail_ptr are set to `0`.
+ *  This function returns a digraph where all tail pointers are set to `0`.
  *  The memory space pointed to by scc_Digraph::head is left uninitialized.
  *
  *  \param vertices number of vertices that can be represented in the digraph.
@@ -176,6 +282,7 @@ scc_ErrorCode iscc_empty_digraph(size_t vertices,
  *  Increases or decreases the memory space for arcs in \p dg to fit exactly \p new_max_arcs arcs.
  *  Requires that the number of arcs in \p dg is less or equally to \p new_max_arcs.
  *  If `new_max_arcs == 0`, the memory space is deallocated and scc_Digraph::head is set to `NULL`.
+ *  The tail pointers are converted to the width that fits \p new_max_arcs.
  *
  *  \param[in,out] dg digraph to reallocate arc memory for.
  *  \param         new_max_arcs new size of memory.
@@ -184,4 +291,55 @@ scc_ErrorCode iscc_change_arc_storage(iscc_Digraph* dg,
                                       uintmax_t new_max_arcs);
 
 
+/** Moves a digraph to a temporary file.
+ *
+ *  Writes the rows of \p dg to a temporary file and frees \p dg. If the file
+ *  cannot be written, \p dg is left untouched.
+ *
+ *  \param[in,out] dg digraph to spill. Set to #ISCC_NULL_DIGRAPH on success.
+ *  \param[out]    out_spilled the spilled digraph, positioned at its first row.
+ *
+ *  \note Spilling is disabled when compiled with `SCC_NO_DISK_SPILL`, in which case
+ *        #SCC_ER_NO_MEMORY is returned.
+ */
+scc_ErrorCode iscc_spill_digraph(iscc_Digraph* dg,
+                                 iscc_SpilledDigraph* out_spilled);
+
+
+/** Reads the next row of a spilled digraph.
+ *
+ *  \param[in,out] spilled digraph to read from.
+ *  \param[out]    out_row buffer for the heads. Must be of length scc_SpilledDigraph::max_row_arcs.
+ *  \param[out]    out_row_arcs number of arcs written to \p out_row.
+ */
+scc_ErrorCode iscc_read_spilled_row(iscc_SpilledDigraph* spilled,
+                                    scc_PointIndex out_row[],
+                                    size_t* out_row_arcs);
+
+
+/** Moves a spilled digraph back to memory.
+ *
+ *  \param[in,out] spilled digraph to load. Must be positioned at its first row. Freed on success.
+ *  \param[out]    out_dg the loaded digraph.
+ */
+scc_ErrorCode iscc_load_spilled_digraph(iscc_SpilledDigraph* spilled,
+                                        iscc_Digraph* out_dg);
+
+
+/** Rewinds a spilled digraph to its first row.
+ *
+ *  \param[in,out] spilled digraph to rewind.
+ */
+scc_ErrorCode iscc_rewind_spilled_digraph(iscc_SpilledDigraph* spilled);
+
+
+/** Destructor for spilled digraphs.
+ *
+ *  Closes (and thereby deletes) the temporary file.
+ *
+ *  \param[in,out] spilled digraph to destroy. Set to #ISCC_NULL_SPILLED_DIGRAPH.
+ */
+void iscc_free_spilled_digraph(iscc_SpilledDigraph* spilled);
+
+
 #endif // ifndef SCC_DIGRAPH_CORE_HG
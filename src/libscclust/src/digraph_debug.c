@@ -30,6 +30,7 @@
 #include "digraph_core.h"
 #include "error.h"
 #include "scclust_types.h"
+#include "workspace.h"
 
 
 // =============================================================================
@@ -42,7 +43,7 @@ bool iscc_is_balanced_digraph(const iscc_Digraph* const dg,
 	if (!iscc_digraph_is_valid(dg)) return false;
 
 	for (size_t i = 0; i <= dg->vertices; ++i) {
-		if (dg->tail_ptr[i] != i * arcs_per_vertex) return false;
+		if (iscc_get_tail_ptr(dg, (scc_PointIndex) i) != i * arcs_per_vertex) return false;
 	}
 
 	return true;
@@ -55,22 +56,22 @@ bool iscc_digraphs_equal(const iscc_Digraph* const dg_a,
 	assert(iscc_digraph_is_valid(dg_a));
 	assert(iscc_digraph_is_valid(dg_b));
 	if (dg_a->vertices != dg_b->vertices) return false;
-	if ((dg_a->tail_ptr[dg_a->vertices] == 0) && (dg_b->tail_ptr[dg_b->vertices] == 0)) return true;
+	if (iscc_digraph_is_empty(dg_a) && iscc_digraph_is_empty(dg_b)) return true;
 
-	int_fast8_t* const single_row = calloc(dg_a->vertices, sizeof(int_fast8_t));
+	int_fast8_t* const single_row = iscc_calloc(dg_a->vertices, sizeof(int_fast8_t));
 
 	for (size_t v = 0; v < dg_a->vertices; ++v) {
-		const scc_PointIndex* const arc_a_stop = dg_a->head + dg_a->tail_ptr[v + 1];
-		for (const scc_PointIndex* arc_a = dg_a->head + dg_a->tail_ptr[v];
+		const scc_PointIndex* const arc_a_stop = iscc_arc_stop(dg_a, (scc_PointIndex) v);
+		for (const scc_PointIndex* arc_a = iscc_arc_start(dg_a, (scc_PointIndex) v);
 		        arc_a != arc_a_stop; ++arc_a) {
 			single_row[*arc_a] = 1;
 		}
 
-		const scc_PointIndex* const arc_b_stop = dg_b->head + dg_b->tail_ptr[v + 1];
-		for (const scc_PointIndex* arc_b = dg_b->head + dg_b->tail_ptr[v];
+		const scc_PointIndex* const arc_b_stop = iscc_arc_stop(dg_b, (scc_PointIndex) v);
+		for (const scc_PointIndex* arc_b = iscc_arc_start(dg_b, (scc_PointIndex) v);
 		        arc_b != arc_b_stop; ++arc_b) {
 			if (single_row[*arc_b] == 0) {
-				free(single_row);
+				iscc_free(single_row);
 				return false;
 			}
 			single_row[*arc_b] = 2;
@@ -78,14 +79,14 @@ bool iscc_digraphs_equal(const iscc_Digraph* const dg_a,
 
 		for (size_t i = 0; i < dg_a->vertices; ++i) {
 			if (single_row[i] == 1) {
-				free(single_row);
+				iscc_free(single_row);
 				return false;
 			}
 			single_row[i] = 0;
 		}
 	}
 
-	free(single_row);
+	iscc_free(single_row);
 
 	return true;
 }
@@ -109,7 +110,9 @@ scc_ErrorCode iscc_digraph_from_pieces(const size_t vertices,
 	scc_ErrorCode ec;
 	if ((ec = iscc_init_digraph(vertices, max_arcs, out_dg)) != SCC_ER_OK) return ec;
 
-	memcpy(out_dg->tail_ptr, tail_ptr, (vertices + 1) * sizeof(iscc_ArcIndex));
+	for (size_t v = 0; v <= vertices; ++v) {
+		iscc_set_tail_ptr(out_dg, (scc_PointIndex) v, (size_t) tail_ptr[v]);
+	}
 	memcpy(out_dg->head, head, max_arcs * sizeof(scc_PointIndex));
 
 	return iscc_no_error();
@@ -141,7 +144,7 @@ scc_ErrorCode iscc_digraph_from_string(const char dg_str[const],
 	iscc_ArcIndex curr_array_pos = 0;
 	size_t curr_row = 0;
 	scc_PointIndex curr_col = 0;
-	out_dg->tail_ptr[0] = 0;
+	iscc_set_tail_ptr(out_dg, 0, 0);
 
 	for (size_t c = 0; dg_str[c] != '\0'; ++c) {
 		if (dg_str[c] == '#') {
@@ -152,10 +155,10 @@ scc_ErrorCode iscc_digraph_from_string(const char dg_str[const],
 		if (dg_str[c] == '/') {
 			++curr_row;
 			curr_col = 0;
-			out_dg->tail_ptr[curr_row] = curr_array_pos;
+			iscc_set_tail_ptr(out_dg, (scc_PointIndex) curr_row, (size_t) curr_array_pos);
 		}
 	}
-	out_dg->tail_ptr[vertices] = curr_array_pos;
+	iscc_set_tail_ptr(out_dg, (scc_PointIndex) vertices, (size_t) curr_array_pos);
 
 	assert(iscc_digraph_is_valid(out_dg));
 
@@ -172,11 +175,13 @@ scc_ErrorCode iscc_copy_digraph(const iscc_Digraph* const in_dg,
 	if (in_dg->vertices == 0) return iscc_empty_digraph(0, 0, out_dg);
 
 	const size_t num_vertices = in_dg->vertices;
-	const uintmax_t num_arcs = in_dg->tail_ptr[in_dg->vertices];
+	const uintmax_t num_arcs = iscc_digraph_arcs(in_dg);
 
 	if ((ec = iscc_init_digraph(num_vertices, num_arcs, out_dg)) != SCC_ER_OK) return ec;
 
-	memcpy(out_dg->tail_ptr, in_dg->tail_ptr, (num_vertices + 1) * sizeof(iscc_ArcIndex));
+	for (size_t v = 0; v <= num_vertices; ++v) {
+		iscc_set_tail_ptr(out_dg, (scc_PointIndex) v, iscc_get_tail_ptr(in_dg, (scc_PointIndex) v));
+	}
 	if (num_arcs > 0) {
 		memcpy(out_dg->head, in_dg->head, num_arcs * sizeof(scc_PointIndex));
 	}
@@ -194,15 +199,15 @@ void iscc_print_digraph(const iscc_Digraph* const dg)
 		return;
 	}
 
-	bool* const single_row = calloc(dg->vertices, sizeof(bool));
+	bool* const single_row = iscc_calloc(dg->vertices, sizeof(bool));
 	if (single_row == NULL) {
 		printf("Out of memory.\n\n");
 		return;
 	}
 
 	for (size_t v = 0; v < dg->vertices; ++v) {
-		const scc_PointIndex* const a_stop = dg->head + dg->tail_ptr[v + 1];
-		for (const scc_PointIndex* a = dg->head + dg->tail_ptr[v];
+		const scc_PointIndex* const a_stop = iscc_arc_stop(dg, (scc_PointIndex) v);
+		for (const scc_PointIndex* a = iscc_arc_start(dg, (scc_PointIndex) v);
 		        a != a_stop; ++a) {
 			single_row[*a] = true;
 		}
@@ -220,5 +225,5 @@ void iscc_print_digraph(const iscc_Digraph* const dg)
 	}
 	putchar('\n');
 
-	free(single_row);
+	iscc_free(single_row);
 }
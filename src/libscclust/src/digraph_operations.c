@@ -28,6 +28,24 @@
 #include "digraph_core.h"
 #include "error.h"
 #include "scclust_types.h"
+#include "utilities.h"
+#include "workspace.h"
+
+#ifdef _OPENMP
+	#include <omp.h>
+#endif
+
+
+// =============================================================================
+// Internal variables
+// =============================================================================
+
+#ifdef _OPENMP
+
+/// Smallest digraph for which transposes are derived in parallel.
+static const size_t ISCC_PARALLEL_DIGRAPH_MIN_VERTICES = 10000;
+
+#endif // ifdef _OPENMP
 
 
 // =============================================================================
@@ -41,8 +59,42 @@ static inline uintmax_t iscc_do_union_and_delete(uint_fast16_t num_dgs,
                                                  const scc_PointIndex tails_to_keep[restrict],
                                                  bool keep_self_loops,
                                                  bool write,
-                                                 iscc_ArcIndex out_tail_ptr[restrict],
-                                                 scc_PointIndex out_head[restrict]);
+                                                 iscc_Digraph* out_dg);
+
+
+static scc_ErrorCode iscc_do_union_and_delete_spilled(uint_fast16_t num_dgs,
+                                                      iscc_SpilledDigraph dgs[restrict static num_dgs],
+                                                      scc_PointIndex* const rows[restrict],
+                                                      scc_PointIndex row_markers[restrict],
+                                                      size_t len_tails_to_keep,
+                                                      const scc_PointIndex tails_to_keep[restrict],
+                                                      bool keep_self_loops,
+                                                      bool write,
+                                                      iscc_Digraph* out_dg,
+                                                      uintmax_t* out_arcs);
+
+
+static inline uintmax_t iscc_do_union_and_delete_sorted(uint_fast16_t num_dgs,
+                                                        const iscc_Digraph dgs[restrict static num_dgs],
+                                                        const scc_PointIndex* row_cursors[restrict],
+                                                        size_t len_tails_to_keep,
+                                                        const scc_PointIndex tails_to_keep[restrict],
+                                                        bool keep_self_loops,
+                                                        bool write,
+                                                        iscc_Digraph* out_dg);
+
+
+static inline size_t iscc_do_merge_rows(uint_fast16_t num_dgs,
+                                        const iscc_Digraph dgs[restrict static num_dgs],
+                                        scc_PointIndex v,
+                                        const scc_PointIndex* row_cursors[restrict],
+                                        bool keep_self_loops,
+                                        scc_PointIndex out_row[restrict]);
+
+
+static inline bool iscc_sorted_row_contains(const scc_PointIndex* row_start,
+                                            const scc_PointIndex* row_stop,
+                                            scc_PointIndex value);
 
 
 static inline uintmax_t iscc_do_adjacency_product(const iscc_Digraph* dg_a,
@@ -50,8 +102,15 @@ static inline uintmax_t iscc_do_adjacency_product(const iscc_Digraph* dg_a,
                                                   scc_PointIndex row_markers[restrict],
                                                   bool force_loops,
                                                   bool write,
-                                                  iscc_ArcIndex out_tail_ptr[restrict],
-                                                  scc_PointIndex out_head[restrict]);
+                                                  iscc_Digraph* out_dg);
+
+
+#ifdef _OPENMP
+
+static scc_ErrorCode iscc_digraph_transpose_parallel(const iscc_Digraph* in_dg,
+                                                     iscc_Digraph* out_dg);
+
+#endif // ifdef _OPENMP
 
 
 // =============================================================================
@@ -65,13 +124,13 @@ scc_ErrorCode iscc_delete_loops(iscc_Digraph* const dg)
 	if (iscc_digraph_is_empty(dg)) return iscc_no_error();
 	assert(dg->head != NULL);
 
-	iscc_ArcIndex head_write = 0;
+	size_t head_write = 0;
 	assert(dg->vertices <= ISCC_POINTINDEX_MAX);
 	const scc_PointIndex vertices = (scc_PointIndex) dg->vertices; // If `scc_PointIndex` is signed
 	for (scc_PointIndex v = 0; v < vertices; ++v) {
-		const scc_PointIndex* v_arc = dg->head + dg->tail_ptr[v];
-		const scc_PointIndex* const v_arc_stop = dg->head + dg->tail_ptr[v + 1];
-		dg->tail_ptr[v] = head_write;
+		const scc_PointIndex* v_arc = iscc_arc_start(dg, v);
+		const scc_PointIndex* const v_arc_stop = iscc_arc_stop(dg, v);
+		iscc_set_tail_ptr(dg, v, head_write);
 
 		for (; v_arc != v_arc_stop; ++v_arc) {
 			if (*v_arc != v) {
@@ -80,7 +139,7 @@ scc_ErrorCode iscc_delete_loops(iscc_Digraph* const dg)
 			}
 		}
 	}
-	dg->tail_ptr[vertices] = head_write;
+	iscc_set_tail_ptr(dg, vertices, head_write);
 
 	return iscc_change_arc_storage(dg, head_write);
 }
@@ -102,14 +161,25 @@ scc_ErrorCode iscc_digraph_union_and_delete(const uint_fast16_t num_in_dgs,
 
 	// Try greedy memory count first
 	uintmax_t out_arcs_write = 0;
+	bool sorted_rows = true;
 	for (uint_fast16_t i = 0; i < num_in_dgs; ++i) {
 		assert(iscc_digraph_is_valid(&in_dgs[i]));
 		assert(in_dgs[i].vertices == vertices);
-		out_arcs_write += in_dgs[i].tail_ptr[vertices];
+		out_arcs_write += iscc_digraph_arcs(&in_dgs[i]);
+		sorted_rows = sorted_rows && in_dgs[i].sorted_rows;
 	}
 
-	scc_PointIndex* const row_markers = malloc(sizeof(scc_PointIndex[vertices]));
-	if (row_markers == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+	// When all rows are sorted, they are merged using one cursor per input digraph
+	// instead of marking heads in an array with one element per vertex
+	scc_PointIndex* row_markers = NULL;
+	const scc_PointIndex** row_cursors = NULL;
+	if (sorted_rows) {
+		row_cursors = iscc_malloc(sizeof(const scc_PointIndex*[num_in_dgs]));
+		if (row_cursors == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+	} else {
+		row_markers = iscc_malloc(sizeof(scc_PointIndex[vertices]));
+		if (row_markers == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
 
 	scc_ErrorCode ec;
 	if (iscc_init_digraph(vertices, out_arcs_write, out_dg) != SCC_ER_OK) {
@@ -118,28 +188,120 @@ scc_ErrorCode iscc_digraph_union_and_delete(const uint_fast16_t num_in_dgs,
 		// union without writing.
 		iscc_reset_error();
 
-		out_arcs_write = iscc_do_union_and_delete(num_in_dgs, in_dgs,
-		                                          row_markers, len_tails_to_keep, tails_to_keep,
-		                                          keep_self_loops, false, NULL, NULL);
+		if (sorted_rows) {
+			out_arcs_write = iscc_do_union_and_delete_sorted(num_in_dgs, in_dgs,
+			                                                 row_cursors, len_tails_to_keep, tails_to_keep,
+			                                                 keep_self_loops, false, NULL);
+		} else {
+			out_arcs_write = iscc_do_union_and_delete(num_in_dgs, in_dgs,
+			                                          row_markers, len_tails_to_keep, tails_to_keep,
+			                                          keep_self_loops, false, NULL);
+		}
 
 		// Try again. If fail, give up.
 		if ((ec = iscc_init_digraph(vertices, out_arcs_write, out_dg)) != SCC_ER_OK) {
-			free(row_markers);
+			iscc_free(row_markers);
+			iscc_free(row_cursors);
 			return ec;
 		}
 	}
 
-	out_arcs_write = iscc_do_union_and_delete(num_in_dgs, in_dgs,
-	                                          row_markers, len_tails_to_keep, tails_to_keep,
-	                                          keep_self_loops, true, out_dg->tail_ptr, out_dg->head);
+	if (sorted_rows) {
+		out_arcs_write = iscc_do_union_and_delete_sorted(num_in_dgs, in_dgs,
+		                                                 row_cursors, len_tails_to_keep, tails_to_keep,
+		                                                 keep_self_loops, true, out_dg);
+	} else {
+		out_arcs_write = iscc_do_union_and_delete(num_in_dgs, in_dgs,
+		                                          row_markers, len_tails_to_keep, tails_to_keep,
+		                                          keep_self_loops, true, out_dg);
+	}
 
-	free(row_markers);
+	iscc_free(row_markers);
+	iscc_free(row_cursors);
 
 	if ((ec = iscc_change_arc_storage(out_dg, out_arcs_write)) != SCC_ER_OK) {
 		iscc_free_digraph(out_dg);
 		return ec;
 	}
 
+	out_dg->sorted_rows = sorted_rows;
+
+	return iscc_no_error();
+}
+
+
+scc_ErrorCode iscc_digraph_union_and_delete_spilled(const uint_fast16_t num_in_dgs,
+                                                    iscc_SpilledDigraph in_dgs[const static num_in_dgs],
+                                                    const size_t len_tails_to_keep,
+                                                    const scc_PointIndex tails_to_keep[const],
+                                                    const bool keep_self_loops,
+                                                    iscc_Digraph* const out_dg)
+{
+	assert(num_in_dgs > 0);
+	assert(in_dgs != NULL);
+	assert(out_dg != NULL);
+
+	const size_t vertices = in_dgs[0].vertices;
+
+	uintmax_t out_arcs_write = 0;
+	size_t row_buffer_len = 0;
+	for (uint_fast16_t i = 0; i < num_in_dgs; ++i) {
+		assert(in_dgs[i].file != NULL);
+		assert(in_dgs[i].vertices == vertices);
+		out_arcs_write += in_dgs[i].arcs;
+		row_buffer_len += in_dgs[i].max_row_arcs;
+	}
+
+	// One buffer holds the current row of each input digraph
+	scc_PointIndex* const row_markers = iscc_malloc(sizeof(scc_PointIndex[vertices]));
+	scc_PointIndex* const row_buffer = iscc_malloc(sizeof(scc_PointIndex[row_buffer_len + 1]));
+	scc_PointIndex** const rows = iscc_malloc(sizeof(scc_PointIndex*[num_in_dgs]));
+	if ((row_markers == NULL) || (row_buffer == NULL) || (rows == NULL)) {
+		iscc_free(row_markers);
+		iscc_free(row_buffer);
+		iscc_free(rows);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+	rows[0] = row_buffer;
+	for (uint_fast16_t i = 1; i < num_in_dgs; ++i) {
+		rows[i] = rows[i - 1] + in_dgs[i - 1].max_row_arcs;
+	}
+
+	scc_ErrorCode ec = SCC_ER_OK;
+	if (iscc_init_digraph(vertices, out_arcs_write, out_dg) != SCC_ER_OK) {
+		// Count exactly by reading the rows once without writing
+		iscc_reset_error();
+		ec = iscc_do_union_and_delete_spilled(num_in_dgs, in_dgs, rows, row_markers,
+		                                      len_tails_to_keep, tails_to_keep,
+		                                      keep_self_loops, false, NULL, &out_arcs_write);
+		for (uint_fast16_t i = 0; (ec == SCC_ER_OK) && (i < num_in_dgs); ++i) {
+			ec = iscc_rewind_spilled_digraph(&in_dgs[i]);
+		}
+		if (ec == SCC_ER_OK) ec = iscc_init_digraph(vertices, out_arcs_write, out_dg);
+		if (ec != SCC_ER_OK) {
+			iscc_free(row_markers);
+			iscc_free(row_buffer);
+			iscc_free(rows);
+			return ec;
+		}
+	}
+
+	ec = iscc_do_union_and_delete_spilled(num_in_dgs, in_dgs, rows, row_markers,
+	                                      len_tails_to_keep, tails_to_keep,
+	                                      keep_self_loops, true, out_dg, &out_arcs_write);
+	for (uint_fast16_t i = 0; (ec == SCC_ER_OK) && (i < num_in_dgs); ++i) {
+		ec = iscc_rewind_spilled_digraph(&in_dgs[i]);
+	}
+
+	iscc_free(row_markers);
+	iscc_free(row_buffer);
+	iscc_free(rows);
+
+	if ((ec != SCC_ER_OK) || ((ec = iscc_change_arc_storage(out_dg, out_arcs_write)) != SCC_ER_OK)) {
+		iscc_free_digraph(out_dg);
+		return ec;
+	}
+
 	return iscc_no_error();
 }
 
@@ -152,34 +314,59 @@ scc_ErrorCode iscc_digraph_difference(iscc_Digraph* const minuend_dg,
 	assert(iscc_digraph_is_valid(subtrahend_dg));
 	assert(minuend_dg->vertices > 0);
 	assert(minuend_dg->vertices == subtrahend_dg->vertices);
-	assert((subtrahend_dg->tail_ptr[minuend_dg->vertices] == 0) || (subtrahend_dg->head != NULL));
+	assert(iscc_digraph_is_empty(subtrahend_dg) || (subtrahend_dg->head != NULL));
 	assert(max_out_degree > 0);
 
 	if (iscc_digraph_is_empty(minuend_dg)) return iscc_no_error();
 	assert(minuend_dg->head != NULL);
 
-	scc_PointIndex* const row_markers = malloc(sizeof(scc_PointIndex[minuend_dg->vertices]));
+	uint32_t row_counter;
+	size_t out_arcs_write = 0;
+	assert(minuend_dg->vertices <= ISCC_POINTINDEX_MAX);
+	const scc_PointIndex vertices = (scc_PointIndex) minuend_dg->vertices; // If `scc_PointIndex` is signed
+
+	if (subtrahend_dg->sorted_rows) {
+		// Look up minuend arcs in the sorted subtrahend rows. The minuend
+		// keeps its order, so it may be sorted or in, e.g., distance order.
+		for (scc_PointIndex v = 0; v < vertices; ++v) {
+			const scc_PointIndex* const v_arc_s = iscc_arc_start(subtrahend_dg, v);
+			const scc_PointIndex* const v_arc_s_stop = iscc_arc_stop(subtrahend_dg, v);
+
+			row_counter = 0;
+			const scc_PointIndex* arc_m = iscc_arc_start(minuend_dg, v);
+			const scc_PointIndex* const arc_m_stop = iscc_arc_stop(minuend_dg, v);
+			iscc_set_tail_ptr(minuend_dg, v, out_arcs_write);
+			for (; ((row_counter < max_out_degree) && (arc_m != arc_m_stop)); ++arc_m) {
+				if (!iscc_sorted_row_contains(v_arc_s, v_arc_s_stop, *arc_m)) {
+					minuend_dg->head[out_arcs_write] = *arc_m;
+					++row_counter;
+					++out_arcs_write;
+				}
+			}
+		}
+		iscc_set_tail_ptr(minuend_dg, vertices, out_arcs_write);
+
+		return iscc_change_arc_storage(minuend_dg, out_arcs_write);
+	}
+
+	scc_PointIndex* const row_markers = iscc_malloc(sizeof(scc_PointIndex[minuend_dg->vertices]));
 	if (row_markers == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 
 	for (size_t v = 0; v < minuend_dg->vertices; ++v) {
 		row_markers[v] = ISCC_POINTINDEX_MAX_PI;
 	}
 
-	uint32_t row_counter;
-	iscc_ArcIndex out_arcs_write = 0;
-	assert(minuend_dg->vertices <= ISCC_POINTINDEX_MAX);
-	const scc_PointIndex vertices = (scc_PointIndex) minuend_dg->vertices; // If `scc_PointIndex` is signed
 	for (scc_PointIndex v = 0; v < vertices; ++v) {
-		const scc_PointIndex* const v_arc_s_stop = subtrahend_dg->head + subtrahend_dg->tail_ptr[v + 1];
-		for (const scc_PointIndex* v_arc_s = subtrahend_dg->head + subtrahend_dg->tail_ptr[v];
+		const scc_PointIndex* const v_arc_s_stop = iscc_arc_stop(subtrahend_dg, v);
+		for (const scc_PointIndex* v_arc_s = iscc_arc_start(subtrahend_dg, v);
 		        v_arc_s != v_arc_s_stop; ++v_arc_s) {
 			row_markers[*v_arc_s] = v;
 		}
 
 		row_counter = 0;
-		const scc_PointIndex* arc_m = minuend_dg->head + minuend_dg->tail_ptr[v];
-		const scc_PointIndex* const arc_m_stop = minuend_dg->head + minuend_dg->tail_ptr[v + 1];
-		minuend_dg->tail_ptr[v] = out_arcs_write;
+		const scc_PointIndex* arc_m = iscc_arc_start(minuend_dg, v);
+		const scc_PointIndex* const arc_m_stop = iscc_arc_stop(minuend_dg, v);
+		iscc_set_tail_ptr(minuend_dg, v, out_arcs_write);
 		for (; ((row_counter < max_out_degree) && (arc_m != arc_m_stop)); ++arc_m) {
 			if (row_markers[*arc_m] != v) {
 				minuend_dg->head[out_arcs_write] = *arc_m;
@@ -188,9 +375,9 @@ scc_ErrorCode iscc_digraph_difference(iscc_Digraph* const minuend_dg,
 			}
 		}
 	}
-	minuend_dg->tail_ptr[vertices] = out_arcs_write;
+	iscc_set_tail_ptr(minuend_dg, vertices, out_arcs_write);
 
-	free(row_markers);
+	iscc_free(row_markers);
 
 	return iscc_change_arc_storage(minuend_dg, out_arcs_write);
 }
@@ -204,7 +391,7 @@ scc_ErrorCode iscc_digraph_transpose(const iscc_Digraph* const in_dg,
 	assert(out_dg != NULL);
 
 	scc_ErrorCode ec;
-	if ((ec = iscc_empty_digraph(in_dg->vertices, in_dg->tail_ptr[in_dg->vertices], out_dg)) != SCC_ER_OK) {
+	if ((ec = iscc_empty_digraph(in_dg->vertices, iscc_digraph_arcs(in_dg), out_dg)) != SCC_ER_OK) {
 		return ec;
 	}
 
@@ -212,24 +399,33 @@ scc_ErrorCode iscc_digraph_transpose(const iscc_Digraph* const in_dg,
 	assert(in_dg->head != NULL);
 	assert(out_dg->head != NULL);
 
-	const scc_PointIndex* const arc_c_stop = in_dg->head + in_dg->tail_ptr[in_dg->vertices];
+	#ifdef _OPENMP
+		if ((in_dg->vertices >= ISCC_PARALLEL_DIGRAPH_MIN_VERTICES) && (omp_get_max_threads() > 1)) {
+			if (iscc_digraph_transpose_parallel(in_dg, out_dg) == SCC_ER_OK) return iscc_no_error();
+			// Not enough memory for the counts, do it serially
+			iscc_reset_error();
+		}
+	#endif
+
+	const scc_PointIndex* const arc_c_stop = in_dg->head + iscc_digraph_arcs(in_dg);
 	for (const scc_PointIndex* arc_c = in_dg->head;
 	        arc_c != arc_c_stop; ++arc_c) {
-		++out_dg->tail_ptr[*arc_c];
+		iscc_set_tail_ptr(out_dg, *arc_c, iscc_get_tail_ptr(out_dg, *arc_c) + 1);
 	}
 
 	for (size_t v = 0; v < in_dg->vertices; ++v) {
-		out_dg->tail_ptr[v + 1] += out_dg->tail_ptr[v];
+		iscc_set_tail_ptr(out_dg, (scc_PointIndex) (v + 1), iscc_get_tail_ptr(out_dg, (scc_PointIndex) (v + 1)) + iscc_get_tail_ptr(out_dg, (scc_PointIndex) v));
 	}
 
 	assert(in_dg->vertices <= ISCC_POINTINDEX_MAX);
 	const scc_PointIndex vertices = (scc_PointIndex) in_dg->vertices; // If `scc_PointIndex` is signed
 	for (scc_PointIndex v = 0; v < vertices; ++v) {
-		const scc_PointIndex* const arc_stop = in_dg->head + in_dg->tail_ptr[v + 1];
-		for (const scc_PointIndex* arc = in_dg->head + in_dg->tail_ptr[v];
+		const scc_PointIndex* const arc_stop = iscc_arc_stop(in_dg, v);
+		for (const scc_PointIndex* arc = iscc_arc_start(in_dg, v);
 		        arc != arc_stop; ++arc) {
-			--out_dg->tail_ptr[*arc];
-			out_dg->head[out_dg->tail_ptr[*arc]] = v;
+			const size_t write_pos = iscc_get_tail_ptr(out_dg, *arc) - 1;
+			iscc_set_tail_ptr(out_dg, *arc, write_pos);
+			out_dg->head[write_pos] = v;
 		}
 	}
 
@@ -252,16 +448,16 @@ scc_ErrorCode iscc_adjacency_product(const iscc_Digraph* const in_dg_a,
 
 	const size_t vertices = in_dg_a->vertices;
 
-	scc_PointIndex* const row_markers = malloc(sizeof(scc_PointIndex[vertices]));
+	scc_PointIndex* const row_markers = iscc_malloc(sizeof(scc_PointIndex[vertices]));
 	if (row_markers == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 
 	// Try greedy memory count first
 	uintmax_t out_arcs_write = 0;
-	const scc_PointIndex* const arc_a_stop = in_dg_a->head + in_dg_a->tail_ptr[vertices];
+	const scc_PointIndex* const arc_a_stop = in_dg_a->head + iscc_digraph_arcs(in_dg_a);
 	for (const scc_PointIndex* arc_a = in_dg_a->head; arc_a != arc_a_stop; ++arc_a) {
-		out_arcs_write += in_dg_b->tail_ptr[*arc_a + 1] - in_dg_b->tail_ptr[*arc_a];
+		out_arcs_write += iscc_get_tail_ptr(in_dg_b, *arc_a + 1) - iscc_get_tail_ptr(in_dg_b, *arc_a);
 	}
-	if (force_loops) out_arcs_write += in_dg_b->tail_ptr[vertices];
+	if (force_loops) out_arcs_write += iscc_digraph_arcs(in_dg_b);
 
 	scc_ErrorCode ec;
 	if (iscc_init_digraph(vertices, out_arcs_write, out_dg) != SCC_ER_OK) {
@@ -272,20 +468,20 @@ scc_ErrorCode iscc_adjacency_product(const iscc_Digraph* const in_dg_a,
 
 		out_arcs_write = iscc_do_adjacency_product(in_dg_a, in_dg_b,
 		                                           row_markers, force_loops,
-		                                           false, NULL, NULL);
+		                                           false, NULL);
 
 		// Try again. If fail, give up.
 		if ((ec = iscc_init_digraph(vertices, out_arcs_write, out_dg)) != SCC_ER_OK) {
-			free(row_markers);
+			iscc_free(row_markers);
 			return ec;
 		}
 	}
 
 	out_arcs_write = iscc_do_adjacency_product(in_dg_a, in_dg_b,
 	                                           row_markers, force_loops,
-	                                           true, out_dg->tail_ptr, out_dg->head);
+	                                           true, out_dg);
 
-	free(row_markers);
+	iscc_free(row_markers);
 
 	if ((ec = iscc_change_arc_storage(out_dg, out_arcs_write)) != SCC_ER_OK) {
 		iscc_free_digraph(out_dg);
@@ -296,6 +492,88 @@ scc_ErrorCode iscc_adjacency_product(const iscc_Digraph* const in_dg_a,
 }
 
 
+scc_ErrorCode iscc_digraph_compact(const iscc_Digraph* const in_dg,
+                                   const size_t max_vertices,
+                                   scc_PointIndex** const out_vertex_ids,
+                                   iscc_Digraph* const out_dg)
+{
+	assert(iscc_digraph_is_valid(in_dg));
+	assert(in_dg->vertices > 0);
+	assert(in_dg->vertices <= ISCC_POINTINDEX_MAX);
+	assert(out_vertex_ids != NULL);
+	assert(out_dg != NULL);
+
+	*out_vertex_ids = NULL;
+
+	const size_t vertices = in_dg->vertices;
+	const scc_PointIndex vertices_pi = (scc_PointIndex) vertices; // If `scc_PointIndex` is signed
+
+	// `new_id` first marks vertices to keep, then holds their new IDs
+	scc_PointIndex* const new_id = iscc_calloc(vertices, sizeof(scc_PointIndex));
+	if (new_id == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+
+	const size_t arcs = iscc_digraph_arcs(in_dg);
+	for (size_t i = 0; i < arcs; ++i) {
+		new_id[in_dg->head[i]] = 1;
+	}
+
+	size_t out_vertices = 0;
+	for (scc_PointIndex v = 0; v < vertices_pi; ++v) {
+		if ((new_id[v] != 0) || (iscc_get_tail_ptr(in_dg, v) != iscc_get_tail_ptr(in_dg, v + 1))) {
+			++out_vertices;
+		}
+	}
+
+	if ((out_vertices > max_vertices) || (out_vertices == 0)) {
+		iscc_free(new_id);
+		return iscc_no_error();
+	}
+
+	scc_ErrorCode ec;
+	scc_PointIndex* const vertex_ids = iscc_malloc(sizeof(scc_PointIndex[out_vertices]));
+	if (vertex_ids == NULL) {
+		iscc_free(new_id);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+	if ((ec = iscc_init_digraph(out_vertices, arcs, out_dg)) != SCC_ER_OK) {
+		iscc_free(new_id);
+		iscc_free(vertex_ids);
+		return ec;
+	}
+
+	scc_PointIndex next_id = 0;
+	for (scc_PointIndex v = 0; v < vertices_pi; ++v) {
+		if ((new_id[v] != 0) || (iscc_get_tail_ptr(in_dg, v) != iscc_get_tail_ptr(in_dg, v + 1))) {
+			vertex_ids[next_id] = v;
+			new_id[v] = next_id;
+			++next_id;
+		}
+	}
+	assert(((size_t) next_id) == out_vertices);
+
+	size_t arc_write = 0;
+	for (size_t cv = 0; cv < out_vertices; ++cv) {
+		iscc_set_tail_ptr(out_dg, (scc_PointIndex) cv, arc_write);
+		const scc_PointIndex* const arc_stop = iscc_arc_stop(in_dg, vertex_ids[cv]);
+		for (const scc_PointIndex* arc = iscc_arc_start(in_dg, vertex_ids[cv]);
+		        arc != arc_stop; ++arc) {
+			out_dg->head[arc_write] = new_id[*arc];
+			++arc_write;
+		}
+	}
+	iscc_set_tail_ptr(out_dg, (scc_PointIndex) out_vertices, arc_write);
+	assert(arc_write == arcs);
+	// New IDs are increasing in old IDs so sorted rows stay sorted
+	out_dg->sorted_rows = in_dg->sorted_rows;
+
+	iscc_free(new_id);
+
+	*out_vertex_ids = vertex_ids;
+
+	return iscc_no_error();
+}
+
+
 // =============================================================================
 // Static function implementations
 // =============================================================================
@@ -307,8 +585,7 @@ static inline uintmax_t iscc_do_union_and_delete(const uint_fast16_t num_dgs,
                                                  const scc_PointIndex tails_to_keep[restrict const],
                                                  const bool keep_self_loops,
                                                  const bool write,
-                                                 iscc_ArcIndex out_tail_ptr[restrict const],
-                                                 scc_PointIndex out_head[restrict const])
+                                                 iscc_Digraph* const out_dg)
 {
 	assert(num_dgs > 0);
 	assert(dgs != NULL);
@@ -335,8 +612,8 @@ static inline uintmax_t iscc_do_union_and_delete(const uint_fast16_t num_dgs,
 		for (scc_PointIndex v = 0; v < vertices; ++v) {
 			if (!keep_self_loops) row_markers[v] = v;
 			for (uint_fast16_t i = 0; i < num_dgs; ++i) {
-				const scc_PointIndex* const arc_i_stop = dgs[i].head + dgs[i].tail_ptr[v + 1];
-				for (const scc_PointIndex* arc_i = dgs[i].head + dgs[i].tail_ptr[v];
+				const scc_PointIndex* const arc_i_stop = iscc_arc_stop(&dgs[i], v);
+				for (const scc_PointIndex* arc_i = iscc_arc_start(&dgs[i], v);
 				        arc_i != arc_i_stop; ++arc_i) {
 					if (row_markers[*arc_i] != v) {
 						row_markers[*arc_i] = v;
@@ -350,8 +627,8 @@ static inline uintmax_t iscc_do_union_and_delete(const uint_fast16_t num_dgs,
 		for (size_t v = 0; v < len_tails_to_keep; ++v) {
 			if (!keep_self_loops) row_markers[tails_to_keep[v]] = tails_to_keep[v];
 			for (uint_fast16_t i = 0; i < num_dgs; ++i) {
-				const scc_PointIndex* const arc_i_stop = dgs[i].head + dgs[i].tail_ptr[tails_to_keep[v] + 1];
-				for (const scc_PointIndex* arc_i = dgs[i].head + dgs[i].tail_ptr[tails_to_keep[v]];
+				const scc_PointIndex* const arc_i_stop = iscc_arc_stop(&dgs[i], tails_to_keep[v]);
+				for (const scc_PointIndex* arc_i = iscc_arc_start(&dgs[i], tails_to_keep[v]);
 				        arc_i != arc_i_stop; ++arc_i) {
 					if (row_markers[*arc_i] != tails_to_keep[v]) {
 						row_markers[*arc_i] = tails_to_keep[v];
@@ -362,13 +639,14 @@ static inline uintmax_t iscc_do_union_and_delete(const uint_fast16_t num_dgs,
 		}
 
 	} else if ((tails_to_keep == NULL) && write) {
-		assert(out_tail_ptr != NULL);
-		out_tail_ptr[0] = 0;
+		assert(out_dg != NULL);
+		scc_PointIndex* restrict const out_head = out_dg->head;
+		iscc_set_tail_ptr(out_dg, 0, 0);
 		for (scc_PointIndex v = 0; v < vertices; ++v) {
 			if (!keep_self_loops) row_markers[v] = v;
 			for (uint_fast16_t i = 0; i < num_dgs; ++i) {
-				const scc_PointIndex* const arc_i_stop = dgs[i].head + dgs[i].tail_ptr[v + 1];
-				for (const scc_PointIndex* arc_i = dgs[i].head + dgs[i].tail_ptr[v];
+				const scc_PointIndex* const arc_i_stop = iscc_arc_stop(&dgs[i], v);
+				for (const scc_PointIndex* arc_i = iscc_arc_start(&dgs[i], v);
 				        arc_i != arc_i_stop; ++arc_i) {
 					if (row_markers[*arc_i] != v) {
 						row_markers[*arc_i] = v;
@@ -377,13 +655,14 @@ static inline uintmax_t iscc_do_union_and_delete(const uint_fast16_t num_dgs,
 					}
 				}
 			}
-			out_tail_ptr[v + 1] = (iscc_ArcIndex) counter;
+			iscc_set_tail_ptr(out_dg, v + 1, (size_t) counter);
 			assert((counter == 0) || (out_head != NULL));
 		}
 
 	} else if ((tails_to_keep != NULL) && write) {
-		assert(out_tail_ptr != NULL);
-		out_tail_ptr[0] = 0;
+		assert(out_dg != NULL);
+		scc_PointIndex* restrict const out_head = out_dg->head;
+		iscc_set_tail_ptr(out_dg, 0, 0);
 		const scc_PointIndex* next_tail_to_keep = tails_to_keep;
 		const scc_PointIndex* const stop_tails_to_keep = tails_to_keep + len_tails_to_keep;
 		for (scc_PointIndex v = 0; v < vertices; ++v) {
@@ -391,8 +670,8 @@ static inline uintmax_t iscc_do_union_and_delete(const uint_fast16_t num_dgs,
 				++next_tail_to_keep;
 				if (!keep_self_loops) row_markers[v] = v;
 				for (uint_fast16_t i = 0; i < num_dgs; ++i) {
-					const scc_PointIndex* const arc_i_stop = dgs[i].head + dgs[i].tail_ptr[v + 1];
-					for (const scc_PointIndex* arc_i = dgs[i].head + dgs[i].tail_ptr[v];
+					const scc_PointIndex* const arc_i_stop = iscc_arc_stop(&dgs[i], v);
+					for (const scc_PointIndex* arc_i = iscc_arc_start(&dgs[i], v);
 					        arc_i != arc_i_stop; ++arc_i) {
 						if (row_markers[*arc_i] != v) {
 							row_markers[*arc_i] = v;
@@ -402,7 +681,7 @@ static inline uintmax_t iscc_do_union_and_delete(const uint_fast16_t num_dgs,
 					}
 				}
 			}
-			out_tail_ptr[v + 1] = (iscc_ArcIndex) counter;
+			iscc_set_tail_ptr(out_dg, v + 1, (size_t) counter);
 			assert((counter == 0) || (out_head != NULL));
 		}
 	}
@@ -411,13 +690,200 @@ static inline uintmax_t iscc_do_union_and_delete(const uint_fast16_t num_dgs,
 }
 
 
+static scc_ErrorCode iscc_do_union_and_delete_spilled(const uint_fast16_t num_dgs,
+                                                      iscc_SpilledDigraph dgs[restrict const static num_dgs],
+                                                      scc_PointIndex* const rows[restrict const],
+                                                      scc_PointIndex row_markers[restrict const],
+                                                      const size_t len_tails_to_keep,
+                                                      const scc_PointIndex tails_to_keep[restrict const],
+                                                      const bool keep_self_loops,
+                                                      const bool write,
+                                                      iscc_Digraph* const out_dg,
+                                                      uintmax_t* const out_arcs)
+{
+	assert(num_dgs > 0);
+	assert(dgs != NULL);
+	assert(dgs[0].vertices > 0);
+	assert(rows != NULL);
+	assert(row_markers != NULL);
+	assert(!write || (out_dg != NULL));
+	assert(out_arcs != NULL);
+
+	uintmax_t counter = 0;
+	assert(dgs->vertices <= ISCC_POINTINDEX_MAX);
+	const scc_PointIndex vertices = (scc_PointIndex) dgs->vertices; // If `scc_PointIndex` is signed
+
+	for (scc_PointIndex v = 0; v < vertices; ++v) {
+		row_markers[v] = ISCC_POINTINDEX_MAX_PI;
+	}
+
+	// Rows must be read in order, so `tails_to_keep` is traversed in step with the vertices
+	scc_ErrorCode ec;
+	size_t row_arcs;
+	const scc_PointIndex* next_tail_to_keep = tails_to_keep;
+	const scc_PointIndex* const stop_tails_to_keep = tails_to_keep + len_tails_to_keep;
+	if (write) iscc_set_tail_ptr(out_dg, 0, 0);
+	for (scc_PointIndex v = 0; v < vertices; ++v) {
+		bool keep_row = (tails_to_keep == NULL);
+		if (!keep_row && (next_tail_to_keep != stop_tails_to_keep) && (*next_tail_to_keep == v)) {
+			++next_tail_to_keep;
+			keep_row = true;
+		}
+		if (!keep_self_loops) row_markers[v] = v;
+		for (uint_fast16_t i = 0; i < num_dgs; ++i) {
+			if ((ec = iscc_read_spilled_row(&dgs[i], rows[i], &row_arcs)) != SCC_ER_OK) return ec;
+			if (!keep_row) continue;
+			const scc_PointIndex* const arc_i_stop = rows[i] + row_arcs;
+			for (const scc_PointIndex* arc_i = rows[i]; arc_i != arc_i_stop; ++arc_i) {
+				if (row_markers[*arc_i] != v) {
+					row_markers[*arc_i] = v;
+					if (write) out_dg->head[counter] = *arc_i;
+					++counter;
+				}
+			}
+		}
+		if (write) iscc_set_tail_ptr(out_dg, v + 1, (size_t) counter);
+	}
+
+	*out_arcs = counter;
+
+	return iscc_no_error();
+}
+
+
+static inline uintmax_t iscc_do_union_and_delete_sorted(const uint_fast16_t num_dgs,
+                                                        const iscc_Digraph dgs[restrict const static num_dgs],
+                                                        const scc_PointIndex* row_cursors[restrict const],
+                                                        const size_t len_tails_to_keep,
+                                                        const scc_PointIndex tails_to_keep[restrict const],
+                                                        const bool keep_self_loops,
+                                                        const bool write,
+                                                        iscc_Digraph* const out_dg)
+{
+	assert(num_dgs > 0);
+	assert(dgs != NULL);
+	assert(iscc_digraph_is_initialized(&dgs[0]));
+	assert(dgs[0].vertices > 0);
+	assert(row_cursors != NULL);
+
+	#ifndef NDEBUG
+		for (uint_fast16_t i = 0; i < num_dgs; ++i) {
+			assert(iscc_digraph_is_initialized(&dgs[i]));
+			assert(dgs[i].vertices == dgs[0].vertices);
+			assert(dgs[i].sorted_rows);
+		}
+	#endif
+
+	uintmax_t counter = 0;
+	assert(dgs->vertices <= ISCC_POINTINDEX_MAX);
+	const scc_PointIndex vertices = (scc_PointIndex) dgs->vertices; // If `scc_PointIndex` is signed
+
+	if (!write) {
+		if (tails_to_keep == NULL) {
+			for (scc_PointIndex v = 0; v < vertices; ++v) {
+				counter += iscc_do_merge_rows(num_dgs, dgs, v, row_cursors, keep_self_loops, NULL);
+			}
+		} else {
+			for (size_t v = 0; v < len_tails_to_keep; ++v) {
+				counter += iscc_do_merge_rows(num_dgs, dgs, tails_to_keep[v], row_cursors, keep_self_loops, NULL);
+			}
+		}
+
+	} else {
+		assert(out_dg != NULL);
+		scc_PointIndex* restrict const out_head = out_dg->head;
+		iscc_set_tail_ptr(out_dg, 0, 0);
+		const scc_PointIndex* next_tail_to_keep = tails_to_keep;
+		const scc_PointIndex* const stop_tails_to_keep = tails_to_keep + len_tails_to_keep;
+		for (scc_PointIndex v = 0; v < vertices; ++v) {
+			if (tails_to_keep == NULL) {
+				counter += iscc_do_merge_rows(num_dgs, dgs, v, row_cursors, keep_self_loops, out_head + counter);
+			} else if ((next_tail_to_keep != stop_tails_to_keep) && (*next_tail_to_keep == v)) {
+				++next_tail_to_keep;
+				counter += iscc_do_merge_rows(num_dgs, dgs, v, row_cursors, keep_self_loops, out_head + counter);
+			}
+			iscc_set_tail_ptr(out_dg, v + 1, (size_t) counter);
+			assert((counter == 0) || (out_head != NULL));
+		}
+	}
+
+	return counter;
+}
+
+
+static inline size_t iscc_do_merge_rows(const uint_fast16_t num_dgs,
+                                        const iscc_Digraph dgs[restrict const static num_dgs],
+                                        const scc_PointIndex v,
+                                        const scc_PointIndex* row_cursors[restrict const],
+                                        const bool keep_self_loops,
+                                        scc_PointIndex out_row[restrict const])
+{
+	assert(num_dgs > 0);
+	assert(row_cursors != NULL);
+
+	for (uint_fast16_t i = 0; i < num_dgs; ++i) {
+		row_cursors[i] = iscc_arc_start(&dgs[i], v);
+	}
+
+	// Each round writes the smallest head among the cursors and advances
+	// all cursors pointing to it. The number of digraphs is small, so a
+	// linear scan over the cursors is cheaper than a heap.
+	size_t row_size = 0;
+	while (true) {
+		bool found = false;
+		scc_PointIndex min_head = 0;
+		for (uint_fast16_t i = 0; i < num_dgs; ++i) {
+			if ((row_cursors[i] != iscc_arc_stop(&dgs[i], v)) && (!found || (*row_cursors[i] < min_head))) {
+				min_head = *row_cursors[i];
+				found = true;
+			}
+		}
+		if (!found) break;
+
+		for (uint_fast16_t i = 0; i < num_dgs; ++i) {
+			if ((row_cursors[i] != iscc_arc_stop(&dgs[i], v)) && (*row_cursors[i] == min_head)) {
+				++row_cursors[i];
+			}
+		}
+
+		if (keep_self_loops || (min_head != v)) {
+			if (out_row != NULL) out_row[row_size] = min_head;
+			++row_size;
+		}
+	}
+
+	return row_size;
+}
+
+
+static inline bool iscc_sorted_row_contains(const scc_PointIndex* const row_start,
+                                            const scc_PointIndex* const row_stop,
+                                            const scc_PointIndex value)
+{
+	assert(row_start <= row_stop);
+
+	// Binary search for the first head not less than `value`
+	const scc_PointIndex* low = row_start;
+	const scc_PointIndex* high = row_stop;
+	while (low < high) {
+		const scc_PointIndex* const mid = low + (high - low) / 2;
+		if (*mid < value) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+
+	return (low != row_stop) && (*low == value);
+}
+
+
 static inline uintmax_t iscc_do_adjacency_product(const iscc_Digraph* const dg_a,
                                                   const iscc_Digraph* const dg_b,
                                                   scc_PointIndex row_markers[restrict const],
                                                   const bool force_loops,
                                                   const bool write,
-                                                  iscc_ArcIndex out_tail_ptr[restrict const],
-                                                  scc_PointIndex out_head[restrict const])
+                                                  iscc_Digraph* const out_dg)
 {
 	assert(iscc_digraph_is_initialized(dg_a));
 	assert(iscc_digraph_is_initialized(dg_b));
@@ -431,11 +897,6 @@ static inline uintmax_t iscc_do_adjacency_product(const iscc_Digraph* const dg_a
 	assert(dg_a->vertices <= ISCC_POINTINDEX_MAX);
 	const scc_PointIndex vertices = (scc_PointIndex) dg_a->vertices; // If `scc_PointIndex` is signed
 
-	const iscc_ArcIndex* const dg_a_tail_ptr = dg_a->tail_ptr;
-	const scc_PointIndex* const dg_a_head = dg_a->head;
-	const iscc_ArcIndex* const dg_b_tail_ptr = dg_b->tail_ptr;
-	const scc_PointIndex* const dg_b_head = dg_b->head;
-
 	for (scc_PointIndex v = 0; v < vertices; ++v) {
 		row_markers[v] = ISCC_POINTINDEX_MAX_PI;
 	}
@@ -444,8 +905,8 @@ static inline uintmax_t iscc_do_adjacency_product(const iscc_Digraph* const dg_a
 		for (scc_PointIndex v = 0; v < vertices; ++v) {
 			row_markers[v] = v;
 			if (force_loops) {
-				const scc_PointIndex* const v_arc_b_stop = dg_b_head + dg_b_tail_ptr[v + 1];
-				for (const scc_PointIndex* v_arc_b = dg_b_head + dg_b_tail_ptr[v];
+				const scc_PointIndex* const v_arc_b_stop = iscc_arc_stop(dg_b, v);
+				for (const scc_PointIndex* v_arc_b = iscc_arc_start(dg_b, v);
 				        v_arc_b != v_arc_b_stop; ++v_arc_b) {
 					if (row_markers[*v_arc_b] != v) {
 						row_markers[*v_arc_b] = v;
@@ -453,11 +914,11 @@ static inline uintmax_t iscc_do_adjacency_product(const iscc_Digraph* const dg_a
 					}
 				}
 			}
-			const scc_PointIndex* const arc_a_stop = dg_a_head + dg_a_tail_ptr[v + 1];
-			for (const scc_PointIndex* arc_a = dg_a_head + dg_a_tail_ptr[v];
+			const scc_PointIndex* const arc_a_stop = iscc_arc_stop(dg_a, v);
+			for (const scc_PointIndex* arc_a = iscc_arc_start(dg_a, v);
 			        arc_a != arc_a_stop; ++arc_a) {
-				const scc_PointIndex* const arc_b_stop = dg_b_head + dg_b_tail_ptr[*arc_a + 1];
-				for (const scc_PointIndex* arc_b = dg_b_head + dg_b_tail_ptr[*arc_a];
+				const scc_PointIndex* const arc_b_stop = iscc_arc_stop(dg_b, *arc_a);
+				for (const scc_PointIndex* arc_b = iscc_arc_start(dg_b, *arc_a);
 				        arc_b != arc_b_stop; ++arc_b) {
 					if (row_markers[*arc_b] != v) {
 						row_markers[*arc_b] = v;
@@ -468,15 +929,16 @@ static inline uintmax_t iscc_do_adjacency_product(const iscc_Digraph* const dg_a
 		}
 
 	} else if (write) {
-		assert(out_tail_ptr != NULL);
-		assert(out_head != NULL);
+		assert(out_dg != NULL);
+		assert(out_dg->head != NULL);
+		scc_PointIndex* restrict const out_head = out_dg->head;
 
-		out_tail_ptr[0] = 0;
+		iscc_set_tail_ptr(out_dg, 0, 0);
 		for (scc_PointIndex v = 0; v < vertices; ++v) {
 			row_markers[v] = v;
 			if (force_loops) {
-				const scc_PointIndex* const v_arc_b_stop = dg_b_head + dg_b_tail_ptr[v + 1];
-				for (const scc_PointIndex* v_arc_b = dg_b_head + dg_b_tail_ptr[v];
+				const scc_PointIndex* const v_arc_b_stop = iscc_arc_stop(dg_b, v);
+				for (const scc_PointIndex* v_arc_b = iscc_arc_start(dg_b, v);
 				        v_arc_b != v_arc_b_stop; ++v_arc_b) {
 					if (row_markers[*v_arc_b] != v) {
 						row_markers[*v_arc_b] = v;
@@ -485,11 +947,11 @@ static inline uintmax_t iscc_do_adjacency_product(const iscc_Digraph* const dg_a
 					}
 				}
 			}
-			const scc_PointIndex* const arc_a_stop = dg_a_head + dg_a_tail_ptr[v + 1];
-			for (const scc_PointIndex* arc_a = dg_a_head + dg_a_tail_ptr[v];
+			const scc_PointIndex* const arc_a_stop = iscc_arc_stop(dg_a, v);
+			for (const scc_PointIndex* arc_a = iscc_arc_start(dg_a, v);
 			        arc_a != arc_a_stop; ++arc_a) {
-				const scc_PointIndex* const arc_b_stop = dg_b_head + dg_b_tail_ptr[*arc_a + 1];
-				for (const scc_PointIndex* arc_b = dg_b_head + dg_b_tail_ptr[*arc_a];
+				const scc_PointIndex* const arc_b_stop = iscc_arc_stop(dg_b, *arc_a);
+				for (const scc_PointIndex* arc_b = iscc_arc_start(dg_b, *arc_a);
 				        arc_b != arc_b_stop; ++arc_b) {
 					if (row_markers[*arc_b] != v) {
 						row_markers[*arc_b] = v;
@@ -498,9 +960,83 @@ static inline uintmax_t iscc_do_adjacency_product(const iscc_Digraph* const dg_a
 					}
 				}
 			}
-			out_tail_ptr[v + 1] = (iscc_ArcIndex) counter;
+			iscc_set_tail_ptr(out_dg, v + 1, (size_t) counter);
 		}
 	}
 
 	return counter;
 }
+
+
+
+#ifdef _OPENMP
+
+// Gives the same digraph as the serial transpose. Inwards arcs are counted with atomic
+// increments into one vertex-sized array, and heads are scattered into their rows with
+// atomic decrements. The order within rows is then arbitrary, so each row is sorted in
+// descending order of tails as written by the serial version.
+static scc_ErrorCode iscc_digraph_transpose_parallel(const iscc_Digraph* const in_dg,
+                                                     iscc_Digraph* const out_dg)
+{
+	assert(iscc_digraph_is_valid(in_dg));
+	assert(!iscc_digraph_is_empty(in_dg));
+	assert(in_dg->vertices <= ISCC_POINTINDEX_MAX);
+	assert(out_dg != NULL);
+	assert(out_dg->head != NULL);
+
+	const size_t arcs = iscc_digraph_arcs(in_dg);
+	const scc_PointIndex vertices = (scc_PointIndex) in_dg->vertices; // If `scc_PointIndex` is signed
+
+	// Counts fit `scc_PointIndex` since no vertex has more than `vertices` inwards arcs
+	scc_PointIndex* const row_counts = iscc_calloc(in_dg->vertices, sizeof(scc_PointIndex));
+	if (row_counts == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+
+	const scc_PointIndex* const in_head = in_dg->head;
+	#pragma omp parallel for schedule(static)
+	for (size_t i = 0; i < arcs; ++i) {
+		#pragma omp atomic
+		++row_counts[in_head[i]];
+	}
+
+	size_t row_start = 0;
+	for (scc_PointIndex v = 0; v < vertices; ++v) {
+		iscc_set_tail_ptr(out_dg, v, row_start);
+		row_start += (size_t) row_counts[v];
+	}
+	assert(row_start == arcs);
+	iscc_set_tail_ptr(out_dg, vertices, row_start);
+
+	scc_PointIndex* const out_head = out_dg->head;
+	#pragma omp parallel
+	{
+		#pragma omp for schedule(static)
+		for (scc_PointIndex v = 0; v < vertices; ++v) {
+			const scc_PointIndex* const arc_stop = iscc_arc_stop(in_dg, v);
+			for (const scc_PointIndex* arc = iscc_arc_start(in_dg, v); arc != arc_stop; ++arc) {
+				scc_PointIndex row_pos;
+				#pragma omp atomic capture
+				row_pos = --row_counts[*arc];
+				out_head[iscc_get_tail_ptr(out_dg, *arc) + (size_t) row_pos] = v;
+			}
+		}
+
+		#pragma omp for schedule(dynamic, 256)
+		for (scc_PointIndex v = 0; v < vertices; ++v) {
+			scc_PointIndex* const row = out_head + iscc_get_tail_ptr(out_dg, v);
+			const size_t row_len = iscc_get_tail_ptr(out_dg, v + 1) - iscc_get_tail_ptr(out_dg, v);
+			iscc_sort_point_indices(row_len, row);
+			for (size_t i = 0, j = row_len; i + 1 < j; ++i, --j) {
+				const scc_PointIndex tmp = row[i];
+				row[i] = row[j - 1];
+				row[j - 1] = tmp;
+			}
+		}
+	}
+
+	iscc_free(row_counts);
+
+	return iscc_no_error();
+}
+
+
+#endif // ifdef _OPENMP
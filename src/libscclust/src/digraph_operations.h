@@ -91,6 +91,9 @@ scc_ErrorCode iscc_delete_loops(iscc_Digraph* dg);
  *
  *  \note All digraphs in \p dgs must contain equally many vertices.
  *  \note All self-loops in the digraphs will be ignored.
+ *  \note If all digraphs in \p dgs have sorted rows, the rows are merged without an
+ *        array indexed by vertex, and \p out_dg is sorted. Otherwise, arcs are ordered
+ *        by first occurrence in \p dgs.
  */
 scc_ErrorCode iscc_digraph_union_and_delete(uint_fast16_t num_in_dgs,
                                             const iscc_Digraph in_dgs[static num_in_dgs],
@@ -100,6 +103,29 @@ scc_ErrorCode iscc_digraph_union_and_delete(uint_fast16_t num_in_dgs,
                                             iscc_Digraph* out_dg);
 
 
+/** Derives the union of spilled digraphs and deletes arcs.
+ *
+ *  Same as #iscc_digraph_union_and_delete, but the input digraphs are read from
+ *  disk one row at a time, so only the output and one row per input is held in memory.
+ *
+ *  \param num_in_dgs number of digraph to calculate union for. Must be non-zero.
+ *  \param[in,out] in_dgs the spilled digraphs. Must be of length \p num_in_dgs. Rewound on return.
+ *  \param[in] len_tails_to_keep length of \p tails_to_keep.
+ *  \param[in] tails_to_keep sorted indices of tails for which the arcs should be *kept*.
+ *                           If `NULL` no arcs (except self-loops) are deleted.
+ *  \param keep_self_loops when \c false, self-loops are deleted.
+ *  \param[out] out_dg the union of \p in_dgs.
+ *
+ *  \note Arcs are ordered by first occurrence, as with unsorted rows in #iscc_digraph_union_and_delete.
+ */
+scc_ErrorCode iscc_digraph_union_and_delete_spilled(uint_fast16_t num_in_dgs,
+                                                    iscc_SpilledDigraph in_dgs[static num_in_dgs],
+                                                    size_t len_tails_to_keep,
+                                                    const scc_PointIndex tails_to_keep[],
+                                                    bool keep_self_loops,
+                                                    iscc_Digraph* out_dg);
+
+
 scc_ErrorCode iscc_digraph_difference(iscc_Digraph* minuend_dg,
                                       const iscc_Digraph* subtrahend_dg,
                                       uint32_t max_out_degree);
@@ -184,4 +210,24 @@ scc_ErrorCode iscc_adjacency_product(const iscc_Digraph* in_dg_a,
                                      iscc_Digraph* out_dg);
 
 
+/** Removes isolated vertices from a digraph.
+ *
+ *  This function produces a copy of the inputted digraph without the vertices that have neither
+ *  outwards nor inwards arcs. Remaining vertices are renumbered in their original order, so the
+ *  relative order of vertices and arcs is unchanged.
+ *
+ *  \param[in] in_dg digraph to compact.
+ *  \param max_vertices largest number of remaining vertices for which the compacted digraph is derived.
+ *  \param[out] out_vertex_ids original ID of each vertex in \p out_dg. Set to `NULL` when more than
+ *                             \p max_vertices vertices remain, in which case \p out_dg is untouched.
+ *  \param[out] out_dg the compacted digraph.
+ *
+ *  \note \p out_vertex_ids must be freed by the caller.
+ */
+scc_ErrorCode iscc_digraph_compact(const iscc_Digraph* in_dg,
+                                   size_t max_vertices,
+                                   scc_PointIndex** out_vertex_ids,
+                                   iscc_Digraph* out_dg);
+
+
 #endif // ifndef SCC_DIGRAPH_OPERATIONS_HG
@@ -28,6 +28,7 @@
 #include "../include/scclust.h"
 #include "data_set_struct.h"
 #include "scclust_types.h"
+#include "workspace.h"
 
 
 // =============================================================================
@@ -180,7 +181,7 @@ bool iscc_imp_init_max_dist_object(void* const data_set,
 	assert(len_search_indices > 0);
 	assert(out_max_dist_object != NULL);
 
-	*out_max_dist_object = malloc(sizeof(iscc_MaxDistObject));
+	*out_max_dist_object = iscc_malloc(sizeof(iscc_MaxDistObject));
 	if (*out_max_dist_object == NULL) return false;
 
 	**out_max_dist_object = (iscc_MaxDistObject) {
@@ -276,7 +277,7 @@ bool iscc_imp_close_max_dist_object(iscc_MaxDistObject** const max_dist_object)
 {
 	if (max_dist_object != NULL && *max_dist_object != NULL) {
 		assert((*max_dist_object)->max_dist_version == ISCC_MAXDIST_STRUCT_VERSION);
-		free(*max_dist_object);
+		iscc_free(*max_dist_object);
 		*max_dist_object = NULL;
 	}
 	return true;
@@ -326,7 +327,7 @@ bool iscc_imp_init_nn_search_object(void* const data_set,
 	assert(len_search_indices > 0);
 	assert(out_nn_search_object != NULL);
 
-	*out_nn_search_object = malloc(sizeof(iscc_NNSearchObject));
+	*out_nn_search_object = iscc_malloc(sizeof(iscc_NNSearchObject));
 	if (*out_nn_search_object == NULL) return false;
 
 	**out_nn_search_object = (iscc_NNSearchObject) {
@@ -368,7 +369,7 @@ bool iscc_imp_nearest_neighbor_search(iscc_NNSearchObject* const nn_search_objec
 	double tmp_dist;
 	size_t num_ok_queries = 0;
 	scc_PointIndex* index_write = out_nn_indices;
-	double* const sort_scratch = malloc(sizeof(double[k]));
+	double* const sort_scratch = iscc_malloc(sizeof(double[k]));
 	if (sort_scratch == NULL) return false;
 	double* const sort_scratch_end = sort_scratch + k - 1;
 	const double radius_sq = radius * radius;
@@ -462,7 +463,7 @@ bool iscc_imp_nearest_neighbor_search(iscc_NNSearchObject* const nn_search_objec
 
 	*out_num_ok_queries = num_ok_queries;
 
-	free(sort_scratch);
+	iscc_free(sort_scratch);
 
 	return true;
 }
@@ -472,7 +473,7 @@ bool iscc_imp_close_nn_search_object(iscc_NNSearchObject** const nn_search_objec
 {
 	if (nn_search_object != NULL && *nn_search_object != NULL) {
 		assert((*nn_search_object)->nn_search_version == ISCC_NN_SEARCH_STRUCT_VERSION);
-		free(*nn_search_object);
+		iscc_free(*nn_search_object);
 		*nn_search_object = NULL;
 	}
 	return true;
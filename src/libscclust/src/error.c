@@ -46,10 +46,16 @@ scc_ErrorCode iscc_make_error__(const scc_ErrorCode ec,
 {
 	assert((ec > SCC_ER_OK) && (ec <= SCC_ER_NOT_IMPLEMENTED));
 
-	iscc_error_code = ec;
-	iscc_error_msg = msg;
-	iscc_error_file = file;
-	iscc_error_line = line;
+	// Seed methods may run concurrently (see `seed_portfolio`)
+	#ifdef _OPENMP
+		#pragma omp critical(iscc_error_state)
+	#endif
+	{
+		iscc_error_code = ec;
+		iscc_error_msg = msg;
+		iscc_error_file = file;
+		iscc_error_line = line;
+	}
 
 	return ec;
 }
@@ -57,10 +63,15 @@ scc_ErrorCode iscc_make_error__(const scc_ErrorCode ec,
 
 void iscc_reset_error(void)
 {
-	iscc_error_code = SCC_ER_OK;
-	iscc_error_msg = NULL;
-	iscc_error_file = "unknown file";
-	iscc_error_line = -1;
+	#ifdef _OPENMP
+		#pragma omp critical(iscc_error_state)
+	#endif
+	{
+		iscc_error_code = SCC_ER_OK;
+		iscc_error_msg = NULL;
+		iscc_error_file = "unknown file";
+		iscc_error_line = -1;
+	}
 }
 
 
@@ -26,25 +26,57 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include "dist_search.h"
+#include "dist_search_imp.h"
 #include "clustering_struct.h"
+#include "data_set_struct.h"
 #include "error.h"
 #include "scclust_types.h"
+#include "workspace.h"
 
-// Maximum number of data points to check when finding centers.
-static const uint_fast16_t ISCC_HI_NUM_TO_CHECK = 100;
+#ifdef _OPENMP
+	#include <omp.h>
+#endif
+
+static const int32_t ISCC_HI_OPTIONS_STRUCT_VERSION = 722519001;
+
+// Default number of data points to start from when finding centers.
+static const uint32_t ISCC_HI_NUM_CENTER_PROBES = 100;
+
+// Number of random directions used when finding centers by projections.
+static const size_t ISCC_HI_NUM_PROJECTIONS = 4;
+
+// Edge lists shorter than this are sorted with insertion sort rather than radix sort.
+static const size_t ISCC_HI_RADIX_SORT_MIN = 64;
+
+#ifdef _OPENMP
+	// Minimum number of data points to run the clustering in parallel
+	static const size_t ISCC_HI_PARALLEL_MIN_DATA_POINTS = 4096;
+
+	// Clusters smaller than this are broken by the thread that made them
+	// rather than being handed to other threads
+	static const size_t ISCC_HI_MIN_TASK_SIZE = 512;
+#endif
 
 
 // =============================================================================
 // Internal structs
 // =============================================================================
 
-typedef struct iscc_hi_DistanceEdge iscc_hi_DistanceEdge;
-struct iscc_hi_DistanceEdge {
-	scc_PointIndex head;
-	double distance;
-	iscc_hi_DistanceEdge* next_dist;
-};
+// Edges from a center to the other points in a cluster, sorted by distance.
+// Entry 0 is the center itself and the start of the list. `next[i]` is the
+// entry after `i` that has not been skipped, so entries of assigned points
+// are spliced out of the list as it is walked.
+typedef struct iscc_hi_EdgeList {
+	scc_PointIndex* heads;
+	double* distances;
+	uint32_t* next;
+} iscc_hi_EdgeList;
+
+
+// `next` of the last entry in an edge list
+static const uint32_t ISCC_HI_LIST_END = UINT32_MAX;
 
 
 typedef struct iscc_hi_ClusterItem {
@@ -62,16 +94,55 @@ typedef struct iscc_hi_ClusterStack {
 } iscc_hi_ClusterStack;
 
 
+// State of each new cluster when breaking a cluster into more than two.
+typedef struct iscc_hi_NewCluster {
+	scc_PointIndex center;
+	bool picked_nearest;
+	uint32_t last_assigned_edge;
+	size_t size;
+	scc_PointIndex* write_members;
+} iscc_hi_NewCluster;
+
+
+// `capacity` is the size of the largest cluster that `dist_array`, the
+// edge lists and the scratch arrays can hold. There is one edge list for
+// each new cluster when breaking clusters. `new_clusters` and
+// `assigned_to` are only used when breaking clusters into more than two.
 typedef struct iscc_hi_WorkArea {
-	scc_PointIndex* const pointindex_array1;
-	scc_PointIndex* const pointindex_array2;
-	double* const dist_array;
-	uint_fast16_t* const vertex_markers;
-	iscc_hi_DistanceEdge* const edge_store1;
-	iscc_hi_DistanceEdge* const edge_store2;
+	size_t capacity;
+	uint32_t num_edge_lists;
+	scc_PointIndex* pointindex_array1;
+	scc_PointIndex* pointindex_array2;
+	double* dist_array;
+	uint_fast16_t* vertex_markers;
+	iscc_hi_EdgeList* edge_lists;
+	scc_PointIndex* scratch_heads;
+	double* scratch_distances;
+	iscc_hi_NewCluster* new_clusters;
+	uint32_t* assigned_to;
 } iscc_hi_WorkArea;
 
 
+#ifdef _OPENMP
+
+// Shared by the tasks of the parallel clustering. Each thread has its own
+// work area, so the vertex markers of a cluster are only valid in the work
+// area of the thread that made it. The leaves of the tree are collected in
+// `leaves` and labeled when all tasks are done.
+typedef struct iscc_hi_TaskContext {
+	void* data_set;
+	const scc_HierarchicalOptions* options;
+	iscc_hi_WorkArea* work_areas;
+	size_t max_leaves;
+	size_t num_leaves;
+	iscc_hi_ClusterItem* leaves;
+	int failed;
+	scc_ErrorCode ec;
+} iscc_hi_TaskContext;
+
+#endif // ifdef _OPENMP
+
+
 // =============================================================================
 // Static function prototypes
 // =============================================================================
@@ -89,39 +160,115 @@ static scc_ErrorCode iscc_hi_run_hierarchical_clustering(iscc_hi_ClusterStack* c
                                                          scc_Clustering* cl,
                                                          void* data_set,
                                                          iscc_hi_WorkArea* work_area,
-                                                         uint32_t size_constraint,
-                                                         bool batch_assign);
+                                                         const scc_HierarchicalOptions* options);
+
+
+#ifdef _OPENMP
+
+static scc_ErrorCode iscc_hi_run_hierarchical_clustering_parallel(iscc_hi_ClusterStack* cl_stack,
+                                                                  scc_Clustering* cl,
+                                                                  void* data_set,
+                                                                  const scc_HierarchicalOptions* options);
+
+
+static void iscc_hi_run_cluster_task(iscc_hi_TaskContext* ctx,
+                                     int creator,
+                                     size_t num_clusters,
+                                     const iscc_hi_ClusterItem clusters[]);
+
+
+static void iscc_hi_set_task_error(iscc_hi_TaskContext* ctx,
+                                   scc_ErrorCode ec);
+
 
+static int iscc_hi_compare_leaves(const void* a,
+                                  const void* b);
 
-static scc_ErrorCode iscc_hi_check_capacity(iscc_hi_ClusterStack* cl_stack);
+#endif // ifdef _OPENMP
 
 
-static inline void iscc_hi_push_to_stack(iscc_hi_ClusterStack* cl_stack,
-                                         iscc_hi_ClusterItem** cl);
+static inline size_t iscc_hi_size_pointindex_array(size_t num_data_points,
+                                                   const scc_HierarchicalOptions* options);
+
+
+static scc_ErrorCode iscc_hi_reserve_work_area(iscc_hi_WorkArea* work_area,
+                                               size_t cluster_size);
+
+
+static void iscc_hi_free_work_area(iscc_hi_WorkArea* work_area);
+
+
+static void iscc_hi_free_cluster_arrays(iscc_hi_WorkArea* work_area);
+
+
+static scc_ErrorCode iscc_hi_check_capacity(iscc_hi_ClusterStack* cl_stack,
+                                            uint32_t num_to_push);
+
+
+static scc_ErrorCode iscc_hi_break_top_cluster(iscc_hi_ClusterStack* cl_stack,
+                                               void* data_set,
+                                               iscc_hi_WorkArea* work_area,
+                                               const scc_HierarchicalOptions* options);
 
 
 static scc_ErrorCode iscc_hi_break_cluster_into_two(iscc_hi_ClusterItem* cluster_to_break,
                                                     void* data_set,
                                                     iscc_hi_WorkArea* work_area,
-                                                    uint32_t size_constraint,
-                                                    bool batch_assign,
+                                                    const scc_HierarchicalOptions* options,
                                                     iscc_hi_ClusterItem* out_new_cluster);
 
 
+static scc_ErrorCode iscc_hi_break_cluster_into_k(iscc_hi_ClusterItem* cluster_to_break,
+                                                  void* data_set,
+                                                  iscc_hi_WorkArea* work_area,
+                                                  const scc_HierarchicalOptions* options,
+                                                  uint32_t num_ways,
+                                                  iscc_hi_ClusterItem out_new_clusters[]);
+
+
+static void iscc_hi_break_cluster_by_coordinates(iscc_hi_ClusterItem* cluster_to_break,
+                                                 const scc_DataSet* data_set,
+                                                 iscc_hi_WorkArea* work_area,
+                                                 uint32_t size_constraint,
+                                                 uint32_t num_ways,
+                                                 iscc_hi_ClusterItem out_new_clusters[]);
+
+
+static scc_ErrorCode iscc_hi_find_k_centers(iscc_hi_ClusterItem* cl,
+                                            void* data_set,
+                                            iscc_hi_WorkArea* work_area,
+                                            const scc_HierarchicalOptions* options,
+                                            uint32_t num_ways);
+
+
+static inline void iscc_hi_assign_to_new_cluster(uint32_t len_ids,
+                                                 const scc_PointIndex ids[static len_ids],
+                                                 uint32_t new_cluster,
+                                                 iscc_hi_WorkArea* work_area,
+                                                 uint_fast16_t curr_marker,
+                                                 size_t* num_assigned);
+
+
 static inline uint_fast16_t iscc_hi_get_next_marker(iscc_hi_ClusterItem* cl,
                                                     uint_fast16_t vertex_markers[]);
 
 
-static inline iscc_hi_DistanceEdge* iscc_hi_get_next_k_nn(iscc_hi_DistanceEdge* prev_dist,
-                                                          uint32_t k,
-                                                          const uint_fast16_t vertex_markers[],
-                                                          uint_fast16_t curr_marker,
-                                                          scc_PointIndex out_dist_array[static k]);
+static inline void iscc_hi_reset_markers(iscc_hi_ClusterItem* cl,
+                                         uint_fast16_t vertex_markers[]);
 
 
-static inline iscc_hi_DistanceEdge* iscc_hi_get_next_dist(iscc_hi_DistanceEdge* prev_dist,
-                                                          const uint_fast16_t vertex_markers[],
-                                                          uint_fast16_t curr_marker);
+static inline uint32_t iscc_hi_get_next_k_nn(const iscc_hi_EdgeList* edge_list,
+                                             uint32_t prev_dist,
+                                             uint32_t k,
+                                             const uint_fast16_t vertex_markers[],
+                                             uint_fast16_t curr_marker,
+                                             scc_PointIndex out_dist_array[static k]);
+
+
+static inline uint32_t iscc_hi_get_next_dist(const iscc_hi_EdgeList* edge_list,
+                                             uint32_t prev_dist,
+                                             const uint_fast16_t vertex_markers[],
+                                             uint_fast16_t curr_marker);
 
 
 static inline void iscc_hi_move_point_to_cluster1(scc_PointIndex id,
@@ -153,10 +300,17 @@ static inline void iscc_hi_move_array_to_cluster2(uint32_t len_ids,
 static scc_ErrorCode iscc_hi_find_centers(iscc_hi_ClusterItem* cl,
                                           void* data_set,
                                           iscc_hi_WorkArea* work_area,
+                                          const scc_HierarchicalOptions* options,
                                           scc_PointIndex* out_center1,
                                           scc_PointIndex* out_center2);
 
 
+static scc_ErrorCode iscc_hi_find_centers_by_projections(const iscc_hi_ClusterItem* cl,
+                                                         const scc_DataSet* data_set,
+                                                         scc_PointIndex* out_center1,
+                                                         scc_PointIndex* out_center2);
+
+
 static scc_ErrorCode iscc_hi_populate_edge_lists(const iscc_hi_ClusterItem* cl,
                                                  void* data_set,
                                                  scc_PointIndex center1,
@@ -167,22 +321,49 @@ static scc_ErrorCode iscc_hi_populate_edge_lists(const iscc_hi_ClusterItem* cl,
 static inline void iscc_hi_sort_edge_list(const iscc_hi_ClusterItem* cl,
                                           scc_PointIndex center,
                                           const double row_dists[static cl->size],
-                                          iscc_hi_DistanceEdge edge_store[static cl->size]);
+                                          iscc_hi_WorkArea* work_area,
+                                          iscc_hi_EdgeList* out_edge_list);
 
 
-static int iscc_hi_compare_dist_edges(const void* a,
-                                      const void* b);
+static void iscc_hi_sort_edges(size_t len_edges,
+                               scc_PointIndex heads[static len_edges],
+                               double distances[static len_edges],
+                               scc_PointIndex scratch_heads[static len_edges],
+                               double scratch_distances[static len_edges]);
+
+
+static inline uint64_t iscc_hi_radix_key(double distance);
 
 
 // =============================================================================
 // Public function implementations
 // =============================================================================
 
+scc_HierarchicalOptions scc_get_default_hierarchical_options(void)
+{
+	return (scc_HierarchicalOptions) {
+		.options_version = ISCC_HI_OPTIONS_STRUCT_VERSION,
+		.size_constraint = 0,
+		.batch_assign = true,
+		.num_splits = 2,
+		.split_method = SCC_SP_DISTANCES,
+		.num_center_probes = ISCC_HI_NUM_CENTER_PROBES,
+		.max_center_iterations = 0,
+		.approximate_centers = false,
+	};
+}
+
+
 scc_ErrorCode scc_hierarchical_clustering(void* const data_set,
-                                          const uint32_t size_constraint,
-                                          const bool batch_assign,
+                                          const scc_HierarchicalOptions* const options,
                                           scc_Clustering* const out_clustering)
 {
+	if (options == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid options object.");
+	}
+	if (options->options_version != ISCC_HI_OPTIONS_STRUCT_VERSION) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Incompatible scc_HierarchicalOptions version.");
+	}
 	if (!iscc_check_input_clustering(out_clustering)) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid clustering object.");
 	}
@@ -192,10 +373,28 @@ scc_ErrorCode scc_hierarchical_clustering(void* const data_set,
 	if (iscc_num_data_points(data_set) != out_clustering->num_data_points) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Number of data points in data set does not match clustering object.");
 	}
-	if (size_constraint < 2) {
+	if (options->size_constraint < 2) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Size constraint must be 2 or greater.");
 	}
-	if (out_clustering->num_data_points < size_constraint) {
+	if (options->num_splits < 2) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Number of splits must be 2 or greater.");
+	}
+	if ((options->split_method != SCC_SP_DISTANCES) &&
+	        (options->split_method != SCC_SP_COORDINATES)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Unknown split method.");
+	}
+	if ((options->split_method == SCC_SP_COORDINATES) &&
+	        (iscc_dist_functions.check_data_set != iscc_imp_check_data_set)) {
+		return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "Coordinate splitting requires the built-in distance functions.");
+	}
+	if (options->num_center_probes < 1) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Number of center probes must be 1 or greater.");
+	}
+	if (options->approximate_centers &&
+	        (iscc_dist_functions.check_data_set != iscc_imp_check_data_set)) {
+		return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "Approximate centers require the built-in distance functions.");
+	}
+	if (out_clustering->num_data_points < options->size_constraint) {
 		return iscc_make_error_msg(SCC_ER_NO_SOLUTION, "Fewer data points than size constraint.");
 	}
 
@@ -205,7 +404,7 @@ scc_ErrorCode scc_hierarchical_clustering(void* const data_set,
 	if (out_clustering->num_clusters == 0) {
 		if (out_clustering->cluster_label == NULL) {
 			out_clustering->external_labels = false;
-			out_clustering->cluster_label = malloc(sizeof(scc_Clabel[out_clustering->num_data_points]));
+			out_clustering->cluster_label = iscc_malloc(sizeof(scc_Clabel[out_clustering->num_data_points]));
 			if (out_clustering->cluster_label == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 		}
 
@@ -223,40 +422,66 @@ scc_ErrorCode scc_hierarchical_clustering(void* const data_set,
 	assert(cl_stack.clusters != NULL);
 	assert(cl_stack.pointindex_store != NULL);
 
-	const size_t size_pointindex_array = (size_constraint > ISCC_HI_NUM_TO_CHECK) ? size_constraint : ISCC_HI_NUM_TO_CHECK;
-	const size_t size_dist_array = ((2 * size_largest_cluster) > ISCC_HI_NUM_TO_CHECK) ? (2 * size_largest_cluster) : ISCC_HI_NUM_TO_CHECK;
+	// No cluster can be broken into more parts than the size constraint allows, so
+	// larger `num_splits` would only give work areas with unused edge lists
+	scc_HierarchicalOptions split_options = *options;
+	const size_t max_splits = size_largest_cluster / options->size_constraint;
+	if (max_splits < 2) {
+		split_options.num_splits = 2;
+	} else if (split_options.num_splits > max_splits) {
+		split_options.num_splits = (uint32_t) max_splits;
+	}
+
+	#ifdef _OPENMP
+		// Distance functions supplied by the user are only called from the master thread
+		if ((out_clustering->num_data_points >= ISCC_HI_PARALLEL_MIN_DATA_POINTS) &&
+		        (omp_get_max_threads() > 1) &&
+		        (iscc_dist_functions.check_data_set == iscc_imp_check_data_set)) {
+			ec = iscc_hi_run_hierarchical_clustering_parallel(&cl_stack,
+			                                                  out_clustering,
+			                                                  data_set,
+			                                                  &split_options);
+			iscc_free(cl_stack.clusters);
+			iscc_free(cl_stack.pointindex_store);
+			return ec;
+		}
+	#endif
+
+	const size_t size_pointindex_array = iscc_hi_size_pointindex_array(out_clustering->num_data_points, &split_options);
 	iscc_hi_WorkArea work_area = {
-		.pointindex_array1 = malloc(sizeof(scc_PointIndex[size_pointindex_array])),
-		.pointindex_array2 = malloc(sizeof(scc_PointIndex[size_pointindex_array])),
-		.dist_array = malloc(sizeof(double[size_dist_array])),
-		.vertex_markers = calloc(out_clustering->num_data_points, sizeof(uint_fast16_t)),
-		.edge_store1 = malloc(sizeof(iscc_hi_DistanceEdge[size_largest_cluster])),
-		.edge_store2 = malloc(sizeof(iscc_hi_DistanceEdge[size_largest_cluster])),
+		.capacity = 0,
+		.num_edge_lists = split_options.num_splits,
+		.pointindex_array1 = iscc_malloc(sizeof(scc_PointIndex[size_pointindex_array])),
+		.pointindex_array2 = iscc_malloc(sizeof(scc_PointIndex[size_pointindex_array])),
+		.dist_array = NULL,
+		.vertex_markers = iscc_calloc(out_clustering->num_data_points, sizeof(uint_fast16_t)),
+		.edge_lists = NULL,
+		.scratch_heads = NULL,
+		.scratch_distances = NULL,
+		.new_clusters = NULL,
+		.assigned_to = NULL,
 	};
 
 	if ((work_area.pointindex_array1 == NULL) || (work_area.pointindex_array2 == NULL) ||
-	        (work_area.dist_array == NULL) || (work_area.vertex_markers == NULL) ||
-	        (work_area.edge_store1 == NULL) || (work_area.edge_store2 == NULL)) {
+	        (work_area.vertex_markers == NULL)) {
 		ec = iscc_make_error(SCC_ER_NO_MEMORY);
 	}
 
+	if (ec == SCC_ER_OK) {
+		ec = iscc_hi_reserve_work_area(&work_area, size_largest_cluster);
+	}
+
 	if (ec == SCC_ER_OK) {
 		ec = iscc_hi_run_hierarchical_clustering(&cl_stack,
 		                                         out_clustering,
 		                                         data_set,
 		                                         &work_area,
-		                                         size_constraint,
-		                                         batch_assign);
+		                                         &split_options);
 	}
 
-	free(work_area.pointindex_array1);
-	free(work_area.pointindex_array2);
-	free(work_area.dist_array);
-	free(work_area.vertex_markers);
-	free(work_area.edge_store1);
-	free(work_area.edge_store2);
-	free(cl_stack.clusters);
-	free(cl_stack.pointindex_store);
+	iscc_hi_free_work_area(&work_area);
+	iscc_free(cl_stack.clusters);
+	iscc_free(cl_stack.pointindex_store);
 
 	return ec;
 }
@@ -276,12 +501,12 @@ static scc_ErrorCode iscc_hi_empty_cl_stack(const size_t num_data_points,
 	*out_cl_stack = (iscc_hi_ClusterStack) {
 		.capacity = tmp_capacity,
 		.items = 1,
-		.clusters = malloc(sizeof(iscc_hi_ClusterItem[tmp_capacity])),
-		.pointindex_store = malloc(sizeof(scc_PointIndex[num_data_points])),
+		.clusters = iscc_malloc(sizeof(iscc_hi_ClusterItem[tmp_capacity])),
+		.pointindex_store = iscc_malloc(sizeof(scc_PointIndex[num_data_points])),
 	};
 	if ((out_cl_stack->clusters == NULL) || (out_cl_stack->pointindex_store == NULL)) {
-		free(out_cl_stack->clusters);
-		free(out_cl_stack->pointindex_store);
+		iscc_free(out_cl_stack->clusters);
+		iscc_free(out_cl_stack->pointindex_store);
 		return iscc_make_error(SCC_ER_NO_MEMORY);
 	}
 
@@ -317,12 +542,12 @@ static scc_ErrorCode iscc_hi_init_cl_stack(const scc_Clustering* const in_cl,
 	*out_cl_stack = (iscc_hi_ClusterStack) {
 		.capacity = (size_t) tmp_capacity,
 		.items = in_cl->num_clusters,
-		.clusters = calloc((size_t) tmp_capacity, sizeof(iscc_hi_ClusterItem)),
-		.pointindex_store = malloc(sizeof(scc_PointIndex[in_cl->num_data_points])),
+		.clusters = iscc_calloc((size_t) tmp_capacity, sizeof(iscc_hi_ClusterItem)),
+		.pointindex_store = iscc_malloc(sizeof(scc_PointIndex[in_cl->num_data_points])),
 	};
 	if ((out_cl_stack->clusters == NULL) || (out_cl_stack->pointindex_store == NULL)) {
-		free(out_cl_stack->clusters);
-		free(out_cl_stack->pointindex_store);
+		iscc_free(out_cl_stack->clusters);
+		iscc_free(out_cl_stack->pointindex_store);
 		return iscc_make_error(SCC_ER_NO_MEMORY);
 	}
 
@@ -335,7 +560,7 @@ static scc_ErrorCode iscc_hi_init_cl_stack(const scc_Clustering* const in_cl,
 		}
 	}
 
-	size_t size_largest_cluster = 0;
+	size_t size_largest_cluster = clusters[0].size;
 	clusters[0].members = out_cl_stack->pointindex_store + clusters[0].size;
 	for (size_t c = 1; c < in_cl->num_clusters; ++c) {
 		clusters[c].members = clusters[c - 1].members + clusters[c].size;
@@ -360,8 +585,7 @@ static scc_ErrorCode iscc_hi_run_hierarchical_clustering(iscc_hi_ClusterStack* c
                                                          scc_Clustering* const cl,
                                                          void* const data_set,
                                                          iscc_hi_WorkArea* const work_area,
-                                                         const uint32_t size_constraint,
-                                                         const bool batch_assign)
+                                                         const scc_HierarchicalOptions* const options)
 {
 	assert(cl_stack != NULL);
 	assert(cl_stack->items > 0);
@@ -372,19 +596,21 @@ static scc_ErrorCode iscc_hi_run_hierarchical_clustering(iscc_hi_ClusterStack* c
 	assert(iscc_check_data_set(data_set));
 	assert(iscc_num_data_points(data_set) == cl->num_data_points);
 	assert(work_area != NULL);
-	assert(size_constraint >= 2);
+	assert(options != NULL);
+	assert(options->size_constraint >= 2);
+	assert(options->num_splits >= 2);
 
 	scc_ErrorCode ec;
 	scc_Clabel current_label = 0;
 	while (cl_stack->items > 0) {
 
-		if ((ec = iscc_hi_check_capacity(cl_stack)) != SCC_ER_OK) {
+		if ((ec = iscc_hi_check_capacity(cl_stack, options->num_splits - 1)) != SCC_ER_OK) {
 			return ec;
 		}
 
 		iscc_hi_ClusterItem* current_cluster = &cl_stack->clusters[cl_stack->items - 1];
 
-		if (current_cluster->size < (2 * size_constraint)) {
+		if (current_cluster->size < (2 * options->size_constraint)) {
 			if (current_cluster->size > 0) {
 				if (current_label == SCC_CLABEL_MAX) {
 					return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many clusters (adjust the `scc_Clabel` type).");
@@ -396,14 +622,10 @@ static scc_ErrorCode iscc_hi_run_hierarchical_clustering(iscc_hi_ClusterStack* c
 			}
 			--(cl_stack->items);
 		} else {
-			iscc_hi_ClusterItem* new_cluster = NULL; // Initialize to avoid gcc warning
-			iscc_hi_push_to_stack(cl_stack, &new_cluster);
-			if ((ec = iscc_hi_break_cluster_into_two(current_cluster,
-			                                         data_set,
-			                                         work_area,
-			                                         size_constraint,
-			                                         batch_assign,
-			                                         new_cluster)) != SCC_ER_OK) {
+			if ((ec = iscc_hi_break_top_cluster(cl_stack,
+			                                    data_set,
+			                                    work_area,
+			                                    options)) != SCC_ER_OK) {
 				return ec;
 			}
 		}
@@ -417,18 +639,356 @@ static scc_ErrorCode iscc_hi_run_hierarchical_clustering(iscc_hi_ClusterStack* c
 }
 
 
-static scc_ErrorCode iscc_hi_check_capacity(iscc_hi_ClusterStack* const cl_stack)
+#ifdef _OPENMP
+
+static scc_ErrorCode iscc_hi_run_hierarchical_clustering_parallel(iscc_hi_ClusterStack* const cl_stack,
+                                                                  scc_Clustering* const cl,
+                                                                  void* const data_set,
+                                                                  const scc_HierarchicalOptions* const options)
+{
+	assert(cl_stack != NULL);
+	assert(cl_stack->items > 0);
+	assert(cl_stack->items <= cl_stack->capacity);
+	assert(cl_stack->clusters != NULL);
+	assert(cl_stack->pointindex_store != NULL);
+	assert(iscc_check_input_clustering(cl));
+	assert(iscc_check_data_set(data_set));
+	assert(iscc_num_data_points(data_set) == cl->num_data_points);
+	assert(options != NULL);
+	assert(options->size_constraint >= 2);
+	assert(options->num_splits >= 2);
+
+	const uint32_t size_constraint = options->size_constraint;
+	const int max_threads = omp_get_max_threads();
+	assert(max_threads > 1);
+
+	// Clusters that are broken give leaves with at least `size_constraint` points,
+	// and clusters that are not broken give at most one leaf each
+	const size_t max_leaves = cl_stack->items + cl->num_data_points / size_constraint;
+	iscc_hi_TaskContext ctx = {
+		.data_set = data_set,
+		.options = options,
+		.work_areas = iscc_calloc((size_t) max_threads, sizeof(iscc_hi_WorkArea)),
+		.max_leaves = max_leaves,
+		.num_leaves = 0,
+		.leaves = iscc_malloc(sizeof(iscc_hi_ClusterItem[max_leaves])),
+		.failed = 0,
+		.ec = SCC_ER_OK,
+	};
+
+	scc_ErrorCode ec = iscc_no_error();
+	if ((ctx.work_areas == NULL) || (ctx.leaves == NULL)) {
+		ec = iscc_make_error(SCC_ER_NO_MEMORY);
+	} else {
+		// The arrays that depend on the cluster size are allocated by `iscc_hi_reserve_work_area`
+		const size_t size_pointindex_array = iscc_hi_size_pointindex_array(cl->num_data_points, options);
+		for (int t = 0; t < max_threads; ++t) {
+			ctx.work_areas[t].num_edge_lists = options->num_splits;
+			ctx.work_areas[t].pointindex_array1 = iscc_malloc(sizeof(scc_PointIndex[size_pointindex_array]));
+			ctx.work_areas[t].pointindex_array2 = iscc_malloc(sizeof(scc_PointIndex[size_pointindex_array]));
+			ctx.work_areas[t].vertex_markers = iscc_calloc(cl->num_data_points, sizeof(uint_fast16_t));
+			if ((ctx.work_areas[t].pointindex_array1 == NULL) ||
+			        (ctx.work_areas[t].pointindex_array2 == NULL) ||
+			        (ctx.work_areas[t].vertex_markers == NULL)) {
+				ec = iscc_make_error(SCC_ER_NO_MEMORY);
+				break;
+			}
+		}
+	}
+
+	if (ec == SCC_ER_OK) {
+		#pragma omp parallel num_threads(max_threads)
+		#pragma omp single
+		{
+			const int thread = omp_get_thread_num();
+			// Small clusters are handed out together so that each task has some work
+			size_t end_task = cl_stack->items;
+			size_t size_task = 0;
+			for (size_t c = cl_stack->items; c > 0; --c) {
+				size_task += cl_stack->clusters[c - 1].size;
+				if ((size_task >= ISCC_HI_MIN_TASK_SIZE) || (c == 1)) {
+					size_t num_clusters = end_task - (c - 1);
+					const iscc_hi_ClusterItem* clusters = &cl_stack->clusters[c - 1];
+					#pragma omp task firstprivate(num_clusters, clusters)
+					iscc_hi_run_cluster_task(&ctx, thread, num_clusters, clusters);
+					end_task = c - 1;
+					size_task = 0;
+				}
+			}
+		}
+		// All tasks are done at the implicit barrier of `single`
+		ec = ctx.ec;
+	}
+
+	if ((ec == SCC_ER_OK) && (ctx.num_leaves > (size_t) SCC_CLABEL_MAX)) {
+		ec = iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many clusters (adjust the `scc_Clabel` type).");
+	}
+
+	if (ec == SCC_ER_OK) {
+		// The sequential clustering labels the leaves in reverse order of
+		// their members in `pointindex_store`; the parallel does the same
+		qsort(ctx.leaves, ctx.num_leaves, sizeof(iscc_hi_ClusterItem), iscc_hi_compare_leaves);
+		for (size_t l = 0; l < ctx.num_leaves; ++l) {
+			for (size_t v = 0; v < ctx.leaves[l].size; ++v) {
+				cl->cluster_label[ctx.leaves[l].members[v]] = (scc_Clabel) l;
+			}
+		}
+		cl->num_clusters = ctx.num_leaves;
+	}
+
+	if (ctx.work_areas != NULL) {
+		for (int t = 0; t < max_threads; ++t) {
+			iscc_hi_free_work_area(&ctx.work_areas[t]);
+		}
+	}
+	iscc_free(ctx.work_areas);
+	iscc_free(ctx.leaves);
+
+	return ec;
+}
+
+
+// Breaks `clusters` and their descendants, using the work area of the running thread.
+// Large clusters are handed out as new tasks when they are made, so idle threads
+// can pick them up, while smaller clusters stay on the stack of this task.
+static void iscc_hi_run_cluster_task(iscc_hi_TaskContext* const ctx,
+                                     const int creator,
+                                     const size_t num_clusters,
+                                     const iscc_hi_ClusterItem clusters[const])
+{
+	assert(ctx != NULL);
+	assert(ctx->work_areas != NULL);
+	assert(ctx->leaves != NULL);
+	assert(num_clusters > 0);
+	assert(clusters != NULL);
+
+	const int thread = omp_get_thread_num();
+	iscc_hi_WorkArea* const work_area = &ctx->work_areas[thread];
+	const uint32_t size_constraint = ctx->options->size_constraint;
+
+	iscc_hi_ClusterStack cl_stack = {
+		.capacity = num_clusters + 16,
+		.items = num_clusters,
+		.clusters = iscc_malloc(sizeof(iscc_hi_ClusterItem[num_clusters + 16])),
+		.pointindex_store = NULL,
+	};
+	if (cl_stack.clusters == NULL) {
+		iscc_hi_set_task_error(ctx, iscc_make_error(SCC_ER_NO_MEMORY));
+		return;
+	}
+
+	for (size_t c = 0; c < num_clusters; ++c) {
+		cl_stack.clusters[c] = clusters[c];
+		// The markers are only valid in the work area of the thread that made the cluster
+		if (thread != creator) {
+			iscc_hi_reset_markers(&cl_stack.clusters[c], work_area->vertex_markers);
+		}
+	}
+
+	scc_ErrorCode ec = SCC_ER_OK;
+	while (cl_stack.items > 0) {
+
+		int failed;
+		#pragma omp atomic read
+		failed = ctx->failed;
+		if (failed) break;
+
+		if ((ec = iscc_hi_check_capacity(&cl_stack, ctx->options->num_splits - 1)) != SCC_ER_OK) break;
+
+		iscc_hi_ClusterItem* current_cluster = &cl_stack.clusters[cl_stack.items - 1];
+
+		if (current_cluster->size < (2 * size_constraint)) {
+			if (current_cluster->size > 0) {
+				size_t leaf;
+				#pragma omp atomic capture
+				leaf = ctx->num_leaves++;
+				assert(leaf < ctx->max_leaves);
+				ctx->leaves[leaf] = *current_cluster;
+			}
+			--(cl_stack.items);
+		} else {
+			if ((ec = iscc_hi_reserve_work_area(work_area, current_cluster->size)) != SCC_ER_OK) break;
+
+			const size_t first_new_item = cl_stack.items;
+			if ((ec = iscc_hi_break_top_cluster(&cl_stack,
+			                                    ctx->data_set,
+			                                    work_area,
+			                                    ctx->options)) != SCC_ER_OK) {
+				break;
+			}
+
+			size_t write_item = first_new_item;
+			for (size_t c = first_new_item; c < cl_stack.items; ++c) {
+				if (cl_stack.clusters[c].size >= ISCC_HI_MIN_TASK_SIZE) {
+					iscc_hi_ClusterItem task_cluster = cl_stack.clusters[c];
+					#pragma omp task firstprivate(task_cluster)
+					iscc_hi_run_cluster_task(ctx, thread, 1, &task_cluster);
+				} else {
+					cl_stack.clusters[write_item] = cl_stack.clusters[c];
+					++write_item;
+				}
+			}
+			cl_stack.items = write_item;
+		}
+	}
+
+	iscc_free(cl_stack.clusters);
+
+	if (ec != SCC_ER_OK) {
+		iscc_hi_set_task_error(ctx, ec);
+	}
+}
+
+
+static void iscc_hi_set_task_error(iscc_hi_TaskContext* const ctx,
+                                   const scc_ErrorCode ec)
+{
+	assert(ctx != NULL);
+	assert(ec != SCC_ER_OK);
+
+	#pragma omp critical(iscc_hi_task_error)
+	{
+		if (ctx->ec == SCC_ER_OK) ctx->ec = ec;
+	}
+
+	#pragma omp atomic write
+	ctx->failed = 1;
+}
+
+
+static int iscc_hi_compare_leaves(const void* const a,
+                                  const void* const b)
+{
+	const scc_PointIndex* const members_a = ((const iscc_hi_ClusterItem*)a)->members;
+	const scc_PointIndex* const members_b = ((const iscc_hi_ClusterItem*)b)->members;
+
+	if (members_a > members_b) return -1;
+	if (members_a < members_b) return 1;
+	return 0;
+}
+
+#endif // ifdef _OPENMP
+
+
+// `pointindex_array1` and `pointindex_array2` hold the nearest neighbors when
+// breaking clusters and the probes when finding centers
+static inline size_t iscc_hi_size_pointindex_array(const size_t num_data_points,
+                                                   const scc_HierarchicalOptions* const options)
+{
+	assert(options != NULL);
+
+	const size_t num_probes = (options->num_center_probes < num_data_points) ? options->num_center_probes : num_data_points;
+	return (options->size_constraint > num_probes) ? options->size_constraint : num_probes;
+}
+
+
+static scc_ErrorCode iscc_hi_reserve_work_area(iscc_hi_WorkArea* const work_area,
+                                               const size_t cluster_size)
+{
+	assert(work_area != NULL);
+
+	if (cluster_size <= work_area->capacity) return iscc_no_error();
+
+	// The arrays are overwritten when breaking clusters, so the old content is not kept
+	iscc_hi_free_cluster_arrays(work_area);
+
+	// Two distance rows, which also fit the distances in `iscc_hi_find_centers`
+	const size_t size_dist_array = 2 * cluster_size;
+	const uint32_t num_edge_lists = work_area->num_edge_lists;
+	work_area->dist_array = iscc_malloc(sizeof(double[size_dist_array]));
+	work_area->edge_lists = iscc_calloc(num_edge_lists, sizeof(iscc_hi_EdgeList));
+	work_area->scratch_heads = iscc_malloc(sizeof(scc_PointIndex[cluster_size]));
+	work_area->scratch_distances = iscc_malloc(sizeof(double[cluster_size]));
+
+	bool memory_ok = (work_area->dist_array != NULL) && (work_area->edge_lists != NULL) &&
+	                 (work_area->scratch_heads != NULL) && (work_area->scratch_distances != NULL);
+	for (uint32_t l = 0; memory_ok && (l < num_edge_lists); ++l) {
+		work_area->edge_lists[l] = (iscc_hi_EdgeList) {
+			.heads = iscc_malloc(sizeof(scc_PointIndex[cluster_size])),
+			.distances = iscc_malloc(sizeof(double[cluster_size])),
+			.next = iscc_malloc(sizeof(uint32_t[cluster_size])),
+		};
+		memory_ok = (work_area->edge_lists[l].heads != NULL) &&
+		            (work_area->edge_lists[l].distances != NULL) &&
+		            (work_area->edge_lists[l].next != NULL);
+	}
+	if (memory_ok && (num_edge_lists > 2)) {
+		work_area->new_clusters = iscc_malloc(sizeof(iscc_hi_NewCluster[num_edge_lists]));
+		work_area->assigned_to = iscc_malloc(sizeof(uint32_t[cluster_size]));
+		memory_ok = (work_area->new_clusters != NULL) && (work_area->assigned_to != NULL);
+	}
+
+	if (!memory_ok) {
+		iscc_hi_free_cluster_arrays(work_area);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	work_area->capacity = cluster_size;
+
+	return iscc_no_error();
+}
+
+
+static void iscc_hi_free_work_area(iscc_hi_WorkArea* const work_area)
+{
+	assert(work_area != NULL);
+
+	iscc_free(work_area->pointindex_array1);
+	iscc_free(work_area->pointindex_array2);
+	iscc_free(work_area->vertex_markers);
+	work_area->pointindex_array1 = NULL;
+	work_area->pointindex_array2 = NULL;
+	work_area->vertex_markers = NULL;
+	iscc_hi_free_cluster_arrays(work_area);
+}
+
+
+// Frees the arrays that depend on the cluster size
+static void iscc_hi_free_cluster_arrays(iscc_hi_WorkArea* const work_area)
+{
+	assert(work_area != NULL);
+
+	if (work_area->edge_lists != NULL) {
+		for (uint32_t l = 0; l < work_area->num_edge_lists; ++l) {
+			iscc_free(work_area->edge_lists[l].heads);
+			iscc_free(work_area->edge_lists[l].distances);
+			iscc_free(work_area->edge_lists[l].next);
+		}
+	}
+	iscc_free(work_area->dist_array);
+	iscc_free(work_area->edge_lists);
+	iscc_free(work_area->scratch_heads);
+	iscc_free(work_area->scratch_distances);
+	iscc_free(work_area->new_clusters);
+	iscc_free(work_area->assigned_to);
+
+	work_area->capacity = 0;
+	work_area->dist_array = NULL;
+	work_area->edge_lists = NULL;
+	work_area->scratch_heads = NULL;
+	work_area->scratch_distances = NULL;
+	work_area->new_clusters = NULL;
+	work_area->assigned_to = NULL;
+}
+
+
+// Makes room for `num_to_push` more clusters on the stack
+static scc_ErrorCode iscc_hi_check_capacity(iscc_hi_ClusterStack* const cl_stack,
+                                            const uint32_t num_to_push)
 {
 	assert(cl_stack != NULL);
 	assert(cl_stack->items <= cl_stack->capacity);
 	assert(cl_stack->clusters != NULL);
+	assert(num_to_push > 0);
 
-	if (cl_stack->items == cl_stack->capacity) {
-		const uintmax_t capacity_tmp = cl_stack->capacity + 16 + (cl_stack->capacity >> 4);
+	const uintmax_t capacity_needed = ((uintmax_t) cl_stack->items) + num_to_push;
+	if (capacity_needed > cl_stack->capacity) {
+		uintmax_t capacity_tmp = cl_stack->capacity + 16 + (cl_stack->capacity >> 4);
+		if (capacity_tmp < capacity_needed) capacity_tmp = capacity_needed;
 		if ((capacity_tmp > SIZE_MAX) || (capacity_tmp < cl_stack->capacity)) {
 			return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many clusters.");
 		}
-		iscc_hi_ClusterItem* const clusters_tmp = realloc(cl_stack->clusters, sizeof(iscc_hi_ClusterItem[(size_t) capacity_tmp]));
+		iscc_hi_ClusterItem* const clusters_tmp = iscc_realloc(cl_stack->clusters, sizeof(iscc_hi_ClusterItem[(size_t) capacity_tmp]));
 		if (clusters_tmp == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 		cl_stack->clusters = clusters_tmp;
 		cl_stack->capacity = (size_t) capacity_tmp;
@@ -438,39 +998,82 @@ static scc_ErrorCode iscc_hi_check_capacity(iscc_hi_ClusterStack* const cl_stack
 }
 
 
-static inline void iscc_hi_push_to_stack(iscc_hi_ClusterStack* const cl_stack,
-                                         iscc_hi_ClusterItem** const cl)
+// Breaks the cluster at the top of the stack into `options->num_splits` clusters, or into as many
+// as the size constraint allows, and pushes the new clusters to the stack. The new clusters follow
+// the broken cluster in `pointindex_store` in the order they are pushed.
+static scc_ErrorCode iscc_hi_break_top_cluster(iscc_hi_ClusterStack* const cl_stack,
+                                               void* const data_set,
+                                               iscc_hi_WorkArea* const work_area,
+                                               const scc_HierarchicalOptions* const options)
 {
 	assert(cl_stack != NULL);
-	assert(cl_stack->items <= cl_stack->capacity);
+	assert(cl_stack->items > 0);
 	assert(cl_stack->clusters != NULL);
-	assert(cl != NULL);
+	assert(cl_stack->items + options->num_splits - 1 <= cl_stack->capacity);
+	assert(iscc_check_data_set(data_set));
+	assert(work_area != NULL);
+	assert(options != NULL);
+	assert(options->num_splits >= 2);
+	assert(options->num_splits <= work_area->num_edge_lists);
+
+	iscc_hi_ClusterItem* const cluster_to_break = &cl_stack->clusters[cl_stack->items - 1];
+	const size_t max_ways = cluster_to_break->size / options->size_constraint;
+	const uint32_t num_ways = (max_ways < options->num_splits) ? (uint32_t) max_ways : options->num_splits;
+	assert(num_ways >= 2);
+
+	iscc_hi_ClusterItem* const new_clusters = &cl_stack->clusters[cl_stack->items];
+	cl_stack->items += num_ways - 1;
+
+	if (options->split_method == SCC_SP_COORDINATES) {
+		iscc_hi_break_cluster_by_coordinates(cluster_to_break,
+		                                     data_set,
+		                                     work_area,
+		                                     options->size_constraint,
+		                                     num_ways,
+		                                     new_clusters);
+		return iscc_no_error();
+	}
 
-	*cl = &cl_stack->clusters[cl_stack->items];
-	++(cl_stack->items);
+	if (num_ways == 2) {
+		return iscc_hi_break_cluster_into_two(cluster_to_break,
+		                                      data_set,
+		                                      work_area,
+		                                      options,
+		                                      new_clusters);
+	}
+
+	return iscc_hi_break_cluster_into_k(cluster_to_break,
+	                                    data_set,
+	                                    work_area,
+	                                    options,
+	                                    num_ways,
+	                                    new_clusters);
 }
 
 
 static scc_ErrorCode iscc_hi_break_cluster_into_two(iscc_hi_ClusterItem* const cluster_to_break,
                                                     void* const data_set,
                                                     iscc_hi_WorkArea* const work_area,
-                                                    const uint32_t size_constraint,
-                                                    const bool batch_assign,
+                                                    const scc_HierarchicalOptions* const options,
                                                     iscc_hi_ClusterItem* const out_new_cluster)
 {
 	assert(cluster_to_break != NULL);
-	assert(cluster_to_break->size >= 2 * size_constraint);
+	assert(options != NULL);
+	assert(cluster_to_break->size >= 2 * options->size_constraint);
 	assert(cluster_to_break->members != NULL);
 	assert(iscc_check_data_set(data_set));
 	assert(work_area != NULL);
+	assert(work_area->capacity >= cluster_to_break->size);
 	assert(work_area->pointindex_array1 != NULL);
 	assert(work_area->pointindex_array2 != NULL);
+	assert(work_area->dist_array != NULL);
 	assert(work_area->vertex_markers != NULL);
-	assert(work_area->edge_store1 != NULL);
-	assert(work_area->edge_store2 != NULL);
-	assert(size_constraint >= 2);
+	assert(options->size_constraint >= 2);
 	assert(out_new_cluster != NULL);
 
+	const uint32_t size_constraint = options->size_constraint;
+	const bool batch_assign = options->batch_assign;
+
 	scc_ErrorCode ec;
 	scc_PointIndex center1 = ISCC_POINTINDEX_MAX_PI, center2 = ISCC_POINTINDEX_MAX_PI; // Initialize these to avoid gcc warning
 	// `iscc_hi_find_centers` must be before `iscc_hi_get_next_marker`
@@ -478,6 +1081,7 @@ static scc_ErrorCode iscc_hi_break_cluster_into_two(iscc_hi_ClusterItem* const c
 	if ((ec = iscc_hi_find_centers(cluster_to_break,
 	                               data_set,
 	                               work_area,
+	                               options,
 	                               &center1,
 	                               &center2)) != SCC_ER_OK) {
 		return ec;
@@ -495,12 +1099,18 @@ static scc_ErrorCode iscc_hi_break_cluster_into_two(iscc_hi_ClusterItem* const c
 	scc_PointIndex* const k_nn_array2 = work_area->pointindex_array2;
 	uint_fast16_t* const vertex_markers = work_area->vertex_markers;
 
-	// `edge_store1` and `edge_store2` have been populated by `iscc_hi_populate_edge_lists`
-	iscc_hi_DistanceEdge* last_assigned_edge1 = work_area->edge_store1;
-	iscc_hi_DistanceEdge* last_assigned_edge2 = work_area->edge_store2;
+	// The first two edge lists have been populated by `iscc_hi_populate_edge_lists`
+	const iscc_hi_EdgeList* const edge_list1 = &work_area->edge_lists[0];
+	const iscc_hi_EdgeList* const edge_list2 = &work_area->edge_lists[1];
+	const double* const distances1 = edge_list1->distances;
+	const double* const distances2 = edge_list2->distances;
+
+	// Entry 0 is the center
+	uint32_t last_assigned_edge1 = 0;
+	uint32_t last_assigned_edge2 = 0;
 
-	iscc_hi_DistanceEdge* temp_edge1;
-	iscc_hi_DistanceEdge* temp_edge2;
+	uint32_t temp_edge1;
+	uint32_t temp_edge2;
 
 	size_t num_unassigned = cluster_to_break->size;
 	const uint_fast16_t curr_marker = iscc_hi_get_next_marker(cluster_to_break, vertex_markers);
@@ -518,20 +1128,20 @@ static scc_ErrorCode iscc_hi_break_cluster_into_two(iscc_hi_ClusterItem* const c
 	iscc_hi_move_point_to_cluster1(center1, cluster1, vertex_markers, curr_marker);
 	iscc_hi_move_point_to_cluster2(center2, cluster2, vertex_markers, curr_marker);
 
-	temp_edge1 = iscc_hi_get_next_k_nn(last_assigned_edge1, size_constraint - 1, vertex_markers, curr_marker, k_nn_array1);
-	temp_edge2 = iscc_hi_get_next_k_nn(last_assigned_edge2, size_constraint - 1, vertex_markers, curr_marker, k_nn_array2);
+	temp_edge1 = iscc_hi_get_next_k_nn(edge_list1, last_assigned_edge1, size_constraint - 1, vertex_markers, curr_marker, k_nn_array1);
+	temp_edge2 = iscc_hi_get_next_k_nn(edge_list2, last_assigned_edge2, size_constraint - 1, vertex_markers, curr_marker, k_nn_array2);
 
-	if (temp_edge1->distance >= temp_edge2->distance) {
+	if (distances1[temp_edge1] >= distances2[temp_edge2]) {
 		iscc_hi_move_array_to_cluster1(size_constraint - 1, k_nn_array1, cluster1, vertex_markers, curr_marker);
 		last_assigned_edge1 = temp_edge1;
 
-		last_assigned_edge2 = iscc_hi_get_next_k_nn(last_assigned_edge2, size_constraint - 1, vertex_markers, curr_marker, k_nn_array2);
+		last_assigned_edge2 = iscc_hi_get_next_k_nn(edge_list2, last_assigned_edge2, size_constraint - 1, vertex_markers, curr_marker, k_nn_array2);
 		iscc_hi_move_array_to_cluster2(size_constraint - 1, k_nn_array2, cluster2, vertex_markers, curr_marker);
 	} else {
 		iscc_hi_move_array_to_cluster2(size_constraint - 1, k_nn_array2, cluster2, vertex_markers, curr_marker);
 		last_assigned_edge2 = temp_edge2;
 
-		last_assigned_edge1 = iscc_hi_get_next_k_nn(last_assigned_edge1, size_constraint - 1, vertex_markers, curr_marker, k_nn_array1);
+		last_assigned_edge1 = iscc_hi_get_next_k_nn(edge_list1, last_assigned_edge1, size_constraint - 1, vertex_markers, curr_marker, k_nn_array1);
 		iscc_hi_move_array_to_cluster1(size_constraint - 1, k_nn_array1, cluster1, vertex_markers, curr_marker);
 	}
 
@@ -545,10 +1155,10 @@ static scc_ErrorCode iscc_hi_break_cluster_into_two(iscc_hi_ClusterItem* const c
 
 			if (num_assign_in_batch > num_unassigned) num_assign_in_batch = (uint32_t) num_unassigned;
 
-			temp_edge1 = iscc_hi_get_next_k_nn(last_assigned_edge1, num_assign_in_batch, vertex_markers, curr_marker, k_nn_array1);
-			temp_edge2 = iscc_hi_get_next_k_nn(last_assigned_edge2, num_assign_in_batch, vertex_markers, curr_marker, k_nn_array2);
+			temp_edge1 = iscc_hi_get_next_k_nn(edge_list1, last_assigned_edge1, num_assign_in_batch, vertex_markers, curr_marker, k_nn_array1);
+			temp_edge2 = iscc_hi_get_next_k_nn(edge_list2, last_assigned_edge2, num_assign_in_batch, vertex_markers, curr_marker, k_nn_array2);
 
-			if (temp_edge1->distance <= temp_edge2->distance) {
+			if (distances1[temp_edge1] <= distances2[temp_edge2]) {
 				iscc_hi_move_array_to_cluster1(num_assign_in_batch, k_nn_array1, cluster1, vertex_markers, curr_marker);
 				last_assigned_edge1 = temp_edge1;
 			} else {
@@ -559,14 +1169,14 @@ static scc_ErrorCode iscc_hi_break_cluster_into_two(iscc_hi_ClusterItem* const c
 
 	} else {
 		for (; num_unassigned > 0; --num_unassigned) {
-			temp_edge1 = iscc_hi_get_next_dist(last_assigned_edge1, vertex_markers, curr_marker);
-			temp_edge2 = iscc_hi_get_next_dist(last_assigned_edge2, vertex_markers, curr_marker);
+			temp_edge1 = iscc_hi_get_next_dist(edge_list1, last_assigned_edge1, vertex_markers, curr_marker);
+			temp_edge2 = iscc_hi_get_next_dist(edge_list2, last_assigned_edge2, vertex_markers, curr_marker);
 
-			if (temp_edge1->distance <= temp_edge2->distance) {
-				iscc_hi_move_point_to_cluster1(temp_edge1->head, cluster1, vertex_markers, curr_marker);
+			if (distances1[temp_edge1] <= distances2[temp_edge2]) {
+				iscc_hi_move_point_to_cluster1(edge_list1->heads[temp_edge1], cluster1, vertex_markers, curr_marker);
 				last_assigned_edge1 = temp_edge1;
 			} else {
-				iscc_hi_move_point_to_cluster2(temp_edge2->head, cluster2, vertex_markers, curr_marker);
+				iscc_hi_move_point_to_cluster2(edge_list2->heads[temp_edge2], cluster2, vertex_markers, curr_marker);
 				last_assigned_edge2 = temp_edge2;
 			}
 		}
@@ -581,6 +1191,345 @@ static scc_ErrorCode iscc_hi_break_cluster_into_two(iscc_hi_ClusterItem* const c
 }
 
 
+// Breaks a cluster into `num_ways` clusters. The centers are the two points
+// found by `iscc_hi_find_centers` followed by the points found by a
+// farthest-first traversal from them. The centers then pick their nearest
+// points and the remaining points are assigned as in `iscc_hi_break_cluster_into_two`.
+static scc_ErrorCode iscc_hi_break_cluster_into_k(iscc_hi_ClusterItem* const cluster_to_break,
+                                                  void* const data_set,
+                                                  iscc_hi_WorkArea* const work_area,
+                                                  const scc_HierarchicalOptions* const options,
+                                                  const uint32_t num_ways,
+                                                  iscc_hi_ClusterItem out_new_clusters[const])
+{
+	assert(cluster_to_break != NULL);
+	assert(options != NULL);
+	assert(num_ways > 2);
+	assert(cluster_to_break->size >= num_ways * options->size_constraint);
+	assert(cluster_to_break->members != NULL);
+	assert(iscc_check_data_set(data_set));
+	assert(work_area != NULL);
+	assert(work_area->capacity >= cluster_to_break->size);
+	assert(work_area->num_edge_lists >= num_ways);
+	assert(work_area->pointindex_array1 != NULL);
+	assert(work_area->pointindex_array2 != NULL);
+	assert(work_area->vertex_markers != NULL);
+	assert(work_area->new_clusters != NULL);
+	assert(work_area->assigned_to != NULL);
+	assert(options->size_constraint >= 2);
+	assert(out_new_clusters != NULL);
+
+	const uint32_t size_constraint = options->size_constraint;
+	const bool batch_assign = options->batch_assign;
+
+	scc_ErrorCode ec;
+	// `iscc_hi_find_k_centers` must be before `iscc_hi_get_next_marker`
+	// since the marker becomes invalid after `iscc_hi_find_k_centers`
+	if ((ec = iscc_hi_find_k_centers(cluster_to_break,
+	                                 data_set,
+	                                 work_area,
+	                                 options,
+	                                 num_ways)) != SCC_ER_OK) {
+		return ec;
+	}
+
+	scc_PointIndex* candidate_array = work_area->pointindex_array1;
+	scc_PointIndex* best_array = work_area->pointindex_array2;
+	uint_fast16_t* const vertex_markers = work_area->vertex_markers;
+	const iscc_hi_EdgeList* const edge_lists = work_area->edge_lists;
+	iscc_hi_NewCluster* const new_clusters = work_area->new_clusters;
+
+	size_t num_unassigned = cluster_to_break->size;
+	size_t num_assigned = 0;
+	const uint_fast16_t curr_marker = iscc_hi_get_next_marker(cluster_to_break, vertex_markers);
+
+	for (uint32_t c = 0; c < num_ways; ++c) {
+		new_clusters[c].picked_nearest = false;
+		new_clusters[c].last_assigned_edge = 0; // Entry 0 is the center
+		new_clusters[c].size = 0;
+		iscc_hi_assign_to_new_cluster(1, &new_clusters[c].center, c, work_area, curr_marker, &num_assigned);
+	}
+
+	// In each round, the center with the farthest nearest neighbors picks first
+	for (uint32_t round = 0; round < num_ways; ++round) {
+		uint32_t best_cluster = num_ways;
+		uint32_t best_edge = 0;
+		for (uint32_t c = 0; c < num_ways; ++c) {
+			if (new_clusters[c].picked_nearest) continue;
+			const uint32_t temp_edge = iscc_hi_get_next_k_nn(&edge_lists[c], new_clusters[c].last_assigned_edge, size_constraint - 1, vertex_markers, curr_marker, candidate_array);
+			if ((best_cluster == num_ways) || (edge_lists[c].distances[temp_edge] > edge_lists[best_cluster].distances[best_edge])) {
+				best_cluster = c;
+				best_edge = temp_edge;
+				scc_PointIndex* const tmp_array = best_array;
+				best_array = candidate_array;
+				candidate_array = tmp_array;
+			}
+		}
+		assert(best_cluster < num_ways);
+		iscc_hi_assign_to_new_cluster(size_constraint - 1, best_array, best_cluster, work_area, curr_marker, &num_assigned);
+		new_clusters[best_cluster].picked_nearest = true;
+		new_clusters[best_cluster].last_assigned_edge = best_edge;
+	}
+
+	num_unassigned -= num_ways * size_constraint;
+
+	if (batch_assign) {
+		uint32_t num_assign_in_batch = size_constraint;
+		for (; num_unassigned > 0; num_unassigned -= num_assign_in_batch) {
+
+			if (num_assign_in_batch > num_unassigned) num_assign_in_batch = (uint32_t) num_unassigned;
+
+			uint32_t best_cluster = 0;
+			uint32_t best_edge = iscc_hi_get_next_k_nn(&edge_lists[0], new_clusters[0].last_assigned_edge, num_assign_in_batch, vertex_markers, curr_marker, best_array);
+			for (uint32_t c = 1; c < num_ways; ++c) {
+				const uint32_t temp_edge = iscc_hi_get_next_k_nn(&edge_lists[c], new_clusters[c].last_assigned_edge, num_assign_in_batch, vertex_markers, curr_marker, candidate_array);
+				if (edge_lists[c].distances[temp_edge] < edge_lists[best_cluster].distances[best_edge]) {
+					best_cluster = c;
+					best_edge = temp_edge;
+					scc_PointIndex* const tmp_array = best_array;
+					best_array = candidate_array;
+					candidate_array = tmp_array;
+				}
+			}
+			iscc_hi_assign_to_new_cluster(num_assign_in_batch, best_array, best_cluster, work_area, curr_marker, &num_assigned);
+			new_clusters[best_cluster].last_assigned_edge = best_edge;
+		}
+
+	} else {
+		for (; num_unassigned > 0; --num_unassigned) {
+			uint32_t best_cluster = 0;
+			uint32_t best_edge = iscc_hi_get_next_dist(&edge_lists[0], new_clusters[0].last_assigned_edge, vertex_markers, curr_marker);
+			for (uint32_t c = 1; c < num_ways; ++c) {
+				const uint32_t temp_edge = iscc_hi_get_next_dist(&edge_lists[c], new_clusters[c].last_assigned_edge, vertex_markers, curr_marker);
+				if (edge_lists[c].distances[temp_edge] < edge_lists[best_cluster].distances[best_edge]) {
+					best_cluster = c;
+					best_edge = temp_edge;
+				}
+			}
+			iscc_hi_assign_to_new_cluster(1, &edge_lists[best_cluster].heads[best_edge], best_cluster, work_area, curr_marker, &num_assigned);
+			new_clusters[best_cluster].last_assigned_edge = best_edge;
+		}
+	}
+
+	assert(num_unassigned == 0);
+	assert(num_assigned == cluster_to_break->size);
+
+	// Write the new clusters back as consecutive segments of `cluster_to_break->members`
+	scc_PointIndex* write_members = cluster_to_break->members;
+	for (uint32_t c = 0; c < num_ways; ++c) {
+		assert(new_clusters[c].size >= size_constraint);
+		new_clusters[c].write_members = write_members;
+		write_members += new_clusters[c].size;
+	}
+
+	const scc_PointIndex* const assigned_points = work_area->scratch_heads;
+	const uint32_t* const assigned_to = work_area->assigned_to;
+	for (size_t i = 0; i < num_assigned; ++i) {
+		*(new_clusters[assigned_to[i]].write_members) = assigned_points[i];
+		++(new_clusters[assigned_to[i]].write_members);
+	}
+
+	cluster_to_break->size = new_clusters[0].size;
+	for (uint32_t c = 1; c < num_ways; ++c) {
+		out_new_clusters[c - 1] = (iscc_hi_ClusterItem) {
+			.size = new_clusters[c].size,
+			.marker = curr_marker,
+			.members = new_clusters[c].write_members - new_clusters[c].size,
+		};
+	}
+
+	return iscc_no_error();
+}
+
+
+// Breaks a cluster into `num_ways` clusters by sorting the points along the
+// dimension with the largest range in the cluster. The clusters get (almost)
+// equally many multiples of `size_constraint` points, and the last cluster
+// gets the remainder, so that no points are wasted when the clusters are broken
+// further. The first edge list is used as sort buffer.
+static void iscc_hi_break_cluster_by_coordinates(iscc_hi_ClusterItem* const cluster_to_break,
+                                                 const scc_DataSet* const data_set,
+                                                 iscc_hi_WorkArea* const work_area,
+                                                 const uint32_t size_constraint,
+                                                 const uint32_t num_ways,
+                                                 iscc_hi_ClusterItem out_new_clusters[const])
+{
+	assert(cluster_to_break != NULL);
+	assert(size_constraint >= 2);
+	assert(num_ways >= 2);
+	assert(cluster_to_break->size >= num_ways * size_constraint);
+	assert(cluster_to_break->members != NULL);
+	assert(data_set != NULL);
+	assert(data_set->num_dimensions > 0);
+	assert(work_area != NULL);
+	assert(work_area->capacity >= cluster_to_break->size);
+	assert(work_area->edge_lists != NULL);
+	assert(out_new_clusters != NULL);
+
+	const size_t size = cluster_to_break->size;
+	scc_PointIndex* const members = cluster_to_break->members;
+	const size_t num_dimensions = data_set->num_dimensions;
+
+	size_t widest_dimension = 0;
+	double widest_range = -1.0;
+	for (size_t d = 0; d < num_dimensions; ++d) {
+		const double* const data_column = data_set->data_matrix + d;
+		double min_value = data_column[((size_t) members[0]) * num_dimensions];
+		double max_value = min_value;
+		for (size_t i = 1; i < size; ++i) {
+			const double value = data_column[((size_t) members[i]) * num_dimensions];
+			if (value < min_value) min_value = value;
+			if (value > max_value) max_value = value;
+		}
+		if (max_value - min_value > widest_range) {
+			widest_range = max_value - min_value;
+			widest_dimension = d;
+		}
+	}
+
+	scc_PointIndex* const heads = work_area->edge_lists[0].heads;
+	double* const coordinates = work_area->edge_lists[0].distances;
+	const double* const data_column = data_set->data_matrix + widest_dimension;
+	for (size_t i = 0; i < size; ++i) {
+		heads[i] = members[i];
+		coordinates[i] = data_column[((size_t) members[i]) * num_dimensions];
+	}
+
+	iscc_hi_sort_edges(size,
+	                   heads,
+	                   coordinates,
+	                   work_area->scratch_heads,
+	                   work_area->scratch_distances);
+
+	memcpy(members, heads, sizeof(scc_PointIndex[size]));
+
+	// Cluster `c` ends at `size_constraint * floor((c + 1) * num_units / num_ways)`
+	const size_t num_units = size / size_constraint;
+	cluster_to_break->size = size_constraint * (num_units / num_ways);
+	scc_PointIndex* next_members = members + cluster_to_break->size;
+	for (uint32_t c = 1; c < num_ways; ++c) {
+		const size_t tmp_size = (c + 1 == num_ways) ?
+		                        (size_t) (members + size - next_members) :
+		                        size_constraint * (((c + 1) * num_units) / num_ways - (c * num_units) / num_ways);
+		assert(tmp_size >= size_constraint);
+		out_new_clusters[c - 1] = (iscc_hi_ClusterItem) {
+			.size = tmp_size,
+			.marker = cluster_to_break->marker,
+			.members = next_members,
+		};
+		next_members += tmp_size;
+	}
+
+	assert(next_members == members + size);
+}
+
+
+// Finds `num_ways` centers and populates their edge lists. The first row of
+// `dist_array` holds the distances from the latest center and the second row
+// holds the distances to the closest center found so far.
+static scc_ErrorCode iscc_hi_find_k_centers(iscc_hi_ClusterItem* const cl,
+                                            void* const data_set,
+                                            iscc_hi_WorkArea* const work_area,
+                                            const scc_HierarchicalOptions* const options,
+                                            const uint32_t num_ways)
+{
+	assert(cl != NULL);
+	assert(options != NULL);
+	assert(num_ways > 2);
+	assert(cl->size >= 2 * num_ways);
+	assert(cl->members != NULL);
+	assert(iscc_check_data_set(data_set));
+	assert(work_area != NULL);
+	assert(work_area->dist_array != NULL);
+	assert(work_area->num_edge_lists >= num_ways);
+	assert(work_area->new_clusters != NULL);
+
+	iscc_hi_NewCluster* const new_clusters = work_area->new_clusters;
+
+	scc_ErrorCode ec;
+	if ((ec = iscc_hi_find_centers(cl,
+	                               data_set,
+	                               work_area,
+	                               options,
+	                               &new_clusters[0].center,
+	                               &new_clusters[1].center)) != SCC_ER_OK) {
+		return ec;
+	}
+
+	double* const row_dists = work_area->dist_array;
+	double* const min_dists = work_area->dist_array + cl->size;
+
+	for (uint32_t c = 0; c < num_ways; ++c) {
+		const scc_PointIndex center = new_clusters[c].center;
+		if (!iscc_get_dist_rows(data_set,
+		                        1,
+		                        &center,
+		                        cl->size,
+		                        cl->members,
+		                        row_dists)) {
+			return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+		}
+
+		// Centers are given a negative distance so they are never picked again
+		for (size_t i = 0; i < cl->size; ++i) {
+			if (cl->members[i] == center) {
+				min_dists[i] = -1.0;
+			} else if ((c == 0) || (row_dists[i] < min_dists[i])) {
+				min_dists[i] = row_dists[i];
+			}
+		}
+
+		iscc_hi_sort_edge_list(cl, center, row_dists, work_area, &work_area->edge_lists[c]);
+
+		if ((c > 0) && (c + 1 < num_ways)) {
+			size_t farthest = 0;
+			for (size_t i = 1; i < cl->size; ++i) {
+				if (min_dists[i] > min_dists[farthest]) farthest = i;
+			}
+			assert(min_dists[farthest] >= 0.0);
+			new_clusters[c + 1].center = cl->members[farthest];
+		}
+	}
+
+	return iscc_no_error();
+}
+
+
+// Records that the points in `ids` are assigned to `new_cluster`. The points
+// are stored in `scratch_heads` in the order they are assigned, which is free
+// to use once the edge lists are sorted.
+static inline void iscc_hi_assign_to_new_cluster(const uint32_t len_ids,
+                                                 const scc_PointIndex ids[const static len_ids],
+                                                 const uint32_t new_cluster,
+                                                 iscc_hi_WorkArea* const work_area,
+                                                 const uint_fast16_t curr_marker,
+                                                 size_t* const num_assigned)
+{
+	assert(len_ids > 0);
+	assert(ids != NULL);
+	assert(work_area != NULL);
+	assert(work_area->vertex_markers != NULL);
+	assert(work_area->scratch_heads != NULL);
+	assert(work_area->assigned_to != NULL);
+	assert(work_area->new_clusters != NULL);
+	assert(num_assigned != NULL);
+	assert(*num_assigned + len_ids <= work_area->capacity);
+
+	uint_fast16_t* const vertex_markers = work_area->vertex_markers;
+	scc_PointIndex* const assigned_points = work_area->scratch_heads + *num_assigned;
+	uint32_t* const assigned_to = work_area->assigned_to + *num_assigned;
+	for (uint32_t i = 0; i < len_ids; ++i) {
+		assert(vertex_markers[ids[i]] != curr_marker);
+		vertex_markers[ids[i]] = curr_marker;
+		assigned_points[i] = ids[i];
+		assigned_to[i] = new_cluster;
+	}
+
+	*num_assigned += len_ids;
+	work_area->new_clusters[new_cluster].size += len_ids;
+}
+
+
 static inline uint_fast16_t iscc_hi_get_next_marker(iscc_hi_ClusterItem* const cl,
                                                     uint_fast16_t vertex_markers[const])
 {
@@ -590,10 +1539,7 @@ static inline uint_fast16_t iscc_hi_get_next_marker(iscc_hi_ClusterItem* const c
 	assert(vertex_markers != NULL);
 
 	if (cl->marker == UINT_FAST16_MAX) {
-		cl->marker = 0;
-		for (size_t i = 0; i < cl->size; ++i) {
-			vertex_markers[cl->members[i]] = 0;
-		}
+		iscc_hi_reset_markers(cl, vertex_markers);
 	}
 
 	++(cl->marker);
@@ -601,42 +1547,60 @@ static inline uint_fast16_t iscc_hi_get_next_marker(iscc_hi_ClusterItem* const c
 }
 
 
-static inline iscc_hi_DistanceEdge* iscc_hi_get_next_k_nn(iscc_hi_DistanceEdge* prev_dist,
-                                                          const uint32_t k,
-                                                          const uint_fast16_t vertex_markers[const],
-                                                          const uint_fast16_t curr_marker,
-                                                          scc_PointIndex out_dist_array[const static k])
+static inline void iscc_hi_reset_markers(iscc_hi_ClusterItem* const cl,
+                                         uint_fast16_t vertex_markers[const])
 {
-	assert(prev_dist != NULL);
-	assert(prev_dist->next_dist != NULL); // We should never reach the end!
+	assert(cl != NULL);
+	assert((cl->size == 0) || (cl->members != NULL));
+	assert(vertex_markers != NULL);
+
+	cl->marker = 0;
+	for (size_t i = 0; i < cl->size; ++i) {
+		vertex_markers[cl->members[i]] = 0;
+	}
+}
+
+
+static inline uint32_t iscc_hi_get_next_k_nn(const iscc_hi_EdgeList* const edge_list,
+                                             uint32_t prev_dist,
+                                             const uint32_t k,
+                                             const uint_fast16_t vertex_markers[const],
+                                             const uint_fast16_t curr_marker,
+                                             scc_PointIndex out_dist_array[const static k])
+{
+	assert(edge_list != NULL);
+	assert(edge_list->next[prev_dist] != ISCC_HI_LIST_END); // We should never reach the end!
 	assert(k > 0);
 	assert(vertex_markers != NULL);
 	assert(out_dist_array != NULL);
 
 	for (uint32_t found = 0; found < k; ++found) {
-		prev_dist = iscc_hi_get_next_dist(prev_dist, vertex_markers, curr_marker);
-		out_dist_array[found] = prev_dist->head;
+		prev_dist = iscc_hi_get_next_dist(edge_list, prev_dist, vertex_markers, curr_marker);
+		out_dist_array[found] = edge_list->heads[prev_dist];
 	}
 
 	return prev_dist;
 }
 
 
-static inline iscc_hi_DistanceEdge* iscc_hi_get_next_dist(iscc_hi_DistanceEdge* const prev_dist,
-                                                          const uint_fast16_t vertex_markers[const],
-                                                          const uint_fast16_t curr_marker)
+static inline uint32_t iscc_hi_get_next_dist(const iscc_hi_EdgeList* const edge_list,
+                                             const uint32_t prev_dist,
+                                             const uint_fast16_t vertex_markers[const],
+                                             const uint_fast16_t curr_marker)
 {
-	assert(prev_dist != NULL);
-	assert(prev_dist->next_dist != NULL); // We should never reach the end!
+	assert(edge_list != NULL);
+	assert(edge_list->next[prev_dist] != ISCC_HI_LIST_END); // We should never reach the end!
 	assert(vertex_markers != NULL);
 
-	while(vertex_markers[prev_dist->next_dist->head] == curr_marker) {
+	const scc_PointIndex* const heads = edge_list->heads;
+	uint32_t* const next = edge_list->next;
+	while(vertex_markers[heads[next[prev_dist]]] == curr_marker) {
 		// Vertex has already been assigned to a new cluster, skip it
-		prev_dist->next_dist = prev_dist->next_dist->next_dist;
-		assert(prev_dist->next_dist != NULL); // We should never reach the end!
+		next[prev_dist] = next[next[prev_dist]];
+		assert(next[prev_dist] != ISCC_HI_LIST_END); // We should never reach the end!
 	}
 
-	return prev_dist->next_dist;
+	return next[prev_dist];
 }
 
 
@@ -728,6 +1692,7 @@ static inline void iscc_hi_move_array_to_cluster2(const uint32_t len_ids,
 static scc_ErrorCode iscc_hi_find_centers(iscc_hi_ClusterItem* const cl,
                                           void* const data_set,
                                           iscc_hi_WorkArea* const work_area,
+                                          const scc_HierarchicalOptions* const options,
                                           scc_PointIndex* const out_center1,
                                           scc_PointIndex* const out_center2)
 {
@@ -740,9 +1705,15 @@ static scc_ErrorCode iscc_hi_find_centers(iscc_hi_ClusterItem* const cl,
 	assert(work_area->pointindex_array2 != NULL);
 	assert(work_area->dist_array != NULL);
 	assert(work_area->vertex_markers != NULL);
+	assert(options != NULL);
+	assert(options->num_center_probes > 0);
 	assert(out_center1 != NULL);
 	assert(out_center2 != NULL);
 
+	if (options->approximate_centers) {
+		return iscc_hi_find_centers_by_projections(cl, data_set, out_center1, out_center2);
+	}
+
 	scc_PointIndex* const to_check = work_area->pointindex_array1;
 	scc_PointIndex* const max_indices = work_area->pointindex_array2;
 	double* const max_dists = work_area->dist_array;
@@ -750,12 +1721,13 @@ static scc_ErrorCode iscc_hi_find_centers(iscc_hi_ClusterItem* const cl,
 
 	const uint_fast16_t curr_marker = iscc_hi_get_next_marker(cl, vertex_markers);
 
-	size_t step = cl->size / ISCC_HI_NUM_TO_CHECK;
+	const size_t num_center_probes = options->num_center_probes;
+	size_t step = cl->size / num_center_probes;
 	if (step < 2) step = 2;
 	// num_to_check = ceil(size / step) = floor((size + step - 1) / step) = 1 + floor((size - 1) / step)
-	uint_fast16_t num_to_check = ((uint_fast16_t) (1 + (cl->size - 1) / step));
-	num_to_check = (ISCC_HI_NUM_TO_CHECK < num_to_check) ? ISCC_HI_NUM_TO_CHECK : num_to_check;
-	assert(num_to_check <= ISCC_HI_NUM_TO_CHECK);
+	size_t num_to_check = 1 + (cl->size - 1) / step;
+	num_to_check = (num_center_probes < num_to_check) ? num_center_probes : num_to_check;
+	assert(num_to_check <= num_center_probes);
 
 	for (size_t i = 0; i < num_to_check; ++i) {
 		to_check[i] = cl->members[i * step];
@@ -768,14 +1740,15 @@ static scc_ErrorCode iscc_hi_find_centers(iscc_hi_ClusterItem* const cl,
 	}
 
 	double max_dist = -1.0;
+	uint32_t num_iterations = 0;
 	while (num_to_check > 0) {
 		if (!iscc_get_max_dist(max_dist_object, num_to_check, to_check, max_indices, max_dists)) {
 			iscc_close_max_dist_object(&max_dist_object);
 			return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
 		}
 
-		uint_fast16_t write_in_to_check = 0;
-		for (uint_fast16_t i = 0; i < num_to_check; ++i) {
+		size_t write_in_to_check = 0;
+		for (size_t i = 0; i < num_to_check; ++i) {
 			if (max_dists[i] > max_dist) {
 				max_dist = max_dists[i];
 				*out_center1 = to_check[i];
@@ -790,6 +1763,10 @@ static scc_ErrorCode iscc_hi_find_centers(iscc_hi_ClusterItem* const cl,
 		}
 
 		num_to_check = write_in_to_check;
+
+		// Zero means that the search continues until no new points are found
+		++num_iterations;
+		if (num_iterations == options->max_center_iterations) break;
 	}
 
 	if (!iscc_close_max_dist_object(&max_dist_object)) {
@@ -800,6 +1777,84 @@ static scc_ErrorCode iscc_hi_find_centers(iscc_hi_ClusterItem* const cl,
 }
 
 
+// Projects the points onto a few random directions and picks the two extreme
+// points along the direction where they are farthest apart. The directions
+// are drawn from a generator seeded by the cluster, so the centers do not
+// depend on the order in which clusters are broken.
+static scc_ErrorCode iscc_hi_find_centers_by_projections(const iscc_hi_ClusterItem* const cl,
+                                                         const scc_DataSet* const data_set,
+                                                         scc_PointIndex* const out_center1,
+                                                         scc_PointIndex* const out_center2)
+{
+	assert(cl != NULL);
+	assert(cl->size >= 4);
+	assert(cl->members != NULL);
+	assert(data_set != NULL);
+	assert(data_set->num_dimensions > 0);
+	assert(out_center1 != NULL);
+	assert(out_center2 != NULL);
+
+	const size_t num_dimensions = data_set->num_dimensions;
+	double* const direction = iscc_malloc(sizeof(double[num_dimensions]));
+	if (direction == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+
+	// xorshift64*, the seed must be non-zero
+	uint64_t state = (((uint64_t) cl->members[0]) << 32) ^ ((uint64_t) cl->size) ^ UINT64_C(0x9E3779B97F4A7C15);
+	if (state == 0) state = 1;
+
+	*out_center1 = cl->members[0];
+	*out_center2 = cl->members[cl->size - 1];
+	double max_dist = -1.0;
+	for (size_t p = 0; p < ISCC_HI_NUM_PROJECTIONS; ++p) {
+		for (size_t d = 0; d < num_dimensions; ++d) {
+			state ^= state >> 12;
+			state ^= state << 25;
+			state ^= state >> 27;
+			// Uniform on [-1, 1)
+			direction[d] = ((double) ((state * UINT64_C(2685821657736338717)) >> 11)) / 4503599627370496.0 - 1.0;
+		}
+
+		scc_PointIndex min_point = cl->members[0];
+		scc_PointIndex max_point = cl->members[0];
+		double min_projection = 0.0;
+		double max_projection = 0.0;
+		for (size_t i = 0; i < cl->size; ++i) {
+			const double* const point = data_set->data_matrix + ((size_t) cl->members[i]) * num_dimensions;
+			double projection = 0.0;
+			for (size_t d = 0; d < num_dimensions; ++d) {
+				projection += direction[d] * point[d];
+			}
+			if ((i == 0) || (projection < min_projection)) {
+				min_projection = projection;
+				min_point = cl->members[i];
+			}
+			if ((i == 0) || (projection > max_projection)) {
+				max_projection = projection;
+				max_point = cl->members[i];
+			}
+		}
+
+		if (min_point == max_point) continue;
+
+		double dist;
+		if (!iscc_get_dist_rows((void*) data_set, 1, &min_point, 1, &max_point, &dist)) {
+			iscc_free(direction);
+			return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+		}
+		if (dist > max_dist) {
+			max_dist = dist;
+			*out_center1 = min_point;
+			*out_center2 = max_point;
+		}
+	}
+
+	iscc_free(direction);
+
+	assert(*out_center1 != *out_center2);
+	return iscc_no_error();
+}
+
+
 static scc_ErrorCode iscc_hi_populate_edge_lists(const iscc_hi_ClusterItem* const cl,
                                                  void* const data_set,
                                                  const scc_PointIndex center1,
@@ -813,8 +1868,6 @@ static scc_ErrorCode iscc_hi_populate_edge_lists(const iscc_hi_ClusterItem* cons
 	assert(iscc_check_data_set(data_set));
 	assert(work_area != NULL);
 	assert(work_area->dist_array != NULL);
-	assert(work_area->edge_store1 != NULL);
-	assert(work_area->edge_store2 != NULL);
 
 	double* const row_dists = work_area->dist_array;
 	const scc_PointIndex query_indices[2] = { center1, center2 };
@@ -828,8 +1881,8 @@ static scc_ErrorCode iscc_hi_populate_edge_lists(const iscc_hi_ClusterItem* cons
 		return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
 	}
 
-	iscc_hi_sort_edge_list(cl, center1, row_dists, work_area->edge_store1);
-	iscc_hi_sort_edge_list(cl, center2, row_dists + cl->size, work_area->edge_store2);
+	iscc_hi_sort_edge_list(cl, center1, row_dists, work_area, &work_area->edge_lists[0]);
+	iscc_hi_sort_edge_list(cl, center2, row_dists + cl->size, work_area, &work_area->edge_lists[1]);
 
 	return iscc_no_error();
 }
@@ -838,41 +1891,138 @@ static scc_ErrorCode iscc_hi_populate_edge_lists(const iscc_hi_ClusterItem* cons
 static inline void iscc_hi_sort_edge_list(const iscc_hi_ClusterItem* const cl,
                                           const scc_PointIndex center,
                                           const double row_dists[const static cl->size],
-                                          iscc_hi_DistanceEdge edge_store[const static cl->size])
+                                          iscc_hi_WorkArea* const work_area,
+                                          iscc_hi_EdgeList* const out_edge_list)
 {
 	assert(cl != NULL);
 	assert(cl->size >= 4);
+	assert(cl->size < ISCC_HI_LIST_END);
 	assert(cl->members != NULL);
 	assert(row_dists != NULL);
-	assert(edge_store != NULL);
-
-	iscc_hi_DistanceEdge* write_edge = edge_store + 1;
+	assert(work_area != NULL);
+	assert(work_area->capacity >= cl->size);
+	assert(work_area->scratch_heads != NULL);
+	assert(work_area->scratch_distances != NULL);
+	assert(out_edge_list != NULL);
+	assert(out_edge_list->heads != NULL);
+	assert(out_edge_list->distances != NULL);
+	assert(out_edge_list->next != NULL);
+
+	scc_PointIndex* const heads = out_edge_list->heads;
+	double* const distances = out_edge_list->distances;
+
+	heads[0] = center;
+	distances[0] = 0.0;
+	size_t write_edge = 1;
 	for (size_t i = 0; i < cl->size; ++i) {
 		if (cl->members[i] == center) continue;
-		write_edge->head = cl->members[i];
-		write_edge->distance = row_dists[i];
+		heads[write_edge] = cl->members[i];
+		distances[write_edge] = row_dists[i];
 		++write_edge;
 	}
 
-	assert(write_edge == (edge_store + cl->size));
+	assert(write_edge == cl->size);
 
-	qsort(edge_store + 1, cl->size - 1, sizeof(iscc_hi_DistanceEdge), iscc_hi_compare_dist_edges);
+	iscc_hi_sort_edges(cl->size - 1,
+	                   heads + 1,
+	                   distances + 1,
+	                   work_area->scratch_heads,
+	                   work_area->scratch_distances);
 
-	iscc_hi_DistanceEdge* const edge_stop = edge_store + cl->size - 1;
-	for (iscc_hi_DistanceEdge* edge = edge_store; edge != edge_stop; ++edge) {
-		edge->next_dist = edge + 1;
+	uint32_t* const next = out_edge_list->next;
+	const uint32_t last_edge = (uint32_t) (cl->size - 1);
+	for (uint32_t i = 0; i < last_edge; ++i) {
+		next[i] = i + 1;
 	}
-	edge_stop->next_dist = NULL;
+	next[last_edge] = ISCC_HI_LIST_END;
 }
 
 
-static int iscc_hi_compare_dist_edges(const void* const a,
-                                      const void* const b)
+// Stable sort of edges by distance. Long lists are sorted with a least
+// significant digit radix sort on the bits of the distances, one byte at
+// the time, skipping bytes that are the same for all edges.
+static void iscc_hi_sort_edges(const size_t len_edges,
+                               scc_PointIndex heads[const static len_edges],
+                               double distances[const static len_edges],
+                               scc_PointIndex scratch_heads[const static len_edges],
+                               double scratch_distances[const static len_edges])
 {
-	const double dist_a = ((const iscc_hi_DistanceEdge*)a)->distance;
-	const double dist_b = ((const iscc_hi_DistanceEdge*)b)->distance;
+	assert(len_edges > 0);
+	assert(heads != NULL);
+	assert(distances != NULL);
+	assert(scratch_heads != NULL);
+	assert(scratch_distances != NULL);
+
+	if (len_edges < ISCC_HI_RADIX_SORT_MIN) {
+		for (size_t i = 1; i < len_edges; ++i) {
+			const scc_PointIndex tmp_head = heads[i];
+			const double tmp_distance = distances[i];
+			size_t j = i;
+			for (; (j > 0) && (distances[j - 1] > tmp_distance); --j) {
+				heads[j] = heads[j - 1];
+				distances[j] = distances[j - 1];
+			}
+			heads[j] = tmp_head;
+			distances[j] = tmp_distance;
+		}
+		return;
+	}
 
-	if (dist_a < dist_b) return -1;
-	if (dist_a > dist_b) return 1;
-	return 0;
+	size_t counts[8][256] = { { 0 } };
+	for (size_t i = 0; i < len_edges; ++i) {
+		uint64_t key = iscc_hi_radix_key(distances[i]);
+		for (size_t d = 0; d < 8; ++d) {
+			++counts[d][key & 0xFF];
+			key >>= 8;
+		}
+	}
+
+	const uint64_t first_key = iscc_hi_radix_key(distances[0]);
+	scc_PointIndex* from_heads = heads;
+	double* from_distances = distances;
+	scc_PointIndex* to_heads = scratch_heads;
+	double* to_distances = scratch_distances;
+	for (size_t d = 0; d < 8; ++d) {
+		const unsigned int shift = (unsigned int) (8 * d);
+		if (counts[d][(first_key >> shift) & 0xFF] == len_edges) continue;
+
+		size_t position = 0;
+		for (size_t b = 0; b < 256; ++b) {
+			const size_t tmp_count = counts[d][b];
+			counts[d][b] = position;
+			position += tmp_count;
+		}
+
+		for (size_t i = 0; i < len_edges; ++i) {
+			const size_t b = (size_t) ((iscc_hi_radix_key(from_distances[i]) >> shift) & 0xFF);
+			to_heads[counts[d][b]] = from_heads[i];
+			to_distances[counts[d][b]] = from_distances[i];
+			++counts[d][b];
+		}
+
+		scc_PointIndex* const tmp_swap_heads = from_heads;
+		from_heads = to_heads;
+		to_heads = tmp_swap_heads;
+		double* const tmp_swap_distances = from_distances;
+		from_distances = to_distances;
+		to_distances = tmp_swap_distances;
+	}
+
+	if (from_heads != heads) {
+		memcpy(heads, from_heads, sizeof(scc_PointIndex[len_edges]));
+		memcpy(distances, from_distances, sizeof(double[len_edges]));
+	}
+}
+
+
+// Maps distances to unsigned integers in the same order, assuming IEEE 754 doubles.
+// Negative numbers have all bits flipped, others only the sign bit. Adding zero
+// turns negative zero into positive zero so that the two are equal.
+static inline uint64_t iscc_hi_radix_key(const double distance)
+{
+	const double tmp_distance = distance + 0.0;
+	uint64_t bits;
+	memcpy(&bits, &tmp_distance, sizeof(uint64_t));
+	const uint64_t sign_bit = ((uint64_t) 1) << 63;
+	return (bits & sign_bit) ? ~bits : (bits | sign_bit);
 }
@@ -28,34 +28,261 @@
 #include "../include/scclust.h"
 #include "clustering_struct.h"
 #include "dist_search.h"
+#include "dist_search_imp.h"
 #include "error.h"
+#include "nng_core.h"
 #include "scclust_types.h"
+#include "utilities.h"
+#include "workspace.h"
+
+#ifdef _OPENMP
+	#include <omp.h>
+#endif
 
 
 // =============================================================================
-// Static function prototypes
+// Internal structs and variables
 // =============================================================================
 
-#ifdef SCC_STABLE_NNG
+// Batch size when adapting and no initial size is given
+static const uint32_t ISCC_NB_DEFAULT_BATCH_SIZE = 100;
+
+// The adaptive batch size is never shrunk below this
+static const uint32_t ISCC_NB_MIN_BATCH_SIZE = 16;
+
+// The adaptive batch size doubles when the fraction of wasted queries in a
+// batch is below `ISCC_NB_GROW_WASTE`, and halves when it is above `ISCC_NB_SHRINK_WASTE`
+static const double ISCC_NB_GROW_WASTE = 0.05;
+static const double ISCC_NB_SHRINK_WASTE = 0.25;
+
+
+typedef struct iscc_nb_Schedule {
+	bool adaptive;
+	uint32_t batch_size;
+	uint32_t max_batch_size;
+	scc_BatchStats stats;
+} iscc_nb_Schedule;
+
+
+typedef struct iscc_nb_Buffer {
+	size_t capacity;
+	scc_PointIndex* batch_indices;
+	scc_PointIndex* out_indices;
+	uint32_t* row_lengths;
+} iscc_nb_Buffer;
+
+
+// Search index of the batch engine. The check needs the nearest neighbors among
+// all points, but assigned points stay assigned and can only block seeds. With the
+// built-in (exhaustive) search, the search object is therefore rebuilt over the
+// unassigned points once at least half of the indexed points are assigned. The
+// clusters whose points are dropped are kept with their seeds and radii, so that the
+// dropped points that are nearer than the found neighbors can be merged back in.
+// With type constraints, there is a search object for each constrained type, and
+// rows hold the neighbors of the query followed by the query itself.
+typedef struct iscc_nb_Index {
+	void* data_set;
+	uint32_t row_stride;
+	uint_fast16_t num_types;
+	const uint32_t* type_constraints;
+	const scc_TypeLabel* type_labels;
+	iscc_TypeCount type_count;
+	iscc_NNSearchObject** type_search_objects;
+	iscc_NNSearchObject* nn_search_object;
+	size_t len_search_indices;
+	scc_PointIndex* search_indices;
+	size_t num_dropped_clusters;
+	scc_PointIndex* cluster_seeds;
+	scc_PointIndex* cluster_members;
+	double* cluster_radii;
+} iscc_nb_Index;
+
+
+// Relative slack when pruning dropped clusters with the triangle inequality
+static const double ISCC_NB_PRUNE_TOLERANCE = 1e-9;
+
 
-static int iscc_compare_PointIndex(const void* a, const void* b);
+// Radius of the assignment of unassigned points
+typedef struct iscc_nb_Radius {
+	scc_RadiusMethod method;
+	double supplied;
+} iscc_nb_Radius;
 
-#endif // ifdef SCC_STABLE_NNG
 
+// As in `iscc_estimate_avg_seed_dist`
+static const size_t ISCC_NB_ESTIMATE_AVG_MAX_SAMPLE = 1000;
+
+
+typedef struct iscc_nb_TypeSearch {
+	uint32_t k;
+	size_t num_ok_queries;
+	const scc_PointIndex* ok_queries;
+	const scc_PointIndex* nn_indices;
+	size_t cursor;
+} iscc_nb_TypeSearch;
+
+
+// =============================================================================
+// Static function prototypes
+// =============================================================================
 
 static scc_ErrorCode iscc_run_nng_batches(scc_Clustering* clustering,
-                                          iscc_NNSearchObject* nn_search_object,
+                                          iscc_nb_Index* index,
                                           uint32_t size_constraint,
                                           bool ignore_unassigned,
                                           bool radius_constraint,
                                           double radius,
                                           const bool primary_data_points[],
-                                          uint32_t batch_size,
-                                          scc_PointIndex* batch_indices,
-                                          scc_PointIndex* out_indices,
+                                          bool stable,
+                                          bool pipeline,
+                                          iscc_nb_Schedule* schedule,
+                                          iscc_nb_Buffer buffers[],
                                           bool* assigned);
 
 
+#ifdef _OPENMP
+
+static scc_ErrorCode iscc_run_nng_batches_pipelined(scc_Clustering* clustering,
+                                                    iscc_nb_Index* index,
+                                                    uint32_t size_constraint,
+                                                    bool ignore_unassigned,
+                                                    bool radius_constraint,
+                                                    double radius,
+                                                    const bool primary_data_points[],
+                                                    bool stable,
+                                                    iscc_nb_Schedule* schedule,
+                                                    iscc_nb_Buffer buffers[static 2],
+                                                    bool* assigned,
+                                                    bool* out_search_done,
+                                                    scc_Clabel* out_next_cluster_label);
+
+#endif // ifdef _OPENMP
+
+
+static scc_ErrorCode iscc_nb_init_index(void* data_set,
+                                        size_t num_data_points,
+                                        uint32_t size_constraint,
+                                        uint_fast16_t num_types,
+                                        const uint32_t type_constraints[],
+                                        const scc_TypeLabel type_labels[],
+                                        bool shrink,
+                                        bool record_seeds,
+                                        iscc_nb_Index* out_index);
+
+
+static void iscc_nb_close_index(iscc_nb_Index* index);
+
+
+static scc_ErrorCode iscc_nb_shrink_index(iscc_nb_Index* index,
+                                          uint32_t size_constraint,
+                                          const bool assigned[],
+                                          scc_Clabel num_clusters);
+
+
+static bool iscc_nb_merge_dropped_neighbors(iscc_nb_Index* index,
+                                            uint32_t size_constraint,
+                                            size_t num_queries,
+                                            const scc_PointIndex query_indices[],
+                                            scc_PointIndex nn_indices[]);
+
+
+static inline bool iscc_nb_dist_index_less(double dist_a,
+                                           scc_PointIndex index_a,
+                                           double dist_b,
+                                           scc_PointIndex index_b);
+
+
+static void iscc_nb_init_schedule(uint32_t batch_size,
+                                  bool adaptive,
+                                  size_t max_batch_bytes,
+                                  uint32_t size_constraint,
+                                  size_t num_buffers,
+                                  size_t num_data_points,
+                                  iscc_nb_Schedule* out_schedule);
+
+
+static void iscc_nb_update_schedule(iscc_nb_Schedule* schedule,
+                                    size_t num_checked,
+                                    size_t num_wasted);
+
+
+static scc_ErrorCode iscc_nb_reserve_buffer(iscc_nb_Buffer* buffer,
+                                            size_t capacity,
+                                            const iscc_nb_Index* index);
+
+
+static void iscc_nb_free_buffer(iscc_nb_Buffer* buffer);
+
+
+static size_t iscc_nb_fill_batch(scc_Clustering* clustering,
+                                 const bool primary_data_points[],
+                                 iscc_nb_Schedule* schedule,
+                                 const bool assigned[],
+                                 scc_PointIndex* curr_point,
+                                 scc_PointIndex batch_indices[]);
+
+
+static bool iscc_nb_search_batch(iscc_nb_Index* index,
+                                 uint32_t size_constraint,
+                                 bool radius_constraint,
+                                 double radius,
+                                 bool stable,
+                                 size_t in_batch,
+                                 scc_PointIndex batch_indices[],
+                                 scc_PointIndex out_indices[],
+                                 uint32_t row_lengths[],
+                                 size_t* out_num_ok_in_batch);
+
+
+static bool iscc_nb_search_typed_batch(iscc_nb_Index* index,
+                                       uint32_t size_constraint,
+                                       bool radius_constraint,
+                                       double radius,
+                                       bool stable,
+                                       size_t in_batch,
+                                       scc_PointIndex batch_indices[],
+                                       scc_PointIndex out_indices[],
+                                       uint32_t row_lengths[],
+                                       size_t* out_num_ok_in_batch);
+
+
+static scc_ErrorCode iscc_nb_check_batch(scc_Clustering* clustering,
+                                         iscc_nb_Index* index,
+                                         bool ignore_unassigned,
+                                         size_t num_ok_in_batch,
+                                         const scc_PointIndex batch_indices[],
+                                         const scc_PointIndex out_indices[],
+                                         const uint32_t row_lengths[],
+                                         bool assigned[],
+                                         scc_Clabel* next_cluster_label,
+                                         size_t* out_num_wasted);
+
+
+static scc_ErrorCode iscc_nb_assign_unassigned(scc_Clustering* clustering,
+                                               const iscc_nb_Index* index,
+                                               const bool assigned[],
+                                               const bool primary_data_points[],
+                                               scc_UnassignedMethod unassigned_method,
+                                               iscc_nb_Radius primary_radius,
+                                               scc_UnassignedMethod secondary_unassigned_method,
+                                               iscc_nb_Radius secondary_radius,
+                                               size_t chunk_size);
+
+
+static scc_ErrorCode iscc_nb_estimate_avg_seed_dist(const scc_Clustering* clustering,
+                                                    const iscc_nb_Index* index,
+                                                    const bool assigned[],
+                                                    double* out_avg_seed_dist);
+
+
+static scc_ErrorCode iscc_nb_assign_by_nn_search(scc_Clustering* clustering,
+                                                 iscc_NNSearchObject* nn_search_object,
+                                                 size_t num_to_assign,
+                                                 const scc_PointIndex to_assign[],
+                                                 iscc_nb_Radius radius,
+                                                 size_t chunk_size);
+
+
 // =============================================================================
 // External function implementations
 // =============================================================================
@@ -68,7 +295,19 @@ scc_ErrorCode scc_nng_clustering_batches(scc_Clustering* const clustering,
                                          const double radius,
                                          const size_t len_primary_data_points,
                                          const scc_PointIndex primary_data_points[const],
-                                         uint32_t batch_size)
+                                         const uint_fast16_t num_types,
+                                         const uint32_t type_constraints[const],
+                                         const scc_TypeLabel type_labels[const],
+                                         const scc_UnassignedMethod secondary_unassigned_method,
+                                         const scc_RadiusMethod primary_radius,
+                                         const double primary_supplied_radius,
+                                         const scc_RadiusMethod secondary_radius,
+                                         const double secondary_supplied_radius,
+                                         const uint32_t batch_size,
+                                         const bool adaptive_batch_size,
+                                         const size_t max_batch_bytes,
+                                         const bool stable,
+                                         scc_BatchStats* const out_batch_stats)
 {
 	if (!iscc_check_input_clustering(clustering)) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid clustering object.");
@@ -85,84 +324,161 @@ scc_ErrorCode scc_nng_clustering_batches(scc_Clustering* const clustering,
 	if (clustering->num_data_points < size_constraint) {
 		return iscc_make_error_msg(SCC_ER_NO_SOLUTION, "Fewer data points than size constraint.");
 	}
-	if ((unassigned_method != SCC_UM_IGNORE) && (unassigned_method != SCC_UM_ANY_NEIGHBOR)) {
+	if ((unassigned_method != SCC_UM_IGNORE) &&
+	        (unassigned_method != SCC_UM_ANY_NEIGHBOR) &&
+	        (unassigned_method != SCC_UM_CLOSEST_ASSIGNED) &&
+	        (unassigned_method != SCC_UM_CLOSEST_SEED)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid unassigned method.");
+	}
+	if ((secondary_unassigned_method != SCC_UM_IGNORE) &&
+	        (secondary_unassigned_method != SCC_UM_CLOSEST_ASSIGNED) &&
+	        (secondary_unassigned_method != SCC_UM_CLOSEST_SEED)) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid unassigned method.");
 	}
 	if (radius_constraint && (radius <= 0.0)) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid radius.");
 	}
+	if (((primary_radius == SCC_RM_USE_SUPPLIED) && (primary_supplied_radius <= 0.0)) ||
+	        ((secondary_radius == SCC_RM_USE_SUPPLIED) && (secondary_supplied_radius <= 0.0))) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid radius.");
+	}
 	if ((primary_data_points != NULL) && (len_primary_data_points == 0)) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid primary data points.");
 	}
 	if ((primary_data_points == NULL) && (len_primary_data_points > 0)) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid primary data points.");
 	}
+	if ((num_types >= 2) && ((type_constraints == NULL) || (type_labels == NULL))) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid type constraints.");
+	}
 	if (clustering->num_clusters != 0) {
 		return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "Cannot refine existing clusterings.");
 	}
 
-	if (batch_size == 0) batch_size = UINT32_MAX;
-	if (batch_size > clustering->num_data_points) {
-		batch_size = (uint32_t) clustering->num_data_points;
-	}
+	// With more than one thread and batch, the search for the next batch
+	// runs while the current batch is checked, using two sets of buffers
+	bool pipeline = false;
+	#ifdef _OPENMP
+		pipeline = (adaptive_batch_size || ((batch_size > 0) && (batch_size < clustering->num_data_points))) &&
+		           (omp_get_max_threads() > 1);
+	#endif
+	const size_t num_buffers = pipeline ? 2 : 1;
 
-	iscc_NNSearchObject* nn_search_object;
-	if (!iscc_init_nn_search_object(data_set,
-	                                clustering->num_data_points,
-	                                NULL,
-	                                &nn_search_object)) {
-		return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+	iscc_nb_Schedule schedule;
+	iscc_nb_init_schedule(batch_size,
+	                      adaptive_batch_size,
+	                      max_batch_bytes,
+	                      size_constraint,
+	                      num_buffers,
+	                      clustering->num_data_points,
+	                      &schedule);
+
+	// Dropping assigned points only pays off with the exhaustive built-in search, and
+	// a search with radius or type constraints cannot be completed from the dropped clusters
+	const bool shrink_index = !radius_constraint &&
+	                          (num_types < 2) &&
+	                          (iscc_dist_functions.check_data_set == iscc_imp_check_data_set);
+
+	// Seeds are needed to assign the points left unassigned by the batches
+	const bool assign_by_search = (unassigned_method == SCC_UM_CLOSEST_ASSIGNED) ||
+	                              (unassigned_method == SCC_UM_CLOSEST_SEED) ||
+	                              (secondary_unassigned_method != SCC_UM_IGNORE);
+
+	scc_ErrorCode ec;
+	iscc_nb_Index index;
+	if ((ec = iscc_nb_init_index(data_set,
+	                             clustering->num_data_points,
+	                             size_constraint,
+	                             num_types,
+	                             type_constraints,
+	                             type_labels,
+	                             shrink_index,
+	                             assign_by_search,
+	                             &index)) != SCC_ER_OK) {
+		return ec;
 	}
 
-	scc_PointIndex* const batch_indices = malloc(sizeof(scc_PointIndex[batch_size]));
-	scc_PointIndex* const out_indices = malloc(sizeof(scc_PointIndex[size_constraint * batch_size]));
-	bool* const assigned = calloc(clustering->num_data_points, sizeof(bool));
-	if ((batch_indices == NULL) || (out_indices == NULL) || (assigned == NULL)) {
-		free(batch_indices);
-		free(out_indices);
-		free(assigned);
-		iscc_close_nn_search_object(&nn_search_object);
+	// Buffers grow with the batch size when adapting
+	iscc_nb_Buffer buffers[2] = { { 0, NULL, NULL, NULL }, { 0, NULL, NULL, NULL } };
+	for (size_t b = 0; (ec == SCC_ER_OK) && (b < num_buffers); ++b) {
+		ec = iscc_nb_reserve_buffer(&buffers[b], schedule.batch_size, &index);
+	}
+	bool* const assigned = iscc_calloc(clustering->num_data_points, sizeof(bool));
+	if ((ec != SCC_ER_OK) || (assigned == NULL)) {
+		iscc_nb_free_buffer(&buffers[0]);
+		iscc_nb_free_buffer(&buffers[1]);
+		iscc_free(assigned);
+		iscc_nb_close_index(&index);
 		return iscc_make_error(SCC_ER_NO_MEMORY);
 	}
 
 	// Initialize cluster labels
 	if (clustering->cluster_label == NULL) {
 		clustering->external_labels = false;
-		clustering->cluster_label = malloc(sizeof(scc_Clabel[clustering->num_data_points]));
+		clustering->cluster_label = iscc_malloc(sizeof(scc_Clabel[clustering->num_data_points]));
 		if (clustering->cluster_label == NULL) {
-			free(batch_indices);
-			free(out_indices);
-			free(assigned);
-			iscc_close_nn_search_object(&nn_search_object);
+			iscc_nb_free_buffer(&buffers[0]);
+			iscc_nb_free_buffer(&buffers[1]);
+			iscc_free(assigned);
+			iscc_nb_close_index(&index);
 			return iscc_make_error(SCC_ER_NO_MEMORY);
 		}
 	}
 
 	bool* tmp_primary_data_points = NULL;
 	if (primary_data_points != NULL) {
-		tmp_primary_data_points = calloc(clustering->num_data_points, sizeof(bool));
+		tmp_primary_data_points = iscc_calloc(clustering->num_data_points, sizeof(bool));
 		for (size_t i = 0; i < len_primary_data_points; ++i) {
 			tmp_primary_data_points[primary_data_points[i]] = true;
 		}
 	}
 
-	scc_ErrorCode ec = iscc_run_nng_batches(clustering,
-	                                        nn_search_object,
-	                                        size_constraint,
-	                                        (unassigned_method == SCC_UM_IGNORE),
-	                                        radius_constraint,
-	                                        radius,
-	                                        tmp_primary_data_points,
-	                                        batch_size,
-	                                        batch_indices,
-	                                        out_indices,
-	                                        assigned);
+	// Only `SCC_UM_ANY_NEIGHBOR` assigns points while the batches run
+	ec = iscc_run_nng_batches(clustering,
+	                          &index,
+	                          size_constraint,
+	                          (unassigned_method != SCC_UM_ANY_NEIGHBOR),
+	                          radius_constraint,
+	                          radius,
+	                          tmp_primary_data_points,
+	                          stable,
+	                          pipeline,
+	                          &schedule,
+	                          buffers,
+	                          assigned);
 
-	free(batch_indices);
-	free(out_indices);
-	free(assigned);
-	free(tmp_primary_data_points);
-	iscc_close_nn_search_object(&nn_search_object);
+	// The batch buffers are not needed for the assignment
+	iscc_nb_free_buffer(&buffers[0]);
+	iscc_nb_free_buffer(&buffers[1]);
+
+	if ((ec == SCC_ER_OK) && assign_by_search) {
+		iscc_nb_Radius primary = { (radius_constraint ? SCC_RM_USE_SUPPLIED : SCC_RM_NO_RADIUS), radius };
+		iscc_nb_Radius secondary = primary;
+		if (primary_radius != SCC_RM_USE_SEED_RADIUS) {
+			primary = (iscc_nb_Radius) { primary_radius, primary_supplied_radius };
+		}
+		if (secondary_radius != SCC_RM_USE_SEED_RADIUS) {
+			secondary = (iscc_nb_Radius) { secondary_radius, secondary_supplied_radius };
+		}
+		ec = iscc_nb_assign_unassigned(clustering,
+		                               &index,
+		                               assigned,
+		                               tmp_primary_data_points,
+		                               unassigned_method,
+		                               primary,
+		                               secondary_unassigned_method,
+		                               secondary,
+		                               schedule.batch_size);
+	}
+
+	iscc_free(assigned);
+	iscc_free(tmp_primary_data_points);
+	iscc_nb_close_index(&index);
+
+	if ((ec == SCC_ER_OK) && (out_batch_stats != NULL)) {
+		*out_batch_stats = schedule.stats;
+		out_batch_stats->final_batch_size = schedule.batch_size;
+	}
 
 	return ec;
 }
@@ -172,157 +488,1273 @@ scc_ErrorCode scc_nng_clustering_batches(scc_Clustering* const clustering,
 // Static function implementations
 // =============================================================================
 
-#ifdef SCC_STABLE_NNG
-
-static int iscc_compare_PointIndex(const void* const a, const void* const b)
-{
-    const scc_PointIndex arg1 = *(const scc_PointIndex* const)a;
-    const scc_PointIndex arg2 = *(const scc_PointIndex* const)b;
-    return (arg1 > arg2) - (arg1 < arg2);
-}
-
-#endif // ifdef SCC_STABLE_NNG
-
-
 static scc_ErrorCode iscc_run_nng_batches(scc_Clustering* const clustering,
-                                          iscc_NNSearchObject* const nn_search_object,
+                                          iscc_nb_Index* const index,
                                           const uint32_t size_constraint,
                                           const bool ignore_unassigned,
                                           const bool radius_constraint,
                                           const double radius,
                                           const bool primary_data_points[const],
-                                          const uint32_t batch_size,
-                                          scc_PointIndex* const batch_indices,
-                                          scc_PointIndex* const out_indices,
+                                          const bool stable,
+                                          const bool pipeline,
+                                          iscc_nb_Schedule* const schedule,
+                                          iscc_nb_Buffer buffers[const],
                                           bool* const assigned)
 {
 	assert(iscc_check_input_clustering(clustering));
 	assert(clustering->cluster_label != NULL);
 	assert(clustering->num_clusters == 0);
-	assert(nn_search_object != NULL);
+	assert(index != NULL);
 	assert(size_constraint >= 2);
 	assert(clustering->num_data_points >= size_constraint);
 	assert(!radius_constraint || (radius > 0.0));
-	assert(batch_size > 0);
-	assert(batch_indices != NULL);
-	assert(out_indices != NULL);
+	assert(schedule != NULL);
+	assert(buffers != NULL);
 	assert(assigned != NULL);
 
+	scc_ErrorCode ec;
 	bool search_done = false;
 	scc_Clabel next_cluster_label = 0;
-	assert(clustering->num_data_points <= ISCC_POINTINDEX_MAX);
-	const scc_PointIndex num_data_points = (scc_PointIndex) clustering->num_data_points; // If `scc_PointIndex` is signed
 
-	for (scc_PointIndex curr_point = 0; curr_point < num_data_points; ) {
+	if (pipeline) {
+		#ifdef _OPENMP
+			if ((ec = iscc_run_nng_batches_pipelined(clustering,
+			                                         index,
+			                                         size_constraint,
+			                                         ignore_unassigned,
+			                                         radius_constraint,
+			                                         radius,
+			                                         primary_data_points,
+			                                         stable,
+			                                         schedule,
+			                                         buffers,
+			                                         assigned,
+			                                         &search_done,
+			                                         &next_cluster_label)) != SCC_ER_OK) {
+				return ec;
+			}
+		#else
+			assert(false);
+		#endif
+	} else {
+		for (scc_PointIndex curr_point = 0; ; ) {
+			if ((ec = iscc_nb_reserve_buffer(&buffers[0], schedule->batch_size, index)) != SCC_ER_OK) return ec;
+			const size_t in_batch = iscc_nb_fill_batch(clustering,
+			                                           primary_data_points,
+			                                           schedule,
+			                                           assigned,
+			                                           &curr_point,
+			                                           buffers[0].batch_indices);
+			if (in_batch == 0) break;
 
-		size_t in_batch = 0;
-		if (primary_data_points == NULL) {
-			for (; (in_batch < batch_size) && (curr_point < num_data_points); ++curr_point) {
-				if (!assigned[curr_point]) {
-					clustering->cluster_label[curr_point] = SCC_CLABEL_NA;
-					batch_indices[in_batch] = curr_point;
-					++in_batch;
-				}
+			size_t num_ok_in_batch = 0;
+			search_done = true;
+			if (!iscc_nb_search_batch(index,
+			                          size_constraint,
+			                          radius_constraint,
+			                          radius,
+			                          stable,
+			                          in_batch,
+			                          buffers[0].batch_indices,
+			                          buffers[0].out_indices,
+			                          buffers[0].row_lengths,
+			                          &num_ok_in_batch)) {
+				return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+			}
+
+			size_t num_wasted = 0;
+			if ((ec = iscc_nb_check_batch(clustering,
+			                              index,
+			                              ignore_unassigned,
+			                              num_ok_in_batch,
+			                              buffers[0].batch_indices,
+			                              buffers[0].out_indices,
+			                              buffers[0].row_lengths,
+			                              assigned,
+			                              &next_cluster_label,
+			                              &num_wasted)) != SCC_ER_OK) {
+				return ec;
 			}
+			iscc_nb_update_schedule(schedule, num_ok_in_batch, num_wasted);
+			if ((ec = iscc_nb_shrink_index(index, size_constraint, assigned, next_cluster_label)) != SCC_ER_OK) return ec;
+		}
+	}
+
+	if (next_cluster_label == 0) {
+		if (!search_done) {
+			// Never did search, i.e., primary_data_points are all false
+			assert(primary_data_points != NULL);
+			return iscc_make_error_msg(SCC_ER_NO_SOLUTION, "No primary data points.");
 		} else {
-			for (; (in_batch < batch_size) && (curr_point < num_data_points); ++curr_point) {
-				if (!assigned[curr_point]) {
-					clustering->cluster_label[curr_point] = SCC_CLABEL_NA;
-					if (primary_data_points[curr_point]) {
-						batch_indices[in_batch] = curr_point;
-						++in_batch;
-					}
-				}
+			// Did search but still no clusters, i.e., too tight radius constraint
+			assert(radius_constraint);
+			return iscc_make_error_msg(SCC_ER_NO_SOLUTION, "Infeasible radius constraint.");
+		}
+	}
+
+	clustering->num_clusters = (size_t) next_cluster_label;
+
+	return iscc_no_error();
+}
+
+
+#ifdef _OPENMP
+
+// A query's nearest neighbors do not depend on which batch it is searched in, and the
+// check skips queries that are assigned when their turn comes. The next batch can
+// therefore be filled before the current batch is checked, and searched while the
+// check runs, without changing the result. Filling only needs to see assignments up
+// to the previous batch: points assigned by the current batch are skipped when checked.
+// The search runs on the master thread, as user-supplied search functions may require.
+static scc_ErrorCode iscc_run_nng_batches_pipelined(scc_Clustering* const clustering,
+                                                    iscc_nb_Index* const index,
+                                                    const uint32_t size_constraint,
+                                                    const bool ignore_unassigned,
+                                                    const bool radius_constraint,
+                                                    const double radius,
+                                                    const bool primary_data_points[const],
+                                                    const bool stable,
+                                                    iscc_nb_Schedule* const schedule,
+                                                    iscc_nb_Buffer buffers[const static 2],
+                                                    bool* const assigned,
+                                                    bool* const out_search_done,
+                                                    scc_Clabel* const out_next_cluster_label)
+{
+	assert(schedule != NULL);
+	assert(out_search_done != NULL);
+	assert(out_next_cluster_label != NULL);
+
+	scc_PointIndex curr_point = 0;
+	size_t in_batch = iscc_nb_fill_batch(clustering,
+	                                     primary_data_points,
+	                                     schedule,
+	                                     assigned,
+	                                     &curr_point,
+	                                     buffers[0].batch_indices);
+	if (in_batch == 0) return iscc_no_error();
+
+	size_t num_ok_in_batch = 0;
+	*out_search_done = true;
+	if (!iscc_nb_search_batch(index,
+	                          size_constraint,
+	                          radius_constraint,
+	                          radius,
+	                          stable,
+	                          in_batch,
+	                          buffers[0].batch_indices,
+	                          buffers[0].out_indices,
+	                          buffers[0].row_lengths,
+	                          &num_ok_in_batch)) {
+		return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+	}
+
+	scc_ErrorCode ec;
+	for (size_t curr = 0; ; curr = 1 - curr) {
+		const size_t next = 1 - curr;
+		if ((ec = iscc_nb_reserve_buffer(&buffers[next], schedule->batch_size, index)) != SCC_ER_OK) return ec;
+		const size_t next_in_batch = iscc_nb_fill_batch(clustering,
+		                                                primary_data_points,
+		                                                schedule,
+		                                                assigned,
+		                                                &curr_point,
+		                                                buffers[next].batch_indices);
+
+		size_t next_num_ok_in_batch = 0;
+		size_t num_wasted = 0;
+		bool search_ok = true;
+		ec = SCC_ER_OK;
+
+		#pragma omp parallel num_threads(2) if(next_in_batch > 0)
+		{
+			const bool single_thread = (omp_get_num_threads() == 1);
+			if ((omp_get_thread_num() == 0) && (next_in_batch > 0)) {
+				search_ok = iscc_nb_search_batch(index,
+				                                 size_constraint,
+				                                 radius_constraint,
+				                                 radius,
+				                                 stable,
+				                                 next_in_batch,
+				                                 buffers[next].batch_indices,
+				                                 buffers[next].out_indices,
+				                                 buffers[next].row_lengths,
+				                                 &next_num_ok_in_batch);
+			}
+			if ((omp_get_thread_num() == 1) || single_thread) {
+				ec = iscc_nb_check_batch(clustering,
+				                         index,
+				                         ignore_unassigned,
+				                         num_ok_in_batch,
+				                         buffers[curr].batch_indices,
+				                         buffers[curr].out_indices,
+				                         buffers[curr].row_lengths,
+				                         assigned,
+				                         out_next_cluster_label,
+				                         &num_wasted);
+			}
+		}
+
+		if (ec != SCC_ER_OK) return ec;
+		if (!search_ok) return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+		iscc_nb_update_schedule(schedule, num_ok_in_batch, num_wasted);
+		if (next_in_batch == 0) break;
+		num_ok_in_batch = next_num_ok_in_batch;
+		// The next batch is already searched, so the index can change here
+		if ((ec = iscc_nb_shrink_index(index, size_constraint, assigned, *out_next_cluster_label)) != SCC_ER_OK) return ec;
+	}
+
+	return iscc_no_error();
+}
+
+#endif // ifdef _OPENMP
+
+
+static scc_ErrorCode iscc_nb_init_index(void* const data_set,
+                                        const size_t num_data_points,
+                                        const uint32_t size_constraint,
+                                        const uint_fast16_t num_types,
+                                        const uint32_t type_constraints[const],
+                                        const scc_TypeLabel type_labels[const],
+                                        const bool shrink,
+                                        const bool record_seeds,
+                                        iscc_nb_Index* const out_index)
+{
+	assert(num_data_points >= size_constraint);
+	assert(size_constraint >= 2);
+	assert((num_types < 2) || ((type_constraints != NULL) && (type_labels != NULL)));
+	assert(!shrink || (num_types < 2));
+	assert(out_index != NULL);
+
+	*out_index = (iscc_nb_Index) {
+		.data_set = data_set,
+		.row_stride = size_constraint,
+		.num_types = num_types,
+		.type_constraints = type_constraints,
+		.type_labels = type_labels,
+		.type_count = { 0, NULL, NULL, NULL },
+		.type_search_objects = NULL,
+		.nn_search_object = NULL,
+		.len_search_indices = num_data_points,
+		.search_indices = NULL,
+		.num_dropped_clusters = 0,
+		.cluster_seeds = NULL,
+		.cluster_members = NULL,
+		.cluster_radii = NULL,
+	};
+
+	bool search_all = true;
+	if (num_types >= 2) {
+		scc_ErrorCode ec;
+		if ((ec = iscc_type_count(num_data_points,
+		                          size_constraint,
+		                          num_types,
+		                          type_constraints,
+		                          type_labels,
+		                          &out_index->type_count)) != SCC_ER_OK) {
+			out_index->type_count = (iscc_TypeCount) { 0, NULL, NULL, NULL };
+			return ec;
+		}
+
+		// Room for the query after its neighbors
+		out_index->row_stride = size_constraint + 1;
+
+		out_index->type_search_objects = iscc_calloc(num_types, sizeof(iscc_NNSearchObject*));
+		if (out_index->type_search_objects == NULL) {
+			iscc_nb_close_index(out_index);
+			return iscc_make_error(SCC_ER_NO_MEMORY);
+		}
+		for (uint_fast16_t i = 0; i < num_types; ++i) {
+			if (type_constraints[i] == 0) continue;
+			if (!iscc_init_nn_search_object(data_set,
+			                                out_index->type_count.type_group_size[i],
+			                                out_index->type_count.type_groups[i],
+			                                &out_index->type_search_objects[i])) {
+				iscc_nb_close_index(out_index);
+				return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+			}
+		}
+
+		// Only needed when the size constraint is larger than the type constraints
+		search_all = (size_constraint > out_index->type_count.sum_type_constraints);
+	}
+
+	if (search_all && !iscc_init_nn_search_object(data_set,
+	                                              num_data_points,
+	                                              NULL,
+	                                              &out_index->nn_search_object)) {
+		iscc_nb_close_index(out_index);
+		return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+	}
+
+	// Every cluster has at least `size_constraint` points
+	const size_t max_clusters = num_data_points / size_constraint;
+	if (shrink || record_seeds) {
+		out_index->cluster_seeds = iscc_malloc(sizeof(scc_PointIndex[max_clusters]));
+		if (record_seeds && (out_index->cluster_seeds == NULL)) {
+			iscc_nb_close_index(out_index);
+			return iscc_make_error(SCC_ER_NO_MEMORY);
+		}
+	}
+
+	if (shrink) {
+		// Without memory for the clusters, the index is simply never shrunk
+		out_index->cluster_members = iscc_malloc(sizeof(scc_PointIndex[max_clusters * size_constraint]));
+		out_index->cluster_radii = iscc_malloc(sizeof(double[max_clusters]));
+		if ((out_index->cluster_seeds == NULL) || (out_index->cluster_members == NULL) || (out_index->cluster_radii == NULL)) {
+			if (!record_seeds) {
+				iscc_free(out_index->cluster_seeds);
+				out_index->cluster_seeds = NULL;
 			}
+			iscc_free(out_index->cluster_members);
+			iscc_free(out_index->cluster_radii);
+			out_index->cluster_members = NULL;
+			out_index->cluster_radii = NULL;
+		}
+	}
+
+	return iscc_no_error();
+}
+
+
+static void iscc_nb_close_index(iscc_nb_Index* const index)
+{
+	assert(index != NULL);
+
+	if (index->type_search_objects != NULL) {
+		for (uint_fast16_t i = 0; i < index->num_types; ++i) {
+			iscc_close_nn_search_object(&index->type_search_objects[i]);
+		}
+	}
+	iscc_free(index->type_search_objects);
+	iscc_free(index->type_count.type_group_size);
+	iscc_free(index->type_count.point_store);
+	iscc_free(index->type_count.type_groups);
+	iscc_close_nn_search_object(&index->nn_search_object);
+	iscc_free(index->search_indices);
+	iscc_free(index->cluster_seeds);
+	iscc_free(index->cluster_members);
+	iscc_free(index->cluster_radii);
+	index->type_search_objects = NULL;
+	index->type_count = (iscc_TypeCount) { 0, NULL, NULL, NULL };
+	index->search_indices = NULL;
+	index->cluster_seeds = NULL;
+	index->cluster_members = NULL;
+	index->cluster_radii = NULL;
+}
+
+
+static scc_ErrorCode iscc_nb_shrink_index(iscc_nb_Index* const index,
+                                          const uint32_t size_constraint,
+                                          const bool assigned[const],
+                                          const scc_Clabel num_clusters)
+{
+	assert(index != NULL);
+	assert(assigned != NULL);
+
+	if (index->cluster_members == NULL) return iscc_no_error();
+	assert(index->nn_search_object != NULL);
+
+	// Each cluster has exactly `size_constraint` points, and only points in clusters are assigned
+	const size_t num_data_points = iscc_num_data_points(index->data_set);
+	const size_t num_assigned = ((size_t) num_clusters) * size_constraint;
+	assert(num_assigned <= num_data_points);
+	const size_t num_unassigned = num_data_points - num_assigned;
+	if ((num_unassigned < size_constraint) || (2 * num_unassigned > index->len_search_indices)) {
+		return iscc_no_error();
+	}
+
+	// Radii of the clusters whose points are dropped
+	double* const member_dists = iscc_malloc(sizeof(double[size_constraint]));
+	if (member_dists == NULL) return iscc_no_error();
+	for (size_t c = index->num_dropped_clusters; c < (size_t) num_clusters; ++c) {
+		if (!iscc_get_dist_rows(index->data_set,
+		                        1,
+		                        &index->cluster_seeds[c],
+		                        size_constraint,
+		                        index->cluster_members + c * size_constraint,
+		                        member_dists)) {
+			iscc_free(member_dists);
+			return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
 		}
+		double radius = 0.0;
+		for (uint32_t m = 0; m < size_constraint; ++m) {
+			if (radius < member_dists[m]) radius = member_dists[m];
+		}
+		index->cluster_radii[c] = radius;
+	}
+	iscc_free(member_dists);
+
+	scc_PointIndex* const search_indices = iscc_malloc(sizeof(scc_PointIndex[num_unassigned]));
+	if (search_indices == NULL) return iscc_no_error();
+	size_t len_search_indices = 0;
+	for (size_t i = 0; i < num_data_points; ++i) {
+		if (!assigned[i]) search_indices[len_search_indices++] = (scc_PointIndex) i;
+	}
+	assert(len_search_indices == num_unassigned);
+
+	iscc_NNSearchObject* nn_search_object;
+	if (!iscc_init_nn_search_object(index->data_set,
+	                                len_search_indices,
+	                                search_indices,
+	                                &nn_search_object)) {
+		iscc_free(search_indices);
+		return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+	}
+
+	iscc_close_nn_search_object(&index->nn_search_object);
+	iscc_free(index->search_indices);
+	index->nn_search_object = nn_search_object;
+	index->len_search_indices = len_search_indices;
+	index->search_indices = search_indices;
+	index->num_dropped_clusters = (size_t) num_clusters;
+
+	return iscc_no_error();
+}
 
-		if (in_batch == 0) {
-			assert(curr_point == num_data_points);
+
+// The search object only covers the points that were unassigned when it was built.
+// The dropped points are all in clusters, and a cluster can only have points within
+// the distance to a query's `size_constraint`th found neighbor if its seed is within
+// that distance plus the cluster radius. Those points are merged into the found
+// neighbors, which gives the nearest neighbors among all points in the same order
+// as the exhaustive search (increasing distance, ties by index).
+static bool iscc_nb_merge_dropped_neighbors(iscc_nb_Index* const index,
+                                            const uint32_t size_constraint,
+                                            const size_t num_queries,
+                                            const scc_PointIndex query_indices[const],
+                                            scc_PointIndex nn_indices[const])
+{
+	assert(index != NULL);
+	assert(index->num_dropped_clusters > 0);
+	assert(index->cluster_members != NULL);
+	assert(query_indices != NULL);
+	assert(nn_indices != NULL);
+
+	const size_t num_dropped_clusters = index->num_dropped_clusters;
+	double* const seed_dists = iscc_malloc(sizeof(double[num_dropped_clusters]));
+	double* const nn_dists = iscc_malloc(sizeof(double[size_constraint]));
+	double* const member_dists = iscc_malloc(sizeof(double[size_constraint]));
+	double* const dropped_dists = iscc_malloc(sizeof(double[size_constraint]));
+	scc_PointIndex* const dropped_indices = iscc_malloc(sizeof(scc_PointIndex[size_constraint]));
+	scc_PointIndex* const merged_indices = iscc_malloc(sizeof(scc_PointIndex[size_constraint]));
+	bool ok = (seed_dists != NULL) && (nn_dists != NULL) && (member_dists != NULL) &&
+	          (dropped_dists != NULL) && (dropped_indices != NULL) && (merged_indices != NULL);
+
+	for (size_t q = 0; ok && (q < num_queries); ++q) {
+		scc_PointIndex* const nn_row = nn_indices + q * size_constraint;
+		if (!iscc_get_dist_rows(index->data_set, 1, &query_indices[q], size_constraint, nn_row, nn_dists) ||
+		        !iscc_get_dist_rows(index->data_set, 1, &query_indices[q], num_dropped_clusters, index->cluster_seeds, seed_dists)) {
+			ok = false;
 			break;
 		}
+		const double max_nn_dist = nn_dists[size_constraint - 1];
 
-		size_t num_ok_in_batch = 0;
-		search_done = true;
-		if (!iscc_nearest_neighbor_search(nn_search_object,
-		                                  in_batch,
-		                                  batch_indices,
+		// The nearest dropped points that are no farther than the found neighbors
+		uint32_t num_dropped = 0;
+		for (size_t c = 0; ok && (c < num_dropped_clusters); ++c) {
+			const double bound = (max_nn_dist + index->cluster_radii[c]) * (1.0 + ISCC_NB_PRUNE_TOLERANCE);
+			if (seed_dists[c] > bound) continue;
+			const scc_PointIndex* const members = index->cluster_members + c * size_constraint;
+			if (!iscc_get_dist_rows(index->data_set, 1, &query_indices[q], size_constraint, members, member_dists)) {
+				ok = false;
+				break;
+			}
+			for (uint32_t m = 0; m < size_constraint; ++m) {
+				if (member_dists[m] > max_nn_dist) continue;
+				if ((num_dropped == size_constraint) &&
+				        !iscc_nb_dist_index_less(member_dists[m], members[m], dropped_dists[num_dropped - 1], dropped_indices[num_dropped - 1])) {
+					continue;
+				}
+				uint32_t pos = (num_dropped < size_constraint) ? num_dropped++ : num_dropped - 1;
+				for (; (pos > 0) && iscc_nb_dist_index_less(member_dists[m], members[m], dropped_dists[pos - 1], dropped_indices[pos - 1]); --pos) {
+					dropped_dists[pos] = dropped_dists[pos - 1];
+					dropped_indices[pos] = dropped_indices[pos - 1];
+				}
+				dropped_dists[pos] = member_dists[m];
+				dropped_indices[pos] = members[m];
+			}
+		}
+		if (!ok || (num_dropped == 0)) continue;
+
+		uint32_t next_nn = 0;
+		uint32_t next_dropped = 0;
+		for (uint32_t i = 0; i < size_constraint; ++i) {
+			assert(next_nn < size_constraint);
+			if ((next_dropped < num_dropped) &&
+			        iscc_nb_dist_index_less(dropped_dists[next_dropped], dropped_indices[next_dropped], nn_dists[next_nn], nn_row[next_nn])) {
+				merged_indices[i] = dropped_indices[next_dropped++];
+			} else {
+				merged_indices[i] = nn_row[next_nn++];
+			}
+		}
+		for (uint32_t i = 0; i < size_constraint; ++i) {
+			nn_row[i] = merged_indices[i];
+		}
+	}
+
+	iscc_free(seed_dists);
+	iscc_free(nn_dists);
+	iscc_free(member_dists);
+	iscc_free(dropped_dists);
+	iscc_free(dropped_indices);
+	iscc_free(merged_indices);
+
+	return ok;
+}
+
+
+static inline bool iscc_nb_dist_index_less(const double dist_a,
+                                           const scc_PointIndex index_a,
+                                           const double dist_b,
+                                           const scc_PointIndex index_b)
+{
+	return (dist_a < dist_b) || ((dist_a == dist_b) && (index_a < index_b));
+}
+
+
+static void iscc_nb_init_schedule(uint32_t batch_size,
+                                  const bool adaptive,
+                                  const size_t max_batch_bytes,
+                                  const uint32_t size_constraint,
+                                  const size_t num_buffers,
+                                  const size_t num_data_points,
+                                  iscc_nb_Schedule* const out_schedule)
+{
+	assert(size_constraint >= 2);
+	assert(num_buffers > 0);
+	assert(num_data_points > 0);
+	assert(out_schedule != NULL);
+
+	uint32_t max_batch_size = (num_data_points < UINT32_MAX) ? (uint32_t) num_data_points : UINT32_MAX;
+	if (adaptive) {
+		if (batch_size == 0) batch_size = ISCC_NB_DEFAULT_BATCH_SIZE;
+		if (max_batch_bytes > 0) {
+			const size_t query_bytes = num_buffers * (((size_t) size_constraint) + 1) * sizeof(scc_PointIndex);
+			const size_t max_batch_queries = max_batch_bytes / query_bytes;
+			if (max_batch_queries < max_batch_size) max_batch_size = (max_batch_queries > 0) ? (uint32_t) max_batch_queries : 1;
+		}
+	} else if (batch_size == 0) {
+		batch_size = max_batch_size;
+	}
+	if (batch_size > max_batch_size) batch_size = max_batch_size;
+
+	*out_schedule = (iscc_nb_Schedule) {
+		.adaptive = adaptive,
+		.batch_size = batch_size,
+		.max_batch_size = adaptive ? max_batch_size : batch_size,
+		.stats = { 0, 0, 0, 0, 0, 0 },
+	};
+}
+
+
+static void iscc_nb_update_schedule(iscc_nb_Schedule* const schedule,
+                                    const size_t num_checked,
+                                    const size_t num_wasted)
+{
+	assert(schedule != NULL);
+	assert(num_wasted <= num_checked);
+
+	schedule->stats.wasted_queries += num_wasted;
+	if (!schedule->adaptive || (num_checked == 0)) return;
+
+	const double waste = ((double) num_wasted) / ((double) num_checked);
+	if (waste < ISCC_NB_GROW_WASTE) {
+		// Few wasted searches, so fewer calls to the search backend are cheaper
+		const uint32_t grown = (schedule->batch_size > schedule->max_batch_size / 2) ? schedule->max_batch_size : 2 * schedule->batch_size;
+		schedule->batch_size = grown;
+	} else if (waste > ISCC_NB_SHRINK_WASTE) {
+		const uint32_t min_batch_size = (ISCC_NB_MIN_BATCH_SIZE < schedule->max_batch_size) ? ISCC_NB_MIN_BATCH_SIZE : schedule->max_batch_size;
+		schedule->batch_size = (schedule->batch_size / 2 > min_batch_size) ? schedule->batch_size / 2 : min_batch_size;
+	}
+}
+
+
+static scc_ErrorCode iscc_nb_reserve_buffer(iscc_nb_Buffer* const buffer,
+                                            const size_t capacity,
+                                            const iscc_nb_Index* const index)
+{
+	assert(buffer != NULL);
+	assert(capacity > 0);
+	assert(index != NULL);
+
+	if (buffer->capacity >= capacity) return iscc_no_error();
+
+	// Buffers are only grown between batches, so their contents need not be kept
+	iscc_nb_free_buffer(buffer);
+	buffer->batch_indices = iscc_malloc(sizeof(scc_PointIndex[capacity]));
+	buffer->out_indices = iscc_malloc(sizeof(scc_PointIndex[index->row_stride * capacity]));
+	if (index->num_types >= 2) {
+		buffer->row_lengths = iscc_malloc(sizeof(uint32_t[capacity]));
+		if (buffer->row_lengths == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+	if ((buffer->batch_indices == NULL) || (buffer->out_indices == NULL)) {
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+	buffer->capacity = capacity;
+
+	return iscc_no_error();
+}
+
+
+static void iscc_nb_free_buffer(iscc_nb_Buffer* const buffer)
+{
+	assert(buffer != NULL);
+
+	iscc_free(buffer->batch_indices);
+	iscc_free(buffer->out_indices);
+	iscc_free(buffer->row_lengths);
+	*buffer = (iscc_nb_Buffer) { 0, NULL, NULL, NULL };
+}
+
+
+static size_t iscc_nb_fill_batch(scc_Clustering* const clustering,
+                                 const bool primary_data_points[const],
+                                 iscc_nb_Schedule* const schedule,
+                                 const bool assigned[const],
+                                 scc_PointIndex* const curr_point,
+                                 scc_PointIndex batch_indices[const])
+{
+	assert(schedule != NULL);
+	assert(schedule->batch_size > 0);
+
+	const uint32_t batch_size = schedule->batch_size;
+	assert(clustering->num_data_points <= ISCC_POINTINDEX_MAX);
+	const scc_PointIndex num_data_points = (scc_PointIndex) clustering->num_data_points; // If `scc_PointIndex` is signed
+
+	size_t in_batch = 0;
+	scc_PointIndex point = *curr_point;
+	if (primary_data_points == NULL) {
+		for (; (in_batch < batch_size) && (point < num_data_points); ++point) {
+			if (!assigned[point]) {
+				clustering->cluster_label[point] = SCC_CLABEL_NA;
+				batch_indices[in_batch] = point;
+				++in_batch;
+			}
+		}
+	} else {
+		for (; (in_batch < batch_size) && (point < num_data_points); ++point) {
+			if (!assigned[point]) {
+				clustering->cluster_label[point] = SCC_CLABEL_NA;
+				if (primary_data_points[point]) {
+					batch_indices[in_batch] = point;
+					++in_batch;
+				}
+			}
+		}
+	}
+
+	assert((in_batch > 0) || (point == num_data_points));
+	*curr_point = point;
+
+	if (in_batch > 0) {
+		scc_BatchStats* const stats = &schedule->stats;
+		if ((stats->num_batches == 0) || (stats->min_batch_size > batch_size)) stats->min_batch_size = batch_size;
+		if (stats->max_batch_size < batch_size) stats->max_batch_size = batch_size;
+		++stats->num_batches;
+		stats->num_queries += in_batch;
+	}
+
+	return in_batch;
+}
+
+
+static bool iscc_nb_search_batch(iscc_nb_Index* const index,
+                                 const uint32_t size_constraint,
+                                 const bool radius_constraint,
+                                 const double radius,
+                                 const bool stable,
+                                 const size_t in_batch,
+                                 scc_PointIndex batch_indices[const],
+                                 scc_PointIndex out_indices[const],
+                                 uint32_t row_lengths[const],
+                                 size_t* const out_num_ok_in_batch)
+{
+	assert(index != NULL);
+	assert(in_batch > 0);
+
+	if (index->num_types >= 2) {
+		return iscc_nb_search_typed_batch(index,
 		                                  size_constraint,
 		                                  radius_constraint,
 		                                  radius,
-		                                  &num_ok_in_batch,
+		                                  stable,
+		                                  in_batch,
 		                                  batch_indices,
-		                                  out_indices)) {
-			return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+		                                  out_indices,
+		                                  row_lengths,
+		                                  out_num_ok_in_batch);
+	}
+
+	if (!iscc_nearest_neighbor_search(index->nn_search_object,
+	                                  in_batch,
+	                                  batch_indices,
+	                                  size_constraint,
+	                                  radius_constraint,
+	                                  radius,
+	                                  out_num_ok_in_batch,
+	                                  batch_indices,
+	                                  out_indices)) {
+		return false;
+	}
+
+	if ((index->num_dropped_clusters > 0) &&
+	        !iscc_nb_merge_dropped_neighbors(index,
+	                                         size_constraint,
+	                                         *out_num_ok_in_batch,
+	                                         batch_indices,
+	                                         out_indices)) {
+		return false;
+	}
+
+	if (stable) {
+		for (size_t i = 0; i < *out_num_ok_in_batch; ++i) {
+			iscc_sort_point_indices(size_constraint, out_indices + i * size_constraint);
+		}
+	}
+
+	return true;
+}
+
+
+// Derives the same rows as `iscc_get_nng_with_type_constraint`: the nearest
+// neighbors of each constrained type (with the query among the neighbors of its
+// own type), followed by the nearest remaining neighbors among all points when
+// the size constraint is larger than the type constraints. The query is removed
+// from its neighbors and written last in its row. A query is only kept if all
+// its searches are within the radius.
+static bool iscc_nb_search_typed_batch(iscc_nb_Index* const index,
+                                       const uint32_t size_constraint,
+                                       const bool radius_constraint,
+                                       const double radius,
+                                       const bool stable,
+                                       const size_t in_batch,
+                                       scc_PointIndex batch_indices[const],
+                                       scc_PointIndex out_indices[const],
+                                       uint32_t row_lengths[const],
+                                       size_t* const out_num_ok_in_batch)
+{
+	assert(index != NULL);
+	assert(index->num_types >= 2);
+	assert(in_batch > 0);
+	assert(row_lengths != NULL);
+	assert(out_num_ok_in_batch != NULL);
+
+	const uint_fast16_t num_types = index->num_types;
+	const uint32_t additional_nn_needed = size_constraint - index->type_count.sum_type_constraints;
+
+	size_t nn_per_query = (additional_nn_needed > 0) ? size_constraint : 0;
+	for (uint_fast16_t t = 0; t < num_types; ++t) {
+		nn_per_query += index->type_constraints[t];
+	}
+
+	iscc_nb_TypeSearch* const searches = iscc_malloc(sizeof(iscc_nb_TypeSearch[num_types + 1]));
+	scc_PointIndex* const query_store = iscc_malloc(sizeof(scc_PointIndex[(num_types + 1) * in_batch]));
+	scc_PointIndex* const nn_store = iscc_malloc(sizeof(scc_PointIndex[nn_per_query * in_batch]));
+	if ((searches == NULL) || (query_store == NULL) || (nn_store == NULL)) {
+		iscc_free(searches);
+		iscc_free(query_store);
+		iscc_free(nn_store);
+		return false;
+	}
+
+	// Each search only gets the queries that were within the radius in the previous searches.
+	// Search `num_types` is among all points.
+	uint_fast16_t num_searches = 0;
+	size_t num_queries = in_batch;
+	const scc_PointIndex* queries = batch_indices;
+	scc_PointIndex* nn_write = nn_store;
+	for (uint_fast16_t t = 0; (t <= num_types) && (num_queries > 0); ++t) {
+		const uint32_t k = (t < num_types) ? index->type_constraints[t] : ((additional_nn_needed > 0) ? size_constraint : 0);
+		if (k == 0) continue;
+		iscc_NNSearchObject* const nn_search_object = (t < num_types) ? index->type_search_objects[t] : index->nn_search_object;
+		scc_PointIndex* const ok_queries = query_store + num_searches * in_batch;
+		size_t num_ok_queries = 0;
+		if (!iscc_nearest_neighbor_search(nn_search_object,
+		                                  num_queries,
+		                                  queries,
+		                                  k,
+		                                  radius_constraint,
+		                                  radius,
+		                                  &num_ok_queries,
+		                                  ok_queries,
+		                                  nn_write)) {
+			iscc_free(searches);
+			iscc_free(query_store);
+			iscc_free(nn_store);
+			return false;
 		}
 
-		#ifdef SCC_STABLE_NNG
-		for (size_t i = 0; i < num_ok_in_batch; ++i) {
-			qsort(out_indices + i * size_constraint, size_constraint, sizeof(scc_PointIndex), iscc_compare_PointIndex);
+		if (t < num_types) {
+			// Identical points may hide the query among the neighbors of its own type
+			for (size_t i = 0; i < num_ok_queries; ++i) {
+				if (index->type_labels[ok_queries[i]] != (scc_TypeLabel) t) continue;
+				scc_PointIndex* const nn_row = nn_write + i * k;
+				uint32_t m = 0;
+				for (; (m < k) && (nn_row[m] != ok_queries[i]); ++m) {}
+				if (m == k) nn_row[k - 1] = ok_queries[i];
+			}
 		}
-		#endif // ifdef SCC_STABLE_NNG
 
-		const scc_PointIndex* check_indices = out_indices;
-		for (size_t i = 0; i < num_ok_in_batch; ++i) {
-			const scc_PointIndex* const stop_check_indices = check_indices + size_constraint;
-			if (!assigned[batch_indices[i]]) {
-				for (; (check_indices != stop_check_indices) && !assigned[*check_indices]; ++check_indices) {}
-				if (check_indices == stop_check_indices) {
-					// `i` has no assigned neighbors and can be seed
-					if (next_cluster_label == SCC_CLABEL_MAX) {
-						return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many clusters (adjust the `scc_Clabel` type).");
-					}
+		searches[num_searches] = (iscc_nb_TypeSearch) {
+			.k = k,
+			.num_ok_queries = num_ok_queries,
+			.ok_queries = ok_queries,
+			.nn_indices = nn_write,
+			.cursor = 0,
+		};
+		++num_searches;
+		num_queries = num_ok_queries;
+		queries = ok_queries;
+		nn_write += k * num_ok_queries;
+	}
+	assert(num_searches > 0);
 
-					assert(!assigned[batch_indices[i]]);
-					const scc_PointIndex* const stop_assign_indices = stop_check_indices - 1;
-					for (check_indices -= size_constraint; check_indices != stop_assign_indices; ++check_indices) {
-						assert(!assigned[*check_indices]);
-						assigned[*check_indices] = true;
-						clustering->cluster_label[*check_indices] = next_cluster_label;
-					}
-					if (assigned[batch_indices[i]]) {
-						// Self-loop from `batch_indices[i]` to `batch_indices[i]` existed among NN
-						assert(!assigned[*check_indices]);
-						assigned[*check_indices] = true;
-						clustering->cluster_label[*check_indices] = next_cluster_label;
-					} else {
-						// Self-loop did not exist
-						assert(!assigned[batch_indices[i]]);
-						assigned[batch_indices[i]] = true;
-						clustering->cluster_label[batch_indices[i]] = next_cluster_label;
+	// The last search has the queries that are within the radius in all searches
+	const uint32_t row_stride = index->row_stride;
+	const uint_fast16_t num_type_searches = (additional_nn_needed > 0) ? num_searches - 1 : num_searches;
+	for (size_t i = 0; i < num_queries; ++i) {
+		const scc_PointIndex query = queries[i];
+		scc_PointIndex* const nn_row = out_indices + i * row_stride;
+		uint32_t row_length = 0;
+
+		for (uint_fast16_t s = 0; s < num_searches; ++s) {
+			iscc_nb_TypeSearch* const search = &searches[s];
+			for (; search->ok_queries[search->cursor] != query; ++search->cursor) {
+				assert(search->cursor < search->num_ok_queries);
+			}
+			const scc_PointIndex* const search_nn = search->nn_indices + search->cursor * search->k;
+
+			if (s < num_type_searches) {
+				for (uint32_t m = 0; m < search->k; ++m) {
+					nn_row[row_length++] = search_nn[m];
+				}
+			} else {
+				// Nearest neighbors not already in the row
+				const uint32_t len_type_nn = row_length;
+				uint32_t added = 0;
+				for (uint32_t m = 0; (m < search->k) && (added < additional_nn_needed); ++m) {
+					uint32_t r = 0;
+					for (; (r < len_type_nn) && (nn_row[r] != search_nn[m]); ++r) {}
+					if (r == len_type_nn) {
+						nn_row[row_length++] = search_nn[m];
+						++added;
 					}
+				}
+			}
+		}
+		assert(row_length <= size_constraint);
+
+		uint32_t write = 0;
+		for (uint32_t m = 0; m < row_length; ++m) {
+			if (nn_row[m] != query) nn_row[write++] = nn_row[m];
+		}
+		if (stable) iscc_sort_point_indices(write, nn_row);
+		nn_row[write] = query;
+		row_lengths[i] = write + 1;
+		batch_indices[i] = query;
+	}
 
-					assert(clustering->cluster_label[batch_indices[i]] == next_cluster_label);
-					++next_cluster_label;
+	*out_num_ok_in_batch = num_queries;
+
+	iscc_free(searches);
+	iscc_free(query_store);
+	iscc_free(nn_store);
+
+	return true;
+}
+
+
+static scc_ErrorCode iscc_nb_check_batch(scc_Clustering* const clustering,
+                                         iscc_nb_Index* const index,
+                                         const bool ignore_unassigned,
+                                         const size_t num_ok_in_batch,
+                                         const scc_PointIndex batch_indices[const],
+                                         const scc_PointIndex out_indices[const],
+                                         const uint32_t row_lengths[const],
+                                         bool assigned[const],
+                                         scc_Clabel* const next_cluster_label,
+                                         size_t* const out_num_wasted)
+{
+	assert(index != NULL);
+	assert(next_cluster_label != NULL);
+	assert(out_num_wasted != NULL);
+
+	size_t num_wasted = 0;
+
+	// Rows without lengths are full
+	const uint32_t row_stride = index->row_stride;
+	for (size_t i = 0; i < num_ok_in_batch; ++i) {
+		const scc_PointIndex* const nn_row = out_indices + i * row_stride;
+		const uint32_t row_length = (row_lengths == NULL) ? row_stride : row_lengths[i];
+		assert(row_length > 0);
+		const scc_PointIndex* const stop_check_indices = nn_row + row_length;
+		const scc_PointIndex* check_indices = nn_row;
+		if (!assigned[batch_indices[i]]) {
+			for (; (check_indices != stop_check_indices) && !assigned[*check_indices]; ++check_indices) {}
+			if (check_indices == stop_check_indices) {
+				// `i` has no assigned neighbors and can be seed
+				if (*next_cluster_label == SCC_CLABEL_MAX) {
+					return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many clusters (adjust the `scc_Clabel` type).");
+				}
+
+				assert(!assigned[batch_indices[i]]);
+				const scc_PointIndex* const stop_assign_indices = stop_check_indices - 1;
+				for (check_indices = nn_row; check_indices != stop_assign_indices; ++check_indices) {
+					assert(!assigned[*check_indices]);
+					assigned[*check_indices] = true;
+					clustering->cluster_label[*check_indices] = *next_cluster_label;
+				}
+				scc_PointIndex last_member;
+				if (assigned[batch_indices[i]]) {
+					// Self-loop from `batch_indices[i]` to `batch_indices[i]` existed among NN
+					assert(!assigned[*check_indices]);
+					last_member = *check_indices;
 				} else {
-					// `i` has assigned neighbors and cannot be seed
-					if (!ignore_unassigned) {
-						// Assign `batch_indices[i]` to a preliminary cluster.
-						// If a future seed wants it as neighbor, it switches cluster.
-						assert(assigned[*check_indices]);
-						assert(clustering->cluster_label[batch_indices[i]] == SCC_CLABEL_NA);
-						assert(clustering->cluster_label[*check_indices] != SCC_CLABEL_NA);
-						assert(!assigned[batch_indices[i]]);
-						clustering->cluster_label[batch_indices[i]] = clustering->cluster_label[*check_indices];
+					// Self-loop did not exist
+					last_member = batch_indices[i];
+				}
+				assert(!assigned[last_member]);
+				assigned[last_member] = true;
+				clustering->cluster_label[last_member] = *next_cluster_label;
+
+				const size_t cluster = (size_t) *next_cluster_label;
+				if (index->cluster_seeds != NULL) {
+					index->cluster_seeds[cluster] = batch_indices[i];
+				}
+				if (index->cluster_members != NULL) {
+					assert(row_length == row_stride);
+					scc_PointIndex* const members = index->cluster_members + cluster * row_stride;
+					for (uint32_t m = 0; m < row_length - 1; ++m) {
+						members[m] = nn_row[m];
 					}
+					members[row_length - 1] = last_member;
 				}
-			}
-			check_indices = stop_check_indices;
-		} // Loop in batch
-	} // Loop between batches
 
-	if (next_cluster_label == 0) {
-		if (!search_done) {
-			// Never did search, i.e., primary_data_points are all false
-			assert(primary_data_points != NULL);
-			return iscc_make_error_msg(SCC_ER_NO_SOLUTION, "No primary data points.");
+				assert(clustering->cluster_label[batch_indices[i]] == *next_cluster_label);
+				++(*next_cluster_label);
+			} else {
+				// `i` has assigned neighbors and cannot be seed
+				if (!ignore_unassigned) {
+					// Assign `batch_indices[i]` to a preliminary cluster.
+					// If a future seed wants it as neighbor, it switches cluster.
+					assert(assigned[*check_indices]);
+					assert(clustering->cluster_label[batch_indices[i]] == SCC_CLABEL_NA);
+					assert(clustering->cluster_label[*check_indices] != SCC_CLABEL_NA);
+					assert(!assigned[batch_indices[i]]);
+					clustering->cluster_label[batch_indices[i]] = clustering->cluster_label[*check_indices];
+				}
+			}
 		} else {
-			// Did search but still no clusters, i.e., too tight radius constraint
-			assert(radius_constraint);
+			// Assigned after the batch was filled, so the search was not needed
+			++num_wasted;
+		}
+	}
+
+	*out_num_wasted = num_wasted;
+
+	return iscc_no_error();
+}
+
+
+// Assigns the points that the batches left unassigned, as `iscc_make_nng_clusters_from_seeds`
+// does for the other seed methods. The points are searched for in chunks of the batch size.
+static scc_ErrorCode iscc_nb_assign_unassigned(scc_Clustering* const clustering,
+                                               const iscc_nb_Index* const index,
+                                               const bool assigned[const],
+                                               const bool primary_data_points[const],
+                                               const scc_UnassignedMethod unassigned_method,
+                                               iscc_nb_Radius primary_radius,
+                                               const scc_UnassignedMethod secondary_unassigned_method,
+                                               iscc_nb_Radius secondary_radius,
+                                               const size_t chunk_size)
+{
+	assert(iscc_check_input_clustering(clustering));
+	assert(clustering->num_clusters > 0);
+	assert(index != NULL);
+	assert(index->cluster_seeds != NULL);
+	assert(assigned != NULL);
+	assert(chunk_size > 0);
+
+	// Points are assigned by `SCC_UM_ANY_NEIGHBOR` while the batches run
+	const bool primary_search = (unassigned_method == SCC_UM_CLOSEST_ASSIGNED) ||
+	                            (unassigned_method == SCC_UM_CLOSEST_SEED);
+	const bool secondary_search = (secondary_unassigned_method != SCC_UM_IGNORE);
+	if (!primary_search && !secondary_search) return iscc_no_error();
+	if (!primary_search) primary_radius = (iscc_nb_Radius) { SCC_RM_NO_RADIUS, 0.0 };
+	if (!secondary_search) secondary_radius = (iscc_nb_Radius) { SCC_RM_NO_RADIUS, 0.0 };
+
+	scc_ErrorCode ec;
+	if ((primary_radius.method == SCC_RM_USE_ESTIMATED) ||
+	        (secondary_radius.method == SCC_RM_USE_ESTIMATED)) {
+		double avg_seed_dist = 0.0;
+		if ((ec = iscc_nb_estimate_avg_seed_dist(clustering,
+		                                         index,
+		                                         assigned,
+		                                         &avg_seed_dist)) != SCC_ER_OK) {
+			return ec;
+		}
+		if (avg_seed_dist <= 0.0) {
 			return iscc_make_error_msg(SCC_ER_NO_SOLUTION, "Infeasible radius constraint.");
 		}
+		if (primary_radius.method == SCC_RM_USE_ESTIMATED) {
+			primary_radius = (iscc_nb_Radius) { SCC_RM_USE_SUPPLIED, avg_seed_dist };
+		}
+		if (secondary_radius.method == SCC_RM_USE_ESTIMATED) {
+			secondary_radius = (iscc_nb_Radius) { SCC_RM_USE_SUPPLIED, avg_seed_dist };
+		}
 	}
 
-	clustering->num_clusters = (size_t) next_cluster_label;
+	assert((primary_radius.method == SCC_RM_NO_RADIUS) || (primary_radius.method == SCC_RM_USE_SUPPLIED));
+	assert((secondary_radius.method == SCC_RM_NO_RADIUS) || (secondary_radius.method == SCC_RM_USE_SUPPLIED));
+
+	assert(clustering->num_data_points <= ISCC_POINTINDEX_MAX);
+	const scc_PointIndex num_data_points_pi = (scc_PointIndex) clustering->num_data_points; // If `scc_PointIndex` is signed.
+
+	// Seeds and their neighbors, i.e., the points assigned before this function
+	size_t num_seed_or_neighbor = 0;
+	scc_PointIndex* seed_or_neighbor = NULL;
+	if ((unassigned_method == SCC_UM_CLOSEST_ASSIGNED) ||
+	        (secondary_unassigned_method == SCC_UM_CLOSEST_ASSIGNED)) {
+		for (size_t i = 0; i < clustering->num_data_points; ++i) {
+			num_seed_or_neighbor += assigned[i];
+		}
+		seed_or_neighbor = iscc_malloc(sizeof(scc_PointIndex[num_seed_or_neighbor]));
+		if (seed_or_neighbor == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+
+		scc_PointIndex* write_seed_or_neighbor = seed_or_neighbor;
+		for (scc_PointIndex i = 0; i < num_data_points_pi; ++i) {
+			if (assigned[i]) {
+				*write_seed_or_neighbor = i;
+				++write_seed_or_neighbor;
+			}
+		}
+		assert(((size_t) (write_seed_or_neighbor - seed_or_neighbor)) == num_seed_or_neighbor);
+	}
+
+	ec = SCC_ER_OK;
+	iscc_NNSearchObject* nn_assigned_search_object = NULL;
+	iscc_NNSearchObject* nn_seed_search_object = NULL;
+	if ((seed_or_neighbor != NULL) &&
+	        !iscc_init_nn_search_object(index->data_set,
+	                                    num_seed_or_neighbor,
+	                                    seed_or_neighbor,
+	                                    &nn_assigned_search_object)) {
+		ec = iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+	}
+	if ((ec == SCC_ER_OK) &&
+	        ((unassigned_method == SCC_UM_CLOSEST_SEED) || (secondary_unassigned_method == SCC_UM_CLOSEST_SEED)) &&
+	        !iscc_init_nn_search_object(index->data_set,
+	                                    clustering->num_clusters,
+	                                    index->cluster_seeds,
+	                                    &nn_seed_search_object)) {
+		ec = iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+	}
+
+	scc_PointIndex* to_assign = NULL;
+	if (ec == SCC_ER_OK) {
+		to_assign = iscc_malloc(sizeof(scc_PointIndex[clustering->num_data_points]));
+		if (to_assign == NULL) ec = iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	if ((ec == SCC_ER_OK) && primary_search) {
+		size_t num_to_assign = 0;
+		for (scc_PointIndex i = 0; i < num_data_points_pi; ++i) {
+			to_assign[num_to_assign] = i;
+			num_to_assign += (clustering->cluster_label[i] == SCC_CLABEL_NA) &&
+			                 ((primary_data_points == NULL) || primary_data_points[i]);
+		}
+		if (num_to_assign > 0) {
+			ec = iscc_nb_assign_by_nn_search(clustering,
+			                                 (unassigned_method == SCC_UM_CLOSEST_SEED) ? nn_seed_search_object : nn_assigned_search_object,
+			                                 num_to_assign,
+			                                 to_assign,
+			                                 primary_radius,
+			                                 chunk_size);
+		}
+	}
+
+	if ((ec == SCC_ER_OK) && secondary_search) {
+		size_t num_to_assign = 0;
+		for (scc_PointIndex i = 0; i < num_data_points_pi; ++i) {
+			to_assign[num_to_assign] = i;
+			num_to_assign += (clustering->cluster_label[i] == SCC_CLABEL_NA);
+		}
+		if (num_to_assign > 0) {
+			ec = iscc_nb_assign_by_nn_search(clustering,
+			                                 (secondary_unassigned_method == SCC_UM_CLOSEST_SEED) ? nn_seed_search_object : nn_assigned_search_object,
+			                                 num_to_assign,
+			                                 to_assign,
+			                                 secondary_radius,
+			                                 chunk_size);
+		}
+	}
+
+	if (nn_assigned_search_object != NULL) {
+		iscc_close_nn_search_object(&nn_assigned_search_object);
+	}
+	if (nn_seed_search_object != NULL) {
+		iscc_close_nn_search_object(&nn_seed_search_object);
+	}
+	iscc_free(to_assign);
+	iscc_free(seed_or_neighbor);
+
+	return ec;
+}
+
+
+// Same as `iscc_estimate_avg_seed_dist`, with the neighbors of the sampled
+// seeds taken from their clusters rather than from the NNG
+static scc_ErrorCode iscc_nb_estimate_avg_seed_dist(const scc_Clustering* const clustering,
+                                                    const iscc_nb_Index* const index,
+                                                    const bool assigned[const],
+                                                    double* const out_avg_seed_dist)
+{
+	assert(iscc_check_input_clustering(clustering));
+	assert(clustering->num_clusters > 0);
+	assert(index != NULL);
+	assert(index->cluster_seeds != NULL);
+	assert(assigned != NULL);
+	assert(out_avg_seed_dist != NULL);
+
+	const size_t num_clusters = clustering->num_clusters;
+	const size_t step = (num_clusters > ISCC_NB_ESTIMATE_AVG_MAX_SAMPLE) ? (num_clusters / ISCC_NB_ESTIMATE_AVG_MAX_SAMPLE) : 1;
+	const size_t num_sampled = 1 + (num_clusters - 1) / step;
+
+	// Rows hold the query and its neighbors, so no cluster is larger than a row
+	const uint32_t max_cluster_size = index->row_stride;
+	uint32_t* const num_members = iscc_calloc(num_sampled, sizeof(uint32_t));
+	scc_PointIndex* const members = iscc_malloc(sizeof(scc_PointIndex[num_sampled * max_cluster_size]));
+	double* const dist_scratch = iscc_malloc(sizeof(double[max_cluster_size]));
+	if ((num_members == NULL) || (members == NULL) || (dist_scratch == NULL)) {
+		iscc_free(num_members);
+		iscc_free(members);
+		iscc_free(dist_scratch);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	// Points assigned by `SCC_UM_ANY_NEIGHBOR` are not in `assigned`
+	const scc_PointIndex num_data_points_pi = (scc_PointIndex) clustering->num_data_points; // If `scc_PointIndex` is signed.
+	for (scc_PointIndex i = 0; i < num_data_points_pi; ++i) {
+		if (!assigned[i]) continue;
+		const size_t cluster = (size_t) clustering->cluster_label[i];
+		if (((cluster % step) != 0) || (index->cluster_seeds[cluster] == i)) continue;
+		const size_t s = cluster / step;
+		assert(num_members[s] < max_cluster_size);
+		members[s * max_cluster_size + num_members[s]] = i;
+		++num_members[s];
+	}
+
+	double sum_dist = 0.0;
+	for (size_t s = 0; s < num_sampled; ++s) {
+		assert(num_members[s] > 0);
+		if (!iscc_get_dist_rows(index->data_set,
+		                        1,
+		                        &index->cluster_seeds[s * step],
+		                        num_members[s],
+		                        members + s * max_cluster_size,
+		                        dist_scratch)) {
+			iscc_free(num_members);
+			iscc_free(members);
+			iscc_free(dist_scratch);
+			return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+		}
+
+		double tmp_dist = 0.0;
+		for (uint32_t m = 0; m < num_members[s]; ++m) {
+			tmp_dist += dist_scratch[m];
+		}
+		sum_dist += tmp_dist / ((double) num_members[s]);
+	}
+
+	iscc_free(num_members);
+	iscc_free(members);
+	iscc_free(dist_scratch);
+
+	*out_avg_seed_dist = sum_dist / ((double) num_sampled);
+
+	return iscc_no_error();
+}
+
+
+// The search object only covers assigned points and the points to assign are
+// distinct, so the chunks are independent. With the built-in search, they are
+// searched in parallel; user-supplied search functions run on one thread.
+static scc_ErrorCode iscc_nb_assign_by_nn_search(scc_Clustering* const clustering,
+                                                 iscc_NNSearchObject* const nn_search_object,
+                                                 const size_t num_to_assign,
+                                                 const scc_PointIndex to_assign[const],
+                                                 const iscc_nb_Radius radius,
+                                                 const size_t chunk_size)
+{
+	assert(iscc_check_input_clustering(clustering));
+	assert(nn_search_object != NULL);
+	assert(num_to_assign > 0);
+	assert(to_assign != NULL);
+	assert((radius.method == SCC_RM_NO_RADIUS) || (radius.method == SCC_RM_USE_SUPPLIED));
+	assert(chunk_size > 0);
+
+	const bool radius_constraint = (radius.method == SCC_RM_USE_SUPPLIED);
+	const size_t num_chunks = 1 + (num_to_assign - 1) / chunk_size;
+
+	bool memory_ok = true;
+	bool search_ok = true;
+
+	#ifdef _OPENMP
+		const bool parallel = (num_chunks > 1) &&
+		                      (iscc_dist_functions.check_data_set == iscc_imp_check_data_set);
+		#pragma omp parallel if(parallel)
+	#endif
+	{
+		scc_PointIndex* const ok_queries = iscc_malloc(sizeof(scc_PointIndex[chunk_size]));
+		scc_PointIndex* const nn_indices = iscc_malloc(sizeof(scc_PointIndex[chunk_size]));
+		bool thread_memory_ok = (ok_queries != NULL) && (nn_indices != NULL);
+		bool thread_search_ok = true;
+
+		#ifdef _OPENMP
+			#pragma omp for schedule(dynamic)
+		#endif
+		for (size_t c = 0; c < num_chunks; ++c) {
+			if (!thread_memory_ok || !thread_search_ok) continue;
+			const size_t chunk_start = c * chunk_size;
+			const size_t in_chunk = ((num_to_assign - chunk_start) < chunk_size) ? (num_to_assign - chunk_start) : chunk_size;
+
+			size_t num_ok_queries = 0;
+			if (!iscc_nearest_neighbor_search(nn_search_object,
+			                                  in_chunk,
+			                                  to_assign + chunk_start,
+			                                  1,
+			                                  radius_constraint,
+			                                  radius.supplied,
+			                                  &num_ok_queries,
+			                                  radius_constraint ? ok_queries : NULL,
+			                                  nn_indices)) {
+				thread_search_ok = false;
+				continue;
+			}
+
+			// Without radius, all queries are ok
+			const scc_PointIndex* const chunk_ok_queries = radius_constraint ? ok_queries : to_assign + chunk_start;
+			assert(radius_constraint || (num_ok_queries == in_chunk));
+			for (size_t i = 0; i < num_ok_queries; ++i) {
+				assert(clustering->cluster_label[chunk_ok_queries[i]] == SCC_CLABEL_NA);
+				assert(clustering->cluster_label[nn_indices[i]] != SCC_CLABEL_NA);
+				clustering->cluster_label[chunk_ok_queries[i]] = clustering->cluster_label[nn_indices[i]];
+			}
+		}
+
+		iscc_free(ok_queries);
+		iscc_free(nn_indices);
+
+		#ifdef _OPENMP
+			#pragma omp critical(iscc_nb_assign)
+		#endif
+		{
+			memory_ok = memory_ok && thread_memory_ok;
+			search_ok = search_ok && thread_search_ok;
+		}
+	}
+
+	if (!memory_ok) return iscc_make_error(SCC_ER_NO_MEMORY);
+	if (!search_ok) return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
 
 	return iscc_no_error();
 }
@@ -39,7 +39,19 @@ scc_ErrorCode scc_nng_clustering_batches(scc_Clustering* clustering,
                                          double radius,
                                          size_t len_primary_data_points,
                                          const scc_PointIndex primary_data_points[],
-                                         uint32_t batch_size);
+                                         uint_fast16_t num_types,
+                                         const uint32_t type_constraints[],
+                                         const scc_TypeLabel type_labels[],
+                                         scc_UnassignedMethod secondary_unassigned_method,
+                                         scc_RadiusMethod primary_radius,
+                                         double primary_supplied_radius,
+                                         scc_RadiusMethod secondary_radius,
+                                         double secondary_supplied_radius,
+                                         uint32_t batch_size,
+                                         bool adaptive_batch_size,
+                                         size_t max_batch_bytes,
+                                         bool stable,
+                                         scc_BatchStats* out_batch_stats);
 
 
 #endif // ifndef SCC_BATCH_CLUSTERING_HG
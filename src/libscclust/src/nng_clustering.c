@@ -27,12 +27,33 @@
 #include <stdlib.h>
 #include "clustering_struct.h"
 #include "digraph_core.h"
+#include "digraph_operations.h"
 #include "dist_search.h"
 #include "error.h"
 #include "nng_batch_clustering.h"
 #include "nng_core.h"
 #include "nng_findseeds.h"
+#include "point_order.h"
 #include "utilities.h"
+#include "workspace.h"
+
+
+// =============================================================================
+// Internal variables
+// =============================================================================
+
+// The compile-time flags turn on stable tie-breaking for all clusterings
+#ifdef SCC_STABLE_NNG
+	static const bool ISCC_ALWAYS_STABLE_NNG = true;
+#else
+	static const bool ISCC_ALWAYS_STABLE_NNG = false;
+#endif // ifdef SCC_STABLE_NNG
+
+#ifdef SCC_STABLE_FINDSEED
+	static const bool ISCC_ALWAYS_STABLE_FINDSEED = true;
+#else
+	static const bool ISCC_ALWAYS_STABLE_FINDSEED = false;
+#endif // ifdef SCC_STABLE_FINDSEED
 
 
 // =============================================================================
@@ -45,6 +66,24 @@ static scc_ErrorCode iscc_make_clustering_from_nng(scc_Clustering* clustering,
                                                    const scc_ClusterOptions* options);
 
 
+static scc_ErrorCode iscc_find_seeds_compacted(const iscc_Digraph* nng,
+                                               const scc_ClusterOptions* options,
+                                               bool stable,
+                                               iscc_SeedResult* out_seeds);
+
+
+static scc_ErrorCode iscc_find_seeds_with_options(const iscc_Digraph* nng,
+                                                  const scc_ClusterOptions* options,
+                                                  bool stable,
+                                                  iscc_SeedResult* out_seeds);
+
+
+static scc_ErrorCode iscc_find_seeds_portfolio(const iscc_Digraph* nng,
+                                               uint32_t seed_portfolio,
+                                               bool stable,
+                                               iscc_SeedResult* out_seeds);
+
+
 // =============================================================================
 // Public function implementations
 // =============================================================================
@@ -70,7 +109,14 @@ scc_ErrorCode scc_sc_clustering(void* const data_set,
 		return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "Cannot refine existing clusterings.");
 	}
 
+	if (options->reorder_data_points) {
+		return iscc_sc_clustering_reordered(data_set, options, out_clustering);
+	}
+
+	const bool stable_nng = options->stable_clustering || ISCC_ALWAYS_STABLE_NNG;
+
 	if (options->seed_method == SCC_SM_BATCHES) {
+		assert(options->num_types <= UINT16_MAX);
 		return scc_nng_clustering_batches(out_clustering,
 		                                  data_set,
 		                                  options->size_constraint,
@@ -79,7 +125,19 @@ scc_ErrorCode scc_sc_clustering(void* const data_set,
 		                                  options->seed_supplied_radius,
 		                                  options->len_primary_data_points,
 		                                  options->primary_data_points,
-		                                  options->batch_size);
+		                                  (uint_fast16_t) options->num_types,
+		                                  options->type_constraints,
+		                                  options->type_labels,
+		                                  options->secondary_unassigned_method,
+		                                  options->primary_radius,
+		                                  options->primary_supplied_radius,
+		                                  options->secondary_radius,
+		                                  options->secondary_supplied_radius,
+		                                  options->batch_size,
+		                                  options->adaptive_batch_size,
+		                                  options->max_batch_bytes,
+		                                  stable_nng,
+		                                  options->batch_stats);
 	}
 
 	iscc_Digraph nng;
@@ -91,6 +149,7 @@ scc_ErrorCode scc_sc_clustering(void* const data_set,
 		                                            options->primary_data_points,
 		                                            (options->seed_radius == SCC_RM_USE_SUPPLIED),
 		                                            options->seed_supplied_radius,
+		                                            stable_nng,
 		                                            &nng)) != SCC_ER_OK) {
 			return ec;
 		}
@@ -106,6 +165,7 @@ scc_ErrorCode scc_sc_clustering(void* const data_set,
 		                                            options->primary_data_points,
 		                                            (options->seed_radius == SCC_RM_USE_SUPPLIED),
 		                                            options->seed_supplied_radius,
+		                                            stable_nng,
 		                                            &nng)) != SCC_ER_OK) {
 			return ec;
 		}
@@ -145,10 +205,15 @@ static scc_ErrorCode iscc_make_clustering_from_nng(scc_Clustering* const cluster
 		.seeds = NULL,
 	};
 
+	const bool stable_findseed = options->stable_clustering || ISCC_ALWAYS_STABLE_FINDSEED;
+
 	scc_ErrorCode ec;
-	if ((ec = iscc_find_seeds(nng, options->seed_method, &seed_result)) != SCC_ER_OK) {
-		return ec;
+	if (options->primary_data_points != NULL) {
+		ec = iscc_find_seeds_compacted(nng, options, stable_findseed, &seed_result);
+	} else {
+		ec = iscc_find_seeds_with_options(nng, options, stable_findseed, &seed_result);
 	}
+	if (ec != SCC_ER_OK) return ec;
 
 	scc_RadiusMethod primary_radius = options->primary_radius;
 	double primary_supplied_radius = options->primary_supplied_radius;
@@ -184,7 +249,7 @@ static scc_ErrorCode iscc_make_clustering_from_nng(scc_Clustering* const cluster
 		                                      nng,
 		                                      options->size_constraint,
 		                                      &avg_seed_dist)) != SCC_ER_OK) {
-			free(seed_result.seeds);
+			iscc_free(seed_result.seeds);
 			return ec;
 		}
 
@@ -193,7 +258,7 @@ static scc_ErrorCode iscc_make_clustering_from_nng(scc_Clustering* const cluster
 				primary_radius = SCC_RM_USE_SUPPLIED;
 				primary_supplied_radius = avg_seed_dist;
 			} else {
-				free(seed_result.seeds);
+				iscc_free(seed_result.seeds);
 				return iscc_make_error_msg(SCC_ER_NO_SOLUTION, "Infeasible radius constraint.");
 			}
 		}
@@ -203,7 +268,7 @@ static scc_ErrorCode iscc_make_clustering_from_nng(scc_Clustering* const cluster
 				secondary_radius = SCC_RM_USE_SUPPLIED;
 				secondary_supplied_radius = avg_seed_dist;
 			} else {
-				free(seed_result.seeds);
+				iscc_free(seed_result.seeds);
 				return iscc_make_error_msg(SCC_ER_NO_SOLUTION, "Infeasible radius constraint.");
 			}
 		}
@@ -215,9 +280,9 @@ static scc_ErrorCode iscc_make_clustering_from_nng(scc_Clustering* const cluster
 	// Initialize cluster labels
 	if (clustering->cluster_label == NULL) {
 		clustering->external_labels = false;
-		clustering->cluster_label = malloc(sizeof(scc_Clabel[clustering->num_data_points]));
+		clustering->cluster_label = iscc_malloc(sizeof(scc_Clabel[clustering->num_data_points]));
 		if (clustering->cluster_label == NULL) {
-			free(seed_result.seeds);
+			iscc_free(seed_result.seeds);
 			return iscc_make_error(SCC_ER_NO_MEMORY);
 		}
 	}
@@ -236,6 +301,130 @@ static scc_ErrorCode iscc_make_clustering_from_nng(scc_Clustering* const cluster
 	                                       (secondary_radius == SCC_RM_USE_SUPPLIED),
 	                                       secondary_supplied_radius);
 
-	free(seed_result.seeds);
+	iscc_free(seed_result.seeds);
+	return ec;
+}
+
+
+// With few primary data points, most vertices in the NNG are isolated. Seeds are then found
+// on a compacted NNG so that the working memory of seed finding scales with the relevant
+// subgraph. Compaction preserves the order of vertices, so the seeds are the same.
+static scc_ErrorCode iscc_find_seeds_compacted(const iscc_Digraph* const nng,
+                                               const scc_ClusterOptions* const options,
+                                               const bool stable,
+                                               iscc_SeedResult* const out_seeds)
+{
+	assert(iscc_digraph_is_valid(nng));
+	assert(!iscc_digraph_is_empty(nng));
+	assert(options->primary_data_points != NULL);
+	assert(out_seeds != NULL);
+	assert(out_seeds->count == 0);
+	assert(out_seeds->seeds == NULL);
+
+	// Only worth it when at least half of the vertices can be dropped
+	scc_PointIndex* vertex_ids;
+	iscc_Digraph compact_nng;
+	if (iscc_digraph_compact(nng, nng->vertices / 2, &vertex_ids, &compact_nng) != SCC_ER_OK) {
+		// Not enough memory to compact, use the full NNG
+		iscc_reset_error();
+		vertex_ids = NULL;
+	}
+	if (vertex_ids == NULL) {
+		return iscc_find_seeds_with_options(nng, options, stable, out_seeds);
+	}
+
+	// The NNG has arcs but no self-loops, so at least two vertices remain
+	assert(compact_nng.vertices > 1);
+	out_seeds->capacity = 1 + (compact_nng.vertices / options->size_constraint);
+
+	const scc_ErrorCode ec = iscc_find_seeds_with_options(&compact_nng, options, stable, out_seeds);
+	iscc_free_digraph(&compact_nng);
+
+	if (ec == SCC_ER_OK) {
+		for (size_t i = 0; i < out_seeds->count; ++i) {
+			out_seeds->seeds[i] = vertex_ids[out_seeds->seeds[i]];
+		}
+	}
+
+	iscc_free(vertex_ids);
+
 	return ec;
 }
+
+
+static scc_ErrorCode iscc_find_seeds_with_options(const iscc_Digraph* const nng,
+                                                  const scc_ClusterOptions* const options,
+                                                  const bool stable,
+                                                  iscc_SeedResult* const out_seeds)
+{
+	if (options->seed_portfolio != 0) {
+		return iscc_find_seeds_portfolio(nng, options->seed_portfolio, stable, out_seeds);
+	}
+	return iscc_find_seeds(nng, options->seed_method, stable, out_seeds);
+}
+
+
+static scc_ErrorCode iscc_find_seeds_portfolio(const iscc_Digraph* const nng,
+                                               const uint32_t seed_portfolio,
+                                               const bool stable,
+                                               iscc_SeedResult* const out_seeds)
+{
+	assert(iscc_digraph_is_valid(nng));
+	assert(!iscc_digraph_is_empty(nng));
+	assert(seed_portfolio != 0);
+	assert(out_seeds != NULL);
+	assert(out_seeds->seeds == NULL);
+
+	static const scc_SeedMethod all_methods[5] = {
+		SCC_SM_LEXICAL,
+		SCC_SM_INWARDS_ORDER,
+		SCC_SM_INWARDS_UPDATING,
+		SCC_SM_EXCLUSION_ORDER,
+		SCC_SM_EXCLUSION_UPDATING,
+	};
+
+	int num_methods = 0;
+	scc_SeedMethod methods[5];
+	iscc_SeedResult results[5];
+	scc_ErrorCode ecs[5];
+	for (int m = 0; m < 5; ++m) {
+		if ((seed_portfolio & (UINT32_C(1) << all_methods[m])) != 0) {
+			methods[num_methods] = all_methods[m];
+			results[num_methods] = *out_seeds;
+			++num_methods;
+		}
+	}
+	assert(num_methods > 0);
+
+	// Seed finding only reads the NNG, so the methods can run side by side. The
+	// methods set and reset the shared error state concurrently, so it is only
+	// meaningful after the loop.
+	#ifdef _OPENMP
+		#pragma omp parallel for schedule(dynamic, 1)
+	#endif
+	for (int i = 0; i < num_methods; ++i) {
+		ecs[i] = iscc_find_seeds(nng, methods[i], stable, &results[i]);
+	}
+
+	int best = -1;
+	scc_ErrorCode ec = SCC_ER_OK;
+	for (int i = 0; i < num_methods; ++i) {
+		if (ecs[i] != SCC_ER_OK) {
+			if (ec == SCC_ER_OK) ec = ecs[i];
+		} else if ((best < 0) || (results[i].count > results[best].count)) {
+			best = i;
+		}
+	}
+
+	// `iscc_find_seeds` frees the seeds of failed methods
+	for (int i = 0; i < num_methods; ++i) {
+		if ((ecs[i] == SCC_ER_OK) && ((i != best) || (ec != SCC_ER_OK))) iscc_free(results[i].seeds);
+	}
+
+	// Record the error of the first failed method once the methods are done
+	if (ec != SCC_ER_OK) return iscc_make_error(ec);
+
+	*out_seeds = results[best];
+
+	return iscc_no_error();
+}
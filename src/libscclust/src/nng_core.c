@@ -34,20 +34,14 @@
 #include "error.h"
 #include "nng_findseeds.h"
 #include "scclust_types.h"
+#include "utilities.h"
+#include "workspace.h"
 
 
 // =============================================================================
 // Internal structs & variables
 // =============================================================================
 
-typedef struct iscc_TypeCount {
-	uint32_t sum_type_constraints;
-	size_t* type_group_size;
-	scc_PointIndex* point_store;
-	scc_PointIndex** type_groups;
-} iscc_TypeCount;
-
-
 static const size_t ISCC_ESTIMATE_AVG_MAX_SAMPLE = 1000;
 
 
@@ -86,14 +80,6 @@ static inline void iscc_ensure_self_match(iscc_Digraph* nng,
                                           const scc_PointIndex search_indices[]);
 
 
-static scc_ErrorCode iscc_type_count(size_t num_data_points,
-                                     uint32_t size_constraint,
-                                     uint_fast16_t num_types,
-                                     const uint32_t type_constraints[static num_types],
-                                     const scc_TypeLabel type_labels[static num_data_points],
-                                     iscc_TypeCount* out_type_result);
-
-
 static size_t iscc_assign_seeds_and_neighbors(scc_Clustering* clustering,
                                               const iscc_SeedResult* seed_result,
                                               iscc_Digraph* nng);
@@ -111,11 +97,13 @@ static scc_ErrorCode iscc_assign_by_nn_search(scc_Clustering* clustering,
                                               double radius);
 
 
-#ifdef SCC_STABLE_NNG
-
 static void iscc_sort_nng(iscc_Digraph* nng);
 
-#endif // ifdef SCC_STABLE_NNG
+
+static scc_ErrorCode iscc_spill_nngs(uint_fast16_t num_nngs,
+                                     uint_fast16_t max_nngs,
+                                     iscc_Digraph nngs[static num_nngs],
+                                     iscc_SpilledDigraph** out_spilled);
 
 
 // =============================================================================
@@ -129,6 +117,7 @@ scc_ErrorCode iscc_get_nng_with_size_constraint(void* const data_set,
                                                 const scc_PointIndex primary_data_points[],
                                                 const bool radius_constraint,
                                                 const double radius,
+                                                const bool stable,
                                                 iscc_Digraph* const out_nng)
 {
 	assert(iscc_check_data_set(data_set));
@@ -174,9 +163,7 @@ scc_ErrorCode iscc_get_nng_with_size_constraint(void* const data_set,
 		return ec;
 	}
 
-	#ifdef SCC_STABLE_NNG
-		iscc_sort_nng(out_nng);
-	#endif // ifdef SCC_STABLE_NNG
+	if (stable) iscc_sort_nng(out_nng);
 
 	return iscc_no_error();
 }
@@ -192,6 +179,7 @@ scc_ErrorCode iscc_get_nng_with_type_constraint(void* const data_set,
                                                 const scc_PointIndex primary_data_points[],
                                                 const bool radius_constraint,
                                                 const double radius,
+                                                const bool stable,
                                                 iscc_Digraph* const out_nng)
 {
 	assert(iscc_check_data_set(data_set));
@@ -213,11 +201,16 @@ scc_ErrorCode iscc_get_nng_with_type_constraint(void* const data_set,
 		num_queries = len_primary_data_points;
 	}
 
+	// With a radius constraint, each search compacts `seedable` in place. A search
+	// that runs out of memory may leave it half compacted, so the list is also kept
+	// in `seedable_backup` and restored before the search is retried.
 	scc_PointIndex* seedable;
+	scc_PointIndex* seedable_backup;
 	const scc_PointIndex* seedable_const;
 	if (radius_constraint) {
-		seedable = malloc(sizeof(scc_PointIndex[num_queries]));
+		seedable = iscc_malloc(sizeof(scc_PointIndex[2 * num_queries]));
 		if (seedable == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+		seedable_backup = seedable + num_queries;
 		seedable_const = seedable;
 		if (primary_data_points == NULL) {
 			for (scc_PointIndex i = 0; i < (scc_PointIndex) num_data_points; ++i) {
@@ -228,12 +221,13 @@ scc_ErrorCode iscc_get_nng_with_type_constraint(void* const data_set,
 		}
 	} else {
 		seedable = NULL;
+		seedable_backup = NULL;
 		seedable_const = primary_data_points;
 	}
 
-	iscc_Digraph* const nng_by_type = malloc(sizeof(iscc_Digraph[num_types]));
+	iscc_Digraph* const nng_by_type = iscc_malloc(sizeof(iscc_Digraph[num_types]));
 	if (nng_by_type == NULL) {
-		free(seedable);
+		iscc_free(seedable);
 		return iscc_make_error(SCC_ER_NO_MEMORY);
 	}
 
@@ -245,28 +239,40 @@ scc_ErrorCode iscc_get_nng_with_type_constraint(void* const data_set,
 	                          type_constraints,
 	                          type_labels,
 	                          &tc)) != SCC_ER_OK) {
-		free(seedable);
-		free(nng_by_type);
+		iscc_free(seedable);
+		iscc_free(nng_by_type);
 		return ec;
 	}
 
+	// When memory runs out, finished NNGs are spilled to disk
+	// and their union is read back from there
+	iscc_SpilledDigraph* spilled_by_type = NULL;
+
 	uint_fast16_t num_non_zero_type_constraints = 0;
 	for (uint_fast16_t i = 0; i < num_types; ++i) {
 		if (type_constraints[i] > 0) {
-			if ((ec = iscc_make_nng(data_set,
-			                        num_data_points,
-			                        tc.type_group_size[i],
-			                        tc.type_groups[i],
-			                        num_queries,
-			                        seedable_const,
-			                        type_constraints[i],
-			                        radius_constraint,
-			                        radius,
-			                        &num_queries,
-			                        seedable,
-			                        &nng_by_type[num_non_zero_type_constraints])) != SCC_ER_OK) {
-				break;
+			const size_t num_queries_before = num_queries;
+			if (seedable != NULL) memcpy(seedable_backup, seedable, sizeof(scc_PointIndex[num_queries]));
+			while (true) {
+				ec = iscc_make_nng(data_set,
+				                   num_data_points,
+				                   tc.type_group_size[i],
+				                   tc.type_groups[i],
+				                   num_queries,
+				                   seedable_const,
+				                   type_constraints[i],
+				                   radius_constraint,
+				                   radius,
+				                   &num_queries,
+				                   seedable,
+				                   &nng_by_type[num_non_zero_type_constraints]);
+				if ((ec != SCC_ER_NO_MEMORY) || (num_non_zero_type_constraints == 0) || (spilled_by_type != NULL)) break;
+				iscc_reset_error();
+				if ((ec = iscc_spill_nngs(num_non_zero_type_constraints, num_types, nng_by_type, &spilled_by_type)) != SCC_ER_OK) break;
+				num_queries = num_queries_before;
+				if (seedable != NULL) memcpy(seedable, seedable_backup, sizeof(scc_PointIndex[num_queries]));
 			}
+			if (ec != SCC_ER_OK) break;
 			++num_non_zero_type_constraints;
 			if (iscc_digraph_is_empty(&nng_by_type[num_non_zero_type_constraints - 1])) {
 				ec = iscc_make_error_msg(SCC_ER_NO_SOLUTION, "Infeasible radius constraint.");
@@ -275,30 +281,38 @@ scc_ErrorCode iscc_get_nng_with_type_constraint(void* const data_set,
 			iscc_ensure_self_match(&nng_by_type[num_non_zero_type_constraints - 1],
 			                       tc.type_group_size[i],
 			                       tc.type_groups[i]);
+			// Sorted rows let the union below merge rows instead of marking heads
+			if (stable) iscc_sort_nng(&nng_by_type[num_non_zero_type_constraints - 1]);
+			if (spilled_by_type != NULL) {
+				ec = iscc_spill_digraph(&nng_by_type[num_non_zero_type_constraints - 1],
+				                        &spilled_by_type[num_non_zero_type_constraints - 1]);
+				if (ec != SCC_ER_OK) break;
+			}
 		}
 	}
 
-	free(tc.type_group_size);
-	free(tc.point_store);
-	free(tc.type_groups);
+	iscc_free(tc.type_group_size);
+	iscc_free(tc.point_store);
+	iscc_free(tc.type_groups);
 
-	if (ec == SCC_ER_OK) {
-		if (size_constraint > tc.sum_type_constraints) {
-			// If general size constaint (besides type constraints), we need to keep self-loops
-			ec = iscc_digraph_union_and_delete(num_non_zero_type_constraints, nng_by_type, num_queries, seedable_const, true, out_nng);
-		} else {
-			ec = iscc_digraph_union_and_delete(num_non_zero_type_constraints, nng_by_type, num_queries, seedable_const, false, out_nng);
-		}
+	// If general size constaint (besides type constraints), we need to keep self-loops
+	const bool keep_self_loops = (size_constraint > tc.sum_type_constraints);
+	if ((ec == SCC_ER_OK) && (spilled_by_type != NULL)) {
+		ec = iscc_digraph_union_and_delete_spilled(num_non_zero_type_constraints, spilled_by_type, num_queries, seedable_const, keep_self_loops, out_nng);
+	} else if (ec == SCC_ER_OK) {
+		ec = iscc_digraph_union_and_delete(num_non_zero_type_constraints, nng_by_type, num_queries, seedable_const, keep_self_loops, out_nng);
 	}
 
 	for (uint_fast16_t i = 0; i < num_non_zero_type_constraints; ++i) {
 		iscc_free_digraph(&nng_by_type[i]);
+		if (spilled_by_type != NULL) iscc_free_spilled_digraph(&spilled_by_type[i]);
 	}
-	free(nng_by_type);
+	iscc_free(nng_by_type);
+	iscc_free(spilled_by_type);
 
 	if (ec != SCC_ER_OK) {
 		// When `ec != SCC_ER_OK`, error is from `iscc_digraph_union_and_delete` so `out_nng` is already freed
-		free(seedable);
+		iscc_free(seedable);
 		return ec;
 	}
 
@@ -307,19 +321,37 @@ scc_ErrorCode iscc_get_nng_with_type_constraint(void* const data_set,
 		iscc_Digraph nng_sum[2];
 		nng_sum[0] = *out_nng;
 
-		if ((ec = iscc_make_nng(data_set,
-		                        num_data_points,
-		                        num_data_points,
-		                        NULL,
-		                        num_queries,
-		                        seedable_const,
-		                        size_constraint,
-		                        radius_constraint,
-		                        radius,
-		                        &num_queries,
-		                        seedable,
-		                        &nng_sum[1])) != SCC_ER_OK) {
-			free(seedable);
+		// If memory runs out, the union is moved to disk during the search
+		iscc_SpilledDigraph spilled_sum = ISCC_NULL_SPILLED_DIGRAPH;
+		const size_t num_queries_before = num_queries;
+		if (seedable != NULL) memcpy(seedable_backup, seedable, sizeof(scc_PointIndex[num_queries]));
+		while (true) {
+			ec = iscc_make_nng(data_set,
+			                   num_data_points,
+			                   num_data_points,
+			                   NULL,
+			                   num_queries,
+			                   seedable_const,
+			                   size_constraint,
+			                   radius_constraint,
+			                   radius,
+			                   &num_queries,
+			                   seedable,
+			                   &nng_sum[1]);
+			if ((ec != SCC_ER_NO_MEMORY) || (spilled_sum.file != NULL)) break;
+			iscc_reset_error();
+			if ((ec = iscc_spill_digraph(&nng_sum[0], &spilled_sum)) != SCC_ER_OK) break;
+			num_queries = num_queries_before;
+			if (seedable != NULL) memcpy(seedable, seedable_backup, sizeof(scc_PointIndex[num_queries]));
+		}
+		if ((ec == SCC_ER_OK) && (spilled_sum.file != NULL)) {
+			if ((ec = iscc_load_spilled_digraph(&spilled_sum, &nng_sum[0])) != SCC_ER_OK) {
+				iscc_free_digraph(&nng_sum[1]);
+			}
+		}
+		iscc_free_spilled_digraph(&spilled_sum);
+		if (ec != SCC_ER_OK) {
+			iscc_free(seedable);
 			iscc_free_digraph(&nng_sum[0]);
 			return ec;
 		}
@@ -330,6 +362,9 @@ scc_ErrorCode iscc_get_nng_with_type_constraint(void* const data_set,
 			ec = iscc_digraph_difference(&nng_sum[1], &nng_sum[0], additional_nn_needed);
 		}
 
+		// `nng_sum[1]` must be in distance order until the difference is taken
+		if ((ec == SCC_ER_OK) && stable) iscc_sort_nng(&nng_sum[1]);
+
 		if (ec == SCC_ER_OK) {
 			ec = iscc_digraph_union_and_delete(2, nng_sum, num_queries, seedable_const, false, out_nng);
 		}
@@ -338,16 +373,81 @@ scc_ErrorCode iscc_get_nng_with_type_constraint(void* const data_set,
 		iscc_free_digraph(&nng_sum[1]);
 
 		if (ec != SCC_ER_OK) {
-			free(seedable);
+			iscc_free(seedable);
 			return ec;
 		}
 	}
 
-	free(seedable);
+	iscc_free(seedable);
+
+	if (stable) iscc_sort_nng(out_nng);
+
+	return iscc_no_error();
+}
+
+
+scc_ErrorCode iscc_type_count(const size_t num_data_points,
+                              const uint32_t size_constraint,
+                              const uint_fast16_t num_types,
+                              const uint32_t type_constraints[const static num_types],
+                              const scc_TypeLabel type_labels[const static num_data_points],
+                              iscc_TypeCount* const out_type_result)
+{
+	assert(num_data_points > 1);
+	assert(size_constraint >= 2);
+	assert(num_types >= 2);
+	assert(num_types <= ISCC_TYPELABEL_MAX);
+	assert(type_constraints != NULL);
+	assert(type_labels != NULL);
+	assert(out_type_result != NULL);
+
+	*out_type_result = (iscc_TypeCount) {
+		.sum_type_constraints = 0,
+		.type_group_size = iscc_calloc(num_types, sizeof(size_t)),
+		.point_store = iscc_malloc(sizeof(scc_PointIndex[num_data_points])),
+		.type_groups = iscc_malloc(sizeof(scc_PointIndex*[num_types])),
+	};
+
+	if ((out_type_result->type_group_size == NULL) || (out_type_result->point_store == NULL) || (out_type_result->type_groups == NULL)) {
+		iscc_free(out_type_result->type_group_size);
+		iscc_free(out_type_result->point_store);
+		iscc_free(out_type_result->type_groups);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	for (size_t i = 0; i < num_data_points; ++i) {
+		assert(type_labels[i] < (scc_TypeLabel) num_types);
+		++out_type_result->type_group_size[type_labels[i]];
+	}
+
+	for (uint_fast16_t i = 0; i < num_types; ++i) {
+		if (out_type_result->type_group_size[i] < type_constraints[i]) {
+			iscc_free(out_type_result->type_group_size);
+			iscc_free(out_type_result->point_store);
+			iscc_free(out_type_result->type_groups);
+			return iscc_make_error_msg(SCC_ER_NO_SOLUTION, "Fewer data points than type size constraint.");
+		}
+		out_type_result->sum_type_constraints += type_constraints[i];
+	}
+
+	if (out_type_result->sum_type_constraints > size_constraint) {
+		iscc_free(out_type_result->type_group_size);
+		iscc_free(out_type_result->point_store);
+		iscc_free(out_type_result->type_groups);
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Type constraint cannot be larger than overall size constraint.");
+	}
+
+	out_type_result->type_groups[0] = out_type_result->point_store + out_type_result->type_group_size[0];
+	for (uint_fast16_t i = 1; i < num_types; ++i) {
+		out_type_result->type_groups[i] = out_type_result->type_groups[i - 1] + out_type_result->type_group_size[i];
+	}
 
-	#ifdef SCC_STABLE_NNG
-		iscc_sort_nng(out_nng);
-	#endif // ifdef SCC_STABLE_NNG
+	assert(num_data_points <= ISCC_POINTINDEX_MAX);
+	const scc_PointIndex num_data_points_pi = (scc_PointIndex) num_data_points; // if case `scc_PointIndex` is signed.
+	for (scc_PointIndex i = 0; i < num_data_points_pi; ++i) {
+		--(out_type_result->type_groups[type_labels[i]]);
+		*(out_type_result->type_groups[type_labels[i]]) = i;
+	}
 
 	return iscc_no_error();
 }
@@ -373,13 +473,13 @@ scc_ErrorCode iscc_estimate_avg_seed_dist(void* const data_set,
 
 	size_t sampled = 0;
 	double sum_dist = 0.0;
-	double* const dist_scratch = malloc(sizeof(double[size_constraint]));
+	double* const dist_scratch = iscc_malloc(sizeof(double[size_constraint]));
 	if (dist_scratch == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 
 	for (size_t s = 0; s < seed_result->count; s += step) {
 		const scc_PointIndex seed = seed_result->seeds[s];
-		const size_t num_neighbors = (nng->tail_ptr[seed + 1] - nng->tail_ptr[seed]);
-		const scc_PointIndex* const neighbors = nng->head + nng->tail_ptr[seed];
+		const size_t num_neighbors = (iscc_get_tail_ptr(nng, seed + 1) - iscc_get_tail_ptr(nng, seed));
+		const scc_PointIndex* const neighbors = iscc_arc_start(nng, seed);
 
 		// Either zero or one self-loops
 		assert((num_neighbors == size_constraint) ||
@@ -391,7 +491,7 @@ scc_ErrorCode iscc_estimate_avg_seed_dist(void* const data_set,
 		                        num_neighbors,
 		                        neighbors,
 		                        dist_scratch)) {
-			free(dist_scratch);
+			iscc_free(dist_scratch);
 			return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
 		}
 
@@ -410,7 +510,7 @@ scc_ErrorCode iscc_estimate_avg_seed_dist(void* const data_set,
 		sum_dist += tmp_dist / ((double) num_non_self_loops);
 	}
 
-	free(dist_scratch);
+	iscc_free(dist_scratch);
 
 	*out_avg_seed_dist = sum_dist / ((double) sampled);
 
@@ -463,7 +563,7 @@ scc_ErrorCode iscc_make_nng_clusters_from_seeds(scc_Clustering* const clustering
 	scc_PointIndex* seed_or_neighbor = NULL;
 	if ((unassigned_method == SCC_UM_CLOSEST_ASSIGNED) ||
 	        (secondary_unassigned_method == SCC_UM_CLOSEST_ASSIGNED)) {
-		seed_or_neighbor = malloc(sizeof(scc_PointIndex[num_assigned_as_seed_or_neighbor]));
+		seed_or_neighbor = iscc_malloc(sizeof(scc_PointIndex[num_assigned_as_seed_or_neighbor]));
 		if (seed_or_neighbor == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 
 		scc_PointIndex* write_seed_or_neighbor = seed_or_neighbor;
@@ -492,7 +592,7 @@ scc_ErrorCode iscc_make_nng_clusters_from_seeds(scc_Clustering* const clustering
 		// Are we done?
 		if ((total_assigned == clustering->num_data_points) ||
 		        ((unassigned_method == SCC_UM_IGNORE) && (secondary_unassigned_method == SCC_UM_IGNORE))) {
-			free(seed_or_neighbor);
+			iscc_free(seed_or_neighbor);
 			return iscc_no_error();
 		}
 	}
@@ -516,7 +616,7 @@ scc_ErrorCode iscc_make_nng_clusters_from_seeds(scc_Clustering* const clustering
 	}
 
 	if (ec != SCC_ER_OK) {
-		free(seed_or_neighbor);
+		iscc_free(seed_or_neighbor);
 		return ec;
 	}
 
@@ -531,7 +631,7 @@ scc_ErrorCode iscc_make_nng_clusters_from_seeds(scc_Clustering* const clustering
 	}
 
 	if (ec != SCC_ER_OK) {
-		free(seed_or_neighbor);
+		iscc_free(seed_or_neighbor);
 		if (nn_assigned_search_object != NULL) {
 			iscc_close_nn_search_object(&nn_assigned_search_object);
 		}
@@ -539,9 +639,9 @@ scc_ErrorCode iscc_make_nng_clusters_from_seeds(scc_Clustering* const clustering
 	}
 
 	size_t num_to_assign = 0;
-	scc_PointIndex* const to_assign = malloc(sizeof(scc_PointIndex[clustering->num_data_points - total_assigned + 1]));
+	scc_PointIndex* const to_assign = iscc_malloc(sizeof(scc_PointIndex[clustering->num_data_points - total_assigned + 1]));
 	if (to_assign == NULL) {
-		free(seed_or_neighbor);
+		iscc_free(seed_or_neighbor);
 		if (nn_assigned_search_object != NULL) {
 			iscc_close_nn_search_object(&nn_assigned_search_object);
 		}
@@ -583,8 +683,8 @@ scc_ErrorCode iscc_make_nng_clusters_from_seeds(scc_Clustering* const clustering
 	}
 
 	if (ec != SCC_ER_OK) {
-		free(seed_or_neighbor);
-		free(to_assign);
+		iscc_free(seed_or_neighbor);
+		iscc_free(to_assign);
 		if (nn_assigned_search_object != NULL) {
 			iscc_close_nn_search_object(&nn_assigned_search_object);
 		}
@@ -621,8 +721,8 @@ scc_ErrorCode iscc_make_nng_clusters_from_seeds(scc_Clustering* const clustering
 		}
 	}
 
-	free(seed_or_neighbor);
-	free(to_assign);
+	iscc_free(seed_or_neighbor);
+	iscc_free(to_assign);
 	if (nn_assigned_search_object != NULL) {
 		iscc_close_nn_search_object(&nn_assigned_search_object);
 	}
@@ -715,7 +815,7 @@ static scc_ErrorCode iscc_make_nng_from_search_object(iscc_NNSearchObject* const
 		if (out_query_indices != NULL) {
 			dist_out_query_indices = out_query_indices;
 		} else {
-			internal_out_query_indices = malloc(sizeof(scc_PointIndex[len_query_indices]));
+			internal_out_query_indices = iscc_malloc(sizeof(scc_PointIndex[len_query_indices]));
 			if (internal_out_query_indices == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 			dist_out_query_indices = internal_out_query_indices;
 		}
@@ -725,7 +825,7 @@ static scc_ErrorCode iscc_make_nng_from_search_object(iscc_NNSearchObject* const
 	if ((ec = iscc_init_digraph(num_data_points,
 	                            len_query_indices * k,
 	                            out_nng)) != SCC_ER_OK) {
-		free(internal_out_query_indices);
+		iscc_free(internal_out_query_indices);
 		return ec;
 	}
 
@@ -739,15 +839,14 @@ static scc_ErrorCode iscc_make_nng_from_search_object(iscc_NNSearchObject* const
 	                                  &num_ok_queries,
 	                                  dist_out_query_indices,
 	                                  out_nng->head)) {
-		free(internal_out_query_indices);
+		iscc_free(internal_out_query_indices);
 		iscc_free_digraph(out_nng);
 		return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
 	}
 
-	iscc_ArcIndex* write_tail_ptr = out_nng->tail_ptr;
-	*write_tail_ptr = 0;
-	++write_tail_ptr;
-	const iscc_ArcIndex* const write_tail_ptr_stop = write_tail_ptr + num_data_points;
+	size_t write_v = 0;
+	size_t arcs_written = 0;
+	iscc_set_tail_ptr(out_nng, 0, 0);
 
 	if (radius_search || query_indices != NULL) {
 		const scc_PointIndex* ok_q;
@@ -760,34 +859,32 @@ static scc_ErrorCode iscc_make_nng_from_search_object(iscc_NNSearchObject* const
 			ok_q = query_indices;
 		}
 
-		scc_PointIndex i = 0;
 		const scc_PointIndex* const ok_q_stop = ok_q + num_ok_queries;
 		for (; ok_q < ok_q_stop; ++ok_q) {
-			for (; i < *ok_q; ++i) {
-				*write_tail_ptr = *(write_tail_ptr - 1);
-				++write_tail_ptr;
+			for (; write_v < (size_t) *ok_q; ++write_v) {
+				iscc_set_tail_ptr(out_nng, (scc_PointIndex) (write_v + 1), arcs_written);
 			}
-			*write_tail_ptr = *(write_tail_ptr - 1) + k;
-			++write_tail_ptr;
-			++i;
+			arcs_written += k;
+			iscc_set_tail_ptr(out_nng, (scc_PointIndex) (write_v + 1), arcs_written);
+			++write_v;
 		}
 	} else {
 		assert(!radius_search && query_indices == NULL);
 		assert(len_query_indices == num_ok_queries);
-		for (size_t q = 0; q < len_query_indices; ++q) {
-			*write_tail_ptr = *(write_tail_ptr - 1) + k;
-			++write_tail_ptr;
+		for (; write_v < len_query_indices; ++write_v) {
+			arcs_written += k;
+			iscc_set_tail_ptr(out_nng, (scc_PointIndex) (write_v + 1), arcs_written);
 		}
 	}
 
-	for (; write_tail_ptr < write_tail_ptr_stop; ++write_tail_ptr) {
-		*write_tail_ptr = *(write_tail_ptr - 1);
+	for (; write_v < num_data_points; ++write_v) {
+		iscc_set_tail_ptr(out_nng, (scc_PointIndex) (write_v + 1), arcs_written);
 	}
 
 	if (internal_out_query_indices != NULL) {
 		assert(radius_search);
 		assert(out_query_indices == NULL);
-		free(internal_out_query_indices);
+		iscc_free(internal_out_query_indices);
 	}
 
 	if (len_query_indices > num_ok_queries) {
@@ -823,8 +920,8 @@ static inline void iscc_ensure_self_match(iscc_Digraph* const nng,
 		assert(len_search_indices <= ISCC_POINTINDEX_MAX);
 		const scc_PointIndex len_search_indices_pi = (scc_PointIndex) len_search_indices; // If `scc_PointIndex` is signed.
 		for (scc_PointIndex search_point = 0; search_point < len_search_indices_pi; ++search_point) {
-			scc_PointIndex* v_arc = nng->head + nng->tail_ptr[search_point];
-			const scc_PointIndex* const v_arc_stop = nng->head + nng->tail_ptr[search_point + 1];
+			scc_PointIndex* v_arc = iscc_arc_start(nng, search_point);
+			const scc_PointIndex* const v_arc_stop = iscc_arc_stop(nng, search_point);
 			if ((v_arc != v_arc_stop) && (*v_arc != search_point)) {
 				for (++v_arc; (v_arc != v_arc_stop) && (*v_arc != search_point); ++v_arc);
 				if (v_arc == v_arc_stop) *(v_arc - 1) = search_point;
@@ -834,8 +931,8 @@ static inline void iscc_ensure_self_match(iscc_Digraph* const nng,
 	} else if (search_indices != NULL) {
 		for (size_t s = 0; s < len_search_indices; ++s) {
 			const scc_PointIndex search_point = search_indices[s];
-			scc_PointIndex* v_arc = nng->head + nng->tail_ptr[search_point];
-			const scc_PointIndex* const v_arc_stop = nng->head + nng->tail_ptr[search_point + 1];
+			scc_PointIndex* v_arc = iscc_arc_start(nng, search_point);
+			const scc_PointIndex* const v_arc_stop = iscc_arc_stop(nng, search_point);
 			if ((v_arc != v_arc_stop) && (*v_arc != search_point)) {
 				for (++v_arc; (v_arc != v_arc_stop) && (*v_arc != search_point); ++v_arc);
 				if (v_arc == v_arc_stop) *(v_arc - 1) = search_point;
@@ -845,73 +942,6 @@ static inline void iscc_ensure_self_match(iscc_Digraph* const nng,
 }
 
 
-static scc_ErrorCode iscc_type_count(const size_t num_data_points,
-                                     const uint32_t size_constraint,
-                                     const uint_fast16_t num_types,
-                                     const uint32_t type_constraints[const static num_types],
-                                     const scc_TypeLabel type_labels[const static num_data_points],
-                                     iscc_TypeCount* const out_type_result)
-{
-	assert(num_data_points > 1);
-	assert(size_constraint >= 2);
-	assert(num_types >= 2);
-	assert(num_types <= ISCC_TYPELABEL_MAX);
-	assert(type_constraints != NULL);
-	assert(type_labels != NULL);
-	assert(out_type_result != NULL);
-
-	*out_type_result = (iscc_TypeCount) {
-		.sum_type_constraints = 0,
-		.type_group_size = calloc(num_types, sizeof(size_t)),
-		.point_store = malloc(sizeof(scc_PointIndex[num_data_points])),
-		.type_groups = malloc(sizeof(scc_PointIndex*[num_types])),
-	};
-
-	if ((out_type_result->type_group_size == NULL) || (out_type_result->point_store == NULL) || (out_type_result->type_groups == NULL)) {
-		free(out_type_result->type_group_size);
-		free(out_type_result->point_store);
-		free(out_type_result->type_groups);
-		return iscc_make_error(SCC_ER_NO_MEMORY);
-	}
-
-	for (size_t i = 0; i < num_data_points; ++i) {
-		assert(type_labels[i] < (scc_TypeLabel) num_types);
-		++out_type_result->type_group_size[type_labels[i]];
-	}
-
-	for (uint_fast16_t i = 0; i < num_types; ++i) {
-		if (out_type_result->type_group_size[i] < type_constraints[i]) {
-			free(out_type_result->type_group_size);
-			free(out_type_result->point_store);
-			free(out_type_result->type_groups);
-			return iscc_make_error_msg(SCC_ER_NO_SOLUTION, "Fewer data points than type size constraint.");
-		}
-		out_type_result->sum_type_constraints += type_constraints[i];
-	}
-
-	if (out_type_result->sum_type_constraints > size_constraint) {
-		free(out_type_result->type_group_size);
-		free(out_type_result->point_store);
-		free(out_type_result->type_groups);
-		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Type constraint cannot be larger than overall size constraint.");
-	}
-
-	out_type_result->type_groups[0] = out_type_result->point_store + out_type_result->type_group_size[0];
-	for (uint_fast16_t i = 1; i < num_types; ++i) {
-		out_type_result->type_groups[i] = out_type_result->type_groups[i - 1] + out_type_result->type_group_size[i];
-	}
-
-	assert(num_data_points <= ISCC_POINTINDEX_MAX);
-	const scc_PointIndex num_data_points_pi = (scc_PointIndex) num_data_points; // if case `scc_PointIndex` is signed.
-	for (scc_PointIndex i = 0; i < num_data_points_pi; ++i) {
-		--(out_type_result->type_groups[type_labels[i]]);
-		*(out_type_result->type_groups[type_labels[i]]) = i;
-	}
-
-	return iscc_no_error();
-}
-
-
 static size_t iscc_assign_seeds_and_neighbors(scc_Clustering* const clustering,
                                               const iscc_SeedResult* const seed_result,
                                               iscc_Digraph* const nng)
@@ -938,13 +968,13 @@ static size_t iscc_assign_seeds_and_neighbors(scc_Clustering* const clustering,
 		assert(clabel < SCC_CLABEL_MAX);
 		assert(clustering->cluster_label[*seed] == SCC_CLABEL_NA);
 
-		const scc_PointIndex* const s_arc_stop = nng->head + nng->tail_ptr[*seed + 1];
-		for (const scc_PointIndex* s_arc = nng->head + nng->tail_ptr[*seed];
+		const scc_PointIndex* const s_arc_stop = iscc_arc_stop(nng, *seed);
+		for (const scc_PointIndex* s_arc = iscc_arc_start(nng, *seed);
 		        s_arc != s_arc_stop; ++s_arc) {
 			assert(clustering->cluster_label[*s_arc] == SCC_CLABEL_NA);
 			clustering->cluster_label[*s_arc] = clabel;
 		}
-		num_assigned += (nng->tail_ptr[*seed + 1] - nng->tail_ptr[*seed]) + // Number of arcs from seed
+		num_assigned += (iscc_get_tail_ptr(nng, *seed + 1) - iscc_get_tail_ptr(nng, *seed)) + // Number of arcs from seed
 		                    (clustering->cluster_label[*seed] == SCC_CLABEL_NA); // In the case of no seed self-loop
 		clustering->cluster_label[*seed] = clabel; // Assign seed last so seed `assert` work also in case of self-loops
 	}
@@ -962,7 +992,7 @@ static size_t iscc_assign_by_nng(scc_Clustering* const clustering,
 	assert(iscc_digraph_is_valid(nng));
 	assert(!iscc_digraph_is_empty(nng));
 
-	bool* const scratch = malloc(sizeof(bool[clustering->num_data_points]));
+	bool* const scratch = iscc_malloc(sizeof(bool[clustering->num_data_points]));
 	if (scratch == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 	for (size_t i = 0; i < clustering->num_data_points; ++i) {
 		scratch[i] = (clustering->cluster_label[i] == SCC_CLABEL_NA);
@@ -972,8 +1002,8 @@ static size_t iscc_assign_by_nng(scc_Clustering* const clustering,
 	for (size_t i = 0; i < clustering->num_data_points; ++i) {
 		if (scratch[i]) {
 			assert(clustering->cluster_label[i] == SCC_CLABEL_NA);
-			const scc_PointIndex* const v_arc_stop = nng->head + nng->tail_ptr[i + 1];
-			for (const scc_PointIndex* v_arc = nng->head + nng->tail_ptr[i];
+			const scc_PointIndex* const v_arc_stop = iscc_arc_stop(nng, (scc_PointIndex) i);
+			for (const scc_PointIndex* v_arc = iscc_arc_start(nng, (scc_PointIndex) i);
 			        v_arc != v_arc_stop; ++v_arc) {
 				if (!scratch[*v_arc]) {
 					assert(clustering->cluster_label[*v_arc] != SCC_CLABEL_NA);
@@ -985,7 +1015,7 @@ static size_t iscc_assign_by_nng(scc_Clustering* const clustering,
 		}
 	}
 
-	free(scratch);
+	iscc_free(scratch);
 
 	return num_assigned_by_nng;
 }
@@ -1009,7 +1039,7 @@ static scc_ErrorCode iscc_assign_by_nn_search(scc_Clustering* const clustering,
 	if (radius_constraint) {
 		out_ok_query = to_assign;
 	}
-	scc_PointIndex* const out_nn_indices = malloc(sizeof(scc_PointIndex[num_to_assign]));
+	scc_PointIndex* const out_nn_indices = iscc_malloc(sizeof(scc_PointIndex[num_to_assign]));
 
 	if (!iscc_nearest_neighbor_search(nn_search_object,
 	                                  num_to_assign,
@@ -1020,7 +1050,7 @@ static scc_ErrorCode iscc_assign_by_nn_search(scc_Clustering* const clustering,
 	                                  &num_ok_queries,
 	                                  out_ok_query,
 	                                  out_nn_indices)) {
-		free(out_nn_indices);
+		iscc_free(out_nn_indices);
 		return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
 	}
 
@@ -1035,30 +1065,50 @@ static scc_ErrorCode iscc_assign_by_nn_search(scc_Clustering* const clustering,
 		clustering->cluster_label[out_ok_query[i]] = clustering->cluster_label[out_nn_indices[i]];
 	}
 
-	free(out_nn_indices);
+	iscc_free(out_nn_indices);
 
 	return iscc_no_error();
 }
 
 
-#ifdef SCC_STABLE_NNG
-
-static int iscc_compare_PointIndex(const void* const a, const void* const b)
-{
-    const scc_PointIndex arg1 = *(const scc_PointIndex* const)a;
-    const scc_PointIndex arg2 = *(const scc_PointIndex* const)b;
-    return (arg1 > arg2) - (arg1 < arg2);
-}
-
-
 static void iscc_sort_nng(iscc_Digraph* const nng)
 {
+	assert(iscc_digraph_is_valid(nng));
+
+	if (nng->sorted_rows) return;
 	for (size_t v = 0; v < nng->vertices; ++v) {
-		const size_t count = nng->tail_ptr[v + 1] - nng->tail_ptr[v];
+		const size_t count = iscc_get_tail_ptr(nng, (scc_PointIndex) (v + 1)) - iscc_get_tail_ptr(nng, (scc_PointIndex) v);
 		if (count > 1) {
-			qsort(nng->head + nng->tail_ptr[v], count, sizeof(scc_PointIndex), iscc_compare_PointIndex);
+			iscc_sort_point_indices(count, iscc_arc_start(nng, (scc_PointIndex) v));
 		}
 	}
+	nng->sorted_rows = true;
 }
 
-#endif // ifdef SCC_STABLE_NNG
+
+static scc_ErrorCode iscc_spill_nngs(const uint_fast16_t num_nngs,
+                                     const uint_fast16_t max_nngs,
+                                     iscc_Digraph nngs[const static num_nngs],
+                                     iscc_SpilledDigraph** const out_spilled)
+{
+	assert(num_nngs > 0);
+	assert(max_nngs >= num_nngs);
+	assert(out_spilled != NULL);
+	assert(*out_spilled == NULL);
+
+	iscc_SpilledDigraph* const spilled = iscc_malloc(sizeof(iscc_SpilledDigraph[max_nngs]));
+	if (spilled == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+	for (uint_fast16_t i = 0; i < max_nngs; ++i) {
+		spilled[i] = ISCC_NULL_SPILLED_DIGRAPH;
+	}
+
+	// Spilled NNGs are set to the null digraph, so callers can free all NNGs on error
+	*out_spilled = spilled;
+
+	scc_ErrorCode ec;
+	for (uint_fast16_t i = 0; i < num_nngs; ++i) {
+		if ((ec = iscc_spill_digraph(&nngs[i], &spilled[i])) != SCC_ER_OK) return ec;
+	}
+
+	return iscc_no_error();
+}
@@ -29,6 +29,18 @@
 #include "nng_findseeds.h"
 
 
+// =============================================================================
+// Structs
+// =============================================================================
+
+typedef struct iscc_TypeCount {
+	uint32_t sum_type_constraints;
+	size_t* type_group_size;
+	scc_PointIndex* point_store;
+	scc_PointIndex** type_groups;
+} iscc_TypeCount;
+
+
 // =============================================================================
 // Function prototypes
 // =============================================================================
@@ -40,6 +52,7 @@ scc_ErrorCode iscc_get_nng_with_size_constraint(void* data_set,
                                                 const scc_PointIndex primary_data_points[],
                                                 bool radius_constraint,
                                                 double radius,
+                                                bool stable,
                                                 iscc_Digraph* out_nng);
 
 
@@ -53,9 +66,18 @@ scc_ErrorCode iscc_get_nng_with_type_constraint(void* data_set,
                                                 const scc_PointIndex primary_data_points[],
                                                 bool radius_constraint,
                                                 double radius,
+                                                bool stable,
                                                 iscc_Digraph* out_nng);
 
 
+scc_ErrorCode iscc_type_count(size_t num_data_points,
+                              uint32_t size_constraint,
+                              uint_fast16_t num_types,
+                              const uint32_t type_constraints[static num_types],
+                              const scc_TypeLabel type_labels[static num_data_points],
+                              iscc_TypeCount* out_type_result);
+
+
 scc_ErrorCode iscc_estimate_avg_seed_dist(void* data_set,
                                           const iscc_SeedResult* seed_result,
                                           const iscc_Digraph* nng,
@@ -29,10 +29,16 @@
 #include "digraph_operations.h"
 #include "error.h"
 #include "scclust_types.h"
+#include "utilities.h"
+#include "workspace.h"
+
+#ifdef _OPENMP
+	#include <omp.h>
+#endif
 
 
 // =============================================================================
-// Internal structs
+// Internal structs and variables
 // =============================================================================
 
 typedef struct iscc_fs_SortResult {
@@ -40,9 +46,30 @@ typedef struct iscc_fs_SortResult {
 	scc_PointIndex* sorted_vertices;
 	scc_PointIndex** vertex_index;
 	scc_PointIndex** bucket_index;
+	size_t queue_size;
+	scc_PointIndex* queue;
+	scc_PointIndex* queue_pos;
 } iscc_fs_SortResult;
 
 
+#ifdef _OPENMP
+
+/// Smallest NNG for which seed finding uses several threads.
+static const size_t ISCC_FS_PARALLEL_MIN_VERTICES = 10000;
+
+/// Number of undecided vertices each thread processes sequentially in a round.
+static const size_t ISCC_FS_PARALLEL_LEXICAL_CHUNK = 1024;
+
+/// Vertex states used by the parallel lexical search.
+enum {
+	ISCC_FS_UNDECIDED = 0,
+	ISCC_FS_SEED = 1,
+	ISCC_FS_EXCLUDED = 2,
+};
+
+#endif // ifdef _OPENMP
+
+
 // =============================================================================
 // Static function prototypes
 // =============================================================================
@@ -51,20 +78,59 @@ static scc_ErrorCode iscc_findseeds_lexical(const iscc_Digraph* nng,
                                             iscc_SeedResult* out_seeds);
 
 
+#ifdef _OPENMP
+
+static scc_ErrorCode iscc_findseeds_lexical_parallel(const iscc_Digraph* nng,
+                                                     iscc_SeedResult* out_seeds);
+
+
+static inline unsigned char iscc_fs_lexical_decide(scc_PointIndex v,
+                                                   scc_PointIndex chunk_start,
+                                                   const iscc_Digraph* nng,
+                                                   const iscc_Digraph* nng_transpose,
+                                                   const bool marks[static nng->vertices],
+                                                   const bool in_window[static nng->vertices],
+                                                   const unsigned char state[static nng->vertices]);
+
+
+static inline unsigned char iscc_fs_lexical_conflict(scc_PointIndex u,
+                                                     scc_PointIndex v,
+                                                     scc_PointIndex chunk_start,
+                                                     const bool in_window[],
+                                                     const unsigned char state[]);
+
+#endif // ifdef _OPENMP
+
+
 static scc_ErrorCode iscc_findseeds_inwards(const iscc_Digraph* nng,
                                             bool updating,
+                                            bool stable,
                                             iscc_SeedResult* out_seeds);
 
 
 static scc_ErrorCode iscc_findseeds_exclusion(const iscc_Digraph* nng,
                                               bool updating,
+                                              bool stable,
                                               iscc_SeedResult* out_seeds);
 
 
-static scc_ErrorCode iscc_fs_exclusion_graph(const iscc_Digraph* nng,
-                                             size_t len_not_excluded,
-                                             const scc_PointIndex not_excluded[],
-                                             iscc_Digraph* out_dg);
+static size_t iscc_fs_max_exclusion_neighbors(const iscc_Digraph* nng,
+                                              const iscc_Digraph* nng_transpose);
+
+
+static inline size_t iscc_fs_exclusion_neighbors(scc_PointIndex v,
+                                                 const iscc_Digraph* nng,
+                                                 const iscc_Digraph* nng_transpose,
+                                                 scc_PointIndex row_markers[restrict static nng->vertices],
+                                                 scc_PointIndex out_neighbors[restrict]);
+
+
+static inline scc_PointIndex iscc_fs_count_exclusion_neighbors(scc_PointIndex v,
+                                                               const iscc_Digraph* nng,
+                                                               const iscc_Digraph* nng_transpose,
+                                                               const bool not_excluded[restrict static nng->vertices],
+                                                               scc_PointIndex row_markers[restrict static nng->vertices],
+                                                               scc_PointIndex neighbors[restrict]);
 
 
 static inline scc_ErrorCode iscc_fs_add_seed(scc_PointIndex s,
@@ -89,6 +155,24 @@ static scc_ErrorCode iscc_fs_sort_by_inwards(const iscc_Digraph* nng,
                                              iscc_fs_SortResult* out_sort);
 
 
+static scc_ErrorCode iscc_fs_sort_by_count(size_t vertices,
+                                           bool make_indices,
+                                           iscc_fs_SortResult* out_sort);
+
+
+#ifdef _OPENMP
+
+static void iscc_fs_count_inwards_parallel(const iscc_Digraph* nng,
+                                           scc_PointIndex inwards_count[static nng->vertices]);
+
+
+static scc_ErrorCode iscc_fs_sort_by_count_parallel(size_t vertices,
+                                                    bool make_indices,
+                                                    iscc_fs_SortResult* out_sort);
+
+#endif // ifdef _OPENMP
+
+
 static inline void iscc_fs_decrease_v_in_sort(scc_PointIndex v_to_decrease,
                                               scc_PointIndex inwards_count[restrict],
                                               scc_PointIndex* vertex_index[restrict],
@@ -96,23 +180,26 @@ static inline void iscc_fs_decrease_v_in_sort(scc_PointIndex v_to_decrease,
                                               scc_PointIndex* current_pos);
 
 
-#ifdef SCC_STABLE_FINDSEED
+static inline void iscc_fs_decrease_v(scc_PointIndex v_to_decrease,
+                                      iscc_fs_SortResult* sort,
+                                      scc_PointIndex* current_pos);
+
+
+static scc_ErrorCode iscc_fs_make_stable_queue(size_t vertices,
+                                               iscc_fs_SortResult* sort);
 
-static inline void iscc_fs_debug_bucket_sort(const scc_PointIndex* bucket_start,
-                                             scc_PointIndex* pos,
-                                             const scc_PointIndex inwards_count[],
-                                             scc_PointIndex* vertex_index[]);
 
-#endif // ifdef SCC_STABLE_FINDSEED
+static inline void iscc_fs_pop_stable_queue(iscc_fs_SortResult* sort,
+                                            scc_PointIndex* current_pos);
 
 
-#if defined(SCC_STABLE_FINDSEED) && !defined(NDEBUG)
+static inline void iscc_fs_decrease_v_in_queue(scc_PointIndex v_to_decrease,
+                                               iscc_fs_SortResult* sort);
 
-static inline void iscc_fs_debug_check_sort(const scc_PointIndex* current_pos,
-                                            const scc_PointIndex* last_pos,
-                                            const scc_PointIndex inwards_count[]);
 
-#endif // if defined(SCC_STABLE_FINDSEED) && !defined(NDEBUG)
+static inline bool iscc_fs_queue_before(scc_PointIndex v1,
+                                        scc_PointIndex v2,
+                                        const scc_PointIndex inwards_count[]);
 
 
 // =============================================================================
@@ -121,6 +208,7 @@ static inline void iscc_fs_debug_check_sort(const scc_PointIndex* current_pos,
 
 scc_ErrorCode iscc_find_seeds(const iscc_Digraph* const nng,
                               const scc_SeedMethod seed_method,
+                              const bool stable,
                               iscc_SeedResult* const out_seeds)
 {
 	assert(iscc_digraph_is_valid(nng));
@@ -138,19 +226,19 @@ scc_ErrorCode iscc_find_seeds(const iscc_Digraph* const nng,
 			break;
 
 		case SCC_SM_INWARDS_ORDER:
-			ec = iscc_findseeds_inwards(nng, false, out_seeds);
+			ec = iscc_findseeds_inwards(nng, false, stable, out_seeds);
 			break;
 
 		case SCC_SM_INWARDS_UPDATING:
-			ec = iscc_findseeds_inwards(nng, true, out_seeds);
+			ec = iscc_findseeds_inwards(nng, true, stable, out_seeds);
 			break;
 
 		case SCC_SM_EXCLUSION_ORDER:
-			ec = iscc_findseeds_exclusion(nng, false, out_seeds);
+			ec = iscc_findseeds_exclusion(nng, false, stable, out_seeds);
 			break;
 
 		case SCC_SM_EXCLUSION_UPDATING:
-			ec = iscc_findseeds_exclusion(nng, true, out_seeds);
+			ec = iscc_findseeds_exclusion(nng, true, stable, out_seeds);
 			break;
 
 		default:
@@ -162,7 +250,7 @@ scc_ErrorCode iscc_find_seeds(const iscc_Digraph* const nng,
 	if (ec == SCC_ER_OK) {
 		assert(out_seeds->seeds != NULL);
 		if ((out_seeds->count < out_seeds->capacity) && (out_seeds->count > 0)) {
-			scc_PointIndex* const tmp_seed_ptr = realloc(out_seeds->seeds, sizeof(scc_PointIndex[out_seeds->count]));
+			scc_PointIndex* const tmp_seed_ptr = iscc_realloc(out_seeds->seeds, sizeof(scc_PointIndex[out_seeds->count]));
 			if (tmp_seed_ptr != NULL) {
 				out_seeds->seeds = tmp_seed_ptr;
 				out_seeds->capacity = out_seeds->count;
@@ -174,6 +262,62 @@ scc_ErrorCode iscc_find_seeds(const iscc_Digraph* const nng,
 }
 
 
+scc_ErrorCode iscc_exclusion_graph_degrees(const iscc_Digraph* const nng,
+                                           uint64_t* const out_arcs,
+                                           uint64_t* const out_max_degree)
+{
+	assert(iscc_digraph_is_valid(nng));
+	assert(nng->vertices > 0);
+	assert(out_arcs != NULL);
+	assert(out_max_degree != NULL);
+
+	*out_arcs = 0;
+	*out_max_degree = 0;
+	if (iscc_digraph_is_empty(nng)) return iscc_no_error();
+
+	// The exclusion graph is symmetric among vertices with arcs, and vertices
+	// without arcs are never tails. A vertex's inwards degree is thus its
+	// number of neighbors with arcs, which is counted as in `iscc_findseeds_exclusion`
+	// without materializing the graph.
+	scc_ErrorCode ec;
+	iscc_Digraph nng_transpose;
+	if ((ec = iscc_digraph_transpose(nng, &nng_transpose)) != SCC_ER_OK) return ec;
+
+	const size_t max_neighbors = iscc_fs_max_exclusion_neighbors(nng, &nng_transpose);
+	bool* const not_excluded = iscc_malloc(sizeof(bool[nng->vertices]));
+	scc_PointIndex* const row_markers = iscc_malloc(sizeof(scc_PointIndex[nng->vertices]));
+	scc_PointIndex* const neighbors = iscc_malloc(sizeof(scc_PointIndex[max_neighbors]));
+	if ((not_excluded == NULL) || (row_markers == NULL) || (neighbors == NULL)) {
+		iscc_free_digraph(&nng_transpose);
+		iscc_free(not_excluded);
+		iscc_free(row_markers);
+		iscc_free(neighbors);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	assert(nng->vertices <= ISCC_POINTINDEX_MAX);
+	const scc_PointIndex vertices_pi = (scc_PointIndex) nng->vertices; // If `scc_PointIndex` is signed
+	for (scc_PointIndex v = 0; v < vertices_pi; ++v) {
+		not_excluded[v] = (iscc_get_tail_ptr(nng, v) != iscc_get_tail_ptr(nng, v + 1));
+		row_markers[v] = ISCC_POINTINDEX_MAX_PI;
+	}
+
+	for (scc_PointIndex v = 0; v < vertices_pi; ++v) {
+		const uint64_t degree = (uint64_t) iscc_fs_count_exclusion_neighbors(v, nng, &nng_transpose,
+		                                                                    not_excluded, row_markers, neighbors);
+		*out_arcs += degree;
+		if (*out_max_degree < degree) *out_max_degree = degree;
+	}
+
+	iscc_free_digraph(&nng_transpose);
+	iscc_free(not_excluded);
+	iscc_free(row_markers);
+	iscc_free(neighbors);
+
+	return iscc_no_error();
+}
+
+
 // =============================================================================
 // Static function implementations
 // =============================================================================
@@ -189,24 +333,36 @@ static scc_ErrorCode iscc_findseeds_lexical(const iscc_Digraph* const nng,
 	assert(out_seeds->count == 0);
 	assert(out_seeds->seeds == NULL);
 
-	bool* const marks = calloc(nng->vertices, sizeof(bool));
-	out_seeds->seeds = malloc(sizeof(scc_PointIndex[out_seeds->capacity]));
+	scc_ErrorCode ec;
+
+	#ifdef _OPENMP
+		if ((nng->vertices >= ISCC_FS_PARALLEL_MIN_VERTICES) && (omp_get_max_threads() > 1)) {
+			ec = iscc_findseeds_lexical_parallel(nng, out_seeds);
+			if (ec != SCC_ER_NO_MEMORY) return ec;
+			// The parallel search needs the transpose; if it doesn't fit, fall back to the sequential scan
+			iscc_reset_error();
+			out_seeds->count = 0;
+			out_seeds->seeds = NULL;
+		}
+	#endif
+
+	bool* const marks = iscc_calloc(nng->vertices, sizeof(bool));
+	out_seeds->seeds = iscc_malloc(sizeof(scc_PointIndex[out_seeds->capacity]));
 	if ((marks == NULL) || (out_seeds->seeds == NULL)) {
-		free(marks);
-		free(out_seeds->seeds);
+		iscc_free(marks);
+		iscc_free(out_seeds->seeds);
 		return iscc_make_error(SCC_ER_NO_MEMORY);
 	}
 
-	scc_ErrorCode ec;
 	assert(nng->vertices <= ISCC_POINTINDEX_MAX);
 	const scc_PointIndex vertices = (scc_PointIndex) nng->vertices; // If `scc_PointIndex` is signed
 	for (scc_PointIndex v = 0; v < vertices; ++v) {
 		if (iscc_fs_check_neighbors_marks(v, nng, marks)) {
-			assert(nng->tail_ptr[v] != nng->tail_ptr[v + 1]);
+			assert(iscc_get_tail_ptr(nng, v) != iscc_get_tail_ptr(nng, v + 1));
 
 			if ((ec = iscc_fs_add_seed(v, out_seeds)) != SCC_ER_OK) {
-				free(marks);
-				free(out_seeds->seeds);
+				iscc_free(marks);
+				iscc_free(out_seeds->seeds);
 				return ec;
 			}
 
@@ -214,14 +370,192 @@ static scc_ErrorCode iscc_findseeds_lexical(const iscc_Digraph* const nng,
 		}
 	}
 
-	free(marks);
+	iscc_free(marks);
+
+	return iscc_no_error();
+}
+
+
+#ifdef _OPENMP
+
+// Gives the same seeds as the sequential scan: `v` is a seed iff no lower vertex whose
+// closed out-neighborhood intersects `v`'s is a seed. Rounds take a window of the lowest
+// undecided vertices, split into chunks that one thread each scans in order. Conflicts
+// with lower vertices in other chunks are deferred to the next round, so the first chunk
+// is always decided and sorted IDs cost no more than a sequential scan. Conflicts are
+// found with the transpose, and threads only write state of their own chunk.
+static scc_ErrorCode iscc_findseeds_lexical_parallel(const iscc_Digraph* const nng,
+                                                     iscc_SeedResult* const out_seeds)
+{
+	assert(iscc_digraph_is_valid(nng));
+	assert(!iscc_digraph_is_empty(nng));
+	assert(nng->vertices > 1);
+	assert(nng->vertices <= ISCC_POINTINDEX_MAX);
+	assert(out_seeds != NULL);
+	assert(out_seeds->capacity > 0);
+	assert(out_seeds->count == 0);
+	assert(out_seeds->seeds == NULL);
+
+	scc_ErrorCode ec;
+	iscc_Digraph nng_transpose;
+	if ((ec = iscc_digraph_transpose(nng, &nng_transpose)) != SCC_ER_OK) return ec;
+
+	const size_t vertices = nng->vertices;
+	bool* const marks = iscc_calloc(vertices, sizeof(bool));
+	bool* const in_window = iscc_calloc(vertices, sizeof(bool));
+	unsigned char* const state = iscc_malloc(sizeof(unsigned char[vertices]));
+	scc_PointIndex* const queue = iscc_malloc(sizeof(scc_PointIndex[vertices]));
+	out_seeds->seeds = iscc_malloc(sizeof(scc_PointIndex[out_seeds->capacity]));
+	if ((marks == NULL) || (in_window == NULL) || (state == NULL) || (queue == NULL) || (out_seeds->seeds == NULL)) {
+		iscc_free_digraph(&nng_transpose);
+		iscc_free(marks);
+		iscc_free(in_window);
+		iscc_free(state);
+		iscc_free(queue);
+		iscc_free(out_seeds->seeds);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	// Vertices without arcs can never be seeds
+	size_t queue_end = 0;
+	const scc_PointIndex vertices_pi = (scc_PointIndex) vertices; // If `scc_PointIndex` is signed
+	for (scc_PointIndex v = 0; v < vertices_pi; ++v) {
+		if (iscc_arc_start(nng, v) == iscc_arc_stop(nng, v)) {
+			state[v] = ISCC_FS_EXCLUDED;
+		} else {
+			state[v] = ISCC_FS_UNDECIDED;
+			queue[queue_end] = v;
+			++queue_end;
+		}
+	}
+
+	const size_t chunk_len = ISCC_FS_PARALLEL_LEXICAL_CHUNK;
+	const size_t window_len = 4 * chunk_len * ((size_t) omp_get_max_threads());
+	size_t queue_start = 0;
+	while (queue_start < queue_end) {
+		const size_t window_end = (queue_end - queue_start > window_len) ? queue_start + window_len : queue_end;
+		const size_t num_chunks = (window_end - queue_start + chunk_len - 1) / chunk_len;
+
+		for (size_t i = queue_start; i < window_end; ++i) {
+			in_window[queue[i]] = true;
+		}
+
+		#pragma omp parallel
+		{
+			#pragma omp for schedule(dynamic, 1)
+			for (size_t c = 0; c < num_chunks; ++c) {
+				const size_t c_start = queue_start + c * chunk_len;
+				const size_t c_stop = (c_start + chunk_len < window_end) ? c_start + chunk_len : window_end;
+				const scc_PointIndex chunk_start = queue[c_start];
+				for (size_t i = c_start; i < c_stop; ++i) {
+					state[queue[i]] = iscc_fs_lexical_decide(queue[i], chunk_start, nng, &nng_transpose, marks, in_window, state);
+				}
+			}
+
+			// Closed out-neighborhoods of new seeds are disjoint, so no two threads write the same mark
+			#pragma omp for schedule(static)
+			for (size_t i = queue_start; i < window_end; ++i) {
+				if (state[queue[i]] == ISCC_FS_SEED) {
+					iscc_fs_mark_seed_neighbors(queue[i], nng, marks);
+				}
+			}
+		}
+
+		// Keep undecided vertices in order, adjacent to the rest of the queue
+		size_t write_pos = window_end;
+		for (size_t i = window_end; i > queue_start; --i) {
+			in_window[queue[i - 1]] = false;
+			if (state[queue[i - 1]] == ISCC_FS_UNDECIDED) {
+				--write_pos;
+				queue[write_pos] = queue[i - 1];
+			}
+		}
+		assert(write_pos > queue_start); // The first chunk is always decided
+		queue_start = write_pos;
+	}
+
+	iscc_free_digraph(&nng_transpose);
+	iscc_free(marks);
+	iscc_free(in_window);
+	iscc_free(queue);
+
+	for (scc_PointIndex v = 0; v < vertices_pi; ++v) {
+		if (state[v] == ISCC_FS_SEED) {
+			if ((ec = iscc_fs_add_seed(v, out_seeds)) != SCC_ER_OK) {
+				iscc_free(state);
+				iscc_free(out_seeds->seeds);
+				out_seeds->seeds = NULL;
+				out_seeds->count = 0;
+				return ec;
+			}
+		}
+	}
+
+	iscc_free(state);
 
 	return iscc_no_error();
 }
 
 
+static inline unsigned char iscc_fs_lexical_decide(const scc_PointIndex v,
+                                                   const scc_PointIndex chunk_start,
+                                                   const iscc_Digraph* const nng,
+                                                   const iscc_Digraph* const nng_transpose,
+                                                   const bool marks[const static nng->vertices],
+                                                   const bool in_window[const static nng->vertices],
+                                                   const unsigned char state[const static nng->vertices])
+{
+	if (!iscc_fs_check_neighbors_marks(v, nng, marks)) return ISCC_FS_EXCLUDED;
+
+	// Lower vertices whose closed out-neighborhoods intersect `v`'s: `v`'s out-neighbors,
+	// and vertices pointing to `v` or to any of its out-neighbors.
+	bool decided = true;
+	unsigned char u_state;
+	const scc_PointIndex* const v_arc_stop = iscc_arc_stop(nng, v);
+	for (const scc_PointIndex* v_arc = iscc_arc_start(nng, v); v_arc != v_arc_stop; ++v_arc) {
+		u_state = iscc_fs_lexical_conflict(*v_arc, v, chunk_start, in_window, state);
+		if (u_state == ISCC_FS_SEED) return ISCC_FS_EXCLUDED;
+		decided = decided && (u_state != ISCC_FS_UNDECIDED);
+
+		const scc_PointIndex* const t_arc_stop = iscc_arc_stop(nng_transpose, *v_arc);
+		for (const scc_PointIndex* t_arc = iscc_arc_start(nng_transpose, *v_arc); t_arc != t_arc_stop; ++t_arc) {
+			u_state = iscc_fs_lexical_conflict(*t_arc, v, chunk_start, in_window, state);
+			if (u_state == ISCC_FS_SEED) return ISCC_FS_EXCLUDED;
+			decided = decided && (u_state != ISCC_FS_UNDECIDED);
+		}
+	}
+
+	const scc_PointIndex* const t_arc_stop = iscc_arc_stop(nng_transpose, v);
+	for (const scc_PointIndex* t_arc = iscc_arc_start(nng_transpose, v); t_arc != t_arc_stop; ++t_arc) {
+		u_state = iscc_fs_lexical_conflict(*t_arc, v, chunk_start, in_window, state);
+		if (u_state == ISCC_FS_SEED) return ISCC_FS_EXCLUDED;
+		decided = decided && (u_state != ISCC_FS_UNDECIDED);
+	}
+
+	return decided ? ISCC_FS_SEED : ISCC_FS_UNDECIDED;
+}
+
+
+static inline unsigned char iscc_fs_lexical_conflict(const scc_PointIndex u,
+                                                     const scc_PointIndex v,
+                                                     const scc_PointIndex chunk_start,
+                                                     const bool in_window[const],
+                                                     const unsigned char state[const])
+{
+	// Higher vertices never block `v`
+	if (u >= v) return ISCC_FS_EXCLUDED;
+	// Lower vertices in `v`'s chunk have already been decided by this thread
+	if (u >= chunk_start) return state[u];
+	// Other chunks are decided concurrently; treat them as undecided until next round
+	return in_window[u] ? ISCC_FS_UNDECIDED : ISCC_FS_EXCLUDED;
+}
+
+#endif // ifdef _OPENMP
+
+
 static scc_ErrorCode iscc_findseeds_inwards(const iscc_Digraph* const nng,
                                             const bool updating,
+                                            const bool stable,
                                             iscc_SeedResult* const out_seeds)
 {
 	assert(iscc_digraph_is_valid(nng));
@@ -235,13 +569,16 @@ static scc_ErrorCode iscc_findseeds_inwards(const iscc_Digraph* const nng,
 	scc_ErrorCode ec;
 	iscc_fs_SortResult sort;
 	if ((ec = iscc_fs_sort_by_inwards(nng, updating, &sort)) != SCC_ER_OK) return ec;
+	if (updating && stable) {
+		if ((ec = iscc_fs_make_stable_queue(nng->vertices, &sort)) != SCC_ER_OK) return ec;
+	}
 
-	bool* const marks = calloc(nng->vertices, sizeof(bool));
-	out_seeds->seeds = malloc(sizeof(scc_PointIndex[out_seeds->capacity]));
+	bool* const marks = iscc_calloc(nng->vertices, sizeof(bool));
+	out_seeds->seeds = iscc_malloc(sizeof(scc_PointIndex[out_seeds->capacity]));
 	if ((marks == NULL) || (out_seeds->seeds == NULL)) {
 		iscc_fs_free_sort_result(&sort);
-		free(marks);
-		free(out_seeds->seeds);
+		iscc_free(marks);
+		iscc_free(out_seeds->seeds);
 		return iscc_make_error(SCC_ER_NO_MEMORY);
 	}
 
@@ -249,52 +586,50 @@ static scc_ErrorCode iscc_findseeds_inwards(const iscc_Digraph* const nng,
 	for (scc_PointIndex* sorted_v = sort.sorted_vertices;
 	        sorted_v != sorted_v_stop; ++sorted_v) {
 
-		#if defined(SCC_STABLE_FINDSEED) && !defined(NDEBUG)
-			if (updating) iscc_fs_debug_check_sort(sorted_v, sorted_v_stop - 1, sort.inwards_count);
-		#endif
+		if (sort.queue != NULL) iscc_fs_pop_stable_queue(&sort, sorted_v);
 
 		if (iscc_fs_check_neighbors_marks(*sorted_v, nng, marks)) {
-			assert(nng->tail_ptr[*sorted_v] != nng->tail_ptr[*sorted_v + 1]);
+			assert(iscc_get_tail_ptr(nng, *sorted_v) != iscc_get_tail_ptr(nng, *sorted_v + 1));
 
 			if ((ec = iscc_fs_add_seed(*sorted_v, out_seeds)) != SCC_ER_OK) {
 				iscc_fs_free_sort_result(&sort);
-				free(marks);
-				free(out_seeds->seeds);
+				iscc_free(marks);
+				iscc_free(out_seeds->seeds);
 				return ec;
 			}
 
 			iscc_fs_mark_seed_neighbors(*sorted_v, nng, marks);
 
 			if (updating) {
-				const scc_PointIndex* const v_arc_stop = nng->head + nng->tail_ptr[*sorted_v + 1];
-				for (const scc_PointIndex* v_arc = nng->head + nng->tail_ptr[*sorted_v];
+				const scc_PointIndex* const v_arc_stop = iscc_arc_stop(nng, *sorted_v);
+				for (const scc_PointIndex* v_arc = iscc_arc_start(nng, *sorted_v);
 				        v_arc != v_arc_stop; ++v_arc) {
 					if (sorted_v < sort.vertex_index[*v_arc]) {
-						const scc_PointIndex* const v_arc_arc_stop = nng->head + nng->tail_ptr[*v_arc + 1];
-						for (scc_PointIndex* v_arc_arc = nng->head + nng->tail_ptr[*v_arc];
+						const scc_PointIndex* const v_arc_arc_stop = iscc_arc_stop(nng, *v_arc);
+						for (scc_PointIndex* v_arc_arc = iscc_arc_start(nng, *v_arc);
 						        v_arc_arc != v_arc_arc_stop; ++v_arc_arc) {
 							// Only decrease if vertex can be seed (i.e., not already assigned, not already considered and has arcs in nng)
-							if (!marks[*v_arc_arc] && (sorted_v < sort.vertex_index[*v_arc_arc]) && (nng->tail_ptr[*v_arc_arc] != nng->tail_ptr[*v_arc_arc + 1])) {
-								iscc_fs_decrease_v_in_sort(*v_arc_arc, sort.inwards_count, sort.vertex_index, sort.bucket_index, sorted_v);
+							if (!marks[*v_arc_arc] && (sorted_v < sort.vertex_index[*v_arc_arc]) && (iscc_get_tail_ptr(nng, *v_arc_arc) != iscc_get_tail_ptr(nng, *v_arc_arc + 1))) {
+								iscc_fs_decrease_v(*v_arc_arc, &sort, sorted_v);
 							}
 						}
 					}
 				}
 			}
 		} else if (updating && !marks[*sorted_v]) {
-			const scc_PointIndex* const v_arc_stop = nng->head + nng->tail_ptr[*sorted_v + 1];
-			for (const scc_PointIndex* v_arc = nng->head + nng->tail_ptr[*sorted_v];
+			const scc_PointIndex* const v_arc_stop = iscc_arc_stop(nng, *sorted_v);
+			for (const scc_PointIndex* v_arc = iscc_arc_start(nng, *sorted_v);
 			        v_arc != v_arc_stop; ++v_arc) {
 				// Only decrease if vertex can be seed (i.e., not already assigned, not already considered and has arcs in nng)
-				if (!marks[*v_arc] && (sorted_v < sort.vertex_index[*v_arc]) && (nng->tail_ptr[*v_arc] != nng->tail_ptr[*v_arc + 1])) {
-					iscc_fs_decrease_v_in_sort(*v_arc, sort.inwards_count, sort.vertex_index, sort.bucket_index, sorted_v);
+				if (!marks[*v_arc] && (sorted_v < sort.vertex_index[*v_arc]) && (iscc_get_tail_ptr(nng, *v_arc) != iscc_get_tail_ptr(nng, *v_arc + 1))) {
+					iscc_fs_decrease_v(*v_arc, &sort, sorted_v);
 				}
 			}
 		}
 	}
 
 	iscc_fs_free_sort_result(&sort);
-	free(marks);
+	iscc_free(marks);
 
 	return iscc_no_error();
 }
@@ -302,6 +637,7 @@ static scc_ErrorCode iscc_findseeds_inwards(const iscc_Digraph* const nng,
 
 static scc_ErrorCode iscc_findseeds_exclusion(const iscc_Digraph* const nng,
                                               const bool updating,
+                                              const bool stable,
                                               iscc_SeedResult* const out_seeds)
 {
 	assert(iscc_digraph_is_valid(nng));
@@ -312,57 +648,75 @@ static scc_ErrorCode iscc_findseeds_exclusion(const iscc_Digraph* const nng,
 	assert(out_seeds->count == 0);
 	assert(out_seeds->seeds == NULL);
 
-	bool* const not_excluded = malloc(sizeof(bool[nng->vertices]));
-	if (not_excluded == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
-
-	// FIX THIS
-	size_t tmp_num_not_excluded = 0;
-	scc_PointIndex* tmp_index_not_excluded = malloc(sizeof(scc_PointIndex[nng->vertices]));
-	if (tmp_index_not_excluded == NULL) {
-		free(not_excluded);
-		iscc_make_error(SCC_ER_NO_MEMORY);
+	// The exclusion graph is never materialized. Neighbors are enumerated
+	// on demand from the NNG and its transpose; see `iscc_fs_exclusion_neighbors`.
+	scc_ErrorCode ec;
+	iscc_Digraph nng_transpose;
+	if ((ec = iscc_digraph_transpose(nng, &nng_transpose)) != SCC_ER_OK) return ec;
+
+	// With the updating method, the second half stores neighbors of the excluded vertices
+	const size_t max_neighbors = iscc_fs_max_exclusion_neighbors(nng, &nng_transpose);
+	const size_t neighbors_len = updating ? 2 * max_neighbors : max_neighbors;
+
+	bool* const not_excluded = iscc_malloc(sizeof(bool[nng->vertices]));
+	scc_PointIndex* const row_markers = iscc_malloc(sizeof(scc_PointIndex[nng->vertices]));
+	scc_PointIndex* const neighbors = iscc_malloc(sizeof(scc_PointIndex[neighbors_len]));
+	iscc_fs_SortResult sort = {
+		.inwards_count = iscc_malloc(sizeof(scc_PointIndex[nng->vertices])),
+		.sorted_vertices = NULL,
+		.vertex_index = NULL,
+		.bucket_index = NULL,
+		.queue_size = 0,
+		.queue = NULL,
+		.queue_pos = NULL,
+	};
+	if ((not_excluded == NULL) || (row_markers == NULL) || (neighbors == NULL) || (sort.inwards_count == NULL)) {
+		iscc_free_digraph(&nng_transpose);
+		iscc_free(not_excluded);
+		iscc_free(row_markers);
+		iscc_free(neighbors);
+		iscc_free(sort.inwards_count);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
 	}
+
 	assert(nng->vertices <= ISCC_POINTINDEX_MAX);
 	const scc_PointIndex vertices_pi = (scc_PointIndex) nng->vertices; // If `scc_PointIndex` is signed
 	for (scc_PointIndex v = 0; v < vertices_pi; ++v) {
-		not_excluded[v] = (nng->tail_ptr[v] != nng->tail_ptr[v + 1]);
-		tmp_index_not_excluded[tmp_num_not_excluded] = v;
-		tmp_num_not_excluded += not_excluded[v];
-	}
-	if (tmp_num_not_excluded == nng->vertices) {
-		tmp_num_not_excluded = 0;
-		free(tmp_index_not_excluded);
-		tmp_index_not_excluded = NULL;
+		not_excluded[v] = (iscc_get_tail_ptr(nng, v) != iscc_get_tail_ptr(nng, v + 1));
+		row_markers[v] = ISCC_POINTINDEX_MAX_PI;
 	}
-	// UNTIL HERE
 
-	//for (size_t v = 0; v < nng->vertices; ++v) {
-	//	not_excluded[v] = (nng->tail_ptr[v] != nng->tail_ptr[v + 1]);
-	//}
-
-	scc_ErrorCode ec;
-	iscc_Digraph exclusion_graph;
-	if ((ec = iscc_fs_exclusion_graph(nng, tmp_num_not_excluded, tmp_index_not_excluded, &exclusion_graph)) != SCC_ER_OK) {
-		free(not_excluded);
-		return ec;
+	// Vertices with zero outwards arcs in `nng` are excluded from the beginning, and
+	// their arcs in the exclusion graph must not be counted. As the exclusion graph is
+	// symmetric among the other vertices, and vertices without arcs only have inwards
+	// arcs, the inwards count is the number of non-excluded neighbors.
+	for (scc_PointIndex v = 0; v < vertices_pi; ++v) {
+		sort.inwards_count[v] = iscc_fs_count_exclusion_neighbors(v, nng, &nng_transpose,
+		                                                          not_excluded, row_markers, neighbors);
 	}
 
-	// FIX THIS
-	free(tmp_index_not_excluded);
-	tmp_index_not_excluded = NULL;
-	// UNTIL HERE
+	// Each vertex is enumerated at most once below (as seed or when excluded), so resetting the markers once suffices
+	for (scc_PointIndex v = 0; v < vertices_pi; ++v) {
+		row_markers[v] = ISCC_POINTINDEX_MAX_PI;
+	}
 
-	iscc_fs_SortResult sort;
-	if ((ec = iscc_fs_sort_by_inwards(&exclusion_graph, updating, &sort)) != SCC_ER_OK) {
-		free(not_excluded);
-		iscc_free_digraph(&exclusion_graph);
+	if ((ec = iscc_fs_sort_by_count(nng->vertices, updating, &sort)) == SCC_ER_OK) {
+		if (updating && stable) ec = iscc_fs_make_stable_queue(nng->vertices, &sort);
+	}
+	if (ec != SCC_ER_OK) {
+		iscc_free_digraph(&nng_transpose);
+		iscc_free(not_excluded);
+		iscc_free(row_markers);
+		iscc_free(neighbors);
 		return ec;
 	}
 
-	out_seeds->seeds = malloc(sizeof(scc_PointIndex[out_seeds->capacity]));
+	out_seeds->seeds = iscc_malloc(sizeof(scc_PointIndex[out_seeds->capacity]));
 	if (out_seeds->seeds == NULL) {
-		free(not_excluded);
-		iscc_free_digraph(&exclusion_graph);
+		iscc_free_digraph(&nng_transpose);
+		iscc_free(not_excluded);
+		iscc_free(row_markers);
+		iscc_free(neighbors);
 		iscc_fs_free_sort_result(&sort);
 		return iscc_make_error(SCC_ER_NO_MEMORY);
 	}
@@ -371,28 +725,28 @@ static scc_ErrorCode iscc_findseeds_exclusion(const iscc_Digraph* const nng,
 	for (scc_PointIndex* sorted_v = sort.sorted_vertices;
 	        sorted_v != sorted_v_stop; ++sorted_v) {
 
-		#if defined(SCC_STABLE_FINDSEED) && !defined(NDEBUG)
-			if (updating) iscc_fs_debug_check_sort(sorted_v, sorted_v_stop - 1, sort.inwards_count);
-		#endif
+		if (sort.queue != NULL) iscc_fs_pop_stable_queue(&sort, sorted_v);
 
 		if (not_excluded[*sorted_v]) {
-			assert(nng->tail_ptr[*sorted_v] != nng->tail_ptr[*sorted_v + 1]);
+			assert(iscc_get_tail_ptr(nng, *sorted_v) != iscc_get_tail_ptr(nng, *sorted_v + 1));
 
 			if ((ec = iscc_fs_add_seed(*sorted_v, out_seeds)) != SCC_ER_OK) {
-				free(not_excluded);
-				iscc_free_digraph(&exclusion_graph);
+				iscc_free_digraph(&nng_transpose);
+				iscc_free(not_excluded);
+				iscc_free(row_markers);
+				iscc_free(neighbors);
 				iscc_fs_free_sort_result(&sort);
-				free(out_seeds->seeds);
+				iscc_free(out_seeds->seeds);
 				return ec;
 			}
 
 			not_excluded[*sorted_v] = false;
 
+			const size_t num_neighbors = iscc_fs_exclusion_neighbors(*sorted_v, nng, &nng_transpose, row_markers, neighbors);
+
 			if (!updating) {
-				const scc_PointIndex* const ex_arc_stop = exclusion_graph.head + exclusion_graph.tail_ptr[*sorted_v + 1];
-				const scc_PointIndex* ex_arc = exclusion_graph.head + exclusion_graph.tail_ptr[*sorted_v];
-				for (; ex_arc != ex_arc_stop; ++ex_arc) {
-					not_excluded[*ex_arc] = false;
+				for (size_t i = 0; i < num_neighbors; ++i) {
+					not_excluded[neighbors[i]] = false;
 				}
 
 			} else {
@@ -400,28 +754,22 @@ static scc_ErrorCode iscc_findseeds_exclusion(const iscc_Digraph* const nng,
 				// Since most of the seed's neighbors' neighbors will be neighbors themselves (and thus excluded) we don't want to
 				// waste computations on decreasing their count since they will fall out of the queue anyways. Therefore, we want
 				// to make two passes over the neighbors: one to exclude all neighbors that is not already excluded (and record them),
-				// and another to decrease the count on non-excluded neighbors' neighbors. As we never will return to the seed's edges,
-				// we use that as a scratch area.
-				scc_PointIndex* const ex_arc_start = exclusion_graph.head + exclusion_graph.tail_ptr[*sorted_v];
-				const scc_PointIndex* const ex_arc_stop = exclusion_graph.head + exclusion_graph.tail_ptr[*sorted_v + 1];
-				const scc_PointIndex* ex_arc = ex_arc_start;
-				scc_PointIndex* write_arc = ex_arc_start;
-
-				for (; ex_arc != ex_arc_stop; ++ex_arc) {
-					if (not_excluded[*ex_arc]) {
-						*write_arc = *ex_arc;
-						++write_arc;
+				// and another to decrease the count on non-excluded neighbors' neighbors.
+				size_t num_excluded = 0;
+				for (size_t i = 0; i < num_neighbors; ++i) {
+					if (not_excluded[neighbors[i]]) {
+						neighbors[num_excluded] = neighbors[i];
+						++num_excluded;
 					}
-					not_excluded[*ex_arc] = false;
+					not_excluded[neighbors[i]] = false;
 				}
 
-				ex_arc = ex_arc_start;
-				for (; ex_arc != write_arc; ++ex_arc) {
-					const scc_PointIndex* const ex_arc_arc_stop = exclusion_graph.head + exclusion_graph.tail_ptr[*ex_arc + 1];
-					for (scc_PointIndex* ex_arc_arc = exclusion_graph.head + exclusion_graph.tail_ptr[*ex_arc];
-					        ex_arc_arc != ex_arc_arc_stop; ++ex_arc_arc) {
-						if (not_excluded[*ex_arc_arc]) {
-							iscc_fs_decrease_v_in_sort(*ex_arc_arc, sort.inwards_count, sort.vertex_index, sort.bucket_index, sorted_v);
+				scc_PointIndex* const ex_neighbors = neighbors + max_neighbors;
+				for (size_t i = 0; i < num_excluded; ++i) {
+					const size_t num_ex_neighbors = iscc_fs_exclusion_neighbors(neighbors[i], nng, &nng_transpose, row_markers, ex_neighbors);
+					for (size_t j = 0; j < num_ex_neighbors; ++j) {
+						if (not_excluded[ex_neighbors[j]]) {
+							iscc_fs_decrease_v(ex_neighbors[j], &sort, sorted_v);
 						}
 					}
 				}
@@ -429,8 +777,10 @@ static scc_ErrorCode iscc_findseeds_exclusion(const iscc_Digraph* const nng,
 		}
 	}
 
-	free(not_excluded);
-	iscc_free_digraph(&exclusion_graph);
+	iscc_free_digraph(&nng_transpose);
+	iscc_free(not_excluded);
+	iscc_free(row_markers);
+	iscc_free(neighbors);
 	iscc_fs_free_sort_result(&sort);
 
 	return iscc_no_error();
@@ -454,40 +804,95 @@ bool iscc_findseeds_onearc_updating(const scc_Digraph* const nng, ...) {
 */
 
 
-static scc_ErrorCode iscc_fs_exclusion_graph(const iscc_Digraph* const nng,
-                                             const size_t len_not_excluded,
-                                             const scc_PointIndex not_excluded[const],
-                                             iscc_Digraph* const out_dg)
+static size_t iscc_fs_max_exclusion_neighbors(const iscc_Digraph* const nng,
+                                              const iscc_Digraph* const nng_transpose)
 {
 	assert(iscc_digraph_is_valid(nng));
-	assert(!iscc_digraph_is_empty(nng));
-	assert(out_dg != NULL);
+	assert(iscc_digraph_is_valid(nng_transpose));
+	assert(nng->vertices == nng_transpose->vertices);
 
-	scc_ErrorCode ec;
+	size_t max_neighbors = 1;
+	assert(nng->vertices <= ISCC_POINTINDEX_MAX);
+	const scc_PointIndex vertices = (scc_PointIndex) nng->vertices; // If `scc_PointIndex` is signed
+	for (scc_PointIndex v = 0; v < vertices; ++v) {
+		size_t bound = (size_t) (iscc_arc_stop(nng, v) - iscc_arc_start(nng, v)) +
+		               (size_t) (iscc_arc_stop(nng_transpose, v) - iscc_arc_start(nng_transpose, v));
+		const scc_PointIndex* const v_arc_stop = iscc_arc_stop(nng, v);
+		for (const scc_PointIndex* v_arc = iscc_arc_start(nng, v); v_arc != v_arc_stop; ++v_arc) {
+			bound += (size_t) (iscc_arc_stop(nng_transpose, *v_arc) - iscc_arc_start(nng_transpose, *v_arc));
+		}
+		if (max_neighbors < bound) max_neighbors = bound;
+	}
 
-	iscc_Digraph nng_transpose;
-	ec = iscc_digraph_transpose(nng, &nng_transpose);
-	if (ec != SCC_ER_OK) return ec;
-	assert(!iscc_digraph_is_empty(&nng_transpose));
+	// Neighbors are distinct
+	if (max_neighbors > nng->vertices) max_neighbors = nng->vertices;
 
-	iscc_Digraph nng_nng_transpose;
-	ec = iscc_adjacency_product(nng, &nng_transpose, true, &nng_nng_transpose);
-	iscc_free_digraph(&nng_transpose);
-	if (ec != SCC_ER_OK) return ec;
-
-	/* In `out_dg`, all vertices with zero outwards arcs in `nng` will have
-	 * arcs pointing to vertices that points to them in `nng`. These vertices are
-	 * excluded from the the beginning (due to zero arcs), thus their outwards arcs
-	 * are not necessary. In fact, to keep these arcs leads to that the sorting on
-	 * inwards arcs by `iscc_fs_sort_by_inwards()` becomes wrong. Remove
-	 * by calling `iscc_digraph_union_and_delete` with `not_excluded`.
-	 */
-	const iscc_Digraph nng_sum[2] = { *nng, nng_nng_transpose };
-	ec = iscc_digraph_union_and_delete(2, nng_sum, len_not_excluded, not_excluded, false, out_dg);
-	iscc_free_digraph(&nng_nng_transpose);
-	if (ec != SCC_ER_OK) return ec;
+	return max_neighbors;
+}
 
-	return iscc_no_error();
+
+// The exclusion graph has an arc between two vertices when their closed out-neighborhoods
+// in the NNG intersect, i.e., when they cannot both be seeds. The neighbors of `v` are
+// written in the same order as the rows of NNG ∪ NNG·NNG^T would have: `v`'s out-neighbors,
+// then vertices pointing to `v`, and then vertices pointing to each out-neighbor. Duplicates
+// and `v` itself are skipped using `row_markers`, which must not contain `v` on entry.
+static inline size_t iscc_fs_exclusion_neighbors(const scc_PointIndex v,
+                                                 const iscc_Digraph* const nng,
+                                                 const iscc_Digraph* const nng_transpose,
+                                                 scc_PointIndex row_markers[restrict const static nng->vertices],
+                                                 scc_PointIndex out_neighbors[restrict const])
+{
+	assert(row_markers[v] != v);
+
+	size_t num_neighbors = 0;
+	row_markers[v] = v;
+
+	const scc_PointIndex* const v_arc_stop = iscc_arc_stop(nng, v);
+	for (const scc_PointIndex* v_arc = iscc_arc_start(nng, v); v_arc != v_arc_stop; ++v_arc) {
+		if (row_markers[*v_arc] != v) {
+			row_markers[*v_arc] = v;
+			out_neighbors[num_neighbors] = *v_arc;
+			++num_neighbors;
+		}
+	}
+
+	const scc_PointIndex* const t_arc_stop = iscc_arc_stop(nng_transpose, v);
+	for (const scc_PointIndex* t_arc = iscc_arc_start(nng_transpose, v); t_arc != t_arc_stop; ++t_arc) {
+		if (row_markers[*t_arc] != v) {
+			row_markers[*t_arc] = v;
+			out_neighbors[num_neighbors] = *t_arc;
+			++num_neighbors;
+		}
+	}
+
+	for (const scc_PointIndex* v_arc = iscc_arc_start(nng, v); v_arc != v_arc_stop; ++v_arc) {
+		const scc_PointIndex* const tt_arc_stop = iscc_arc_stop(nng_transpose, *v_arc);
+		for (const scc_PointIndex* tt_arc = iscc_arc_start(nng_transpose, *v_arc); tt_arc != tt_arc_stop; ++tt_arc) {
+			if (row_markers[*tt_arc] != v) {
+				row_markers[*tt_arc] = v;
+				out_neighbors[num_neighbors] = *tt_arc;
+				++num_neighbors;
+			}
+		}
+	}
+
+	return num_neighbors;
+}
+
+
+static inline scc_PointIndex iscc_fs_count_exclusion_neighbors(const scc_PointIndex v,
+                                                               const iscc_Digraph* const nng,
+                                                               const iscc_Digraph* const nng_transpose,
+                                                               const bool not_excluded[restrict const static nng->vertices],
+                                                               scc_PointIndex row_markers[restrict const static nng->vertices],
+                                                               scc_PointIndex neighbors[restrict const])
+{
+	const size_t num_neighbors = iscc_fs_exclusion_neighbors(v, nng, nng_transpose, row_markers, neighbors);
+	scc_PointIndex count = 0;
+	for (size_t i = 0; i < num_neighbors; ++i) {
+		count += not_excluded[neighbors[i]];
+	}
+	return count;
 }
 
 
@@ -506,7 +911,7 @@ static inline scc_ErrorCode iscc_fs_add_seed(const scc_PointIndex s,
 	if (seed_result->count == seed_result->capacity) {
 		seed_result->capacity = seed_result->capacity + (seed_result->capacity >> 3) + 1024;
 		if (seed_result->capacity > ((uintmax_t) SCC_CLABEL_MAX)) seed_result->capacity = ((size_t) SCC_CLABEL_MAX);
-		scc_PointIndex* const seeds_tmp_ptr = realloc(seed_result->seeds, sizeof(scc_PointIndex[seed_result->capacity]));
+		scc_PointIndex* const seeds_tmp_ptr = iscc_realloc(seed_result->seeds, sizeof(scc_PointIndex[seed_result->capacity]));
 		if (seeds_tmp_ptr == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 		seed_result->seeds = seeds_tmp_ptr;
 	}
@@ -524,8 +929,8 @@ static inline bool iscc_fs_check_neighbors_marks(const scc_PointIndex v,
 {
 	if (marks[v]) return false;
 
-	const scc_PointIndex* v_arc = nng->head + nng->tail_ptr[v];
-	const scc_PointIndex* const v_arc_stop = nng->head + nng->tail_ptr[v + 1];
+	const scc_PointIndex* v_arc = iscc_arc_start(nng, v);
+	const scc_PointIndex* const v_arc_stop = iscc_arc_stop(nng, v);
 	if (v_arc == v_arc_stop) return false;
 
 	for (; v_arc != v_arc_stop; ++v_arc) {
@@ -542,8 +947,8 @@ static inline void iscc_fs_mark_seed_neighbors(const scc_PointIndex s,
 {
 	assert(!marks[s]);
 
-	const scc_PointIndex* const s_arc_stop = nng->head + nng->tail_ptr[s + 1];
-	for (const scc_PointIndex* s_arc = nng->head + nng->tail_ptr[s];
+	const scc_PointIndex* const s_arc_stop = iscc_arc_stop(nng, s);
+	for (const scc_PointIndex* s_arc = iscc_arc_start(nng, s);
 	        s_arc != s_arc_stop; ++s_arc) {
 		assert(!marks[*s_arc]);
 		marks[*s_arc] = true;
@@ -556,10 +961,12 @@ static inline void iscc_fs_mark_seed_neighbors(const scc_PointIndex s,
 static void iscc_fs_free_sort_result(iscc_fs_SortResult* const sr)
 {
 	if (sr != NULL) {
-		free(sr->inwards_count);
-		free(sr->sorted_vertices);
-		free(sr->vertex_index);
-		free(sr->bucket_index);
+		iscc_free(sr->inwards_count);
+		iscc_free(sr->sorted_vertices);
+		iscc_free(sr->vertex_index);
+		iscc_free(sr->bucket_index);
+		iscc_free(sr->queue);
+		iscc_free(sr->queue_pos);
 	}
 }
 
@@ -576,22 +983,58 @@ static scc_ErrorCode iscc_fs_sort_by_inwards(const iscc_Digraph* const nng,
 	const size_t vertices = nng->vertices;
 
 	*out_sort = (iscc_fs_SortResult) {
-		.inwards_count = calloc(vertices, sizeof(scc_PointIndex)),
-		.sorted_vertices = malloc(sizeof(scc_PointIndex[vertices])),
+		.inwards_count = iscc_calloc(vertices, sizeof(scc_PointIndex)),
+		.sorted_vertices = NULL,
 		.vertex_index = NULL,
 		.bucket_index = NULL,
+		.queue_size = 0,
+		.queue = NULL,
+		.queue_pos = NULL,
 	};
 
-	if ((out_sort->inwards_count == NULL) || (out_sort->sorted_vertices == NULL)) {
-		iscc_fs_free_sort_result(out_sort);
-		return iscc_make_error(SCC_ER_NO_MEMORY);
-	}
+	if (out_sort->inwards_count == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+
+	#ifdef _OPENMP
+		if ((vertices >= ISCC_FS_PARALLEL_MIN_VERTICES) && (omp_get_max_threads() > 1)) {
+			iscc_fs_count_inwards_parallel(nng, out_sort->inwards_count);
+			return iscc_fs_sort_by_count(vertices, make_indices, out_sort);
+		}
+	#endif
 
-	const scc_PointIndex* const arc_stop = nng->head + nng->tail_ptr[vertices];
+	const scc_PointIndex* const arc_stop = iscc_arc_start(nng, (scc_PointIndex) vertices);
 	for (const scc_PointIndex* arc = nng->head; arc != arc_stop; ++arc) {
 		++out_sort->inwards_count[*arc];
 	}
 
+	return iscc_fs_sort_by_count(vertices, make_indices, out_sort);
+}
+
+
+// Sorts vertices by `out_sort->inwards_count`, which must be set by the caller.
+// On error, all memory in `out_sort` (including the counts) is freed.
+static scc_ErrorCode iscc_fs_sort_by_count(const size_t vertices,
+                                           const bool make_indices,
+                                           iscc_fs_SortResult* const out_sort)
+{
+	assert(vertices > 1);
+	assert(out_sort != NULL);
+	assert(out_sort->inwards_count != NULL);
+	assert(out_sort->sorted_vertices == NULL);
+	assert(out_sort->vertex_index == NULL);
+	assert(out_sort->bucket_index == NULL);
+
+	#ifdef _OPENMP
+		if ((vertices >= ISCC_FS_PARALLEL_MIN_VERTICES) && (omp_get_max_threads() > 1)) {
+			return iscc_fs_sort_by_count_parallel(vertices, make_indices, out_sort);
+		}
+	#endif
+
+	out_sort->sorted_vertices = iscc_malloc(sizeof(scc_PointIndex[vertices]));
+	if (out_sort->sorted_vertices == NULL) {
+		iscc_fs_free_sort_result(out_sort);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
 	// Dynamic alloc is slightly faster but more error-prone
 	// Add if turns out to be bottleneck
 	scc_PointIndex max_inwards_tmp = 0;
@@ -600,10 +1043,10 @@ static scc_ErrorCode iscc_fs_sort_by_inwards(const iscc_Digraph* const nng,
 	}
 	const size_t max_inwards = (size_t) max_inwards_tmp; // If `scc_PointIndex` is signed
 
-	size_t* bucket_count = calloc(max_inwards + 1, sizeof(size_t));
-	out_sort->bucket_index = malloc(sizeof(scc_PointIndex*[max_inwards + 1]));
+	size_t* bucket_count = iscc_calloc(max_inwards + 1, sizeof(size_t));
+	out_sort->bucket_index = iscc_malloc(sizeof(scc_PointIndex*[max_inwards + 1]));
 	if ((bucket_count == NULL) || (out_sort->bucket_index == NULL)) {
-		free(bucket_count);
+		iscc_free(bucket_count);
 		iscc_fs_free_sort_result(out_sort);
 		return iscc_make_error(SCC_ER_NO_MEMORY);
 	}
@@ -616,11 +1059,11 @@ static scc_ErrorCode iscc_fs_sort_by_inwards(const iscc_Digraph* const nng,
 	for (size_t b = 1; b <= max_inwards; ++b) {
 		out_sort->bucket_index[b] = out_sort->bucket_index[b - 1] + bucket_count[b];
 	}
-	free(bucket_count);
+	iscc_free(bucket_count);
 
 	assert(vertices <= ISCC_POINTINDEX_MAX);
 	if (make_indices) {
-		out_sort->vertex_index = malloc(sizeof(scc_PointIndex*[vertices]));
+		out_sort->vertex_index = iscc_malloc(sizeof(scc_PointIndex*[vertices]));
 		if (out_sort->vertex_index == NULL) {
 			iscc_fs_free_sort_result(out_sort);
 			return iscc_make_error(SCC_ER_NO_MEMORY);
@@ -638,8 +1081,8 @@ static scc_ErrorCode iscc_fs_sort_by_inwards(const iscc_Digraph* const nng,
 			*out_sort->bucket_index[out_sort->inwards_count[v]] = v;
 		}
 
-		free(out_sort->inwards_count);
-		free(out_sort->bucket_index);
+		iscc_free(out_sort->inwards_count);
+		iscc_free(out_sort->bucket_index);
 		out_sort->inwards_count = NULL;
 		out_sort->bucket_index = NULL;
 	}
@@ -648,6 +1091,122 @@ static scc_ErrorCode iscc_fs_sort_by_inwards(const iscc_Digraph* const nng,
 }
 
 
+#ifdef _OPENMP
+
+static void iscc_fs_count_inwards_parallel(const iscc_Digraph* const nng,
+                                           scc_PointIndex inwards_count[const static nng->vertices])
+{
+	assert(iscc_digraph_is_valid(nng));
+	assert(inwards_count != NULL);
+
+	const size_t arcs = iscc_digraph_arcs(nng);
+	const scc_PointIndex* const head = nng->head;
+
+	#pragma omp parallel for schedule(static)
+	for (size_t i = 0; i < arcs; ++i) {
+		#pragma omp atomic
+		++inwards_count[head[i]];
+	}
+}
+
+
+// Gives the same order as `iscc_fs_sort_by_count`. Each thread scatters a contiguous
+// range of vertices. Per-thread bucket counts are turned into offsets ordered first by
+// bucket and then by thread, so vertices stay in ascending ID order within buckets.
+// There are as many buckets as the largest inwards count, so the threads are capped
+// to keep the offsets within `vertices` elements (one thread if a vertex has more).
+static scc_ErrorCode iscc_fs_sort_by_count_parallel(const size_t vertices,
+                                                    const bool make_indices,
+                                                    iscc_fs_SortResult* const out_sort)
+{
+	assert(vertices > 1);
+	assert(vertices <= ISCC_POINTINDEX_MAX);
+	assert(out_sort != NULL);
+	assert(out_sort->inwards_count != NULL);
+
+	out_sort->sorted_vertices = iscc_malloc(sizeof(scc_PointIndex[vertices]));
+	if (make_indices) out_sort->vertex_index = iscc_malloc(sizeof(scc_PointIndex*[vertices]));
+	if ((out_sort->sorted_vertices == NULL) || (make_indices && (out_sort->vertex_index == NULL))) {
+		iscc_fs_free_sort_result(out_sort);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	const scc_PointIndex* const inwards_count = out_sort->inwards_count;
+	const scc_PointIndex vertices_pi = (scc_PointIndex) vertices; // If `scc_PointIndex` is signed
+
+	scc_PointIndex max_inwards_tmp = 0;
+	#pragma omp parallel for schedule(static) reduction(max: max_inwards_tmp)
+	for (scc_PointIndex v = 0; v < vertices_pi; ++v) {
+		if (max_inwards_tmp < inwards_count[v]) max_inwards_tmp = inwards_count[v];
+	}
+	const size_t num_buckets = ((size_t) max_inwards_tmp) + 1; // If `scc_PointIndex` is signed
+
+	const int max_threads = iscc_capped_num_threads(omp_get_max_threads(), num_buckets, vertices);
+	size_t* const offsets = iscc_calloc(((size_t) max_threads) * num_buckets, sizeof(size_t));
+	out_sort->bucket_index = iscc_malloc(sizeof(scc_PointIndex*[num_buckets]));
+	if ((offsets == NULL) || (out_sort->bucket_index == NULL)) {
+		iscc_free(offsets);
+		iscc_fs_free_sort_result(out_sort);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	scc_PointIndex* const sorted_vertices = out_sort->sorted_vertices;
+	scc_PointIndex** const vertex_index = out_sort->vertex_index;
+	scc_PointIndex** const bucket_index = out_sort->bucket_index;
+
+	#pragma omp parallel num_threads(max_threads)
+	{
+		const size_t thread = (size_t) omp_get_thread_num();
+		const size_t num_threads = (size_t) omp_get_num_threads();
+		const size_t range_len = (vertices + num_threads - 1) / num_threads;
+		const size_t range_start_sz = (thread * range_len < vertices) ? thread * range_len : vertices;
+		const scc_PointIndex range_start = (scc_PointIndex) range_start_sz;
+		const scc_PointIndex range_stop = (scc_PointIndex) ((range_start_sz + range_len < vertices) ? range_start_sz + range_len : vertices);
+		size_t* const thread_offsets = offsets + thread * num_buckets;
+
+		for (scc_PointIndex v = range_start; v < range_stop; ++v) {
+			++thread_offsets[inwards_count[v]];
+		}
+
+		#pragma omp barrier
+
+		#pragma omp single
+		{
+			size_t pos = 0;
+			for (size_t b = 0; b < num_buckets; ++b) {
+				bucket_index[b] = sorted_vertices + pos;
+				for (size_t t = 0; t < num_threads; ++t) {
+					const size_t count = offsets[t * num_buckets + b];
+					offsets[t * num_buckets + b] = pos;
+					pos += count;
+				}
+			}
+			assert(pos == vertices);
+		}
+
+		for (scc_PointIndex v = range_start; v < range_stop; ++v) {
+			const size_t pos = thread_offsets[inwards_count[v]];
+			++thread_offsets[inwards_count[v]];
+			sorted_vertices[pos] = v;
+			if (make_indices) vertex_index[v] = sorted_vertices + pos;
+		}
+	}
+
+	iscc_free(offsets);
+
+	if (!make_indices) {
+		iscc_free(out_sort->inwards_count);
+		iscc_free(out_sort->bucket_index);
+		out_sort->inwards_count = NULL;
+		out_sort->bucket_index = NULL;
+	}
+
+	return iscc_no_error();
+}
+
+#endif // ifdef _OPENMP
+
+
 static inline void iscc_fs_decrease_v_in_sort(const scc_PointIndex v_to_decrease,
                                               scc_PointIndex inwards_count[restrict const],
                                               scc_PointIndex* vertex_index[restrict const],
@@ -682,58 +1241,128 @@ static inline void iscc_fs_decrease_v_in_sort(const scc_PointIndex v_to_decrease
 	// Update vertex index
 	vertex_index[*move_to] = move_to;
 	vertex_index[*move_from] = move_from;
+}
 
-	#ifdef SCC_STABLE_FINDSEED
-		// Sort old bucket by vertex ID
-		if (move_to != move_from) {
-			iscc_fs_debug_bucket_sort(move_to + 1, move_from, inwards_count, vertex_index);
-		}
-
-		// If new bucket start on or before current_pos in the sorted vertices, move it to next in line
-		if (bucket_index[inwards_count[v_to_decrease]] <= current_pos) {
-			bucket_index[inwards_count[v_to_decrease]] = current_pos + 1;
-		}
 
-		// Sort new bucket by vertex ID
-		iscc_fs_debug_bucket_sort(bucket_index[inwards_count[v_to_decrease]],
-		                          move_to, inwards_count, vertex_index);
-	#endif
+static inline void iscc_fs_decrease_v(const scc_PointIndex v_to_decrease,
+                                      iscc_fs_SortResult* const sort,
+                                      scc_PointIndex* const current_pos)
+{
+	if (sort->queue != NULL) {
+		iscc_fs_decrease_v_in_queue(v_to_decrease, sort);
+	} else {
+		iscc_fs_decrease_v_in_sort(v_to_decrease, sort->inwards_count, sort->vertex_index, sort->bucket_index, current_pos);
+	}
 }
 
 
-#ifdef SCC_STABLE_FINDSEED
-
-static inline void iscc_fs_debug_bucket_sort(const scc_PointIndex* const bucket_start,
-                                             scc_PointIndex* pos,
-                                             const scc_PointIndex inwards_count[const],
-                                             scc_PointIndex* vertex_index[const])
+// Replaces the buckets with a binary heap ordered by count and then by vertex ID, so the
+// updating methods always pick the lowest ID among vertices with the lowest count. A sorted
+// array is a valid heap, so the heap is built in linear time from the bucket sort.
+// `sorted_vertices` is instead filled as vertices are popped, and `vertex_index` of all
+// vertices still in the heap points past the end, so that `current_pos < vertex_index[v]`
+// tells whether `v` is yet to be considered in both modes.
+// On error, all memory in `sort` is freed.
+static scc_ErrorCode iscc_fs_make_stable_queue(const size_t vertices,
+                                               iscc_fs_SortResult* const sort)
 {
-	scc_PointIndex tmp_v = *pos;
-	for (; pos != bucket_start; --pos) {
-		assert(inwards_count[tmp_v] == inwards_count[*(pos - 1)]);
-		if (tmp_v >= *(pos - 1)) break;
-		*pos = *(pos - 1);
-		vertex_index[*pos] = pos;
-	}
-	*pos = tmp_v;
-	vertex_index[*pos] = pos;
-}
+	assert(vertices > 1);
+	assert(vertices <= ISCC_POINTINDEX_MAX);
+	assert(sort != NULL);
+	assert(sort->inwards_count != NULL);
+	assert(sort->sorted_vertices != NULL);
+	assert(sort->vertex_index != NULL);
+	assert(sort->queue == NULL);
+
+	sort->queue = iscc_malloc(sizeof(scc_PointIndex[vertices]));
+	sort->queue_pos = iscc_malloc(sizeof(scc_PointIndex[vertices]));
+	if ((sort->queue == NULL) || (sort->queue_pos == NULL)) {
+		iscc_fs_free_sort_result(sort);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
 
-#endif // ifdef SCC_STABLE_FINDSEED
+	scc_PointIndex* const sorted_v_stop = sort->sorted_vertices + vertices;
+	for (size_t i = 0; i < vertices; ++i) {
+		const scc_PointIndex v = sort->sorted_vertices[i];
+		assert((i == 0) || iscc_fs_queue_before(sort->queue[i - 1], v, sort->inwards_count));
+		sort->queue[i] = v;
+		sort->queue_pos[v] = (scc_PointIndex) i;
+		sort->vertex_index[v] = sorted_v_stop;
+	}
+	sort->queue_size = vertices;
+
+	iscc_free(sort->bucket_index);
+	sort->bucket_index = NULL;
 
+	return iscc_no_error();
+}
 
-#if defined(SCC_STABLE_FINDSEED) && !defined(NDEBUG)
 
-static inline void iscc_fs_debug_check_sort(const scc_PointIndex* current_pos,
-                                            const scc_PointIndex* const last_pos,
-                                            const scc_PointIndex inwards_count[const])
+static inline void iscc_fs_pop_stable_queue(iscc_fs_SortResult* const sort,
+                                            scc_PointIndex* const current_pos)
 {
-	for (; current_pos != last_pos; ++current_pos) {
-		assert(inwards_count[*(current_pos)] <= inwards_count[*(current_pos + 1)]);
-		if (inwards_count[*(current_pos)] == inwards_count[*(current_pos + 1)]) {
-			assert(*(current_pos) < *(current_pos + 1));
+	assert(sort->queue_size > 0);
+
+	scc_PointIndex* const queue = sort->queue;
+	scc_PointIndex* const queue_pos = sort->queue_pos;
+	const scc_PointIndex* const inwards_count = sort->inwards_count;
+
+	*current_pos = queue[0];
+	sort->vertex_index[queue[0]] = current_pos;
+
+	--sort->queue_size;
+	const size_t queue_size = sort->queue_size;
+	if (queue_size == 0) return;
+
+	// Sift down the last vertex from the root
+	const scc_PointIndex v = queue[queue_size];
+	size_t pos = 0;
+	while (2 * pos + 1 < queue_size) {
+		size_t child = 2 * pos + 1;
+		if ((child + 1 < queue_size) && iscc_fs_queue_before(queue[child + 1], queue[child], inwards_count)) {
+			++child;
 		}
+		if (!iscc_fs_queue_before(queue[child], v, inwards_count)) break;
+		queue[pos] = queue[child];
+		queue_pos[queue[pos]] = (scc_PointIndex) pos;
+		pos = child;
 	}
+	queue[pos] = v;
+	queue_pos[v] = (scc_PointIndex) pos;
 }
 
-#endif // if defined(SCC_STABLE_FINDSEED) && !defined(NDEBUG)
+
+static inline void iscc_fs_decrease_v_in_queue(const scc_PointIndex v_to_decrease,
+                                               iscc_fs_SortResult* const sort)
+{
+	scc_PointIndex* const queue = sort->queue;
+	scc_PointIndex* const queue_pos = sort->queue_pos;
+	const scc_PointIndex* const inwards_count = sort->inwards_count;
+
+	assert((size_t) queue_pos[v_to_decrease] < sort->queue_size);
+	assert(queue[queue_pos[v_to_decrease]] == v_to_decrease);
+	assert(inwards_count[v_to_decrease] > 0);
+
+	--sort->inwards_count[v_to_decrease];
+
+	// Sift up, the key only decreases
+	size_t pos = (size_t) queue_pos[v_to_decrease];
+	while (pos > 0) {
+		const size_t parent = (pos - 1) / 2;
+		if (!iscc_fs_queue_before(v_to_decrease, queue[parent], inwards_count)) break;
+		queue[pos] = queue[parent];
+		queue_pos[queue[pos]] = (scc_PointIndex) pos;
+		pos = parent;
+	}
+	queue[pos] = v_to_decrease;
+	queue_pos[v_to_decrease] = (scc_PointIndex) pos;
+}
+
+
+static inline bool iscc_fs_queue_before(const scc_PointIndex v1,
+                                        const scc_PointIndex v2,
+                                        const scc_PointIndex inwards_count[const])
+{
+	return (inwards_count[v1] < inwards_count[v2]) ||
+	       ((inwards_count[v1] == inwards_count[v2]) && (v1 < v2));
+}
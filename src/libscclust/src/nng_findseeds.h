@@ -22,6 +22,8 @@
 #define SCC_NNG_FINDSEEDS_HG
 
 #include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include "../include/scclust.h"
 #include "digraph_core.h"
 #include "scclust_types.h"
@@ -44,7 +46,13 @@ typedef struct iscc_SeedResult {
 
 scc_ErrorCode iscc_find_seeds(const iscc_Digraph* nng,
                               scc_SeedMethod seed_method,
+                              bool stable,
                               iscc_SeedResult* out_seeds);
 
 
+scc_ErrorCode iscc_exclusion_graph_degrees(const iscc_Digraph* nng,
+                                           uint64_t* out_arcs,
+                                           uint64_t* out_max_degree);
+
+
 #endif // ifndef SCC_NNG_FINDSEEDS_HG
@@ -0,0 +1,257 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "point_order.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/scclust.h"
+#include "clustering_struct.h"
+#include "data_set_struct.h"
+#include "dist_search.h"
+#include "dist_search_imp.h"
+#include "error.h"
+#include "scclust_types.h"
+#include "workspace.h"
+
+
+// =============================================================================
+// Internal structs and variables
+// =============================================================================
+
+typedef struct iscc_po_MortonKey {
+	uint64_t code;
+	scc_PointIndex point;
+} iscc_po_MortonKey;
+
+
+/// Maximum number of dimensions interleaved in the Morton code.
+static const uint_fast16_t ISCC_PO_MAX_DIMENSIONS = 64;
+
+/// Maximum number of bits per dimension in the Morton code.
+static const uint_fast16_t ISCC_PO_MAX_BITS = 32;
+
+
+// =============================================================================
+// Static function prototypes
+// =============================================================================
+
+static int iscc_po_compare_keys(const void* a, const void* b);
+
+
+// =============================================================================
+// External function implementations
+// =============================================================================
+
+scc_ErrorCode iscc_morton_order(const scc_DataSet* const data_set,
+                                scc_PointIndex** const out_order)
+{
+	assert(scc_is_initialized_data_set(data_set));
+	assert(out_order != NULL);
+
+	const size_t num_data_points = data_set->num_data_points;
+	const uint_fast16_t num_dimensions = data_set->num_dimensions;
+	const uint_fast16_t dims_used = (num_dimensions < ISCC_PO_MAX_DIMENSIONS) ? num_dimensions : ISCC_PO_MAX_DIMENSIONS;
+	const uint_fast16_t bits = (64 / dims_used < ISCC_PO_MAX_BITS) ? 64 / dims_used : ISCC_PO_MAX_BITS;
+	const double max_cell = (double) ((((uint64_t) 1) << bits) - 1);
+
+	double min_coord[ISCC_PO_MAX_DIMENSIONS];
+	double scale[ISCC_PO_MAX_DIMENSIONS];
+	for (uint_fast16_t j = 0; j < dims_used; ++j) {
+		double max_coord = data_set->data_matrix[j];
+		min_coord[j] = data_set->data_matrix[j];
+		for (size_t i = 1; i < num_data_points; ++i) {
+			const double x = data_set->data_matrix[i * num_dimensions + j];
+			if (x < min_coord[j]) min_coord[j] = x;
+			if (x > max_coord) max_coord = x;
+		}
+		scale[j] = (max_coord > min_coord[j]) ? max_cell / (max_coord - min_coord[j]) : 0.0;
+	}
+
+	iscc_po_MortonKey* const keys = iscc_malloc(sizeof(iscc_po_MortonKey[num_data_points]));
+	*out_order = iscc_malloc(sizeof(scc_PointIndex[num_data_points]));
+	if ((keys == NULL) || (*out_order == NULL)) {
+		iscc_free(keys);
+		iscc_free(*out_order);
+		*out_order = NULL;
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	assert(num_data_points <= ISCC_POINTINDEX_MAX);
+	for (size_t i = 0; i < num_data_points; ++i) {
+		uint64_t cell[ISCC_PO_MAX_DIMENSIONS];
+		const double* const coords = &data_set->data_matrix[i * num_dimensions];
+		for (uint_fast16_t j = 0; j < dims_used; ++j) {
+			double scaled = (coords[j] - min_coord[j]) * scale[j];
+			if (!(scaled > 0.0)) scaled = 0.0; // Also catches NaN
+			if (scaled > max_cell) scaled = max_cell;
+			cell[j] = (uint64_t) scaled;
+		}
+
+		uint64_t code = 0;
+		for (uint_fast16_t b = bits; b > 0; --b) {
+			for (uint_fast16_t j = 0; j < dims_used; ++j) {
+				code = (code << 1) | ((cell[j] >> (b - 1)) & 1);
+			}
+		}
+
+		keys[i] = (iscc_po_MortonKey) {
+			.code = code,
+			.point = (scc_PointIndex) i,
+		};
+	}
+
+	qsort(keys, num_data_points, sizeof(iscc_po_MortonKey), iscc_po_compare_keys);
+
+	for (size_t i = 0; i < num_data_points; ++i) {
+		(*out_order)[i] = keys[i].point;
+	}
+
+	iscc_free(keys);
+
+	return iscc_no_error();
+}
+
+
+scc_ErrorCode iscc_sc_clustering_reordered(void* const data_set,
+                                           const scc_ClusterOptions* const options,
+                                           scc_Clustering* const out_clustering)
+{
+	assert(options != NULL);
+	assert(options->reorder_data_points);
+	assert(iscc_check_input_clustering(out_clustering));
+	assert(out_clustering->num_clusters == 0);
+
+	// Points can only be permuted when we know the layout of the data set
+	if (iscc_dist_functions.check_data_set != iscc_imp_check_data_set) {
+		return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "`reorder_data_points` requires the built-in data set.");
+	}
+
+	const scc_DataSet* const in_data_set = data_set;
+	assert(scc_is_initialized_data_set(in_data_set));
+	const size_t num_data_points = in_data_set->num_data_points;
+	const size_t num_dimensions = in_data_set->num_dimensions;
+
+	scc_ErrorCode ec;
+	scc_PointIndex* order;
+	if ((ec = iscc_morton_order(in_data_set, &order)) != SCC_ER_OK) return ec;
+
+	scc_ClusterOptions reordered_options = *options;
+	reordered_options.reorder_data_points = false;
+
+	double* const data_matrix = iscc_malloc(sizeof(double[num_data_points * num_dimensions]));
+	scc_Clabel* const tmp_labels = iscc_malloc(sizeof(scc_Clabel[num_data_points]));
+	scc_TypeLabel* type_labels = NULL;
+	if (options->num_types >= 2) {
+		type_labels = iscc_malloc(sizeof(scc_TypeLabel[num_data_points]));
+	}
+	scc_PointIndex* primary_data_points = NULL;
+	bool* is_primary = NULL;
+	if (options->primary_data_points != NULL) {
+		primary_data_points = iscc_malloc(sizeof(scc_PointIndex[options->len_primary_data_points]));
+		is_primary = iscc_calloc(num_data_points, sizeof(bool));
+	}
+	if ((data_matrix == NULL) || (tmp_labels == NULL) ||
+	        ((options->num_types >= 2) && (type_labels == NULL)) ||
+	        ((options->primary_data_points != NULL) && ((primary_data_points == NULL) || (is_primary == NULL)))) {
+		iscc_free(order);
+		iscc_free(data_matrix);
+		iscc_free(tmp_labels);
+		iscc_free(type_labels);
+		iscc_free(primary_data_points);
+		iscc_free(is_primary);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	for (size_t i = 0; i < num_data_points; ++i) {
+		memcpy(&data_matrix[i * num_dimensions],
+		       &in_data_set->data_matrix[((size_t) order[i]) * num_dimensions],
+		       sizeof(double[num_dimensions]));
+	}
+
+	if (type_labels != NULL) {
+		for (size_t i = 0; i < num_data_points; ++i) {
+			type_labels[i] = options->type_labels[order[i]];
+		}
+		reordered_options.len_type_labels = num_data_points;
+		reordered_options.type_labels = type_labels;
+	}
+
+	if (primary_data_points != NULL) {
+		// Scan in the new order to keep `primary_data_points` sorted
+		for (size_t p = 0; p < options->len_primary_data_points; ++p) {
+			is_primary[options->primary_data_points[p]] = true;
+		}
+		size_t len_primary = 0;
+		for (size_t i = 0; i < num_data_points; ++i) {
+			if (is_primary[order[i]]) {
+				primary_data_points[len_primary] = (scc_PointIndex) i;
+				++len_primary;
+			}
+		}
+		assert(len_primary == options->len_primary_data_points);
+		reordered_options.primary_data_points = primary_data_points;
+	}
+	iscc_free(is_primary);
+
+	scc_DataSet reordered_data_set = {
+		.data_set_version = ISCC_DATASET_STRUCT_VERSION,
+		.num_data_points = num_data_points,
+		.num_dimensions = in_data_set->num_dimensions,
+		.data_matrix = data_matrix,
+	};
+
+	ec = scc_sc_clustering(&reordered_data_set, &reordered_options, out_clustering);
+
+	iscc_free(data_matrix);
+	iscc_free(type_labels);
+	iscc_free(primary_data_points);
+
+	if (ec == SCC_ER_OK) {
+		// Map labels back to the original point IDs
+		memcpy(tmp_labels, out_clustering->cluster_label, sizeof(scc_Clabel[num_data_points]));
+		for (size_t i = 0; i < num_data_points; ++i) {
+			out_clustering->cluster_label[order[i]] = tmp_labels[i];
+		}
+	}
+
+	iscc_free(order);
+	iscc_free(tmp_labels);
+
+	return ec;
+}
+
+
+// =============================================================================
+// Static function implementations
+// =============================================================================
+
+static int iscc_po_compare_keys(const void* const a,
+                                const void* const b)
+{
+	const iscc_po_MortonKey* const key_a = a;
+	const iscc_po_MortonKey* const key_b = b;
+	if (key_a->code != key_b->code) return (key_a->code < key_b->code) ? -1 : 1;
+	return (key_a->point > key_b->point) - (key_a->point < key_b->point);
+}
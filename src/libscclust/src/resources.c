@@ -0,0 +1,680 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "../include/scclust.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "digraph_core.h"
+#include "dist_search.h"
+#include "dist_search_imp.h"
+#include "error.h"
+#include "nng_findseeds.h"
+#include "scclust_types.h"
+#include "utilities.h"
+#include "workspace.h"
+
+#ifdef _OPENMP
+	#include <omp.h>
+#endif
+
+
+// =============================================================================
+// Internal structs and variables
+// =============================================================================
+
+/** Maximum number of data points used when sampling the NNG.
+ *
+ *  The NNG of the sample is derived with an exhaustive search, so the
+ *  sampling costs at most `ISCC_ESTIMATE_RESOURCES_SAMPLE^2` distance evaluations.
+ */
+static const size_t ISCC_ESTIMATE_RESOURCES_SAMPLE = 1000;
+
+static const scc_ResourceEstimate ISCC_NULL_RESOURCE_ESTIMATE = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+
+/// Statistics from the sampled NNG. All counts refer to the sample.
+typedef struct iscc_re_SampleStats {
+	size_t sample_size;
+	size_t rows;
+	uint64_t arcs;
+	uint64_t exclusion_arcs;
+	uint64_t max_inwards_nng;
+	uint64_t max_inwards_exclusion;
+	uint64_t seeds;
+	uint64_t assigned;
+	uint64_t assigned_rows;
+	uint64_t assigned_by_nng;
+} iscc_re_SampleStats;
+
+
+// =============================================================================
+// Static function prototypes
+// =============================================================================
+
+static scc_ErrorCode iscc_re_sample_nng(void* data_set,
+                                        size_t num_data_points,
+                                        uint32_t k,
+                                        const bool is_primary[],
+                                        iscc_Digraph* out_nng,
+                                        size_t* out_rows);
+
+
+static scc_ErrorCode iscc_re_sample_stats(void* data_set,
+                                          size_t num_data_points,
+                                          uint32_t k,
+                                          const scc_ClusterOptions* options,
+                                          iscc_re_SampleStats* out_stats);
+
+
+static scc_ErrorCode iscc_re_inwards_stats(const iscc_Digraph* dg,
+                                           uint64_t* out_max_inwards);
+
+
+static inline uint64_t iscc_re_scale(uint64_t sample_count,
+                                     uint64_t sample_base,
+                                     uint64_t base);
+
+
+static inline uint64_t iscc_re_digraph_bytes(uint64_t vertices,
+                                             uint64_t arcs);
+
+
+static inline uint64_t iscc_re_sort_bytes(uint64_t vertices,
+                                          uint64_t max_inwards,
+                                          bool make_indices,
+                                          bool stable);
+
+
+static inline uint64_t iscc_re_max(uint64_t a,
+                                   uint64_t b);
+
+
+// =============================================================================
+// Public function implementations
+// =============================================================================
+
+scc_ErrorCode scc_estimate_resources(void* const data_set,
+                                     const scc_ClusterOptions* const options,
+                                     scc_ResourceEstimate* const out_estimate)
+{
+	if (out_estimate == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Output parameter may not be NULL.");
+	}
+	*out_estimate = ISCC_NULL_RESOURCE_ESTIMATE;
+	if (!iscc_check_data_set(data_set)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid data set object.");
+	}
+
+	const size_t num_data_points = iscc_num_data_points(data_set);
+	scc_ErrorCode ec;
+	if ((ec = iscc_check_cluster_options(options, num_data_points)) != SCC_ER_OK) {
+		return ec;
+	}
+
+	const uint64_t N = num_data_points;
+	const uint64_t q = (options->primary_data_points == NULL) ? N : options->len_primary_data_points;
+	const uint64_t pi_size = sizeof(scc_PointIndex);
+
+	// Effective size constraint for the NNG, including type constraints
+	uint64_t sum_type_constraints = 0;
+	if (options->num_types >= 2) {
+		for (uint_fast16_t i = 0; i < options->num_types; ++i) {
+			sum_type_constraints += options->type_constraints[i];
+		}
+	}
+	uint32_t k_eff = options->size_constraint;
+	if (sum_type_constraints > k_eff) k_eff = (uint32_t) sum_type_constraints;
+
+	iscc_re_SampleStats ss;
+	if ((ec = iscc_re_sample_stats(data_set, num_data_points, k_eff, options, &ss)) != SCC_ER_OK) {
+		return ec;
+	}
+
+	const uint64_t labels_bytes = N * sizeof(scc_Clabel);
+	const uint64_t num_seeds = iscc_re_scale(ss.seeds, ss.rows, q);
+	const uint64_t seed_capacity_bytes = (1 + N / options->size_constraint) * pi_size;
+
+	*out_estimate = (scc_ResourceEstimate) {
+		.sample_size = ss.sample_size,
+		.num_seeds = num_seeds,
+	};
+
+	if (options->seed_method == SCC_SM_BATCHES) {
+		// An adaptive batch may grow to all points unless capped by `max_batch_bytes`
+		uint64_t batch_size = ((options->batch_size == 0) || options->adaptive_batch_size) ? N : options->batch_size;
+		if (batch_size > N) batch_size = N;
+		uint64_t batch_bytes = batch_size * (options->size_constraint + 1) * pi_size;
+		if (options->adaptive_batch_size && (options->max_batch_bytes > 0) && (batch_bytes > options->max_batch_bytes)) {
+			batch_bytes = options->max_batch_bytes;
+		}
+		// With the built-in search, the clusters are recorded so assigned points can be
+		// dropped from the search index, which holds at most half of the points once rebuilt
+		uint64_t shrink_bytes = 0;
+		if ((options->num_types < 2) &&
+		        (options->seed_radius != SCC_RM_USE_SUPPLIED) &&
+		        (iscc_dist_functions.check_data_set == iscc_imp_check_data_set)) {
+			const uint64_t max_clusters = N / options->size_constraint;
+			shrink_bytes = max_clusters * (options->size_constraint + 1) * pi_size +
+			               max_clusters * sizeof(double) +
+			               (N / 2) * pi_size;
+		}
+		// With type constraints, the points are grouped by type and each batch
+		// is searched once per type before the rows are gathered
+		uint64_t type_bytes = 0;
+		uint64_t dist_evals = q * N;
+		if (options->num_types >= 2) {
+			uint64_t* const type_group_size = iscc_calloc(options->num_types, sizeof(uint64_t));
+			if (type_group_size == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+			for (size_t i = 0; i < num_data_points; ++i) {
+				++type_group_size[options->type_labels[i]];
+			}
+			dist_evals = (options->size_constraint > sum_type_constraints) ? q * N : 0;
+			for (uint_fast16_t i = 0; i < options->num_types; ++i) {
+				if (options->type_constraints[i] > 0) dist_evals += q * type_group_size[i];
+			}
+			iscc_free(type_group_size);
+
+			const uint64_t rows = batch_bytes / ((options->size_constraint + 1) * pi_size);
+			type_bytes = N * pi_size +
+			             options->num_types * (sizeof(uint64_t) + sizeof(void*)) +
+			             rows * ((options->num_types + 1) * pi_size +
+			                     (sum_type_constraints + options->size_constraint) * pi_size +
+			                     sizeof(uint32_t));
+		}
+		out_estimate->nng_bytes = labels_bytes +
+		                          N * sizeof(bool) +
+		                          batch_bytes +
+		                          shrink_bytes +
+		                          type_bytes +
+		                          ((options->primary_data_points != NULL) ? N * sizeof(bool) : 0);
+		out_estimate->nng_dist_evals = dist_evals;
+
+		// Points left unassigned by the batches are searched for in chunks of the batch size
+		const bool primary_search = (options->primary_unassigned_method == SCC_UM_CLOSEST_ASSIGNED) ||
+		                            (options->primary_unassigned_method == SCC_UM_CLOSEST_SEED);
+		const bool secondary_search = (options->secondary_unassigned_method != SCC_UM_IGNORE);
+		if (primary_search || secondary_search) {
+			uint64_t assigned = iscc_re_scale(ss.assigned, ss.sample_size, N);
+			if (assigned > N) assigned = N;
+			uint64_t primary_assigned = iscc_re_scale(ss.assigned_rows, ss.rows, q);
+			if (primary_assigned > q) primary_assigned = q;
+			const uint64_t non_primary_assigned = (assigned > primary_assigned) ? assigned - primary_assigned : 0;
+			const bool uses_closest_assigned = (options->primary_unassigned_method == SCC_UM_CLOSEST_ASSIGNED) ||
+			                                   (options->secondary_unassigned_method == SCC_UM_CLOSEST_ASSIGNED);
+			if (primary_search) {
+				const uint64_t search_set = (options->primary_unassigned_method == SCC_UM_CLOSEST_SEED) ? num_seeds : assigned;
+				out_estimate->assignment_dist_evals += (q - primary_assigned) * search_set;
+			}
+			if (secondary_search) {
+				const uint64_t secondary_to_assign = (N - q > non_primary_assigned) ? N - q - non_primary_assigned : 0;
+				const uint64_t search_set = (options->secondary_unassigned_method == SCC_UM_CLOSEST_SEED) ? num_seeds : assigned;
+				out_estimate->assignment_dist_evals += secondary_to_assign * search_set;
+			}
+			out_estimate->assignment_bytes = labels_bytes +
+			                                 N * sizeof(bool) +
+			                                 seed_capacity_bytes +
+			                                 (uses_closest_assigned ? assigned * pi_size : 0) +
+			                                 N * pi_size +
+			                                 2 * (batch_bytes / ((options->size_constraint + 1) * pi_size)) * pi_size +
+			                                 ((options->primary_data_points != NULL) ? N * sizeof(bool) : 0);
+		}
+
+		out_estimate->peak_bytes = iscc_re_max(out_estimate->nng_bytes, out_estimate->assignment_bytes);
+		out_estimate->total_dist_evals = out_estimate->nng_dist_evals + out_estimate->assignment_dist_evals;
+		return iscc_no_error();
+	}
+
+	// NNG construction
+	const uint64_t seedable_bytes = (options->seed_radius == SCC_RM_USE_SUPPLIED) ? q * pi_size : 0;
+	if (options->num_types < 2) {
+		out_estimate->nng_bytes = seedable_bytes +
+		                          iscc_re_digraph_bytes(N, q * options->size_constraint);
+		out_estimate->nng_dist_evals = q * N;
+	} else {
+		uint64_t* const type_group_size = iscc_calloc(options->num_types, sizeof(uint64_t));
+		if (type_group_size == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+		for (size_t i = 0; i < num_data_points; ++i) {
+			++type_group_size[options->type_labels[i]];
+		}
+
+		uint64_t type_nng_bytes = 0;
+		for (uint_fast16_t i = 0; i < options->num_types; ++i) {
+			if (options->type_constraints[i] > 0) {
+				type_nng_bytes += iscc_re_digraph_bytes(N, q * options->type_constraints[i]);
+				out_estimate->nng_dist_evals += q * type_group_size[i];
+			}
+		}
+		iscc_free(type_group_size);
+
+		const uint64_t union_bytes = iscc_re_digraph_bytes(N, q * sum_type_constraints);
+		out_estimate->nng_bytes = iscc_re_max(N * pi_size + type_nng_bytes,
+		                                      type_nng_bytes + union_bytes + N * pi_size);
+		if (options->size_constraint > sum_type_constraints) {
+			const uint64_t size_nng_bytes = iscc_re_digraph_bytes(N, q * options->size_constraint);
+			out_estimate->nng_bytes = iscc_re_max(out_estimate->nng_bytes,
+			                                      union_bytes + 2 * size_nng_bytes + N * pi_size);
+			out_estimate->nng_dist_evals += q * N;
+		}
+		out_estimate->nng_bytes += seedable_bytes;
+	}
+
+	// Seed finding
+	const uint64_t nng_arcs = q * (k_eff - 1);
+	const uint64_t nng_bytes = iscc_re_digraph_bytes(N, nng_arcs);
+	out_estimate->nng_arcs = nng_arcs;
+
+	switch (options->seed_method) {
+	case SCC_SM_LEXICAL:
+		out_estimate->sort_bytes = nng_bytes + N * sizeof(bool) + seed_capacity_bytes;
+		break;
+
+	case SCC_SM_INWARDS_ORDER:
+	case SCC_SM_INWARDS_UPDATING:
+		out_estimate->sort_bytes = nng_bytes +
+		                           iscc_re_sort_bytes(N, ss.max_inwards_nng, (options->seed_method == SCC_SM_INWARDS_UPDATING), options->stable_clustering) +
+		                           N * sizeof(bool) +
+		                           seed_capacity_bytes;
+		break;
+
+	case SCC_SM_EXCLUSION_ORDER:
+	case SCC_SM_EXCLUSION_UPDATING:
+	{
+		// See `iscc_findseeds_exclusion`: NNG, transpose, exclusion marks, row markers and neighbor buffer
+		const bool updating = (options->seed_method == SCC_SM_EXCLUSION_UPDATING);
+		const uint64_t neighbors_bytes = (updating ? 2 : 1) * (ss.max_inwards_exclusion + k_eff) * pi_size;
+		const uint64_t base_bytes = 2 * nng_bytes + N * sizeof(bool) + N * pi_size + neighbors_bytes;
+		// See `iscc_digraph_transpose_parallel`: inwards counts, freed before the marks are allocated
+		uint64_t transpose_bytes = 2 * nng_bytes;
+		#ifdef _OPENMP
+			transpose_bytes += N * pi_size;
+		#endif
+		out_estimate->exclusion_graph_arcs = iscc_re_scale(ss.exclusion_arcs, ss.arcs, nng_arcs);
+		out_estimate->exclusion_graph_bytes = iscc_re_max(transpose_bytes, base_bytes + N * pi_size);
+		out_estimate->sort_bytes = base_bytes +
+		                           iscc_re_sort_bytes(N, ss.max_inwards_exclusion, updating, options->stable_clustering) +
+		                           seed_capacity_bytes;
+		break;
+	}
+
+	case SCC_SM_BATCHES:
+	default:
+		assert(false);
+		break;
+	}
+
+	// Assignment
+	uint64_t assigned = iscc_re_scale(ss.assigned, ss.sample_size, N);
+	if (assigned > N) assigned = N;
+	uint64_t primary_assigned = iscc_re_scale(ss.assigned_rows, ss.rows, q);
+	if (primary_assigned > q) primary_assigned = q;
+	const uint64_t non_primary_assigned = (assigned > primary_assigned) ? assigned - primary_assigned : 0;
+	const bool uses_closest_assigned = (options->primary_unassigned_method == SCC_UM_CLOSEST_ASSIGNED) ||
+	                                   (options->secondary_unassigned_method == SCC_UM_CLOSEST_ASSIGNED);
+	const uint64_t seed_or_neighbor_bytes = uses_closest_assigned ? assigned * pi_size : 0;
+	out_estimate->assignment_bytes = nng_bytes + labels_bytes + seed_capacity_bytes + seed_or_neighbor_bytes;
+
+	if ((options->primary_unassigned_method == SCC_UM_ANY_NEIGHBOR) ||
+	        ((options->num_types < 2) && (options->primary_unassigned_method == SCC_UM_CLOSEST_ASSIGNED))) {
+		primary_assigned += iscc_re_scale(ss.assigned_by_nng, ss.rows, q);
+		if (primary_assigned > q) primary_assigned = q;
+	}
+
+	const bool estimate_radius = (options->primary_radius == SCC_RM_USE_ESTIMATED) ||
+	                             ((options->primary_radius == SCC_RM_USE_SEED_RADIUS) && (options->seed_radius == SCC_RM_USE_ESTIMATED)) ||
+	                             (options->secondary_radius == SCC_RM_USE_ESTIMATED) ||
+	                             ((options->secondary_radius == SCC_RM_USE_SEED_RADIUS) && (options->seed_radius == SCC_RM_USE_ESTIMATED));
+	if (estimate_radius) {
+		const uint64_t sampled_seeds = (num_seeds > 1000) ? 1000 : num_seeds;
+		out_estimate->assignment_dist_evals += sampled_seeds * options->size_constraint;
+	}
+
+	uint64_t primary_to_assign = 0;
+	if ((options->primary_unassigned_method == SCC_UM_CLOSEST_ASSIGNED) ||
+	        (options->primary_unassigned_method == SCC_UM_CLOSEST_SEED)) {
+		primary_to_assign = q - primary_assigned;
+		const uint64_t search_set = (options->primary_unassigned_method == SCC_UM_CLOSEST_SEED) ? num_seeds : assigned;
+		out_estimate->assignment_dist_evals += primary_to_assign * search_set;
+	}
+
+	uint64_t secondary_to_assign = 0;
+	if (options->secondary_unassigned_method != SCC_UM_IGNORE) {
+		secondary_to_assign = (N - q > non_primary_assigned) ? N - q - non_primary_assigned : 0;
+		const uint64_t search_set = (options->secondary_unassigned_method == SCC_UM_CLOSEST_SEED) ? num_seeds : assigned;
+		out_estimate->assignment_dist_evals += secondary_to_assign * search_set;
+	}
+
+	if ((primary_to_assign > 0) || (secondary_to_assign > 0)) {
+		// The NNG is freed before the search
+		const uint64_t to_assign = iscc_re_max(primary_to_assign, secondary_to_assign);
+		const uint64_t search_bytes = labels_bytes +
+		                              seed_capacity_bytes +
+		                              seed_or_neighbor_bytes +
+		                              (N - assigned + 1) * pi_size +
+		                              to_assign * pi_size;
+		out_estimate->assignment_bytes = iscc_re_max(out_estimate->assignment_bytes, search_bytes);
+	}
+
+	out_estimate->peak_bytes = iscc_re_max(iscc_re_max(out_estimate->nng_bytes, out_estimate->exclusion_graph_bytes),
+	                                       iscc_re_max(out_estimate->sort_bytes, out_estimate->assignment_bytes));
+	out_estimate->total_dist_evals = out_estimate->nng_dist_evals + out_estimate->assignment_dist_evals;
+
+	return iscc_no_error();
+}
+
+
+// =============================================================================
+// Static function implementations
+// =============================================================================
+
+static scc_ErrorCode iscc_re_sample_nng(void* const data_set,
+                                        const size_t num_data_points,
+                                        const uint32_t k,
+                                        const bool is_primary[const],
+                                        iscc_Digraph* const out_nng,
+                                        size_t* const out_rows)
+{
+	assert(iscc_check_data_set(data_set));
+	assert(num_data_points >= 2);
+	assert(k >= 2);
+	assert(out_nng != NULL);
+	assert(out_rows != NULL);
+
+	// Deterministic sample: every `step`th data point
+	const size_t step = (num_data_points > ISCC_ESTIMATE_RESOURCES_SAMPLE) ? (num_data_points / ISCC_ESTIMATE_RESOURCES_SAMPLE) : 1;
+	size_t len_sample = num_data_points / step;
+	if (len_sample > ISCC_ESTIMATE_RESOURCES_SAMPLE) len_sample = ISCC_ESTIMATE_RESOURCES_SAMPLE;
+	assert(len_sample >= 2);
+	const uint32_t k_sample = (k > len_sample) ? (uint32_t) len_sample : k;
+
+	scc_PointIndex* const sample = iscc_malloc(sizeof(scc_PointIndex[len_sample]));
+	scc_PointIndex* const rows = iscc_malloc(sizeof(scc_PointIndex[len_sample]));
+	if ((sample == NULL) || (rows == NULL)) {
+		iscc_free(sample);
+		iscc_free(rows);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	size_t len_rows = 0;
+	for (size_t i = 0; i < len_sample; ++i) {
+		sample[i] = (scc_PointIndex) (i * step);
+		if ((is_primary == NULL) || is_primary[i * step]) {
+			rows[len_rows] = sample[i];
+			++len_rows;
+		}
+	}
+	if (len_rows == 0) {
+		// No primary point in the sample, treat all sampled points as primary
+		for (size_t i = 0; i < len_sample; ++i) {
+			rows[i] = sample[i];
+		}
+		len_rows = len_sample;
+	}
+
+	scc_PointIndex* const nn_indices = iscc_malloc(sizeof(scc_PointIndex[len_rows * k_sample]));
+	if (nn_indices == NULL) {
+		iscc_free(sample);
+		iscc_free(rows);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	iscc_NNSearchObject* nn_search_object;
+	if (!iscc_init_nn_search_object(data_set, len_sample, sample, &nn_search_object)) {
+		iscc_free(sample);
+		iscc_free(rows);
+		iscc_free(nn_indices);
+		return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+	}
+
+	size_t num_ok_queries = 0;
+	const bool search_ok = iscc_nearest_neighbor_search(nn_search_object,
+	                                                    len_rows,
+	                                                    rows,
+	                                                    k_sample,
+	                                                    false,
+	                                                    0.0,
+	                                                    &num_ok_queries,
+	                                                    NULL,
+	                                                    nn_indices);
+	iscc_close_nn_search_object(&nn_search_object);
+	iscc_free(sample);
+	if (!search_ok) {
+		iscc_free(rows);
+		iscc_free(nn_indices);
+		return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
+	}
+	assert(num_ok_queries == len_rows);
+
+	scc_ErrorCode ec;
+	if ((ec = iscc_empty_digraph(len_sample, len_rows * (k_sample - 1), out_nng)) != SCC_ER_OK) {
+		iscc_free(rows);
+		iscc_free(nn_indices);
+		return ec;
+	}
+
+	// Same as `iscc_ensure_self_match` followed by `iscc_delete_loops`:
+	// keep the `k_sample - 1` nearest neighbors that are not the point itself.
+	// Sampled point `i * step` is vertex `i` in the sampled NNG.
+	size_t arcs_written = 0;
+	size_t next_row = 0;
+	for (size_t v = 0; v < len_sample; ++v) {
+		if ((next_row < len_rows) && ((size_t) rows[next_row] == v * step)) {
+			const scc_PointIndex* const nn = nn_indices + next_row * k_sample;
+			uint32_t row_arcs = 0;
+			for (uint32_t j = 0; (j < k_sample) && (row_arcs < k_sample - 1); ++j) {
+				if (nn[j] != rows[next_row]) {
+					assert(((size_t) nn[j]) % step == 0);
+					out_nng->head[arcs_written] = (scc_PointIndex) (((size_t) nn[j]) / step);
+					++arcs_written;
+					++row_arcs;
+				}
+			}
+			++next_row;
+		}
+		iscc_set_tail_ptr(out_nng, (scc_PointIndex) (v + 1), arcs_written);
+	}
+
+	iscc_free(rows);
+	iscc_free(nn_indices);
+
+	*out_rows = len_rows;
+
+	return iscc_change_arc_storage(out_nng, arcs_written);
+}
+
+
+static scc_ErrorCode iscc_re_sample_stats(void* const data_set,
+                                          const size_t num_data_points,
+                                          const uint32_t k,
+                                          const scc_ClusterOptions* const options,
+                                          iscc_re_SampleStats* const out_stats)
+{
+	assert(options != NULL);
+	assert(out_stats != NULL);
+
+	bool* is_primary = NULL;
+	if (options->primary_data_points != NULL) {
+		is_primary = iscc_calloc(num_data_points, sizeof(bool));
+		if (is_primary == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+		for (size_t i = 0; i < options->len_primary_data_points; ++i) {
+			is_primary[options->primary_data_points[i]] = true;
+		}
+	}
+
+	scc_ErrorCode ec;
+	size_t rows = 0;
+	iscc_Digraph nng;
+	ec = iscc_re_sample_nng(data_set, num_data_points, k, is_primary, &nng, &rows);
+	iscc_free(is_primary);
+	if (ec != SCC_ER_OK) return ec;
+
+	*out_stats = (iscc_re_SampleStats) {
+		.sample_size = nng.vertices,
+		.rows = rows,
+		.arcs = iscc_digraph_arcs(&nng),
+	};
+
+	if (iscc_digraph_is_empty(&nng)) {
+		iscc_free_digraph(&nng);
+		return iscc_no_error();
+	}
+
+	if ((ec = iscc_re_inwards_stats(&nng, &out_stats->max_inwards_nng)) != SCC_ER_OK) {
+		iscc_free_digraph(&nng);
+		return ec;
+	}
+
+	if ((options->seed_method == SCC_SM_EXCLUSION_ORDER) ||
+	        (options->seed_method == SCC_SM_EXCLUSION_UPDATING)) {
+		// Counted from the symmetric neighbor relation, as `iscc_findseeds_exclusion`
+		// does, so neither the exclusion graph nor NNG·NNG^T is materialized
+		if ((ec = iscc_exclusion_graph_degrees(&nng,
+		                                       &out_stats->exclusion_arcs,
+		                                       &out_stats->max_inwards_exclusion)) != SCC_ER_OK) {
+			iscc_free_digraph(&nng);
+			return ec;
+		}
+	}
+
+	const scc_SeedMethod sample_seed_method = (options->seed_method == SCC_SM_BATCHES) ? SCC_SM_LEXICAL : options->seed_method;
+	iscc_SeedResult seed_result = {
+		.capacity = 1 + (nng.vertices / k),
+		.count = 0,
+		.seeds = NULL,
+	};
+	if ((ec = iscc_find_seeds(&nng, sample_seed_method, options->stable_clustering, &seed_result)) != SCC_ER_OK) {
+		iscc_free_digraph(&nng);
+		return ec;
+	}
+
+	bool* const assigned = iscc_calloc(nng.vertices, sizeof(bool));
+	if (assigned == NULL) {
+		iscc_free(seed_result.seeds);
+		iscc_free_digraph(&nng);
+		return iscc_make_error(SCC_ER_NO_MEMORY);
+	}
+
+	out_stats->seeds = seed_result.count;
+	for (size_t s = 0; s < seed_result.count; ++s) {
+		const scc_PointIndex seed = seed_result.seeds[s];
+		assigned[seed] = true;
+		const scc_PointIndex* const s_arc_stop = iscc_arc_stop(&nng, seed);
+		for (const scc_PointIndex* s_arc = iscc_arc_start(&nng, seed);
+		        s_arc != s_arc_stop; ++s_arc) {
+			assigned[*s_arc] = true;
+		}
+		out_stats->assigned += 1 + (uint64_t) (s_arc_stop - iscc_arc_start(&nng, seed));
+	}
+	iscc_free(seed_result.seeds);
+
+	// Only vertices with arcs are primary (i.e., rows in the NNG)
+	for (size_t v = 0; v < nng.vertices; ++v) {
+		if (iscc_get_tail_ptr(&nng, (scc_PointIndex) v) == iscc_get_tail_ptr(&nng, (scc_PointIndex) (v + 1))) continue;
+		if (assigned[v]) {
+			++out_stats->assigned_rows;
+			continue;
+		}
+		const scc_PointIndex* const v_arc_stop = iscc_arc_stop(&nng, (scc_PointIndex) v);
+		for (const scc_PointIndex* v_arc = iscc_arc_start(&nng, (scc_PointIndex) v);
+		        v_arc != v_arc_stop; ++v_arc) {
+			if (assigned[*v_arc]) {
+				++out_stats->assigned_by_nng;
+				break;
+			}
+		}
+	}
+
+	iscc_free(assigned);
+	iscc_free_digraph(&nng);
+
+	return iscc_no_error();
+}
+
+
+static scc_ErrorCode iscc_re_inwards_stats(const iscc_Digraph* const dg,
+                                           uint64_t* const out_max_inwards)
+{
+	assert(iscc_digraph_is_valid(dg));
+	assert(out_max_inwards != NULL);
+
+	uint64_t* const inwards_count = iscc_calloc(dg->vertices, sizeof(uint64_t));
+	if (inwards_count == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+
+	const scc_PointIndex* const arc_stop = dg->head + iscc_digraph_arcs(dg);
+	for (const scc_PointIndex* arc = dg->head; arc != arc_stop; ++arc) {
+		++inwards_count[*arc];
+	}
+
+	*out_max_inwards = 0;
+	for (size_t v = 0; v < dg->vertices; ++v) {
+		if (*out_max_inwards < inwards_count[v]) *out_max_inwards = inwards_count[v];
+	}
+
+	iscc_free(inwards_count);
+
+	return iscc_no_error();
+}
+
+
+static inline uint64_t iscc_re_scale(const uint64_t sample_count,
+                                     const uint64_t sample_base,
+                                     const uint64_t base)
+{
+	if (sample_base == 0) return 0;
+	return (uint64_t) (((double) sample_count) * ((double) base) / ((double) sample_base) + 0.5);
+}
+
+
+static inline uint64_t iscc_re_digraph_bytes(const uint64_t vertices,
+                                             const uint64_t arcs)
+{
+	const uint64_t tail_ptr_size = (arcs > ISCC_ARCINDEX32_MAX) ? sizeof(iscc_ArcIndex64) : sizeof(iscc_ArcIndex32);
+	return (vertices + 1) * tail_ptr_size + arcs * sizeof(scc_PointIndex);
+}
+
+
+static inline uint64_t iscc_re_sort_bytes(const uint64_t vertices,
+                                          const uint64_t max_inwards,
+                                          const bool make_indices,
+                                          const bool stable)
+{
+	// See `iscc_fs_sort_by_inwards`
+	uint64_t bytes = 2 * vertices * sizeof(scc_PointIndex) +
+	                 (max_inwards + 1) * (sizeof(size_t) + sizeof(scc_PointIndex*));
+	#ifdef _OPENMP
+		// See `iscc_fs_sort_by_count_parallel`: one set of bucket offsets per thread
+		const int threads = iscc_capped_num_threads(omp_get_max_threads(), (size_t) (max_inwards + 1), (size_t) vertices);
+		bytes += ((uint64_t) threads - 1) * (max_inwards + 1) * sizeof(size_t);
+	#endif
+	if (make_indices) bytes += vertices * sizeof(scc_PointIndex*);
+	// See `iscc_fs_make_stable_queue`
+	if (make_indices && stable) bytes += 2 * vertices * sizeof(scc_PointIndex);
+	return bytes;
+}
+
+
+static inline uint64_t iscc_re_max(const uint64_t a,
+                                   const uint64_t b)
+{
+	return (a > b) ? a : b;
+}
@@ -29,6 +29,7 @@
 #include "clustering_struct.h"
 #include "error.h"
 #include "scclust_types.h"
+#include "workspace.h"
 
 
 // =============================================================================
@@ -66,7 +67,7 @@ scc_ErrorCode scc_init_empty_clustering(const uint64_t num_data_points,
 		return iscc_make_error_msg(SCC_ER_TOO_LARGE_PROBLEM, "Too many data points.");
 	}
 
-	scc_Clustering* tmp_cl = malloc(sizeof(scc_Clustering));
+	scc_Clustering* tmp_cl = iscc_malloc(sizeof(scc_Clustering));
 	if (tmp_cl == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 
 	*tmp_cl = (scc_Clustering) {
@@ -122,7 +123,7 @@ scc_ErrorCode scc_init_existing_clustering(const uint64_t num_data_points,
 
 	const size_t num_data_points_st = (size_t) num_data_points;
 
-	scc_Clustering* tmp_cl = malloc(sizeof(scc_Clustering));
+	scc_Clustering* tmp_cl = iscc_malloc(sizeof(scc_Clustering));
 	if (tmp_cl == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 
 	*tmp_cl = (scc_Clustering) {
@@ -134,9 +135,9 @@ scc_ErrorCode scc_init_existing_clustering(const uint64_t num_data_points,
 	};
 
 	if (deep_label_copy) {
-		tmp_cl->cluster_label = malloc(sizeof(scc_Clabel[num_data_points_st]));
+		tmp_cl->cluster_label = iscc_malloc(sizeof(scc_Clabel[num_data_points_st]));
 		if (tmp_cl->cluster_label == NULL) {
-			free(tmp_cl);
+			iscc_free(tmp_cl);
 			return iscc_make_error(SCC_ER_NO_MEMORY);
 		}
 		memcpy(tmp_cl->cluster_label, current_cluster_labels, num_data_points_st * sizeof(scc_Clabel));
@@ -155,8 +156,8 @@ scc_ErrorCode scc_init_existing_clustering(const uint64_t num_data_points,
 void scc_free_clustering(scc_Clustering** const clustering)
 {
 	if ((clustering != NULL) && (*clustering != NULL)) {
-		if (!((*clustering)->external_labels)) free((*clustering)->cluster_label);
-		free(*clustering);
+		if (!((*clustering)->external_labels)) iscc_free((*clustering)->cluster_label);
+		iscc_free(*clustering);
 		*clustering = NULL;
 	}
 }
@@ -189,7 +190,7 @@ scc_ErrorCode scc_copy_clustering(const scc_Clustering* const in_clustering,
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid clustering object.");
 	}
 
-	scc_Clustering* tmp_cl = malloc(sizeof(scc_Clustering));
+	scc_Clustering* tmp_cl = iscc_malloc(sizeof(scc_Clustering));
 	if (tmp_cl == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 
 	*tmp_cl = (scc_Clustering) {
@@ -201,9 +202,9 @@ scc_ErrorCode scc_copy_clustering(const scc_Clustering* const in_clustering,
 	};
 
 	if (in_clustering->num_clusters > 0) {
-		tmp_cl->cluster_label = malloc(sizeof(scc_Clabel[in_clustering->num_data_points]));
+		tmp_cl->cluster_label = iscc_malloc(sizeof(scc_Clabel[in_clustering->num_data_points]));
 		if (tmp_cl->cluster_label == NULL) {
-			free(tmp_cl);
+			iscc_free(tmp_cl);
 			return iscc_make_error(SCC_ER_NO_MEMORY);
 		}
 		memcpy(tmp_cl->cluster_label, in_clustering->cluster_label, in_clustering->num_data_points * sizeof(scc_Clabel));
@@ -39,25 +39,33 @@
 #include "../include/scclust_spi.h"
 
 
-/** Type used for arc indices. Must be unsigned.
+/** Types used for arc indices. Must be unsigned.
+ *
+ *  Both widths are compiled into the library and the width is chosen
+ *  per digraph from its arc count. Digraphs with at most
+ *  `ISCC_ARCINDEX32_MAX` arcs store their tail pointers as #iscc_ArcIndex32,
+ *  larger digraphs use #iscc_ArcIndex64. #iscc_ArcIndex is the wide
+ *  type used when arc indices are passed between functions.
  *
  *  \note
  *  Number of arcs in any digraph must be less or equal to
  *  the maximum number that can be stored in #iscc_ArcIndex.
  */
-typedef uint32_t iscc_ArcIndex;
-
-#define ISCC_M_ARCINDEX_TYPE_uint32_t
+typedef uint32_t iscc_ArcIndex32;
+typedef uint64_t iscc_ArcIndex64;
+typedef uint64_t iscc_ArcIndex;
 
 static const scc_Clabel SCC_CLABEL_MAX = INT_MAX;
 static const scc_PointIndex ISCC_POINTINDEX_MAX_PI = INT_MAX;
 static const uintmax_t ISCC_POINTINDEX_MAX = INT_MAX;
-static const uintmax_t ISCC_ARCINDEX_MAX = UINT32_MAX;
+static const uintmax_t ISCC_ARCINDEX32_MAX = UINT32_MAX;
+static const uintmax_t ISCC_ARCINDEX_MAX = UINT64_MAX;
 static const uintmax_t ISCC_TYPELABEL_MAX = 65535;
 
 #define ISCC_M_CLABEL_MAX INT_MAX
 #define ISCC_M_POINTINDEX_MAX INT_MAX
-#define ISCC_M_ARCINDEX_MAX UINT32_MAX
+#define ISCC_M_ARCINDEX32_MAX UINT32_MAX
+#define ISCC_M_ARCINDEX_MAX UINT64_MAX
 #define ISCC_M_TYPELABEL_MAX 65535
 
 
@@ -31,6 +31,7 @@
 #include "dist_search.h"
 #include "error.h"
 #include "scclust_types.h"
+#include "workspace.h"
 
 
 // =============================================================================
@@ -43,7 +44,14 @@
  */
 static const scc_ClusteringStats ISCC_NULL_CLUSTERING_STATS = { 0, 0, 0, 0, 0, 0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
 
-static const int32_t ISCC_OPTIONS_STRUCT_VERSION = 722678001;
+static const int32_t ISCC_OPTIONS_STRUCT_VERSION = 722678005;
+
+
+// =============================================================================
+// Static function prototypes
+// =============================================================================
+
+static int iscc_compare_PointIndex(const void* a, const void* b);
 
 
 // =============================================================================
@@ -71,6 +79,12 @@ scc_ClusterOptions scc_get_default_options(void)
 		.secondary_radius = SCC_RM_USE_SEED_RADIUS,
 		.secondary_supplied_radius = 0.0,
 		.batch_size = 0,
+		.reorder_data_points = false,
+		.seed_portfolio = 0,
+		.stable_clustering = false,
+		.adaptive_batch_size = false,
+		.max_batch_bytes = 0,
+		.batch_stats = NULL,
 	};
 }
 
@@ -118,7 +132,7 @@ scc_ErrorCode scc_check_clustering(const scc_Clustering* const clustering,
 
 	if (num_types < 2) {
 
-		size_t* const cluster_sizes = calloc(clustering->num_clusters, sizeof(size_t));
+		size_t* const cluster_sizes = iscc_calloc(clustering->num_clusters, sizeof(size_t));
 		if (cluster_sizes == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 
 		for (size_t i = 0; i < clustering->num_data_points; ++i) {
@@ -129,16 +143,16 @@ scc_ErrorCode scc_check_clustering(const scc_Clustering* const clustering,
 
 		for (size_t i = 0; i < clustering->num_clusters; ++i) {
 			if (cluster_sizes[i] < size_constraint) {
-				free(cluster_sizes);
+				iscc_free(cluster_sizes);
 				return iscc_no_error(); // Error found, return. (`out_is_OK` is set to false)
 			}
 		}
 
-		free(cluster_sizes);
+		iscc_free(cluster_sizes);
 
 	} else { // num_types >= 2
 
-		size_t* const cluster_type_sizes = calloc(num_types * clustering->num_clusters, sizeof(size_t));
+		size_t* const cluster_type_sizes = iscc_calloc(num_types * clustering->num_clusters, sizeof(size_t));
 		if (cluster_type_sizes == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 
 		for (size_t i = 0; i < clustering->num_data_points; ++i) {
@@ -152,17 +166,17 @@ scc_ErrorCode scc_check_clustering(const scc_Clustering* const clustering,
 			for (size_t t = 0; t < num_types; ++t) {
 				tmp_total_size += cluster_type_sizes[(i * num_types) + t];
 				if (cluster_type_sizes[(i * num_types) + t] < type_constraints[t]) {
-					free(cluster_type_sizes);
+					iscc_free(cluster_type_sizes);
 					return iscc_no_error(); // Error found, return. (`out_is_OK` is set to false)
 				}
 			}
 			if (tmp_total_size < size_constraint) {
-				free(cluster_type_sizes);
+				iscc_free(cluster_type_sizes);
 				return iscc_no_error(); // Error found, return. (`out_is_OK` is set to false)
 			}
 		}
 
-		free(cluster_type_sizes);
+		iscc_free(cluster_type_sizes);
 
 	}
 
@@ -192,7 +206,7 @@ scc_ErrorCode scc_get_clustering_stats(void* const data_set,
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Number of data points in data set does not match clustering object.");
 	}
 
-	size_t* const cluster_size = calloc(clustering->num_clusters, sizeof(size_t));
+	size_t* const cluster_size = iscc_calloc(clustering->num_clusters, sizeof(size_t));
 	if (cluster_size == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
 
 	for (size_t i = 0; i < clustering->num_data_points; ++i) {
@@ -231,20 +245,20 @@ scc_ErrorCode scc_get_clustering_stats(void* const data_set,
 	}
 
 	if (tmp_stats.num_populated_clusters == 0) {
-		free(cluster_size);
+		iscc_free(cluster_size);
 		*out_stats = tmp_stats;
 		return iscc_no_error();
 	}
 
 	const size_t largest_dist_matrix = (tmp_stats.max_cluster_size * (tmp_stats.max_cluster_size - 1)) / 2;
-	scc_PointIndex* const id_store = malloc(sizeof(scc_PointIndex[tmp_stats.num_assigned]));
-	scc_PointIndex** const cl_members = malloc(sizeof(scc_PointIndex*[clustering->num_clusters]));
-	double* const dist_scratch = malloc(sizeof(double[largest_dist_matrix]));
+	scc_PointIndex* const id_store = iscc_malloc(sizeof(scc_PointIndex[tmp_stats.num_assigned]));
+	scc_PointIndex** const cl_members = iscc_malloc(sizeof(scc_PointIndex*[clustering->num_clusters]));
+	double* const dist_scratch = iscc_malloc(sizeof(double[largest_dist_matrix]));
 	if ((id_store == NULL) || (cl_members == NULL) || (dist_scratch == NULL)) {
-		free(cluster_size);
-		free(id_store);
-		free(cl_members);
-		free(dist_scratch);
+		iscc_free(cluster_size);
+		iscc_free(id_store);
+		iscc_free(cl_members);
+		iscc_free(dist_scratch);
 		return iscc_make_error(SCC_ER_NO_MEMORY);
 	}
 
@@ -270,10 +284,10 @@ scc_ErrorCode scc_get_clustering_stats(void* const data_set,
 
 		const size_t size_dist_matrix = (cluster_size[c] * (cluster_size[c] - 1)) / 2;
 		if (!iscc_get_dist_matrix(data_set, cluster_size[c], cl_members[c], dist_scratch)) {
-			free(cluster_size);
-			free(id_store);
-			free(cl_members);
-			free(dist_scratch);
+			iscc_free(cluster_size);
+			iscc_free(id_store);
+			iscc_free(cl_members);
+			iscc_free(dist_scratch);
 			return iscc_make_error(SCC_ER_DIST_SEARCH_ERROR);
 		}
 
@@ -312,10 +326,10 @@ scc_ErrorCode scc_get_clustering_stats(void* const data_set,
 	tmp_stats.avg_dist_weighted = tmp_stats.avg_dist_weighted / ((double) tmp_stats.num_assigned);
 	tmp_stats.avg_dist_unweighted = tmp_stats.avg_dist_unweighted / ((double) tmp_stats.num_populated_clusters);
 
-	free(cluster_size);
-	free(id_store);
-	free(cl_members);
-	free(dist_scratch);
+	iscc_free(cluster_size);
+	iscc_free(id_store);
+	iscc_free(cl_members);
+	iscc_free(dist_scratch);
 
 	*out_stats = tmp_stats;
 
@@ -376,6 +390,31 @@ scc_ErrorCode iscc_check_cluster_options(const scc_ClusterOptions* const options
 			(options->seed_method != SCC_SM_EXCLUSION_UPDATING)) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Unknown seed method.");
 	}
+	if (options->seed_portfolio != 0) {
+		const uint32_t valid_portfolio = (UINT32_C(1) << SCC_SM_LEXICAL) |
+		                                 (UINT32_C(1) << SCC_SM_INWARDS_ORDER) |
+		                                 (UINT32_C(1) << SCC_SM_INWARDS_UPDATING) |
+		                                 (UINT32_C(1) << SCC_SM_EXCLUSION_ORDER) |
+		                                 (UINT32_C(1) << SCC_SM_EXCLUSION_UPDATING);
+		if ((options->seed_portfolio & ~valid_portfolio) != 0) {
+			return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid seed portfolio.");
+		}
+		if (options->seed_method == SCC_SM_BATCHES) {
+			return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "SCC_SM_BATCHES cannot be used with a seed portfolio.");
+		}
+	}
+	if ((options->seed_method != SCC_SM_BATCHES) || (options->seed_portfolio != 0)) {
+		if (options->adaptive_batch_size || (options->batch_stats != NULL)) {
+			return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Batch options require SCC_SM_BATCHES.");
+		}
+	}
+	if (!options->adaptive_batch_size && (options->max_batch_bytes != 0)) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "`max_batch_bytes` requires `adaptive_batch_size`.");
+	}
+	if ((options->max_batch_bytes != 0) &&
+			(options->max_batch_bytes < (((size_t) options->size_constraint) + 1) * sizeof(scc_PointIndex))) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "`max_batch_bytes` is too small for a single query.");
+	}
 	if ((options->primary_data_points != NULL) && (options->len_primary_data_points == 0)) {
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid primary data points.");
 	}
@@ -430,17 +469,51 @@ scc_ErrorCode iscc_check_cluster_options(const scc_ClusterOptions* const options
 		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid radius.");
 	}
 
-	if (options->seed_method == SCC_SM_BATCHES) {
-		if (options->num_types >= 2) {
-			return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "SCC_SM_BATCHES cannot be used with type constraints.");
-		}
-		if (options->secondary_unassigned_method != SCC_UM_IGNORE) {
-			return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "SCC_SM_BATCHES must be used with `secondary_unassigned_method = SCC_UM_IGNORE`.");
-		}
-		if (options->primary_radius != SCC_RM_USE_SEED_RADIUS) {
-			return iscc_make_error_msg(SCC_ER_NOT_IMPLEMENTED, "SCC_SM_BATCHES must be used with `primary_radius = SCC_RM_USE_SEED_RADIUS`.");
+	return iscc_no_error();
+}
+
+
+void iscc_sort_point_indices(const size_t len,
+                             scc_PointIndex indices[restrict const])
+{
+	assert(len == 0 || indices != NULL);
+
+	// Rows in NNGs are short, where insertion sort beats `qsort`
+	if (len <= 32) {
+		for (size_t i = 1; i < len; ++i) {
+			const scc_PointIndex tmp = indices[i];
+			size_t j = i;
+			for (; (j > 0) && (indices[j - 1] > tmp); --j) {
+				indices[j] = indices[j - 1];
+			}
+			indices[j] = tmp;
 		}
+	} else {
+		qsort(indices, len, sizeof(scc_PointIndex), iscc_compare_PointIndex);
 	}
+}
 
-	return iscc_no_error();
+
+int iscc_capped_num_threads(const int max_threads,
+                            const size_t per_thread_len,
+                            const size_t total_len)
+{
+	assert(max_threads > 0);
+
+	if (per_thread_len == 0) return max_threads;
+	const size_t cap = total_len / per_thread_len;
+	if (cap < 1) return 1;
+	return (cap < (size_t) max_threads) ? (int) cap : max_threads;
+}
+
+
+// =============================================================================
+// Static function implementations
+// =============================================================================
+
+static int iscc_compare_PointIndex(const void* const a, const void* const b)
+{
+    const scc_PointIndex arg1 = *(const scc_PointIndex* const)a;
+    const scc_PointIndex arg2 = *(const scc_PointIndex* const)b;
+    return (arg1 > arg2) - (arg1 < arg2);
 }
@@ -33,4 +33,16 @@ scc_ErrorCode iscc_check_cluster_options(const scc_ClusterOptions* options,
                                          size_t num_data_points);
 
 
+void iscc_sort_point_indices(size_t len,
+                             scc_PointIndex indices[]);
+
+
+// Number of threads, at most `max_threads` and at least one, such that per-thread
+// arrays of `per_thread_len` elements together hold no more than `total_len` elements.
+// Parallel kernels use it to keep their scratch memory linear in the input.
+int iscc_capped_num_threads(int max_threads,
+                            size_t per_thread_len,
+                            size_t total_len);
+
+
 #endif // ifndef SCC_UTILITIES_HG
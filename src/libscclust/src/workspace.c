@@ -0,0 +1,453 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "workspace.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/scclust.h"
+#include "error.h"
+
+
+// =============================================================================
+// Internal structs and variables
+// =============================================================================
+
+// Blocks are rounded up to powers of two, from 2^ISCC_WS_MIN_CLASS bytes up to 4 MiB.
+// Larger blocks bypass the workspace, so rounding never wastes more than a few MiB
+// per block and large blocks are resized in place.
+enum {
+	ISCC_WS_MIN_CLASS = 6,
+	ISCC_WS_NUM_CLASSES = 17,
+};
+
+static const uint32_t ISCC_WS_NO_CLASS = UINT32_MAX;
+
+
+// Each thread has its own active workspace
+#if defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L)
+	#define ISCC_WS_THREAD_LOCAL _Thread_local
+#elif defined(__GNUC__)
+	#define ISCC_WS_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+	#define ISCC_WS_THREAD_LOCAL __declspec(thread)
+#else
+	#define ISCC_WS_THREAD_LOCAL
+#endif
+
+
+// Placed in front of all memory handed out by `iscc_malloc`, aligned as `malloc`
+typedef union iscc_ws_Header {
+	struct {
+		size_t capacity;
+		uint32_t size_class;
+		uint32_t workspace_id;
+	} info;
+	union iscc_ws_Header* next_free;
+	long double align_ld;
+	uintmax_t align_int;
+	void* align_ptr;
+} iscc_ws_Header;
+
+
+struct scc_Workspace {
+	uint32_t workspace_id;
+	scc_Workspace* next_workspace;
+	iscc_ws_Header* free_blocks[ISCC_WS_NUM_CLASSES];
+	bool class_used[ISCC_WS_NUM_CLASSES];
+	uint64_t used_bytes;
+	uint64_t high_water_bytes;
+	uint64_t cached_bytes;
+	uint64_t num_allocations;
+	uint64_t num_reused;
+};
+
+
+static ISCC_WS_THREAD_LOCAL scc_Workspace* iscc_active_workspace = NULL;
+
+// All live workspaces, so blocks freed in other threads find their way back
+static scc_Workspace* iscc_workspaces = NULL;
+static uint32_t iscc_next_workspace_id = 1;
+
+
+// =============================================================================
+// Static function prototypes
+// =============================================================================
+
+static void* iscc_ws_plain_alloc(size_t size);
+
+
+static void* iscc_ws_alloc(scc_Workspace* ws,
+                           uint32_t size_class);
+
+
+static void iscc_ws_release(scc_Workspace* ws,
+                            iscc_ws_Header* header);
+
+
+static void iscc_ws_free_cached(scc_Workspace* ws,
+                                uint32_t size_class);
+
+
+static scc_Workspace* iscc_ws_find_owner(const iscc_ws_Header* header);
+
+
+static uint32_t iscc_ws_size_class(size_t size);
+
+
+// =============================================================================
+// Public function implementations
+// =============================================================================
+
+scc_ErrorCode scc_init_workspace(scc_Workspace** const out_workspace)
+{
+	if (out_workspace == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid output pointer.");
+	}
+
+	scc_Workspace* const tmp_ws = malloc(sizeof(scc_Workspace));
+	if (tmp_ws == NULL) return iscc_make_error(SCC_ER_NO_MEMORY);
+
+	*tmp_ws = (scc_Workspace) {
+		.workspace_id = 0,
+		.next_workspace = NULL,
+		.used_bytes = 0,
+		.high_water_bytes = 0,
+		.cached_bytes = 0,
+		.num_allocations = 0,
+		.num_reused = 0,
+	};
+	for (size_t c = 0; c < ISCC_WS_NUM_CLASSES; ++c) {
+		tmp_ws->free_blocks[c] = NULL;
+		tmp_ws->class_used[c] = false;
+	}
+
+	#ifdef _OPENMP
+		#pragma omp critical(iscc_workspace)
+	#endif
+	{
+		tmp_ws->workspace_id = iscc_next_workspace_id;
+		++iscc_next_workspace_id;
+		if (iscc_next_workspace_id == 0) iscc_next_workspace_id = 1;
+		tmp_ws->next_workspace = iscc_workspaces;
+		iscc_workspaces = tmp_ws;
+	}
+
+	*out_workspace = tmp_ws;
+
+	return iscc_no_error();
+}
+
+
+void scc_free_workspace(scc_Workspace** const workspace)
+{
+	if ((workspace != NULL) && (*workspace != NULL)) {
+		// Other threads must stop using the workspace before it is freed, as their
+		// active workspace cannot be cleared from here
+		if (iscc_active_workspace == *workspace) iscc_active_workspace = NULL;
+		#ifdef _OPENMP
+			#pragma omp critical(iscc_workspace)
+		#endif
+		{
+			scc_Workspace** link = &iscc_workspaces;
+			while (*link != *workspace) {
+				assert(*link != NULL);
+				link = &(*link)->next_workspace;
+			}
+			*link = (*workspace)->next_workspace;
+		}
+		for (uint32_t c = 0; c < ISCC_WS_NUM_CLASSES; ++c) {
+			iscc_ws_free_cached(*workspace, c);
+		}
+		free(*workspace);
+		*workspace = NULL;
+	}
+}
+
+
+scc_ErrorCode scc_set_workspace(scc_Workspace* const workspace)
+{
+	iscc_active_workspace = workspace;
+	return iscc_no_error();
+}
+
+
+scc_ErrorCode scc_reset_workspace(scc_Workspace* const workspace)
+{
+	if (workspace == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid workspace.");
+	}
+
+	#ifdef _OPENMP
+		#pragma omp critical(iscc_workspace)
+	#endif
+	{
+		// Blocks of sizes not asked for since the last reset are not likely to be reused
+		for (uint32_t c = 0; c < ISCC_WS_NUM_CLASSES; ++c) {
+			if (!workspace->class_used[c]) iscc_ws_free_cached(workspace, c);
+			workspace->class_used[c] = false;
+		}
+		workspace->high_water_bytes = workspace->used_bytes;
+		workspace->num_allocations = 0;
+		workspace->num_reused = 0;
+	}
+
+	return iscc_no_error();
+}
+
+
+scc_ErrorCode scc_get_workspace_stats(const scc_Workspace* const workspace,
+                                      scc_WorkspaceStats* const out_stats)
+{
+	if (workspace == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid workspace.");
+	}
+	if (out_stats == NULL) {
+		return iscc_make_error_msg(SCC_ER_INVALID_INPUT, "Invalid output pointer.");
+	}
+
+	*out_stats = (scc_WorkspaceStats) {
+		.used_bytes = workspace->used_bytes,
+		.high_water_bytes = workspace->high_water_bytes,
+		.cached_bytes = workspace->cached_bytes,
+		.num_allocations = workspace->num_allocations,
+		.num_reused = workspace->num_reused,
+	};
+
+	return iscc_no_error();
+}
+
+
+// =============================================================================
+// External function implementations
+// =============================================================================
+
+void* iscc_malloc(const size_t size)
+{
+	scc_Workspace* const ws = iscc_active_workspace;
+	const uint32_t size_class = iscc_ws_size_class(size);
+	if ((ws == NULL) || (size_class == ISCC_WS_NO_CLASS)) return iscc_ws_plain_alloc(size);
+
+	void* ptr;
+	// Seed methods may run concurrently (see `seed_portfolio`)
+	#ifdef _OPENMP
+		#pragma omp critical(iscc_workspace)
+	#endif
+	ptr = iscc_ws_alloc(ws, size_class);
+
+	return ptr;
+}
+
+
+void* iscc_calloc(const size_t num,
+                  const size_t size)
+{
+	if ((size != 0) && (num > SIZE_MAX / size)) return NULL;
+	void* const ptr = iscc_malloc(num * size);
+	if (ptr != NULL) memset(ptr, 0, num * size);
+	return ptr;
+}
+
+
+void* iscc_realloc(void* const ptr,
+                   const size_t size)
+{
+	if (ptr == NULL) return iscc_malloc(size);
+
+	iscc_ws_Header* const header = ((iscc_ws_Header*) ptr) - 1;
+
+	if (header->info.size_class == ISCC_WS_NO_CLASS) {
+		// Plain blocks, including those above the largest class, are resized in place
+		if (size > SIZE_MAX - sizeof(iscc_ws_Header)) return NULL;
+		iscc_ws_Header* const new_header = realloc(header, sizeof(iscc_ws_Header) + size);
+		if (new_header == NULL) return NULL;
+		new_header->info.capacity = size;
+		return new_header + 1;
+	}
+
+	if (size <= header->info.capacity) {
+		// Move to a smaller block when a smaller class fits, so shrinking gives memory back
+		if (iscc_ws_size_class(size) >= header->info.size_class) return ptr;
+		void* const new_ptr = iscc_malloc(size);
+		if (new_ptr == NULL) return ptr;
+		memcpy(new_ptr, ptr, size);
+		iscc_free(ptr);
+		return new_ptr;
+	}
+
+	void* const new_ptr = iscc_malloc(size);
+	if (new_ptr == NULL) return NULL;
+	memcpy(new_ptr, ptr, header->info.capacity);
+	iscc_free(ptr);
+
+	return new_ptr;
+}
+
+
+void iscc_free(void* const ptr)
+{
+	if (ptr == NULL) return;
+
+	iscc_ws_Header* const header = ((iscc_ws_Header*) ptr) - 1;
+
+	if (header->info.size_class == ISCC_WS_NO_CLASS) {
+		free(header);
+		return;
+	}
+
+	// The block may be freed in another thread than it was allocated in
+	#ifdef _OPENMP
+		#pragma omp critical(iscc_workspace)
+	#endif
+	{
+		scc_Workspace* const ws = iscc_ws_find_owner(header);
+		if (ws != NULL) {
+			iscc_ws_release(ws, header);
+		} else {
+			// Workspace is freed, give back to the system
+			free(header);
+		}
+	}
+}
+
+
+// =============================================================================
+// Static function implementations
+// =============================================================================
+
+static void* iscc_ws_plain_alloc(const size_t size)
+{
+	if (size > SIZE_MAX - sizeof(iscc_ws_Header)) return NULL;
+
+	iscc_ws_Header* const header = malloc(sizeof(iscc_ws_Header) + size);
+	if (header == NULL) return NULL;
+
+	header->info.capacity = size;
+	header->info.size_class = ISCC_WS_NO_CLASS;
+	header->info.workspace_id = 0;
+
+	return header + 1;
+}
+
+
+static void* iscc_ws_alloc(scc_Workspace* const ws,
+                           const uint32_t size_class)
+{
+	assert(ws != NULL);
+	assert(size_class < ISCC_WS_NUM_CLASSES);
+
+	const size_t block_size = ((size_t) 1) << (size_class + ISCC_WS_MIN_CLASS);
+
+	iscc_ws_Header* header = ws->free_blocks[size_class];
+	if (header != NULL) {
+		ws->free_blocks[size_class] = header->next_free;
+		ws->cached_bytes -= block_size;
+		++ws->num_reused;
+	} else {
+		header = malloc(block_size);
+		if (header == NULL) return NULL;
+	}
+
+	header->info.capacity = block_size - sizeof(iscc_ws_Header);
+	header->info.size_class = size_class;
+	header->info.workspace_id = ws->workspace_id;
+
+	ws->class_used[size_class] = true;
+	++ws->num_allocations;
+	ws->used_bytes += block_size;
+	if (ws->high_water_bytes < ws->used_bytes) ws->high_water_bytes = ws->used_bytes;
+
+	return header + 1;
+}
+
+
+static void iscc_ws_release(scc_Workspace* const ws,
+                            iscc_ws_Header* const header)
+{
+	assert(ws != NULL);
+	assert(header->info.size_class < ISCC_WS_NUM_CLASSES);
+	assert(header->info.workspace_id == ws->workspace_id);
+
+	const uint32_t size_class = header->info.size_class;
+	const size_t block_size = ((size_t) 1) << (size_class + ISCC_WS_MIN_CLASS);
+
+	assert(ws->used_bytes >= block_size);
+	ws->used_bytes -= block_size;
+	ws->cached_bytes += block_size;
+
+	header->next_free = ws->free_blocks[size_class];
+	ws->free_blocks[size_class] = header;
+}
+
+
+static void iscc_ws_free_cached(scc_Workspace* const ws,
+                                const uint32_t size_class)
+{
+	assert(ws != NULL);
+	assert(size_class < ISCC_WS_NUM_CLASSES);
+
+	const size_t block_size = ((size_t) 1) << (size_class + ISCC_WS_MIN_CLASS);
+
+	iscc_ws_Header* block = ws->free_blocks[size_class];
+	while (block != NULL) {
+		iscc_ws_Header* const next = block->next_free;
+		free(block);
+		assert(ws->cached_bytes >= block_size);
+		ws->cached_bytes -= block_size;
+		block = next;
+	}
+	ws->free_blocks[size_class] = NULL;
+}
+
+
+// Live workspace that handed out `header`, `NULL` if it is freed. Call in critical section.
+static scc_Workspace* iscc_ws_find_owner(const iscc_ws_Header* const header)
+{
+	assert(header->info.size_class < ISCC_WS_NUM_CLASSES);
+
+	scc_Workspace* ws = iscc_active_workspace;
+	if ((ws != NULL) && (ws->workspace_id == header->info.workspace_id)) return ws;
+
+	for (ws = iscc_workspaces; ws != NULL; ws = ws->next_workspace) {
+		if (ws->workspace_id == header->info.workspace_id) return ws;
+	}
+
+	return NULL;
+}
+
+
+// Smallest class that fits `size` bytes and the header, `ISCC_WS_NO_CLASS` if none
+static uint32_t iscc_ws_size_class(const size_t size)
+{
+	if (size > SIZE_MAX / 4) return ISCC_WS_NO_CLASS;
+
+	const size_t needed = size + sizeof(iscc_ws_Header);
+	uint32_t size_class = 0;
+	while ((((size_t) 1) << (size_class + ISCC_WS_MIN_CLASS)) < needed) {
+		++size_class;
+		if (size_class == ISCC_WS_NUM_CLASSES) return ISCC_WS_NO_CLASS;
+	}
+
+	return size_class;
+}
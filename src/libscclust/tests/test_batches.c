@@ -0,0 +1,233 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+
+#include "test_suite.h"
+
+#define NUM_DATA_POINTS 6000
+#define SIZE_CONSTRAINT 3
+
+static double* data;
+static scc_DataSet* data_set;
+static scc_PointIndex primary_data_points[NUM_DATA_POINTS];
+static size_t len_primary_data_points;
+
+
+static void check_stats(const scc_BatchStats* const stats,
+                        const uint32_t max_batch_size)
+{
+	ts_assert(stats->num_batches > 0);
+	ts_assert(stats->num_queries >= stats->num_batches);
+	ts_assert(stats->num_queries <= NUM_DATA_POINTS);
+	ts_assert(stats->num_queries <= stats->num_batches * stats->max_batch_size);
+	ts_assert(stats->wasted_queries <= stats->num_queries);
+	ts_assert(stats->min_batch_size > 0);
+	ts_assert(stats->min_batch_size <= stats->max_batch_size);
+	ts_assert(stats->max_batch_size <= max_batch_size);
+	ts_assert(stats->final_batch_size > 0);
+	ts_assert(stats->final_batch_size <= max_batch_size);
+}
+
+
+static void test_same_as_default_batches(void)
+{
+	const uint32_t initial_sizes[4] = { 0, 1, 16, 5000 };
+	const size_t max_bytes[3] = { 0, 20 * (SIZE_CONSTRAINT + 1) * sizeof(scc_PointIndex), 100000 };
+
+	for (int primary = 0; primary < 2; ++primary) {
+		const scc_PointIndex* const primary_points = primary ? primary_data_points : NULL;
+		const scc_ClusterOptions default_options = ts_cluster_options(SIZE_CONSTRAINT, SCC_SM_BATCHES, len_primary_data_points, primary_points);
+		scc_Clabel* const default_labels = ts_sc_clustering(data_set, NUM_DATA_POINTS, &default_options);
+
+		// Fixed batches also report their sizes
+		for (size_t s = 1; s < 4; ++s) {
+			scc_BatchStats stats;
+			scc_ClusterOptions options = ts_cluster_options(SIZE_CONSTRAINT, SCC_SM_BATCHES, len_primary_data_points, primary_points);
+			options.batch_size = initial_sizes[s];
+			options.batch_stats = &stats;
+			scc_Clabel* const labels = ts_sc_clustering(data_set, NUM_DATA_POINTS, &options);
+			ts_assert(ts_same_labels(NUM_DATA_POINTS, labels, default_labels));
+			check_stats(&stats, initial_sizes[s]);
+			ts_assert(stats.max_batch_size == initial_sizes[s]);
+			ts_assert(stats.final_batch_size == initial_sizes[s]);
+			free(labels);
+		}
+
+		for (int threads = 1; threads <= 3; threads += 2) {
+			ts_set_num_threads(threads);
+			for (size_t s = 0; s < 4; ++s) {
+				for (size_t b = 0; b < 3; ++b) {
+					scc_BatchStats stats;
+					scc_ClusterOptions options = ts_cluster_options(SIZE_CONSTRAINT, SCC_SM_BATCHES, len_primary_data_points, primary_points);
+					options.batch_size = initial_sizes[s];
+					options.adaptive_batch_size = true;
+					options.max_batch_bytes = max_bytes[b];
+					options.batch_stats = &stats;
+					scc_Clabel* const labels = ts_sc_clustering(data_set, NUM_DATA_POINTS, &options);
+					ts_assert(ts_same_labels(NUM_DATA_POINTS, labels, default_labels));
+
+					const uint32_t max_batch_size = (max_bytes[b] == 0) ? NUM_DATA_POINTS :
+						(uint32_t) (max_bytes[b] / ((SIZE_CONSTRAINT + 1) * sizeof(scc_PointIndex)));
+					check_stats(&stats, max_batch_size);
+
+					free(labels);
+				}
+			}
+		}
+		ts_set_num_threads(1);
+
+		free(default_labels);
+	}
+}
+
+
+// The built-in search drops assigned points from its index between batches. User supplied
+// functions keep the full index, and lexical seeds are found without batches.
+static void check_same_as_full_index(void* const test_data_set,
+                                     const size_t len_primary,
+                                     const scc_PointIndex primary[const])
+{
+	for (uint32_t size_constraint = 2; size_constraint <= 5; size_constraint += 3) {
+		scc_ClusterOptions options = ts_cluster_options(size_constraint, SCC_SM_BATCHES, len_primary, primary);
+		options.batch_size = 16;
+		scc_Clabel* const labels = ts_sc_clustering_all_threads(test_data_set, NUM_DATA_POINTS, &options, 4);
+
+		ts_use_user_dist_functions();
+		scc_Clabel* const full_index_labels = ts_sc_clustering_all_threads(test_data_set, NUM_DATA_POINTS, &options, 4);
+		ts_assert(scc_reset_dist_functions());
+		ts_assert(ts_same_labels(NUM_DATA_POINTS, labels, full_index_labels));
+
+		options = ts_cluster_options(size_constraint, SCC_SM_LEXICAL, len_primary, primary);
+		scc_Clabel* const lexical_labels = ts_sc_clustering(test_data_set, NUM_DATA_POINTS, &options);
+		ts_assert(ts_same_labels(NUM_DATA_POINTS, labels, lexical_labels));
+
+		free(labels);
+		free(full_index_labels);
+		free(lexical_labels);
+	}
+}
+
+
+static void test_same_as_full_index(void)
+{
+	check_same_as_full_index(data_set, 0, NULL);
+	check_same_as_full_index(data_set, len_primary_data_points, primary_data_points);
+
+	// Points on a grid, so most distances are tied
+	double* const tied_data = malloc(sizeof(double[NUM_DATA_POINTS * 2]));
+	ts_assert(tied_data != NULL);
+	for (size_t i = 0; i < NUM_DATA_POINTS; ++i) {
+		tied_data[2 * i] = (double) (i % 100);
+		tied_data[2 * i + 1] = (double) (i / 100);
+	}
+	scc_DataSet* tied_data_set = ts_data_set(NUM_DATA_POINTS, 2, tied_data);
+
+	check_same_as_full_index(tied_data_set, 0, NULL);
+	check_same_as_full_index(tied_data_set, len_primary_data_points, primary_data_points);
+
+	scc_free_data_set(&tied_data_set);
+	free(tied_data);
+}
+
+
+static void test_adapts_batch_size(void)
+{
+	scc_BatchStats stats;
+	scc_ClusterOptions options = ts_cluster_options(SIZE_CONSTRAINT, SCC_SM_BATCHES, 0, NULL);
+	options.batch_size = 16;
+	options.adaptive_batch_size = true;
+	options.batch_stats = &stats;
+	scc_Clabel* const labels = ts_sc_clustering(data_set, NUM_DATA_POINTS, &options);
+	check_stats(&stats, NUM_DATA_POINTS);
+	ts_assert(stats.min_batch_size < stats.max_batch_size);
+	free(labels);
+}
+
+
+static void check_invalid(const scc_ClusterOptions* const options)
+{
+	scc_Clustering* clustering;
+	ts_assert_ok(scc_init_empty_clustering(NUM_DATA_POINTS, NULL, &clustering));
+	ts_assert(scc_sc_clustering(data_set, options, clustering) == SCC_ER_INVALID_INPUT);
+	scc_free_clustering(&clustering);
+
+	scc_ResourceEstimate estimate;
+	ts_assert(scc_estimate_resources(data_set, options, &estimate) == SCC_ER_INVALID_INPUT);
+}
+
+
+static void test_invalid_options(void)
+{
+	scc_BatchStats stats;
+
+	scc_ClusterOptions options = ts_cluster_options(SIZE_CONSTRAINT, SCC_SM_BATCHES, 0, NULL);
+	options.seed_method = SCC_SM_LEXICAL;
+	options.adaptive_batch_size = true;
+	check_invalid(&options);
+
+	options = ts_cluster_options(SIZE_CONSTRAINT, SCC_SM_BATCHES, 0, NULL);
+	options.seed_method = SCC_SM_INWARDS_UPDATING;
+	options.batch_stats = &stats;
+	check_invalid(&options);
+
+	options = ts_cluster_options(SIZE_CONSTRAINT, SCC_SM_BATCHES, 0, NULL);
+	options.seed_portfolio = UINT32_C(1) << SCC_SM_LEXICAL;
+	options.seed_method = SCC_SM_LEXICAL;
+	options.batch_stats = &stats;
+	check_invalid(&options);
+
+	options = ts_cluster_options(SIZE_CONSTRAINT, SCC_SM_BATCHES, 0, NULL);
+	options.max_batch_bytes = 100000;
+	check_invalid(&options);
+
+	options = ts_cluster_options(SIZE_CONSTRAINT, SCC_SM_BATCHES, 0, NULL);
+	options.adaptive_batch_size = true;
+	options.max_batch_bytes = (SIZE_CONSTRAINT + 1) * sizeof(scc_PointIndex) - 1;
+	check_invalid(&options);
+
+	// One query fits
+	options.max_batch_bytes = (SIZE_CONSTRAINT + 1) * sizeof(scc_PointIndex);
+	options.batch_stats = &stats;
+	scc_Clabel* const labels = ts_sc_clustering(data_set, NUM_DATA_POINTS, &options);
+	check_stats(&stats, 1);
+	free(labels);
+}
+
+
+int main(void)
+{
+	printf("test_batches\n");
+
+	data = ts_random_data(NUM_DATA_POINTS, 2, 0);
+	data_set = ts_data_set(NUM_DATA_POINTS, 2, data);
+	for (size_t i = 0; i < NUM_DATA_POINTS; ++i) {
+		if (i % 3 == 0) primary_data_points[len_primary_data_points++] = (scc_PointIndex) i;
+	}
+
+	ts_run_test(test_same_as_default_batches);
+	ts_run_test(test_same_as_full_index);
+	ts_run_test(test_adapts_batch_size);
+	ts_run_test(test_invalid_options);
+
+	scc_free_data_set(&data_set);
+	free(data);
+
+	return 0;
+}
@@ -0,0 +1,193 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "test_suite.h"
+#include "../src/digraph_core.h"
+#include "../src/digraph_operations.h"
+#include "../src/nng_findseeds.h"
+#include "../src/workspace.h"
+
+#define NUM_VERTICES 20000
+#define NUM_PRIMARY 200
+#define ARCS_PER_PRIMARY 3
+
+static const scc_SeedMethod nng_methods[5] = {
+	SCC_SM_LEXICAL,
+	SCC_SM_INWARDS_ORDER,
+	SCC_SM_INWARDS_UPDATING,
+	SCC_SM_EXCLUSION_ORDER,
+	SCC_SM_EXCLUSION_UPDATING,
+};
+
+
+static uint64_t next_random(uint64_t* const state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 7;
+	*state ^= *state << 17;
+	return *state;
+}
+
+
+// NNG with arcs only from `NUM_PRIMARY` tails, as with few primary data points. Heads
+// are drawn from a limited range so that neighborhoods overlap.
+static iscc_Digraph sparse_nng(void)
+{
+	uint64_t state = 88172645463325252u;
+	iscc_Digraph nng;
+	ts_assert_ok(iscc_init_digraph(NUM_VERTICES, NUM_PRIMARY * ARCS_PER_PRIMARY, &nng));
+	size_t arcs = 0;
+	for (scc_PointIndex v = 0; v < NUM_VERTICES; ++v) {
+		iscc_set_tail_ptr(&nng, v, arcs);
+		if (v % (NUM_VERTICES / NUM_PRIMARY) != 0) continue;
+		while (arcs < iscc_get_tail_ptr(&nng, v) + ARCS_PER_PRIMARY) {
+			const scc_PointIndex head = (scc_PointIndex) (next_random(&state) % (NUM_VERTICES / 4));
+			bool duplicate = (head == v);
+			for (size_t a = iscc_get_tail_ptr(&nng, v); a < arcs; ++a) {
+				duplicate = duplicate || (nng.head[a] == head);
+			}
+			if (!duplicate) nng.head[arcs++] = head;
+		}
+	}
+	iscc_set_tail_ptr(&nng, NUM_VERTICES, arcs);
+	return nng;
+}
+
+
+static void test_compact_digraph(void)
+{
+	iscc_Digraph nng = sparse_nng();
+
+	scc_PointIndex* vertex_ids;
+	iscc_Digraph compact;
+	ts_assert_ok(iscc_digraph_compact(&nng, NUM_VERTICES / 2, &vertex_ids, &compact));
+	ts_assert(vertex_ids != NULL);
+	ts_assert(compact.vertices < NUM_VERTICES / 2);
+	ts_assert(iscc_digraph_arcs(&compact) == iscc_digraph_arcs(&nng));
+
+	// Renumbered in original order, with the same arcs
+	for (scc_PointIndex v = 1; v < (scc_PointIndex) compact.vertices; ++v) {
+		ts_assert(vertex_ids[v - 1] < vertex_ids[v]);
+	}
+	for (scc_PointIndex v = 0; v < (scc_PointIndex) compact.vertices; ++v) {
+		const scc_PointIndex* const arc_stop = iscc_arc_stop(&compact, v);
+		const scc_PointIndex* orig_arc = iscc_arc_start(&nng, vertex_ids[v]);
+		ts_assert((size_t) (arc_stop - iscc_arc_start(&compact, v)) ==
+		          (size_t) (iscc_arc_stop(&nng, vertex_ids[v]) - orig_arc));
+		for (const scc_PointIndex* arc = iscc_arc_start(&compact, v); arc != arc_stop; ++arc, ++orig_arc) {
+			ts_assert(vertex_ids[*arc] == *orig_arc);
+		}
+	}
+
+	iscc_free(vertex_ids);
+	iscc_free_digraph(&compact);
+
+	// Not derived when too many vertices remain
+	ts_assert_ok(iscc_digraph_compact(&nng, 10, &vertex_ids, &compact));
+	ts_assert(vertex_ids == NULL);
+
+	iscc_free_digraph(&nng);
+}
+
+
+static void test_same_seeds_as_full_nng(void)
+{
+	iscc_Digraph nng = sparse_nng();
+
+	scc_PointIndex* vertex_ids;
+	iscc_Digraph compact;
+	ts_assert_ok(iscc_digraph_compact(&nng, NUM_VERTICES / 2, &vertex_ids, &compact));
+	ts_assert(vertex_ids != NULL);
+
+	for (int stable = 0; stable < 2; ++stable) {
+		for (size_t m = 0; m < 5; ++m) {
+			iscc_SeedResult full_seeds = { .capacity = 1 + NUM_VERTICES / ARCS_PER_PRIMARY, .count = 0, .seeds = NULL };
+			ts_assert_ok(iscc_find_seeds(&nng, nng_methods[m], stable, &full_seeds));
+
+			iscc_SeedResult compact_seeds = { .capacity = 1 + compact.vertices / ARCS_PER_PRIMARY, .count = 0, .seeds = NULL };
+			ts_assert_ok(iscc_find_seeds(&compact, nng_methods[m], stable, &compact_seeds));
+
+			ts_assert(full_seeds.count > 0);
+			ts_assert(full_seeds.count == compact_seeds.count);
+			for (size_t i = 0; i < full_seeds.count; ++i) {
+				ts_assert(full_seeds.seeds[i] == vertex_ids[compact_seeds.seeds[i]]);
+			}
+
+			iscc_free(full_seeds.seeds);
+			iscc_free(compact_seeds.seeds);
+		}
+	}
+
+	iscc_free(vertex_ids);
+	iscc_free_digraph(&compact);
+	iscc_free_digraph(&nng);
+}
+
+
+// Clustering with few primary data points goes through the compacted NNG
+static void test_clustering_with_few_primary(void)
+{
+	const size_t num_data_points = 5000;
+	double* const data = ts_random_data(num_data_points, 2, 0);
+	scc_DataSet* data_set = ts_data_set(num_data_points, 2, data);
+
+	scc_PointIndex primary_data_points[50];
+	for (size_t p = 0; p < 50; ++p) {
+		primary_data_points[p] = (scc_PointIndex) (p * (num_data_points / 50));
+	}
+
+	for (size_t m = 0; m < 5; ++m) {
+		scc_ClusterOptions options = scc_get_default_options();
+		options.size_constraint = 3;
+		options.seed_method = nng_methods[m];
+		options.len_primary_data_points = 50;
+		options.primary_data_points = primary_data_points;
+		options.primary_unassigned_method = SCC_UM_CLOSEST_SEED;
+		scc_Clabel* const labels = ts_sc_clustering(data_set, num_data_points, &options);
+
+		size_t* const sizes = calloc(num_data_points, sizeof(size_t));
+		ts_assert(sizes != NULL);
+		for (size_t i = 0; i < num_data_points; ++i) {
+			if (labels[i] >= 0) ++sizes[labels[i]];
+		}
+		for (size_t p = 0; p < 50; ++p) {
+			ts_assert(labels[primary_data_points[p]] >= 0);
+			ts_assert(sizes[labels[primary_data_points[p]]] >= options.size_constraint);
+		}
+
+		free(sizes);
+		free(labels);
+	}
+
+	scc_free_data_set(&data_set);
+	free(data);
+}
+
+
+int main(void)
+{
+	printf("test_compact_seeds\n");
+
+	ts_run_test(test_compact_digraph);
+	ts_run_test(test_same_seeds_as_full_nng);
+	ts_run_test(test_clustering_with_few_primary);
+
+	return 0;
+}
@@ -0,0 +1,111 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "test_suite.h"
+#include "../src/digraph_core.h"
+#include "../src/digraph_operations.h"
+
+// Large enough for the parallel transpose
+#define NUM_VERTICES 15000
+#define ARCS_PER_VERTEX 4
+
+
+// Random digraph. With `skewed`, vertex 0 has arcs to all other vertices
+// and most other arcs point to a few vertices.
+static iscc_Digraph random_digraph(const bool skewed,
+                                   uint64_t state)
+{
+	iscc_Digraph dg;
+	ts_assert_ok(iscc_init_digraph(NUM_VERTICES, NUM_VERTICES * (ARCS_PER_VERTEX + 1), &dg));
+	size_t arcs = 0;
+	for (scc_PointIndex v = 0; v < NUM_VERTICES; ++v) {
+		iscc_set_tail_ptr(&dg, v, arcs);
+		if (skewed && (v == 0)) {
+			for (scc_PointIndex head = 1; head < NUM_VERTICES; ++head) {
+				dg.head[arcs++] = head;
+			}
+			continue;
+		}
+		const size_t row_arcs = (size_t) v % (ARCS_PER_VERTEX + 1);
+		for (size_t i = 0; i < row_arcs; ++i) {
+			state ^= state << 13;
+			state ^= state >> 7;
+			state ^= state << 17;
+			const uint64_t range = (skewed && (i > 0)) ? 3 : NUM_VERTICES;
+			const scc_PointIndex head = (scc_PointIndex) (state % range);
+			if (head != v) dg.head[arcs++] = head;
+		}
+	}
+	iscc_set_tail_ptr(&dg, NUM_VERTICES, arcs);
+	return dg;
+}
+
+
+static bool same_digraph(const iscc_Digraph* const dg_a,
+                         const iscc_Digraph* const dg_b)
+{
+	if (dg_a->vertices != dg_b->vertices) return false;
+	for (scc_PointIndex v = 0; v <= (scc_PointIndex) dg_a->vertices; ++v) {
+		if (iscc_get_tail_ptr(dg_a, v) != iscc_get_tail_ptr(dg_b, v)) return false;
+	}
+	return memcmp(dg_a->head, dg_b->head, sizeof(scc_PointIndex[iscc_digraph_arcs(dg_a)])) == 0;
+}
+
+
+static void test_transpose_independent_of_threads(void)
+{
+	for (int skewed = 0; skewed < 2; ++skewed) {
+		iscc_Digraph dg = random_digraph(skewed, 88172645463325252u);
+
+		ts_set_num_threads(1);
+		iscc_Digraph serial;
+		ts_assert_ok(iscc_digraph_transpose(&dg, &serial));
+
+		// Serial rows are in descending order of tails
+		for (scc_PointIndex v = 0; v < NUM_VERTICES; ++v) {
+			const scc_PointIndex* const arc_stop = iscc_arc_stop(&serial, v);
+			for (const scc_PointIndex* arc = iscc_arc_start(&serial, v); arc + 1 < arc_stop; ++arc) {
+				ts_assert(arc[0] >= arc[1]);
+			}
+		}
+
+		for (int threads = 2; threads <= 4; ++threads) {
+			ts_set_num_threads(threads);
+			iscc_Digraph parallel;
+			ts_assert_ok(iscc_digraph_transpose(&dg, &parallel));
+			ts_assert(same_digraph(&serial, &parallel));
+			iscc_free_digraph(&parallel);
+		}
+		ts_set_num_threads(1);
+
+		iscc_free_digraph(&serial);
+		iscc_free_digraph(&dg);
+	}
+}
+
+
+int main(void)
+{
+	printf("test_digraph_operations\n");
+
+	ts_run_test(test_transpose_independent_of_threads);
+
+	return 0;
+}
@@ -0,0 +1,230 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+
+#include "test_suite.h"
+
+// Large enough for parallel hierarchical clustering
+#define NUM_DATA_POINTS 6000
+
+static double* data;
+static scc_DataSet* data_set;
+
+
+static void test_k_way_size_constraint(void)
+{
+	const uint32_t size_constraints[3] = { 2, 3, 5 };
+	const uint32_t num_splits[4] = { 2, 3, 4, 7 };
+	for (size_t s = 0; s < 3; ++s) {
+		for (size_t k = 0; k < 4; ++k) {
+			const scc_HierarchicalOptions options = ts_hierarchical_options(size_constraints[s], num_splits[k]);
+			scc_Clabel* const labels = ts_hierarchical_clustering(data_set, NUM_DATA_POINTS, &options);
+			size_t num_clusters, min_size;
+			ts_cluster_sizes(NUM_DATA_POINTS, labels, &num_clusters, &min_size);
+			ts_assert(min_size >= size_constraints[s]);
+			ts_assert(num_clusters > 1);
+			free(labels);
+		}
+	}
+}
+
+
+static void test_k_way_independent_of_threads(void)
+{
+	const uint32_t num_splits[3] = { 3, 4, 7 };
+	for (size_t k = 0; k < 3; ++k) {
+		const scc_HierarchicalOptions options = ts_hierarchical_options(3, num_splits[k]);
+		free(ts_hierarchical_clustering_all_threads(data_set, NUM_DATA_POINTS, &options, 4));
+	}
+}
+
+
+// More splits than the size constraint allows is the same as the largest possible number
+static void test_large_num_splits(void)
+{
+	const size_t num_points = 200;
+	const uint32_t size_constraint = 3;
+	scc_DataSet* small_data_set = ts_data_set(num_points, 2, data);
+	scc_HierarchicalOptions options = ts_hierarchical_options(size_constraint, (uint32_t) (num_points / size_constraint));
+	scc_Clabel* const max_labels = ts_hierarchical_clustering(small_data_set, num_points, &options);
+
+	const uint32_t large_splits[3] = { (uint32_t) (num_points / size_constraint + 1), 1000000, UINT32_MAX };
+	for (size_t k = 0; k < 3; ++k) {
+		options.num_splits = large_splits[k];
+		scc_Clabel* const labels = ts_hierarchical_clustering(small_data_set, num_points, &options);
+		ts_assert(ts_same_labels(num_points, labels, max_labels));
+		free(labels);
+	}
+
+	size_t num_clusters, min_size;
+	ts_cluster_sizes(num_points, max_labels, &num_clusters, &min_size);
+	ts_assert(min_size >= size_constraint);
+	free(max_labels);
+	scc_free_data_set(&small_data_set);
+}
+
+
+static void test_coordinates_cluster_count(void)
+{
+	const size_t num_points[3] = { 1000, 1001, NUM_DATA_POINTS };
+	const uint32_t size_constraints[3] = { 2, 3, 7 };
+	const uint32_t num_splits[3] = { 2, 3, 5 };
+	for (size_t n = 0; n < 3; ++n) {
+		scc_DataSet* sub_data_set = ts_data_set(num_points[n], 2, data);
+		for (size_t s = 0; s < 3; ++s) {
+			for (size_t k = 0; k < 3; ++k) {
+				scc_HierarchicalOptions options = ts_hierarchical_options(size_constraints[s], num_splits[k]);
+				options.split_method = SCC_SP_COORDINATES;
+				scc_Clabel* const labels = ts_hierarchical_clustering(sub_data_set, num_points[n], &options);
+				size_t num_clusters, min_size;
+				ts_cluster_sizes(num_points[n], labels, &num_clusters, &min_size);
+				ts_assert(min_size >= size_constraints[s]);
+				ts_assert(num_clusters == num_points[n] / size_constraints[s]);
+				free(labels);
+			}
+		}
+		scc_free_data_set(&sub_data_set);
+	}
+}
+
+
+static void test_coordinates_independent_of_threads(void)
+{
+	const uint32_t num_splits[2] = { 2, 4 };
+	for (size_t k = 0; k < 2; ++k) {
+		scc_HierarchicalOptions options = ts_hierarchical_options(3, num_splits[k]);
+		options.split_method = SCC_SP_COORDINATES;
+		free(ts_hierarchical_clustering_all_threads(data_set, NUM_DATA_POINTS, &options, 4));
+	}
+}
+
+
+static void test_coordinates_require_builtin(void)
+{
+	scc_HierarchicalOptions options = ts_hierarchical_options(3, 2);
+	options.split_method = SCC_SP_COORDINATES;
+
+	scc_Clustering* clustering;
+	ts_assert_ok(scc_init_empty_clustering(NUM_DATA_POINTS, NULL, &clustering));
+	ts_use_user_dist_functions();
+	ts_assert(scc_hierarchical_clustering(data_set, &options, clustering) == SCC_ER_NOT_IMPLEMENTED);
+	ts_assert(scc_reset_dist_functions());
+
+	// Distance splitting works with the same functions
+	ts_use_user_dist_functions();
+	options.split_method = SCC_SP_DISTANCES;
+	ts_assert_ok(scc_hierarchical_clustering(data_set, &options, clustering));
+	ts_assert(scc_reset_dist_functions());
+
+	scc_free_clustering(&clustering);
+}
+
+
+// With all points at the same location every projection has the same extremes, and
+// the first and last members of the cluster are used as centers
+static void test_approximate_centers_duplicates(void)
+{
+	const size_t num_points = 500;
+	double* const duplicate_data = malloc(sizeof(double[num_points * 2]));
+	ts_assert(duplicate_data != NULL);
+	for (size_t i = 0; i < num_points; ++i) {
+		duplicate_data[2 * i] = 0.25;
+		duplicate_data[2 * i + 1] = 0.75;
+	}
+	// Also a cluster where only a few points differ
+	double* const few_distinct_data = malloc(sizeof(double[num_points * 2]));
+	ts_assert(few_distinct_data != NULL);
+	memcpy(few_distinct_data, duplicate_data, sizeof(double[num_points * 2]));
+	few_distinct_data[0] = 0.5;
+	few_distinct_data[2 * (num_points / 2) + 1] = 0.0;
+
+	double* const test_data[2] = { duplicate_data, few_distinct_data };
+	const uint32_t num_splits[2] = { 2, 4 };
+	for (size_t t = 0; t < 2; ++t) {
+		scc_DataSet* duplicate_data_set = ts_data_set(num_points, 2, test_data[t]);
+		for (size_t k = 0; k < 2; ++k) {
+			scc_HierarchicalOptions options = ts_hierarchical_options(3, num_splits[k]);
+			options.approximate_centers = true;
+			scc_Clabel* const labels = ts_hierarchical_clustering(duplicate_data_set, num_points, &options);
+			size_t num_clusters, min_size;
+			ts_cluster_sizes(num_points, labels, &num_clusters, &min_size);
+			ts_assert(min_size >= 3);
+			ts_assert(num_clusters > 1);
+
+			scc_Clabel* const repeated_labels = ts_hierarchical_clustering(duplicate_data_set, num_points, &options);
+			ts_assert(ts_same_labels(num_points, labels, repeated_labels));
+
+			free(labels);
+			free(repeated_labels);
+		}
+		scc_free_data_set(&duplicate_data_set);
+	}
+
+	free(duplicate_data);
+	free(few_distinct_data);
+}
+
+
+static void test_approximate_centers_independent_of_threads(void)
+{
+	const uint32_t num_splits[2] = { 2, 4 };
+	for (size_t k = 0; k < 2; ++k) {
+		scc_HierarchicalOptions options = ts_hierarchical_options(3, num_splits[k]);
+		options.approximate_centers = true;
+		scc_Clabel* const serial_labels = ts_hierarchical_clustering_all_threads(data_set, NUM_DATA_POINTS, &options, 4);
+		size_t num_clusters, min_size;
+		ts_cluster_sizes(NUM_DATA_POINTS, serial_labels, &num_clusters, &min_size);
+		ts_assert(min_size >= 3);
+		free(serial_labels);
+	}
+
+	// Requires the built-in distance functions
+	scc_HierarchicalOptions options = ts_hierarchical_options(3, 2);
+	options.approximate_centers = true;
+	scc_Clustering* clustering;
+	ts_assert_ok(scc_init_empty_clustering(NUM_DATA_POINTS, NULL, &clustering));
+	ts_use_user_dist_functions();
+	ts_assert(scc_hierarchical_clustering(data_set, &options, clustering) == SCC_ER_NOT_IMPLEMENTED);
+	ts_assert(scc_reset_dist_functions());
+	scc_free_clustering(&clustering);
+}
+
+
+int main(void)
+{
+	printf("test_hierarchical\n");
+
+	data = ts_random_data(NUM_DATA_POINTS, 2, 0);
+	data_set = ts_data_set(NUM_DATA_POINTS, 2, data);
+
+	ts_run_test(test_k_way_size_constraint);
+	ts_run_test(test_k_way_independent_of_threads);
+	ts_run_test(test_large_num_splits);
+	ts_run_test(test_coordinates_cluster_count);
+	ts_run_test(test_coordinates_independent_of_threads);
+	ts_run_test(test_coordinates_require_builtin);
+	ts_run_test(test_approximate_centers_duplicates);
+	ts_run_test(test_approximate_centers_independent_of_threads);
+
+	scc_free_data_set(&data_set);
+	free(data);
+
+	return 0;
+}
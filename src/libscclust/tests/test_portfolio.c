@@ -0,0 +1,146 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "test_suite.h"
+
+#define NUM_DATA_POINTS 3000
+#define NUM_LARGE_DATA_POINTS 12000
+
+static double* data;
+static scc_DataSet* data_set;
+static scc_PointIndex primary_data_points[NUM_DATA_POINTS];
+static size_t len_primary_data_points;
+
+static const scc_SeedMethod portfolio_methods[5] = {
+	SCC_SM_LEXICAL,
+	SCC_SM_INWARDS_ORDER,
+	SCC_SM_INWARDS_UPDATING,
+	SCC_SM_EXCLUSION_ORDER,
+	SCC_SM_EXCLUSION_UPDATING,
+};
+
+
+// Seeds are counted through the clusters, as every seed gives one cluster
+static size_t count_clusters(const scc_Clabel labels[const])
+{
+	size_t num_clusters = 0;
+	for (size_t i = 0; i < NUM_DATA_POINTS; ++i) {
+		if ((labels[i] >= 0) && ((size_t) labels[i] >= num_clusters)) num_clusters = (size_t) labels[i] + 1;
+	}
+	return num_clusters;
+}
+
+
+static void test_equals_best_single_method(void)
+{
+	for (int primary = 0; primary < 2; ++primary) {
+		const scc_PointIndex* const primary_points = primary ? primary_data_points : NULL;
+		scc_Clabel* single_labels[5];
+		size_t single_clusters[5];
+		for (size_t m = 0; m < 5; ++m) {
+			scc_ClusterOptions options = ts_cluster_options(4, SCC_SM_LEXICAL, len_primary_data_points, primary_points);
+			options.seed_method = portfolio_methods[m];
+			single_labels[m] = ts_sc_clustering(data_set, NUM_DATA_POINTS, &options);
+			single_clusters[m] = count_clusters(single_labels[m]);
+		}
+
+		for (uint32_t mask = 1; mask < 32; ++mask) {
+			size_t best = 5;
+			uint32_t portfolio = 0;
+			for (size_t m = 0; m < 5; ++m) {
+				if ((mask & (UINT32_C(1) << m)) == 0) continue;
+				portfolio |= UINT32_C(1) << portfolio_methods[m];
+				if ((best == 5) || (single_clusters[m] > single_clusters[best])) best = m;
+			}
+
+			scc_ClusterOptions options = ts_cluster_options(4, SCC_SM_LEXICAL, len_primary_data_points, primary_points);
+			options.seed_portfolio = portfolio;
+			scc_Clabel* const labels = ts_sc_clustering(data_set, NUM_DATA_POINTS, &options);
+			ts_assert(ts_same_labels(NUM_DATA_POINTS, labels, single_labels[best]));
+			free(labels);
+		}
+
+		for (size_t m = 0; m < 5; ++m) {
+			free(single_labels[m]);
+		}
+	}
+}
+
+
+static void test_independent_of_threads(void)
+{
+	double* const large_data = ts_random_data(NUM_LARGE_DATA_POINTS, 2, 7);
+	scc_DataSet* large_data_set = ts_data_set(NUM_LARGE_DATA_POINTS, 2, large_data);
+
+	scc_ClusterOptions options = ts_cluster_options(4, SCC_SM_LEXICAL, 0, NULL);
+	options.seed_portfolio = (UINT32_C(1) << SCC_SM_LEXICAL) |
+	                         (UINT32_C(1) << SCC_SM_INWARDS_UPDATING) |
+	                         (UINT32_C(1) << SCC_SM_EXCLUSION_ORDER) |
+	                         (UINT32_C(1) << SCC_SM_EXCLUSION_UPDATING);
+
+	free(ts_sc_clustering_all_threads(large_data_set, NUM_LARGE_DATA_POINTS, &options, 5));
+
+	scc_free_data_set(&large_data_set);
+	free(large_data);
+}
+
+
+static void test_invalid_portfolio(void)
+{
+	scc_Clustering* clustering;
+	ts_assert_ok(scc_init_empty_clustering(NUM_DATA_POINTS, NULL, &clustering));
+
+	scc_ClusterOptions options = ts_cluster_options(4, SCC_SM_LEXICAL, 0, NULL);
+	options.seed_portfolio = UINT32_C(1) << SCC_SM_BATCHES;
+	ts_assert(scc_sc_clustering(data_set, &options, clustering) == SCC_ER_INVALID_INPUT);
+
+	options.seed_portfolio = (UINT32_C(1) << SCC_SM_LEXICAL) | (UINT32_C(1) << SCC_SM_BATCHES);
+	ts_assert(scc_sc_clustering(data_set, &options, clustering) == SCC_ER_INVALID_INPUT);
+
+	options.seed_portfolio = (UINT32_C(1) << SCC_SM_LEXICAL) | (UINT32_C(1) << 31);
+	ts_assert(scc_sc_clustering(data_set, &options, clustering) == SCC_ER_INVALID_INPUT);
+
+	options.seed_portfolio = UINT32_C(1) << SCC_SM_LEXICAL;
+	options.seed_method = SCC_SM_BATCHES;
+	ts_assert(scc_sc_clustering(data_set, &options, clustering) == SCC_ER_NOT_IMPLEMENTED);
+
+	scc_free_clustering(&clustering);
+}
+
+
+int main(void)
+{
+	printf("test_portfolio\n");
+
+	data = ts_random_data(NUM_DATA_POINTS, 2, 0);
+	data_set = ts_data_set(NUM_DATA_POINTS, 2, data);
+	for (size_t i = 0; i < NUM_DATA_POINTS; ++i) {
+		if (i % 5 < 2) primary_data_points[len_primary_data_points++] = (scc_PointIndex) i;
+	}
+
+	ts_run_test(test_equals_best_single_method);
+	ts_run_test(test_independent_of_threads);
+	ts_run_test(test_invalid_portfolio);
+
+	scc_free_data_set(&data_set);
+	free(data);
+
+	return 0;
+}
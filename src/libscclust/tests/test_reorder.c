@@ -0,0 +1,212 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "test_suite.h"
+#include "../src/point_order.h"
+#include "../src/workspace.h"
+
+#define NUM_DATA_POINTS 2000
+#define NUM_DIMENSIONS 2
+
+static double* data;
+static scc_DataSet* data_set;
+static scc_TypeLabel type_labels[NUM_DATA_POINTS];
+static scc_PointIndex primary_data_points[NUM_DATA_POINTS];
+static size_t len_primary_data_points;
+static const uint32_t type_constraints[3] = { 1, 1, 0 };
+
+
+// Input with point `i` moved to `permutation[i]`
+typedef struct Permuted {
+	double data[NUM_DATA_POINTS * NUM_DIMENSIONS];
+	scc_DataSet* data_set;
+	scc_TypeLabel type_labels[NUM_DATA_POINTS];
+	scc_PointIndex primary_data_points[NUM_DATA_POINTS];
+} Permuted;
+
+
+static void permute(const scc_PointIndex permutation[const],
+                    Permuted* const out)
+{
+	bool is_primary[NUM_DATA_POINTS] = { false };
+	for (size_t p = 0; p < len_primary_data_points; ++p) {
+		is_primary[primary_data_points[p]] = true;
+	}
+	bool is_primary_permuted[NUM_DATA_POINTS] = { false };
+	for (size_t i = 0; i < NUM_DATA_POINTS; ++i) {
+		const size_t to = (size_t) permutation[i];
+		memcpy(&out->data[to * NUM_DIMENSIONS], &data[i * NUM_DIMENSIONS], sizeof(double[NUM_DIMENSIONS]));
+		out->type_labels[to] = type_labels[i];
+		is_primary_permuted[to] = is_primary[i];
+	}
+	size_t len = 0;
+	for (size_t i = 0; i < NUM_DATA_POINTS; ++i) {
+		if (is_primary_permuted[i]) out->primary_data_points[len++] = (scc_PointIndex) i;
+	}
+	ts_assert(len == len_primary_data_points);
+	out->data_set = ts_data_set(NUM_DATA_POINTS, NUM_DIMENSIONS, out->data);
+}
+
+
+static scc_ClusterOptions make_options(const int variant,
+                                       const scc_TypeLabel labels[const],
+                                       const scc_PointIndex primary[const])
+{
+	scc_ClusterOptions options = ts_cluster_options(3, SCC_SM_INWARDS_UPDATING, len_primary_data_points,
+	                                                (variant == 2) ? primary : NULL);
+	if (variant == 1) {
+		options.num_types = 3;
+		options.type_constraints = type_constraints;
+		options.len_type_labels = NUM_DATA_POINTS;
+		options.type_labels = labels;
+	}
+	return options;
+}
+
+
+// Reordering equals clustering the Morton-sorted input and mapping the labels back
+static void test_maps_back_to_original_ids(void)
+{
+	scc_PointIndex* order;
+	ts_assert_ok(iscc_morton_order(data_set, &order));
+
+	scc_PointIndex* const position = malloc(sizeof(scc_PointIndex[NUM_DATA_POINTS]));
+	ts_assert(position != NULL);
+	for (size_t i = 0; i < NUM_DATA_POINTS; ++i) {
+		position[order[i]] = (scc_PointIndex) i;
+	}
+	Permuted* const sorted = malloc(sizeof(Permuted));
+	ts_assert(sorted != NULL);
+	permute(position, sorted);
+
+	for (int variant = 0; variant < 3; ++variant) {
+		scc_ClusterOptions options = make_options(variant, type_labels, primary_data_points);
+		options.reorder_data_points = true;
+		scc_Clabel* const labels = ts_sc_clustering(data_set, NUM_DATA_POINTS, &options);
+
+		const scc_ClusterOptions sorted_options = make_options(variant, sorted->type_labels, sorted->primary_data_points);
+		scc_Clabel* const sorted_labels = ts_sc_clustering(sorted->data_set, NUM_DATA_POINTS, &sorted_options);
+
+		for (size_t i = 0; i < NUM_DATA_POINTS; ++i) {
+			ts_assert(labels[i] == sorted_labels[position[i]]);
+		}
+
+		free(labels);
+		free(sorted_labels);
+	}
+
+	scc_free_data_set(&sorted->data_set);
+	free(sorted);
+	free(position);
+	iscc_free(order);
+}
+
+
+// The sorted order only depends on the coordinates, so reordering makes the
+// clustering independent of the order of the input
+static void test_independent_of_input_order(void)
+{
+	scc_PointIndex* const permutation = malloc(sizeof(scc_PointIndex[NUM_DATA_POINTS]));
+	ts_assert(permutation != NULL);
+	for (size_t i = 0; i < NUM_DATA_POINTS; ++i) {
+		permutation[i] = (scc_PointIndex) i;
+	}
+	uint64_t state = 2463534242u;
+	for (size_t i = NUM_DATA_POINTS - 1; i > 0; --i) {
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		const size_t j = (size_t) (state % (i + 1));
+		const scc_PointIndex tmp = permutation[i];
+		permutation[i] = permutation[j];
+		permutation[j] = tmp;
+	}
+	Permuted* const shuffled = malloc(sizeof(Permuted));
+	ts_assert(shuffled != NULL);
+	permute(permutation, shuffled);
+
+	for (int variant = 0; variant < 3; ++variant) {
+		scc_ClusterOptions options = make_options(variant, type_labels, primary_data_points);
+		options.reorder_data_points = true;
+		scc_Clabel* const labels = ts_sc_clustering(data_set, NUM_DATA_POINTS, &options);
+
+		scc_ClusterOptions shuffled_options = make_options(variant, shuffled->type_labels, shuffled->primary_data_points);
+		shuffled_options.reorder_data_points = true;
+		scc_Clabel* const shuffled_labels = ts_sc_clustering(shuffled->data_set, NUM_DATA_POINTS, &shuffled_options);
+
+		size_t num_clusters, min_size;
+		ts_cluster_sizes(NUM_DATA_POINTS, labels, &num_clusters, &min_size);
+		ts_assert(num_clusters > 0);
+		if (variant == 0) ts_assert(min_size >= options.size_constraint);
+
+		for (size_t i = 0; i < NUM_DATA_POINTS; ++i) {
+			ts_assert(labels[i] == shuffled_labels[permutation[i]]);
+		}
+
+		free(labels);
+		free(shuffled_labels);
+	}
+
+	scc_free_data_set(&shuffled->data_set);
+	free(shuffled);
+	free(permutation);
+}
+
+
+static void test_user_dist_functions(void)
+{
+	ts_use_user_dist_functions();
+
+	scc_ClusterOptions options = make_options(0, NULL, NULL);
+	scc_Clustering* clustering;
+	ts_assert_ok(scc_init_empty_clustering(NUM_DATA_POINTS, NULL, &clustering));
+	options.reorder_data_points = false;
+	ts_assert_ok(scc_sc_clustering(data_set, &options, clustering));
+	scc_free_clustering(&clustering);
+
+	ts_assert_ok(scc_init_empty_clustering(NUM_DATA_POINTS, NULL, &clustering));
+	options.reorder_data_points = true;
+	ts_assert(scc_sc_clustering(data_set, &options, clustering) == SCC_ER_NOT_IMPLEMENTED);
+	scc_free_clustering(&clustering);
+
+	ts_assert(scc_reset_dist_functions());
+}
+
+
+int main(void)
+{
+	printf("test_reorder\n");
+
+	data = ts_random_data(NUM_DATA_POINTS, NUM_DIMENSIONS, 0);
+	data_set = ts_data_set(NUM_DATA_POINTS, NUM_DIMENSIONS, data);
+	for (size_t i = 0; i < NUM_DATA_POINTS; ++i) {
+		type_labels[i] = (scc_TypeLabel) ((i * 7) % 3);
+		if (i % 3 == 0) primary_data_points[len_primary_data_points++] = (scc_PointIndex) i;
+	}
+
+	ts_run_test(test_maps_back_to_original_ids);
+	ts_run_test(test_independent_of_input_order);
+	ts_run_test(test_user_dist_functions);
+
+	scc_free_data_set(&data_set);
+	free(data);
+
+	return 0;
+}
@@ -0,0 +1,253 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "test_suite.h"
+
+#define NUM_DATA_POINTS 3000
+
+static double* data;
+static scc_DataSet* data_set;
+static scc_TypeLabel type_labels[NUM_DATA_POINTS];
+static scc_PointIndex primary_data_points[NUM_DATA_POINTS];
+static size_t len_primary_data_points;
+static const uint32_t type_constraints[3] = { 1, 2, 1 };
+
+
+static scc_ResourceEstimate estimate(const scc_ClusterOptions* const options)
+{
+	scc_ResourceEstimate out_estimate;
+	ts_assert_ok(scc_estimate_resources(data_set, options, &out_estimate));
+	return out_estimate;
+}
+
+
+static void check_consistent(const scc_ResourceEstimate* const est)
+{
+	ts_assert(est->sample_size > 0);
+	ts_assert(est->num_seeds > 0);
+	ts_assert(est->peak_bytes > 0);
+	ts_assert(est->nng_dist_evals > 0);
+	ts_assert(est->peak_bytes >= est->nng_bytes);
+	ts_assert(est->peak_bytes >= est->exclusion_graph_bytes);
+	ts_assert(est->peak_bytes >= est->sort_bytes);
+	ts_assert(est->peak_bytes >= est->assignment_bytes);
+	ts_assert(est->peak_bytes == est->nng_bytes ||
+	          est->peak_bytes == est->exclusion_graph_bytes ||
+	          est->peak_bytes == est->sort_bytes ||
+	          est->peak_bytes == est->assignment_bytes);
+	ts_assert(est->total_dist_evals == est->nng_dist_evals + est->assignment_dist_evals);
+}
+
+
+static void test_positive_and_deterministic(void)
+{
+	for (int method = SCC_SM_LEXICAL; method <= SCC_SM_EXCLUSION_UPDATING; ++method) {
+		scc_ClusterOptions options = scc_get_default_options();
+		options.size_constraint = 3;
+		options.seed_method = (scc_SeedMethod) method;
+		const scc_ResourceEstimate est1 = estimate(&options);
+		const scc_ResourceEstimate est2 = estimate(&options);
+		check_consistent(&est1);
+		ts_assert(memcmp(&est1, &est2, sizeof(scc_ResourceEstimate)) == 0);
+		ts_assert(est1.num_seeds <= NUM_DATA_POINTS / options.size_constraint);
+	}
+}
+
+
+static void test_tracks_seed_method(void)
+{
+	scc_ClusterOptions options = scc_get_default_options();
+	options.size_constraint = 3;
+
+	options.seed_method = SCC_SM_LEXICAL;
+	const scc_ResourceEstimate lexical = estimate(&options);
+	options.seed_method = SCC_SM_INWARDS_UPDATING;
+	const scc_ResourceEstimate inwards = estimate(&options);
+	options.seed_method = SCC_SM_EXCLUSION_UPDATING;
+	const scc_ResourceEstimate exclusion = estimate(&options);
+
+	ts_assert(lexical.exclusion_graph_arcs == 0);
+	ts_assert(lexical.exclusion_graph_bytes == 0);
+	ts_assert(inwards.exclusion_graph_arcs == 0);
+	ts_assert(exclusion.exclusion_graph_arcs > 0);
+	ts_assert(exclusion.exclusion_graph_bytes > 0);
+
+	// Same NNG for all methods
+	ts_assert(lexical.nng_arcs == inwards.nng_arcs);
+	ts_assert(lexical.nng_arcs == exclusion.nng_arcs);
+	ts_assert(lexical.nng_bytes == exclusion.nng_bytes);
+
+	// Updating methods keep more state when sorting
+	ts_assert(inwards.sort_bytes > lexical.sort_bytes);
+	ts_assert(exclusion.sort_bytes > inwards.sort_bytes);
+
+	// A larger size constraint gives more arcs and fewer seeds
+	options.seed_method = SCC_SM_LEXICAL;
+	options.size_constraint = 6;
+	const scc_ResourceEstimate lexical6 = estimate(&options);
+	ts_assert(lexical6.nng_arcs > lexical.nng_arcs);
+	ts_assert(lexical6.num_seeds < lexical.num_seeds);
+}
+
+
+static void test_tracks_types_and_primary(void)
+{
+	scc_ClusterOptions options = scc_get_default_options();
+	options.size_constraint = 3;
+	const scc_ResourceEstimate plain = estimate(&options);
+
+	options.num_types = 3;
+	options.type_constraints = type_constraints;
+	options.len_type_labels = NUM_DATA_POINTS;
+	options.type_labels = type_labels;
+	const scc_ResourceEstimate types = estimate(&options);
+	check_consistent(&types);
+	ts_assert(types.nng_bytes > plain.nng_bytes);
+
+	options = scc_get_default_options();
+	options.size_constraint = 3;
+	options.len_primary_data_points = len_primary_data_points;
+	options.primary_data_points = primary_data_points;
+	const scc_ResourceEstimate primary = estimate(&options);
+	check_consistent(&primary);
+	ts_assert(primary.nng_arcs < plain.nng_arcs);
+	ts_assert(primary.nng_dist_evals < plain.nng_dist_evals);
+	ts_assert(primary.num_seeds < plain.num_seeds);
+}
+
+
+static void test_tracks_batches(void)
+{
+	scc_ClusterOptions options = scc_get_default_options();
+	options.size_constraint = 3;
+	options.seed_method = SCC_SM_BATCHES;
+	options.primary_unassigned_method = SCC_UM_ANY_NEIGHBOR;
+
+	options.batch_size = 10;
+	const scc_ResourceEstimate small = estimate(&options);
+	options.batch_size = 1000;
+	const scc_ResourceEstimate large = estimate(&options);
+	check_consistent(&small);
+	check_consistent(&large);
+
+	// Batches never store the NNG
+	ts_assert(small.nng_arcs == 0);
+	ts_assert(small.sort_bytes == 0);
+	ts_assert(small.nng_bytes < large.nng_bytes);
+
+	// Adaptive batches may grow to all points unless capped
+	options.adaptive_batch_size = true;
+	options.batch_size = 10;
+	const scc_ResourceEstimate adaptive = estimate(&options);
+	ts_assert(adaptive.nng_bytes > large.nng_bytes);
+	options.max_batch_bytes = 1000;
+	const scc_ResourceEstimate capped = estimate(&options);
+	ts_assert(capped.nng_bytes < adaptive.nng_bytes);
+}
+
+
+static void check_same_error(const scc_ClusterOptions* const options)
+{
+	scc_Clustering* clustering;
+	ts_assert_ok(scc_init_empty_clustering(NUM_DATA_POINTS, NULL, &clustering));
+	const scc_ErrorCode ec_cl = scc_sc_clustering(data_set, options, clustering);
+	char msg_cl[255];
+	scc_get_latest_error(sizeof(msg_cl), msg_cl);
+	scc_free_clustering(&clustering);
+
+	scc_ResourceEstimate est;
+	const scc_ErrorCode ec_est = scc_estimate_resources(data_set, options, &est);
+	char msg_est[255];
+	scc_get_latest_error(sizeof(msg_est), msg_est);
+
+	ts_assert(ec_cl != SCC_ER_OK);
+	ts_assert(ec_cl == ec_est);
+	ts_assert(strcmp(msg_cl, msg_est) == 0);
+}
+
+
+static void test_invalid_options(void)
+{
+	scc_ClusterOptions options = scc_get_default_options();
+	options.options_version = 1;
+	check_same_error(&options);
+
+	options = scc_get_default_options();
+	options.size_constraint = 1;
+	check_same_error(&options);
+
+	options = scc_get_default_options();
+	options.size_constraint = NUM_DATA_POINTS + 1;
+	check_same_error(&options);
+
+	options = scc_get_default_options();
+	options.num_types = 3;
+	check_same_error(&options);
+
+	options = scc_get_default_options();
+	options.seed_method = (scc_SeedMethod) 99;
+	check_same_error(&options);
+
+	options = scc_get_default_options();
+	options.seed_portfolio = UINT32_C(1) << SCC_SM_BATCHES;
+	check_same_error(&options);
+
+	options = scc_get_default_options();
+	options.primary_data_points = primary_data_points;
+	check_same_error(&options);
+
+	options = scc_get_default_options();
+	options.secondary_unassigned_method = SCC_UM_ANY_NEIGHBOR;
+	check_same_error(&options);
+
+	options = scc_get_default_options();
+	options.seed_radius = SCC_RM_USE_SUPPLIED;
+	options.seed_supplied_radius = -1.0;
+	check_same_error(&options);
+
+	scc_ResourceEstimate est;
+	options = scc_get_default_options();
+	ts_assert(scc_estimate_resources(data_set, &options, NULL) == SCC_ER_INVALID_INPUT);
+	ts_assert(scc_estimate_resources(NULL, &options, &est) == SCC_ER_INVALID_INPUT);
+}
+
+
+int main(void)
+{
+	printf("test_resources\n");
+
+	data = ts_random_data(NUM_DATA_POINTS, 2, 0);
+	data_set = ts_data_set(NUM_DATA_POINTS, 2, data);
+	for (size_t i = 0; i < NUM_DATA_POINTS; ++i) {
+		type_labels[i] = (scc_TypeLabel) (i % 3);
+		if (i % 4 == 0) primary_data_points[len_primary_data_points++] = (scc_PointIndex) i;
+	}
+
+	ts_run_test(test_positive_and_deterministic);
+	ts_run_test(test_tracks_seed_method);
+	ts_run_test(test_tracks_types_and_primary);
+	ts_run_test(test_tracks_batches);
+	ts_run_test(test_invalid_options);
+
+	scc_free_data_set(&data_set);
+	free(data);
+
+	return 0;
+}
@@ -0,0 +1,162 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#include "test_suite.h"
+
+// Large enough for parallel seed finding
+#define NUM_DATA_POINTS 12000
+
+static double* data;
+static scc_DataSet* data_set;
+
+static const scc_SeedMethod nng_methods[5] = {
+	SCC_SM_LEXICAL,
+	SCC_SM_INWARDS_ORDER,
+	SCC_SM_INWARDS_UPDATING,
+	SCC_SM_EXCLUSION_ORDER,
+	SCC_SM_EXCLUSION_UPDATING,
+};
+
+
+// Built-in search that reports the neighbors of each query in reverse order
+static bool reversed_nearest_neighbor_search(iscc_NNSearchObject* const nn_search_object,
+                                             const size_t len_query_indices,
+                                             const scc_PointIndex query_indices[const],
+                                             const uint32_t k,
+                                             const bool radius_search,
+                                             const double radius,
+                                             size_t* const out_num_ok_queries,
+                                             scc_PointIndex out_query_indices[const],
+                                             scc_PointIndex out_nn_indices[const])
+{
+	if (!iscc_imp_nearest_neighbor_search(nn_search_object, len_query_indices, query_indices, k,
+	                                      radius_search, radius, out_num_ok_queries,
+	                                      out_query_indices, out_nn_indices)) {
+		return false;
+	}
+	for (size_t q = 0; q < *out_num_ok_queries; ++q) {
+		scc_PointIndex* const row = out_nn_indices + q * k;
+		for (size_t i = 0, j = k; i + 1 < j; ++i, --j) {
+			const scc_PointIndex tmp = row[i];
+			row[i] = row[j - 1];
+			row[j - 1] = tmp;
+		}
+	}
+	return true;
+}
+
+
+static void use_reversed_search(void)
+{
+	ts_assert(scc_set_dist_functions(ts_user_check_data_set,
+	                                 iscc_imp_num_data_points,
+	                                 iscc_imp_get_dist_matrix,
+	                                 iscc_imp_get_dist_rows,
+	                                 iscc_imp_init_max_dist_object,
+	                                 iscc_imp_get_max_dist,
+	                                 iscc_imp_close_max_dist_object,
+	                                 iscc_imp_init_nn_search_object,
+	                                 reversed_nearest_neighbor_search,
+	                                 iscc_imp_close_nn_search_object));
+}
+
+
+static void test_independent_of_neighbor_order(void)
+{
+	for (size_t m = 0; m < 5; ++m) {
+		scc_ClusterOptions options = ts_cluster_options(4, nng_methods[m], 0, NULL);
+		options.stable_clustering = true;
+		scc_Clabel* const labels = ts_sc_clustering(data_set, NUM_DATA_POINTS, &options);
+
+		use_reversed_search();
+		scc_Clabel* const reversed_labels = ts_sc_clustering(data_set, NUM_DATA_POINTS, &options);
+		ts_assert(scc_reset_dist_functions());
+
+		ts_assert(ts_same_labels(NUM_DATA_POINTS, labels, reversed_labels));
+
+		size_t num_clusters, min_size;
+		ts_cluster_sizes(NUM_DATA_POINTS, labels, &num_clusters, &min_size);
+		ts_assert(min_size >= options.size_constraint);
+
+		free(labels);
+		free(reversed_labels);
+	}
+}
+
+
+static void test_independent_of_threads(void)
+{
+	for (size_t m = 0; m < 5; ++m) {
+		scc_ClusterOptions options = ts_cluster_options(4, nng_methods[m], 0, NULL);
+		options.stable_clustering = true;
+		free(ts_sc_clustering_all_threads(data_set, NUM_DATA_POINTS, &options, 4));
+	}
+}
+
+
+// The updating methods must break ties in counts by ID, also when most
+// vertices have equal counts (all points at the same few locations)
+static void test_ties_broken_by_id(void)
+{
+	const size_t num_points = 600;
+	double* const tied_data = malloc(sizeof(double[num_points * 2]));
+	ts_assert(tied_data != NULL);
+	for (size_t i = 0; i < num_points; ++i) {
+		tied_data[2 * i] = (double) (i % 4);
+		tied_data[2 * i + 1] = (double) ((i / 4) % 3);
+	}
+	scc_DataSet* tied_data_set = ts_data_set(num_points, 2, tied_data);
+
+	for (size_t m = 0; m < 5; ++m) {
+		scc_ClusterOptions options = ts_cluster_options(4, nng_methods[m], 0, NULL);
+		options.stable_clustering = true;
+		scc_Clabel* const labels = ts_sc_clustering(tied_data_set, num_points, &options);
+
+		use_reversed_search();
+		scc_Clabel* const reversed_labels = ts_sc_clustering(tied_data_set, num_points, &options);
+		ts_assert(scc_reset_dist_functions());
+
+		ts_assert(ts_same_labels(num_points, labels, reversed_labels));
+
+		free(labels);
+		free(reversed_labels);
+	}
+
+	scc_free_data_set(&tied_data_set);
+	free(tied_data);
+}
+
+
+int main(void)
+{
+	printf("test_stable\n");
+
+	data = ts_random_data(NUM_DATA_POINTS, 2, 0);
+	data_set = ts_data_set(NUM_DATA_POINTS, 2, data);
+
+	ts_run_test(test_independent_of_neighbor_order);
+	ts_run_test(test_independent_of_threads);
+	ts_run_test(test_ties_broken_by_id);
+
+	scc_free_data_set(&data_set);
+	free(data);
+
+	return 0;
+}
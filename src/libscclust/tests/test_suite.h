@@ -0,0 +1,268 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+#ifndef SCC_TEST_SUITE_HG
+#define SCC_TEST_SUITE_HG
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/scclust.h"
+#include "../include/scclust_spi.h"
+#include "../src/dist_search_imp.h"
+
+#ifdef _OPENMP
+	#include <omp.h>
+#endif
+
+
+// =============================================================================
+// Assertions
+// =============================================================================
+
+#define ts_assert(expression) do { \
+	if (!(expression)) { \
+		fprintf(stderr, "%s:%d: Assertion failed: %s\n", __FILE__, __LINE__, #expression); \
+		exit(EXIT_FAILURE); \
+	} \
+} while (0)
+
+#define ts_assert_ok(expression) do { \
+	if ((expression) != SCC_ER_OK) { \
+		char ts_error_buffer[255]; \
+		scc_get_latest_error(sizeof(ts_error_buffer), ts_error_buffer); \
+		fprintf(stderr, "%s:%d: %s\n  %s\n", __FILE__, __LINE__, #expression, ts_error_buffer); \
+		exit(EXIT_FAILURE); \
+	} \
+} while (0)
+
+#define ts_run_test(test) do { \
+	printf("  %s\n", #test); \
+	fflush(stdout); \
+	test(); \
+} while (0)
+
+
+// =============================================================================
+// Data
+// =============================================================================
+
+// Uniform data in the unit cube from a fixed xorshift stream
+static inline double* ts_random_data(const size_t num_data_points,
+                                     const uint32_t num_dimensions,
+                                     uint64_t seed)
+{
+	double* const data = malloc(sizeof(double[num_data_points * num_dimensions]));
+	ts_assert(data != NULL);
+	seed = (seed == 0) ? 88172645463325252u : seed;
+	for (size_t i = 0; i < num_data_points * num_dimensions; ++i) {
+		seed ^= seed << 13;
+		seed ^= seed >> 7;
+		seed ^= seed << 17;
+		data[i] = (double) (seed >> 11) / 9007199254740992.0;
+	}
+	return data;
+}
+
+
+static inline scc_DataSet* ts_data_set(const size_t num_data_points,
+                                       const uint32_t num_dimensions,
+                                       const double data[const])
+{
+	scc_DataSet* data_set;
+	ts_assert_ok(scc_init_data_set(num_data_points, num_dimensions,
+	                               num_data_points * num_dimensions, data, &data_set));
+	return data_set;
+}
+
+
+// =============================================================================
+// Environment
+// =============================================================================
+
+static inline void ts_set_num_threads(const int num_threads)
+{
+	#ifdef _OPENMP
+		omp_set_num_threads(num_threads);
+	#else
+		(void) num_threads;
+	#endif
+}
+
+
+// Distinct from `iscc_imp_check_data_set` so the library treats the functions as user supplied
+static inline bool ts_user_check_data_set(void* const data_set)
+{
+	return iscc_imp_check_data_set(data_set);
+}
+
+
+static inline void ts_use_user_dist_functions(void)
+{
+	ts_assert(scc_set_dist_functions(ts_user_check_data_set,
+	                                 iscc_imp_num_data_points,
+	                                 iscc_imp_get_dist_matrix,
+	                                 iscc_imp_get_dist_rows,
+	                                 iscc_imp_init_max_dist_object,
+	                                 iscc_imp_get_max_dist,
+	                                 iscc_imp_close_max_dist_object,
+	                                 iscc_imp_init_nn_search_object,
+	                                 iscc_imp_nearest_neighbor_search,
+	                                 iscc_imp_close_nn_search_object));
+}
+
+
+// =============================================================================
+// Clusterings
+// =============================================================================
+
+// Options shared by the clustering tests. With primary data points, secondary points
+// are assigned as well.
+static inline scc_ClusterOptions ts_cluster_options(const uint32_t size_constraint,
+                                                    const scc_SeedMethod seed_method,
+                                                    const size_t len_primary_data_points,
+                                                    const scc_PointIndex primary_data_points[const])
+{
+	scc_ClusterOptions options = scc_get_default_options();
+	options.size_constraint = size_constraint;
+	options.seed_method = seed_method;
+	options.primary_unassigned_method = SCC_UM_CLOSEST_SEED;
+	if (primary_data_points != NULL) {
+		options.len_primary_data_points = len_primary_data_points;
+		options.primary_data_points = primary_data_points;
+		options.secondary_unassigned_method = SCC_UM_CLOSEST_ASSIGNED;
+	}
+	return options;
+}
+
+
+static inline scc_HierarchicalOptions ts_hierarchical_options(const uint32_t size_constraint,
+                                                              const uint32_t num_splits)
+{
+	scc_HierarchicalOptions options = scc_get_default_hierarchical_options();
+	options.size_constraint = size_constraint;
+	options.num_splits = num_splits;
+	return options;
+}
+
+
+static inline scc_Clabel* ts_sc_clustering(void* const data_set,
+                                           const size_t num_data_points,
+                                           const scc_ClusterOptions* const options)
+{
+	scc_Clabel* const labels = malloc(sizeof(scc_Clabel[num_data_points]));
+	ts_assert(labels != NULL);
+	scc_Clustering* clustering;
+	ts_assert_ok(scc_init_empty_clustering(num_data_points, labels, &clustering));
+	ts_assert_ok(scc_sc_clustering(data_set, options, clustering));
+	scc_free_clustering(&clustering);
+	return labels;
+}
+
+
+static inline scc_Clabel* ts_hierarchical_clustering(void* const data_set,
+                                                     const size_t num_data_points,
+                                                     const scc_HierarchicalOptions* const options)
+{
+	scc_Clabel* const labels = malloc(sizeof(scc_Clabel[num_data_points]));
+	ts_assert(labels != NULL);
+	scc_Clustering* clustering;
+	ts_assert_ok(scc_init_empty_clustering(num_data_points, labels, &clustering));
+	ts_assert_ok(scc_hierarchical_clustering(data_set, options, clustering));
+	scc_free_clustering(&clustering);
+	return labels;
+}
+
+
+static inline bool ts_same_labels(const size_t num_data_points,
+                                  const scc_Clabel labels_a[const],
+                                  const scc_Clabel labels_b[const])
+{
+	return memcmp(labels_a, labels_b, sizeof(scc_Clabel[num_data_points])) == 0;
+}
+
+
+// Number of clusters and smallest cluster size. Labels must be non-negative and assigned.
+static inline void ts_cluster_sizes(const size_t num_data_points,
+                                    const scc_Clabel labels[const],
+                                    size_t* const out_num_clusters,
+                                    size_t* const out_min_size)
+{
+	size_t* const sizes = calloc(num_data_points, sizeof(size_t));
+	ts_assert(sizes != NULL);
+	size_t num_clusters = 0;
+	for (size_t i = 0; i < num_data_points; ++i) {
+		ts_assert(labels[i] >= 0);
+		ts_assert((size_t) labels[i] < num_data_points);
+		if ((size_t) labels[i] >= num_clusters) num_clusters = (size_t) labels[i] + 1;
+		++sizes[labels[i]];
+	}
+	size_t min_size = num_data_points;
+	for (size_t c = 0; c < num_clusters; ++c) {
+		if (sizes[c] < min_size) min_size = sizes[c];
+	}
+	free(sizes);
+	*out_num_clusters = num_clusters;
+	*out_min_size = min_size;
+}
+
+
+// Clusters with one to `max_threads` threads, asserts that all labels are the same
+// and returns the labels from one thread
+static inline scc_Clabel* ts_sc_clustering_all_threads(void* const data_set,
+                                                       const size_t num_data_points,
+                                                       const scc_ClusterOptions* const options,
+                                                       const int max_threads)
+{
+	ts_set_num_threads(1);
+	scc_Clabel* const serial_labels = ts_sc_clustering(data_set, num_data_points, options);
+	for (int threads = 2; threads <= max_threads; ++threads) {
+		ts_set_num_threads(threads);
+		scc_Clabel* const labels = ts_sc_clustering(data_set, num_data_points, options);
+		ts_assert(ts_same_labels(num_data_points, labels, serial_labels));
+		free(labels);
+	}
+	ts_set_num_threads(1);
+	return serial_labels;
+}
+
+
+static inline scc_Clabel* ts_hierarchical_clustering_all_threads(void* const data_set,
+                                                                 const size_t num_data_points,
+                                                                 const scc_HierarchicalOptions* const options,
+                                                                 const int max_threads)
+{
+	ts_set_num_threads(1);
+	scc_Clabel* const serial_labels = ts_hierarchical_clustering(data_set, num_data_points, options);
+	for (int threads = 2; threads <= max_threads; ++threads) {
+		ts_set_num_threads(threads);
+		scc_Clabel* const labels = ts_hierarchical_clustering(data_set, num_data_points, options);
+		ts_assert(ts_same_labels(num_data_points, labels, serial_labels));
+		free(labels);
+	}
+	ts_set_num_threads(1);
+	return serial_labels;
+}
+
+
+#endif // ifndef SCC_TEST_SUITE_HG
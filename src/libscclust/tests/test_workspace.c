@@ -0,0 +1,313 @@
+/* =============================================================================
+ * scclust -- A C library for size-constrained clustering
+ * https://github.com/fsavje/scclust
+ *
+ * Copyright (C) 2015-2017  Fredrik Savje -- http://fredriksavje.com
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see http://www.gnu.org/licenses/
+ * ========================================================================== */
+
+
+#include "test_suite.h"
+#include "../src/workspace.h"
+
+#define NUM_DATA_POINTS 3000
+
+
+static scc_WorkspaceStats get_stats(const scc_Workspace* const workspace)
+{
+	scc_WorkspaceStats stats;
+	ts_assert_ok(scc_get_workspace_stats(workspace, &stats));
+	return stats;
+}
+
+
+static void test_stats(void)
+{
+	scc_Workspace* workspace;
+	ts_assert_ok(scc_init_workspace(&workspace));
+	ts_assert_ok(scc_set_workspace(workspace));
+
+	scc_WorkspaceStats stats = get_stats(workspace);
+	ts_assert((stats.used_bytes == 0) && (stats.high_water_bytes == 0) && (stats.cached_bytes == 0));
+	ts_assert((stats.num_allocations == 0) && (stats.num_reused == 0));
+
+	char* const block_a = iscc_malloc(1000);
+	char* const block_b = iscc_malloc(100);
+	ts_assert((block_a != NULL) && (block_b != NULL));
+	stats = get_stats(workspace);
+	const uint64_t used_ab = stats.used_bytes;
+	ts_assert(used_ab >= 1100);
+	ts_assert(stats.high_water_bytes == used_ab);
+	ts_assert(stats.cached_bytes == 0);
+	ts_assert((stats.num_allocations == 2) && (stats.num_reused == 0));
+
+	iscc_free(block_a);
+	stats = get_stats(workspace);
+	const uint64_t used_b = stats.used_bytes;
+	ts_assert(used_b < used_ab);
+	ts_assert(stats.high_water_bytes == used_ab);
+	ts_assert(stats.cached_bytes == used_ab - used_b);
+
+	// Same size class is served from the cache
+	char* const block_c = iscc_malloc(900);
+	ts_assert(block_c == block_a);
+	stats = get_stats(workspace);
+	ts_assert(stats.used_bytes == used_ab);
+	ts_assert(stats.cached_bytes == 0);
+	ts_assert((stats.num_allocations == 3) && (stats.num_reused == 1));
+
+	iscc_free(block_b);
+	iscc_free(block_c);
+	stats = get_stats(workspace);
+	ts_assert(stats.used_bytes == 0);
+	ts_assert(stats.cached_bytes == used_ab);
+
+	ts_assert_ok(scc_set_workspace(NULL));
+	scc_free_workspace(&workspace);
+	ts_assert(workspace == NULL);
+}
+
+
+static void test_realloc(void)
+{
+	scc_Workspace* workspace;
+	ts_assert_ok(scc_init_workspace(&workspace));
+	ts_assert_ok(scc_set_workspace(workspace));
+
+	unsigned char* block = iscc_malloc(100);
+	ts_assert(block != NULL);
+	for (size_t i = 0; i < 100; ++i) block[i] = (unsigned char) i;
+	const uint64_t used_small = get_stats(workspace).used_bytes;
+
+	// Growing moves to a larger block
+	block = iscc_realloc(block, 100000);
+	ts_assert(block != NULL);
+	const uint64_t used_large = get_stats(workspace).used_bytes;
+	ts_assert(used_large > 100000);
+
+	// Shrinking within the size class keeps the block
+	unsigned char* const same_block = iscc_realloc(block, 90000);
+	ts_assert(same_block == block);
+	ts_assert(get_stats(workspace).used_bytes == used_large);
+
+	// Shrinking to a smaller size class gives the block back
+	block = iscc_realloc(block, 100);
+	ts_assert(block != NULL);
+	ts_assert(get_stats(workspace).used_bytes == used_small);
+	ts_assert(get_stats(workspace).cached_bytes >= used_large);
+	for (size_t i = 0; i < 100; ++i) ts_assert(block[i] == (unsigned char) i);
+
+	iscc_free(block);
+	ts_assert_ok(scc_set_workspace(NULL));
+	scc_free_workspace(&workspace);
+}
+
+
+// Blocks above the largest size class (4 MiB) bypass the workspace
+static void test_large_blocks(void)
+{
+	scc_Workspace* workspace;
+	ts_assert_ok(scc_init_workspace(&workspace));
+	ts_assert_ok(scc_set_workspace(workspace));
+
+	const size_t large_size = ((size_t) 8) << 20;
+	unsigned char* block = iscc_malloc(large_size);
+	ts_assert(block != NULL);
+	for (size_t i = 0; i < 100; ++i) block[i] = (unsigned char) i;
+	scc_WorkspaceStats stats = get_stats(workspace);
+	ts_assert((stats.used_bytes == 0) && (stats.num_allocations == 0));
+
+	// Shrinking resizes the block in place, also below the largest class
+	block = iscc_realloc(block, 100);
+	ts_assert(block != NULL);
+	for (size_t i = 0; i < 100; ++i) ts_assert(block[i] == (unsigned char) i);
+	ts_assert(get_stats(workspace).used_bytes == 0);
+
+	// Growing a pooled block past the largest class leaves the workspace
+	unsigned char* pooled = iscc_malloc(100);
+	ts_assert(pooled != NULL);
+	memcpy(pooled, block, 100);
+	const uint64_t used_small = get_stats(workspace).used_bytes;
+	ts_assert(used_small > 0);
+	pooled = iscc_realloc(pooled, large_size);
+	ts_assert(pooled != NULL);
+	for (size_t i = 0; i < 100; ++i) ts_assert(pooled[i] == (unsigned char) i);
+	stats = get_stats(workspace);
+	ts_assert((stats.used_bytes == 0) && (stats.cached_bytes == used_small));
+
+	iscc_free(block);
+	iscc_free(pooled);
+	ts_assert(get_stats(workspace).cached_bytes == used_small);
+
+	ts_assert_ok(scc_set_workspace(NULL));
+	scc_free_workspace(&workspace);
+}
+
+
+static void test_reset(void)
+{
+	scc_Workspace* workspace;
+	ts_assert_ok(scc_init_workspace(&workspace));
+	ts_assert_ok(scc_set_workspace(workspace));
+
+	iscc_free(iscc_malloc(100000));
+	iscc_free(iscc_malloc(100));
+	const uint64_t cached_both = get_stats(workspace).cached_bytes;
+
+	// Sizes used since the last reset are kept
+	ts_assert_ok(scc_reset_workspace(workspace));
+	scc_WorkspaceStats stats = get_stats(workspace);
+	ts_assert(stats.cached_bytes == cached_both);
+	ts_assert((stats.used_bytes == 0) && (stats.high_water_bytes == 0));
+	ts_assert((stats.num_allocations == 0) && (stats.num_reused == 0));
+
+	// Sizes not used since the last reset are given back
+	iscc_free(iscc_malloc(100));
+	ts_assert(get_stats(workspace).num_reused == 1);
+	ts_assert_ok(scc_reset_workspace(workspace));
+	const uint64_t cached_small = get_stats(workspace).cached_bytes;
+	ts_assert((cached_small > 0) && (cached_small < 1000));
+
+	ts_assert_ok(scc_reset_workspace(workspace));
+	ts_assert(get_stats(workspace).cached_bytes == 0);
+
+	// Blocks in use are not affected
+	char* const block = iscc_malloc(5000);
+	ts_assert_ok(scc_reset_workspace(workspace));
+	ts_assert_ok(scc_reset_workspace(workspace));
+	stats = get_stats(workspace);
+	ts_assert((stats.used_bytes >= 5000) && (stats.high_water_bytes == stats.used_bytes));
+	iscc_free(block);
+	ts_assert(get_stats(workspace).cached_bytes == stats.used_bytes);
+
+	ts_assert(scc_reset_workspace(NULL) == SCC_ER_INVALID_INPUT);
+
+	ts_assert_ok(scc_set_workspace(NULL));
+	scc_free_workspace(&workspace);
+}
+
+
+static void test_outlives_workspace(void)
+{
+	scc_Workspace* workspace;
+	ts_assert_ok(scc_init_workspace(&workspace));
+	ts_assert_ok(scc_set_workspace(workspace));
+
+	char* const block_a = iscc_malloc(1000);
+	char* const block_b = iscc_malloc(1000);
+	ts_assert_ok(scc_set_workspace(NULL));
+
+	// Goes back to its workspace also when that is not in use
+	iscc_free(block_a);
+	scc_WorkspaceStats stats = get_stats(workspace);
+	ts_assert((stats.used_bytes > 0) && (stats.cached_bytes == stats.used_bytes));
+
+	// Given to the system when the workspace is gone
+	scc_free_workspace(&workspace);
+	iscc_free(block_b);
+}
+
+
+static void test_clustering_reuse(void)
+{
+	double* const data = ts_random_data(NUM_DATA_POINTS, 2, 0);
+	scc_DataSet* data_set = ts_data_set(NUM_DATA_POINTS, 2, data);
+
+	scc_ClusterOptions options = scc_get_default_options();
+	options.size_constraint = 3;
+	options.seed_method = SCC_SM_INWARDS_UPDATING;
+	options.primary_unassigned_method = SCC_UM_CLOSEST_SEED;
+	scc_Clabel* const plain_labels = ts_sc_clustering(data_set, NUM_DATA_POINTS, &options);
+
+	scc_Workspace* workspace;
+	ts_assert_ok(scc_init_workspace(&workspace));
+	ts_assert_ok(scc_set_workspace(workspace));
+
+	uint64_t high_water_bytes = 0;
+	for (int run = 0; run < 3; ++run) {
+		scc_Clabel* const labels = ts_sc_clustering(data_set, NUM_DATA_POINTS, &options);
+		ts_assert(ts_same_labels(NUM_DATA_POINTS, labels, plain_labels));
+		free(labels);
+
+		const scc_WorkspaceStats stats = get_stats(workspace);
+		ts_assert(stats.used_bytes == 0);
+		ts_assert(stats.num_allocations > 0);
+		if (run == 0) {
+			high_water_bytes = stats.high_water_bytes;
+		} else {
+			// Later runs find all blocks they need in the cache
+			ts_assert(stats.high_water_bytes == high_water_bytes);
+			ts_assert(stats.num_reused == stats.num_allocations);
+		}
+		ts_assert_ok(scc_reset_workspace(workspace));
+	}
+
+	ts_assert_ok(scc_set_workspace(NULL));
+	scc_free_workspace(&workspace);
+
+	free(plain_labels);
+	scc_free_data_set(&data_set);
+	free(data);
+}
+
+
+static void test_per_thread(void)
+{
+	#ifdef _OPENMP
+		scc_Workspace* workspace;
+		ts_assert_ok(scc_init_workspace(&workspace));
+		ts_assert_ok(scc_set_workspace(workspace));
+
+		char* shared_block = NULL;
+		bool other_thread_ok = true;
+		#pragma omp parallel num_threads(2)
+		{
+			if (omp_get_thread_num() == 0) shared_block = iscc_malloc(1000);
+			#pragma omp barrier
+			if (omp_get_thread_num() == 1) {
+				// Threads have their own workspace, and the block goes back to its workspace
+				char* const block = iscc_malloc(1000);
+				other_thread_ok = (block != NULL);
+				iscc_free(block);
+				iscc_free(shared_block);
+			}
+		}
+		ts_assert(other_thread_ok);
+
+		const scc_WorkspaceStats stats = get_stats(workspace);
+		ts_assert(stats.used_bytes == 0);
+		ts_assert(stats.cached_bytes > 0);
+		ts_assert(stats.num_allocations == 1);
+
+		ts_assert_ok(scc_set_workspace(NULL));
+		scc_free_workspace(&workspace);
+	#endif
+}
+
+
+int main(void)
+{
+	printf("test_workspace\n");
+
+	ts_run_test(test_stats);
+	ts_run_test(test_realloc);
+	ts_run_test(test_large_blocks);
+	ts_run_test(test_reset);
+	ts_run_test(test_outlives_workspace);
+	ts_run_test(test_clustering_reuse);
+	ts_run_test(test_per_thread);
+
+	return 0;
+}